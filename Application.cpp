@@ -36,7 +36,19 @@ Application::Application()
 	_pVertexShader = nullptr;
 	_pPixelShader = nullptr;
 	_pVertexLayout = nullptr;
+	_pCompactVertexShader = nullptr;
+	_pCompactVertexLayout = nullptr;
 	_pConstantBuffer = nullptr;
+	objMeshData = MeshData();
+	_plane = MeshData();
+	_crateTexture = InvalidAssetHandle;
+	_planeMesh = InvalidAssetHandle;
+	_knotMesh = InvalidAssetHandle;
+	_crateTextureVersion = 0;
+	_planeMeshVersion = 0;
+	_knotMeshVersion = 0;
+	_shadersChanged = false;
+	_wireFrameActive = false;
 }
 
 Application::~Application()
@@ -79,6 +91,8 @@ HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
         XMFLOAT3(0.0f, 1.0f, 0.0f),
         _WindowWidth, _WindowHeight, 0.01f, 100.0f);
 
+    _lodPixelError = 1.0f;
+
     // Light direction from surface (XYZ)
     lightDirection = XMFLOAT3(0.25f, 0.5f, -1.0f);
     // Diffuse material properties (RGBA)
@@ -98,8 +112,18 @@ HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
     // Specular light power
     specularPower = 10.0f;
 
-    // Load texture
-    CreateDDSTextureFromFile(_pd3dDevice, L"Textures/Crate_COLOR.dds", nullptr, &_pTextureRV);
+    // Assets are looked for in Assets.pack first if there is one (see Tools/AssetPacker), then in their own files
+    if (_assetPack.Open("Assets.pack"))
+    {
+        AssetPack::Mount(&_assetPack);
+    }
+
+    // Textures and meshes load in the background, and are drawn from the first frame after they arrive (see TakeLoadedAssets)
+    _assetLoader.Init(_pd3dDevice);
+    // Textures drawn least recently give up their biggest mips first once there's more than this of them
+    _assetLoader.SetTextureBudget(256 * 1024 * 1024);
+    // The crate is drawn from its smallest mips first, sharpening as the bigger ones stream in
+    _crateTexture = _assetLoader.StreamTexture("Textures/Crate_COLOR.dds", AssetPriorityHigh);
 
     // Create the sample state
     D3D11_SAMPLER_DESC sampDesc;
@@ -114,8 +138,20 @@ HRESULT Application::Initialise(HINSTANCE hInstance, int nCmdShow)
 
     _pd3dDevice->CreateSamplerState(&sampDesc, &_pSamplerLinear);
 
-    _plane = OBJLoader::Load("OBJ/flat plane.obj", _pd3dDevice);
-    objMeshData = OBJLoader::Load("OBJ/torusKnot.obj", _pd3dDevice);
+    _planeMesh = _assetLoader.LoadMesh("OBJ/flat plane.obj", AssetPriorityHigh);
+
+    // The torus knot gets a chain of simplified versions for when it's further from the camera
+    OBJLoadOptions knotOptions;
+    knotOptions.lodRatios = { 0.5f, 0.25f, 0.125f };
+    knotOptions.buildMeshlets = true;
+    _knotMesh = _assetLoader.LoadMesh("OBJ/torusKnot.obj", AssetPriorityNormal, true, knotOptions);
+
+    // Editing any of these while the game runs reloads just that file (see HotReload)
+    _fileWatcher.Watch("DX11 Framework.fx");
+    _fileWatcher.Watch("Textures/Crate_COLOR.dds");
+    _fileWatcher.Watch("OBJ/flat plane.obj");
+    _fileWatcher.Watch("OBJ/torusKnot.obj");
+    _fileWatcher.Start();
 
 	return S_OK;
 }
@@ -124,43 +160,70 @@ HRESULT Application::InitShadersAndInputLayout()
 {
 	HRESULT hr;
 
-    // Compile the vertex shader
-    ID3DBlob* pVSBlob = nullptr;
-    hr = CompileShaderFromFile(L"DX11 Framework.fx", "VS", "vs_4_0", &pVSBlob);
+    // Compile the vertex, pixel and compact vertex shaders
+    CompiledShaders shaders = CompileShaders();
 
-    if (FAILED(hr))
+    if (!shaders.pVSBlob)
     {
         MessageBox(nullptr,
                    L"The FX file cannot be compiled.  Please run this executable from the directory that contains the FX file.", L"Error", MB_OK);
-        return hr;
+        return E_FAIL;
     }
 
-	// Create the vertex shader
-	hr = _pd3dDevice->CreateVertexShader(pVSBlob->GetBufferPointer(), pVSBlob->GetBufferSize(), nullptr, &_pVertexShader);
+    // Create the shaders and their input layouts
+    hr = CreateShaders(shaders);
+    ReleaseShaders(shaders);
 
 	if (FAILED(hr))
-	{	
-		pVSBlob->Release();
         return hr;
-	}
 
-	// Compile the pixel shader
-	ID3DBlob* pPSBlob = nullptr;
-    hr = CompileShaderFromFile(L"DX11 Framework.fx", "PS", "ps_4_0", &pPSBlob);
+    // Set the input layout
+    _pImmediateContext->IASetInputLayout(_pVertexLayout);
+
+	return hr;
+}
 
-    if (FAILED(hr))
+CompiledShaders Application::CompileShaders()
+{
+    // Nothing here uses the device, so it can run on another thread
+    CompiledShaders shaders = {};
+
+    if (FAILED(CompileShaderFromFile(L"DX11 Framework.fx", "VS", "vs_4_0", &shaders.pVSBlob)) ||
+        FAILED(CompileShaderFromFile(L"DX11 Framework.fx", "PS", "ps_4_0", &shaders.pPSBlob)) ||
+        FAILED(CompileShaderFromFile(L"DX11 Framework.fx", "VSCompact", "vs_4_0", &shaders.pCompactVSBlob)))
     {
-        MessageBox(nullptr,
-                   L"The FX file cannot be compiled.  Please run this executable from the directory that contains the FX file.", L"Error", MB_OK);
-        return hr;
+        ReleaseShaders(shaders);
     }
 
-	// Create the pixel shader
-	hr = _pd3dDevice->CreatePixelShader(pPSBlob->GetBufferPointer(), pPSBlob->GetBufferSize(), nullptr, &_pPixelShader);
-	pPSBlob->Release();
+    return shaders;
+}
 
-    if (FAILED(hr))
-        return hr;
+void Application::ReleaseShaders(CompiledShaders& shaders)
+{
+    if (shaders.pVSBlob) shaders.pVSBlob->Release();
+    if (shaders.pPSBlob) shaders.pPSBlob->Release();
+    if (shaders.pCompactVSBlob) shaders.pCompactVSBlob->Release();
+
+    shaders = CompiledShaders();
+}
+
+HRESULT Application::CreateShaders(const CompiledShaders& shaders)
+{
+	HRESULT hr;
+
+    // Everything is created before anything is replaced, so a shader that won't create leaves the old ones in use
+    ID3D11VertexShader* vertexShader = nullptr;
+    ID3D11PixelShader* pixelShader = nullptr;
+    ID3D11InputLayout* vertexLayout = nullptr;
+    ID3D11VertexShader* compactVertexShader = nullptr;
+    ID3D11InputLayout* compactVertexLayout = nullptr;
+
+	// Create the vertex shader
+	hr = _pd3dDevice->CreateVertexShader(shaders.pVSBlob->GetBufferPointer(), shaders.pVSBlob->GetBufferSize(), nullptr, &vertexShader);
+
+	// Create the pixel shader
+    if (SUCCEEDED(hr))
+        hr = _pd3dDevice->CreatePixelShader(shaders.pPSBlob->GetBufferPointer(), shaders.pPSBlob->GetBufferSize(), nullptr, &pixelShader);
 
     // Define the input layout
     D3D11_INPUT_ELEMENT_DESC layout[] =
@@ -173,15 +236,42 @@ HRESULT Application::InitShadersAndInputLayout()
 	UINT numElements = ARRAYSIZE(layout);
 
     // Create the input layout
-	hr = _pd3dDevice->CreateInputLayout(layout, numElements, pVSBlob->GetBufferPointer(),
-                                        pVSBlob->GetBufferSize(), &_pVertexLayout);
-	pVSBlob->Release();
+    if (SUCCEEDED(hr))
+        hr = _pd3dDevice->CreateInputLayout(layout, numElements, shaders.pVSBlob->GetBufferPointer(),
+                                            shaders.pVSBlob->GetBufferSize(), &vertexLayout);
 
-	if (FAILED(hr))
-        return hr;
+    // The vertex shader for meshes loaded with compact vertices
+    if (SUCCEEDED(hr))
+        hr = _pd3dDevice->CreateVertexShader(shaders.pCompactVSBlob->GetBufferPointer(), shaders.pCompactVSBlob->GetBufferSize(), nullptr,
+                                             &compactVertexShader);
 
-    // Set the input layout
-    _pImmediateContext->IASetInputLayout(_pVertexLayout);
+    // Matches CompactVertex in Structures.h
+    D3D11_INPUT_ELEMENT_DESC compactLayout[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+
+    if (SUCCEEDED(hr))
+        hr = _pd3dDevice->CreateInputLayout(compactLayout, ARRAYSIZE(compactLayout), shaders.pCompactVSBlob->GetBufferPointer(),
+                                            shaders.pCompactVSBlob->GetBufferSize(), &compactVertexLayout);
+
+    // Swap the new ones in, or throw away whatever was made if any of them failed
+    if (SUCCEEDED(hr))
+    {
+        std::swap(vertexShader, _pVertexShader);
+        std::swap(pixelShader, _pPixelShader);
+        std::swap(vertexLayout, _pVertexLayout);
+        std::swap(compactVertexShader, _pCompactVertexShader);
+        std::swap(compactVertexLayout, _pCompactVertexLayout);
+    }
+
+    if (vertexShader) vertexShader->Release();
+    if (pixelShader) pixelShader->Release();
+    if (vertexLayout) vertexLayout->Release();
+    if (compactVertexShader) compactVertexShader->Release();
+    if (compactVertexLayout) compactVertexLayout->Release();
 
 	return hr;
 }
@@ -393,9 +483,23 @@ HRESULT Application::InitDevice()
 void Application::Cleanup()
 {
     if (_pImmediateContext) _pImmediateContext->ClearState();
+
+    // Nothing more is reloaded, and a compile that's still going is waited for so its shaders can be released
+    _fileWatcher.Stop();
+
+    if (_shaderCompile.valid())
+    {
+        CompiledShaders shaders = _shaderCompile.get();
+        ReleaseShaders(shaders);
+    }
+
+    // The loader owns the textures and meshes, so they go before the device does
+    _assetLoader.Shutdown();
     if (_pConstantBuffer) _pConstantBuffer->Release();
     if (_pVertexLayout) _pVertexLayout->Release();
     if (_pVertexShader) _pVertexShader->Release();
+    if (_pCompactVertexLayout) _pCompactVertexLayout->Release();
+    if (_pCompactVertexShader) _pCompactVertexShader->Release();
     if (_pPixelShader) _pPixelShader->Release();
     if (_pRenderTargetView) _pRenderTargetView->Release();
     if (_pSwapChain) _pSwapChain->Release();
@@ -405,6 +509,8 @@ void Application::Cleanup()
     if (_depthStencilBuffer) _depthStencilBuffer->Release();
     if (_wireFrame) _wireFrame->Release();
     if (_solid) _solid->Release();
+
+    AssetPack::Unmount(&_assetPack);
 }
 
 void Application::Update()
@@ -433,6 +539,11 @@ void Application::Update()
     // For shader
     gTime = t;
 
+    // A couple of milliseconds a frame goes on creating whatever the loader has finished, so loads never cause a hitch
+    HotReload();
+    _assetLoader.Update();
+    TakeLoadedAssets();
+
     //
     // Animate the objects
     //
@@ -440,10 +551,16 @@ void Application::Update()
 
     // Change rasterizer state with a key press
     if (GetAsyncKeyState(VK_UP)) 
+    {
         _pImmediateContext->RSSetState(_wireFrame);
+        _wireFrameActive = true;
+    }
     
     if (GetAsyncKeyState(VK_DOWN)) 
+    {
         _pImmediateContext->RSSetState(_solid);
+        _wireFrameActive = false;
+    }
 }
 
 void Application::Draw()
@@ -462,16 +579,15 @@ void Application::Draw()
     XMMATRIX view;
     XMMATRIX projection;
 
+    Camera* activeCamera = &_camera;
+
     if (GetAsyncKeyState(0x31))
     {
-        view = XMLoadFloat4x4(&_camera2.getViewMatrix());
-        projection = XMLoadFloat4x4(&_camera2.getProjectionMatrix());
-    }
-    else
-    {
-        view = XMLoadFloat4x4(&_camera.getViewMatrix());
-        projection = XMLoadFloat4x4(&_camera.getProjectionMatrix());
+        activeCamera = &_camera2;
     }
+
+    view = XMLoadFloat4x4(&activeCamera->getViewMatrix());
+    projection = XMLoadFloat4x4(&activeCamera->getProjectionMatrix());
     //
     // Update variables
     //
@@ -493,12 +609,6 @@ void Application::Draw()
     cb.SpecularPower = specularPower;
     cb.EyePosW = _camera.getEye();
 
-    _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
-
-    // Switch to object mesh data buffers
-    _pImmediateContext->IASetVertexBuffers(0, 1, &objMeshData.VertexBuffer, &objMeshData.VBStride, &objMeshData.VBOffset);
-    _pImmediateContext->IASetIndexBuffer(objMeshData.IndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    
     //
     // Renders a triangle
     //
@@ -508,15 +618,193 @@ void Application::Draw()
 	_pImmediateContext->PSSetShader(_pPixelShader, nullptr, 0);
     _pImmediateContext->PSSetShaderResources(0, 1, &_pTextureRV);
     _pImmediateContext->PSSetSamplers(0, 1, &_pSamplerLinear);
-	_pImmediateContext->DrawIndexed(objMeshData.IndexCount, 0, 0); 
+    // Nothing covers more of the screen than the whole window, so the crate never needs mips bigger than that
+    _assetLoader.UseTexture(_crateTexture, _WindowWidth > _WindowHeight ? _WindowWidth : _WindowHeight);
+    // Full detail is culled a meshlet at a time, the simpler levels are cheap enough to just draw
+    if (objMeshData.VertexBuffer)
+    {
+        UINT lod = SelectLOD(objMeshData, _world, *activeCamera);
 
-    _pImmediateContext->IASetVertexBuffers(0, 1, &_plane.VertexBuffer, &_plane.VBStride, &_plane.VBOffset);
-    _pImmediateContext->IASetIndexBuffer(_plane.IndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
-    _pImmediateContext->DrawIndexed(_plane.IndexCount, 0, 0);
+        if (lod == 0 && !objMeshData.Meshlets.empty())
+            DrawMeshCulled(objMeshData, cb, _objCuller, _world, *activeCamera);
+        else
+            DrawMesh(objMeshData, cb, lod);
+    }
+
+    if (_plane.VertexBuffer)
+        DrawMesh(_plane, cb);
 
     //
     // Present our back buffer to our front buffer
     //
     _pSwapChain->Present(0, 0);
-}
\ No newline at end of file
+
+    // Textures that need to change size to keep within the budget are made again in the background
+    if (_assetLoader.EndFrame().texturesChanged > 0)
+        _assetLoader.ReportResidency();
+}
+
+void Application::TakeLoadedAssets()
+{
+    // The version goes up when an asset is loaded, each time it's reloaded and with each mip a streamed texture gains, and
+    // the old resources are gone by then
+    unsigned int version = _assetLoader.getVersion(_crateTexture);
+    if (version != _crateTextureVersion)
+    {
+        _pTextureRV = _assetLoader.getTexture(_crateTexture);
+        _crateTextureVersion = version;
+    }
+
+    version = _assetLoader.getVersion(_planeMesh);
+    if (version != _planeMeshVersion)
+    {
+        _plane = _assetLoader.getMesh(_planeMesh);
+        _planeMeshVersion = version;
+    }
+
+    version = _assetLoader.getVersion(_knotMesh);
+    if (version != _knotMeshVersion)
+    {
+        objMeshData = _assetLoader.getMesh(_knotMesh);
+        _knotMeshVersion = version;
+
+        _objCuller.Init(objMeshData.Meshlets);
+        ReportMeshletCulling();
+        _assetLoader.ReportRegistry();
+    }
+}
+
+void Application::HotReload()
+{
+    // Only the files that changed are reloaded, everything else carries on as it was
+    for (const std::string& filename : _fileWatcher.TakeChanges())
+    {
+        if (filename == "DX11 Framework.fx")
+            _shadersChanged = true;
+        else
+            _assetLoader.ReloadFile(filename.c_str());
+    }
+
+    // New shaders are swapped in between frames once they've compiled, and a mistake in the FX file keeps the old ones
+    if (_shaderCompile.valid() && _shaderCompile.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        CompiledShaders shaders = _shaderCompile.get();
+
+        if (shaders.pVSBlob && SUCCEEDED(CreateShaders(shaders)))
+            OutputDebugStringA("Application: reloaded DX11 Framework.fx\n");
+        else
+            OutputDebugStringA("Application: couldn't reload DX11 Framework.fx, keeping the shaders already loaded\n");
+
+        ReleaseShaders(shaders);
+    }
+
+    // One compile at a time, and changes made during one are picked up by the next
+    if (_shadersChanged && !_shaderCompile.valid())
+    {
+        _shadersChanged = false;
+        _shaderCompile = std::async(std::launch::async, [this]() { return CompileShaders(); });
+    }
+}
+
+UINT Application::SelectLOD(const MeshData& mesh, const XMFLOAT4X4& world, const Camera& camera)
+{
+    // LOD errors are in model space, so scale them by the biggest axis of the world matrix. The distance is to the
+    // middle of the mesh's bounding sphere, which isn't always its origin
+    XMFLOAT3 position = BoundingVolumes::Transform(mesh.Bounds, world).sphereCenter;
+    float scale = XMVectorGetX(XMVectorMax(XMVectorMax(
+        XMVector3Length(XMVectorSet(world._11, world._12, world._13, 0.0f)),
+        XMVector3Length(XMVectorSet(world._21, world._22, world._23, 0.0f))),
+        XMVector3Length(XMVectorSet(world._31, world._32, world._33, 0.0f))));
+
+    // Errors only get bigger down the chain, so take the last level that still looks right
+    for (UINT lod = (UINT)mesh.LODs.size() - 1; lod > 0; --lod)
+    {
+        if (camera.getProjectedSize(mesh.LODs[lod].Error * scale, position) <= _lodPixelError)
+            return lod;
+    }
+
+    return 0;
+}
+
+void Application::SetMeshState(MeshData& mesh, ConstantBuffer& cb, ID3D11Buffer* indexBuffer)
+{
+    // Compact meshes need their own vertex shader and layout, plus the scale and offset to get positions back out
+    cb.PosScale = XMFLOAT4(mesh.PosScale.x, mesh.PosScale.y, mesh.PosScale.z, 0.0f);
+    cb.PosOffset = XMFLOAT4(mesh.PosOffset.x, mesh.PosOffset.y, mesh.PosOffset.z, 0.0f);
+    _pImmediateContext->UpdateSubresource(_pConstantBuffer, 0, nullptr, &cb, 0, 0);
+
+    _pImmediateContext->VSSetShader(mesh.CompactVertices ? _pCompactVertexShader : _pVertexShader, nullptr, 0);
+    _pImmediateContext->IASetInputLayout(mesh.CompactVertices ? _pCompactVertexLayout : _pVertexLayout);
+
+    // Switch to the mesh's buffers, the index format depends on how many vertices the mesh has
+    _pImmediateContext->IASetVertexBuffers(0, 1, &mesh.VertexBuffer, &mesh.VBStride, &mesh.VBOffset);
+    _pImmediateContext->IASetIndexBuffer(indexBuffer, mesh.IndexFormat, 0);
+}
+
+void Application::DrawMesh(MeshData& mesh, ConstantBuffer& cb, UINT lod)
+{
+    SetMeshState(mesh, cb, mesh.IndexBuffer);
+
+    // Large meshes split for 16-bit indices are drawn one submesh at a time, and only the ranges for the chosen level of detail
+    for (const MeshDrawRange& range : mesh.LODs[lod].DrawRanges)
+    {
+        _pImmediateContext->DrawIndexed(range.IndexCount, range.IndexStart, range.BaseVertex);
+    }
+}
+
+void Application::DrawMeshCulled(MeshData& mesh, ConstantBuffer& cb, const MeshletCuller& culler, const XMFLOAT4X4& world, Camera& camera)
+{
+    XMFLOAT4X4 worldViewProjection;
+    XMFLOAT3 cameraPosition;
+    GetCullingInputs(world, camera, worldViewProjection, cameraPosition);
+
+    // The torus knot is closed, so when it's solid its backfaces are hidden behind its front faces anyway. In wireframe
+    // they show through, so they're kept
+    culler.Cull(worldViewProjection, cameraPosition, !_wireFrameActive, _visibleMeshlets);
+
+    // Copy the indices of the meshlets that survived into the dynamic index buffer and draw them in one go
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(_pImmediateContext->Map(mesh.CulledIndexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+        return;
+
+    UINT indexSize = mesh.IndexFormat == DXGI_FORMAT_R32_UINT ? sizeof(UINT) : sizeof(WORD);
+    UINT indexCount = culler.CompactIndices(_visibleMeshlets, mesh.MeshletIndices.data(), indexSize, mapped.pData);
+
+    _pImmediateContext->Unmap(mesh.CulledIndexBuffer, 0);
+
+    SetMeshState(mesh, cb, mesh.CulledIndexBuffer);
+    _pImmediateContext->DrawIndexed(indexCount, 0, 0);
+}
+
+void Application::GetCullingInputs(const XMFLOAT4X4& world, Camera& camera, XMFLOAT4X4& worldViewProjection, XMFLOAT3& cameraPosition)
+{
+    // Meshlets are culled in model space, so bring the camera into it rather than moving every meshlet out
+    XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
+    XMFLOAT4X4 view = camera.getViewMatrix();
+    XMFLOAT4X4 projection = camera.getProjectionMatrix();
+
+    XMStoreFloat4x4(&worldViewProjection, worldMatrix * XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+
+    XMFLOAT3 eye = camera.getEye();
+    XMStoreFloat3(&cameraPosition, XMVector3TransformCoord(XMLoadFloat3(&eye), XMMatrixInverse(nullptr, worldMatrix)));
+}
+
+void Application::ReportMeshletCulling()
+{
+    if (objMeshData.Meshlets.empty())
+        return;
+
+    // One cull from the first camera, whose matrices Update has already made this frame. Tools/MeshletCullBenchmark
+    // times the culler from both cameras
+    XMFLOAT4X4 worldViewProjection;
+    XMFLOAT3 cameraPosition;
+    GetCullingInputs(_world, _camera, worldViewProjection, cameraPosition);
+
+    MeshletCullStats stats;
+    _objCuller.Cull(worldViewProjection, cameraPosition, !_wireFrameActive, _visibleMeshlets, &stats);
+
+    char report[256];
+    sprintf_s(report, "Meshlet culling: %u of %u triangles rejected, %u of %u meshlets drawn\n",
+              stats.triangles - stats.trianglesVisible, stats.triangles, stats.meshletsVisible, stats.meshlets);
+    OutputDebugStringA(report);
+}
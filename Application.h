@@ -7,10 +7,15 @@
 #include <directxcolors.h>
 #include <stdlib.h>
 #include <time.h>
+#include <future>
 #include "resource.h"
 #include "DDSTextureLoader.h"
 #include "Structures.h"
 #include "OBJLoader.h"
+#include "AssetPack.h"
+#include "AssetLoader.h"
+#include "FileWatcher.h"
+#include "MeshletCuller.h"
 #include "Camera.h"
 
 using namespace DirectX;
@@ -33,6 +38,18 @@ struct ConstantBuffer
 	XMFLOAT4 SpecularLight;
 	XMFLOAT3 EyePosW;
 	float SpecularPower;
+
+	// Dequantization for meshes using CompactVertex, see MeshData
+	XMFLOAT4 PosScale;
+	XMFLOAT4 PosOffset;
+};
+
+// The shaders from the FX file, compiled but not yet created. All null if any of them didn't compile
+struct CompiledShaders
+{
+	ID3DBlob* pVSBlob;
+	ID3DBlob* pPSBlob;
+	ID3DBlob* pCompactVSBlob;
 };
 
 class Application
@@ -49,6 +66,8 @@ private:
 	ID3D11VertexShader*     _pVertexShader;
 	ID3D11PixelShader*      _pPixelShader;
 	ID3D11InputLayout*      _pVertexLayout;
+	ID3D11VertexShader*     _pCompactVertexShader;
+	ID3D11InputLayout*      _pCompactVertexLayout;
 
 	ID3D11Buffer*           _pConstantBuffer;
 	XMFLOAT4X4				_world;
@@ -60,6 +79,7 @@ private:
 	// Set up render states
 	ID3D11RasterizerState* _wireFrame;
 	ID3D11RasterizerState* _solid;
+	bool _wireFrameActive;			// Backfacing meshlets are only culled while the solid state is set
 
 	float gTime;
 
@@ -83,8 +103,35 @@ private:
 	MeshData objMeshData;
 	MeshData _plane;
 
+	// Mounted while the game runs, so anything loaded from it stays mapped
+	AssetPack _assetPack;
+
+	// Loads everything above off the main thread, the handles are for picking each one up once it's loaded
+	AssetLoader _assetLoader;
+	AssetHandle _crateTexture;
+	AssetHandle _planeMesh;
+	AssetHandle _knotMesh;
+
+	// What was last taken from the loader, so reloads are picked up when the version changes
+	unsigned int _crateTextureVersion;
+	unsigned int _planeMeshVersion;
+	unsigned int _knotMeshVersion;
+
+	// Edits to the FX file, textures and meshes are reloaded while the game runs. The FX file is compiled on another
+	// thread, and the new shaders swapped in between frames
+	FileWatcher _fileWatcher;
+	std::future<CompiledShaders> _shaderCompile;
+	bool _shadersChanged;
+
 	Camera _camera;
 	Camera _camera2;
+
+	// The simplest level of detail whose error covers no more than this many pixels on screen is drawn
+	float _lodPixelError;
+
+	// Meshlet culling for the torus knot at full detail, _visibleMeshlets is reused every frame
+	MeshletCuller _objCuller;
+	std::vector<unsigned int> _visibleMeshlets;
 	
 private:
 	HRESULT InitWindow(HINSTANCE hInstance, int nCmdShow);
@@ -92,6 +139,17 @@ private:
 	void Cleanup();
 	HRESULT CompileShaderFromFile(WCHAR* szFileName, LPCSTR szEntryPoint, LPCSTR szShaderModel, ID3DBlob** ppBlobOut);
 	HRESULT InitShadersAndInputLayout();
+	CompiledShaders CompileShaders();
+	void ReleaseShaders(CompiledShaders& shaders);
+	HRESULT CreateShaders(const CompiledShaders& shaders);
+	void HotReload();
+	void SetMeshState(MeshData& mesh, ConstantBuffer& cb, ID3D11Buffer* indexBuffer);
+	void DrawMesh(MeshData& mesh, ConstantBuffer& cb, UINT lod = 0);
+	void DrawMeshCulled(MeshData& mesh, ConstantBuffer& cb, const MeshletCuller& culler, const XMFLOAT4X4& world, Camera& camera);
+	UINT SelectLOD(const MeshData& mesh, const XMFLOAT4X4& world, const Camera& camera);
+	void GetCullingInputs(const XMFLOAT4X4& world, Camera& camera, XMFLOAT4X4& worldViewProjection, XMFLOAT3& cameraPosition);
+	void ReportMeshletCulling();
+	void TakeLoadedAssets();
 
 	UINT _WindowHeight;
 	UINT _WindowWidth;
@@ -0,0 +1,1191 @@
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "DDSFormat.h"
+#include "DDSTextureLoader.h"
+#include "MipGenerator.h"
+#include <algorithm>
+#include <stdio.h>
+
+namespace
+{
+	double Milliseconds()
+	{
+		static LARGE_INTEGER frequency = []() { LARGE_INTEGER f; QueryPerformanceFrequency(&f); return f; }();
+
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+
+		return now.QuadPart * 1000.0 / frequency.QuadPart;
+	}
+
+	//Reads a byte from every page, so the page faults happen on the worker rather than in the upload
+	void TouchPages(const uint8_t* data, size_t size)
+	{
+		volatile uint8_t sum = 0;
+
+		for (size_t i = 0; i < size; i += 4096)
+			sum += data[i];
+
+		//Which, when data doesn't start a page, steps over the start of the last one
+		if (size > 0)
+			sum += data[size - 1];
+	}
+
+	//Everything that changes what a load makes, so that only loads that would make the same thing are shared
+	std::string MeshKey(const char* filename, bool invertTexCoords, const OBJLoadOptions& options)
+	{
+		char settings[32];
+		sprintf_s(settings, "|%016llx", (unsigned long long)MeshCooker::SettingsHash(invertTexCoords, options));
+
+		return "mesh|" + AssetPack::NormalizePath(filename) + settings;
+	}
+
+	//A streamed texture isn't shared with a whole one, which would be handed out with only its smallest mips for a while
+	std::string TextureKey(const char* filename, size_t maxsize, bool forceSRGB, bool streaming)
+	{
+		char settings[32];
+		sprintf_s(settings, "|%llu|%d", (unsigned long long)maxsize, forceSRGB ? 1 : 0);
+
+		return (streaming ? "stream|" : "texture|") + AssetPack::NormalizePath(filename) + settings;
+	}
+
+	//Bytes of the buffers and the CPU copies kept alongside them
+	size_t MeshBytes(const CookedMeshInfo& info, const MeshData& mesh)
+	{
+		size_t bytes = (size_t)info.vertexStride * info.vertexCount + (size_t)info.indexSize * info.indexCount;
+
+		//The meshlet indices are in the culled index buffer as well as on the CPU
+		bytes += mesh.Meshlets.size() * sizeof(Meshlet) + mesh.MeshletIndices.size() * 2;
+
+		for (const MeshLOD& lod : mesh.LODs)
+			bytes += sizeof(MeshLOD) + lod.DrawRanges.size() * sizeof(MeshDrawRange);
+
+		return bytes;
+	}
+
+	void ReleaseMesh(MeshData& mesh)
+	{
+		if (mesh.VertexBuffer) mesh.VertexBuffer->Release();
+		if (mesh.IndexBuffer) mesh.IndexBuffer->Release();
+		if (mesh.CulledIndexBuffer) mesh.CulledIndexBuffer->Release();
+
+		mesh = MeshData();
+	}
+}
+
+AssetLoader::AssetLoader()
+{
+	_pd3dDevice = nullptr;
+	_preparedCapacity = 0;
+	_stopping = false;
+}
+
+AssetLoader::~AssetLoader()
+{
+	Shutdown();
+}
+
+void AssetLoader::Init(ID3D11Device* _pd3dDevice, unsigned int threadCount, size_t preparedCapacity)
+{
+	Shutdown();
+
+	this->_pd3dDevice = _pd3dDevice;
+	_preparedCapacity = std::max<size_t>(1, preparedCapacity);
+	_stopping = false;
+
+	if (threadCount == 0)
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	for (unsigned int i = 0; i < threadCount; ++i)
+		_workers.emplace_back(&AssetLoader::WorkerThread, this);
+}
+
+void AssetLoader::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_stopping = true;
+	}
+
+	_workAvailable.notify_all();
+	_preparedSpace.notify_all();
+
+	for (std::thread& worker : _workers)
+		worker.join();
+
+	_workers.clear();
+	_queue.clear();
+	_prepared.clear();
+	_unloading.clear();
+
+	for (RegistryShard& shard : _registry)
+	{
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+		shard.assets.clear();
+	}
+
+	//The slots are freed rather than cleared, so handles from before stay unloaded after another Init
+	for (RequestSlot& slot : _requests)
+	{
+		if (!slot.request)
+			continue;
+
+		Request& request = *slot.request;
+
+		if (request.status == AssetLoaded)
+		{
+			ReleaseMesh(request.mesh);
+
+			if (request.texture)
+				request.texture->Release();
+		}
+
+		_residency.Remove(request.residencyId);
+		Free(request);
+	}
+}
+
+AssetHandle AssetLoader::Add(std::unique_ptr<Request> request)
+{
+	request->status = AssetQueued;
+	request->reloading = false;
+	request->reloadAgain = false;
+	request->upgrading = false;
+	request->version = 0;
+	request->metrics = AssetLoadMetrics();
+	request->requestTime = Milliseconds();
+	request->preparedTime = 0.0;
+	request->firstRequestTime = request->requestTime;
+	request->streamProgress = TextureStreamProgress();
+	request->textureData = nullptr;
+	request->textureSize = 0;
+	request->textureBytes = 0;
+	request->textureReadBytes = 0;
+	request->textureMips = 0;
+	request->textureMipCount = 0;
+	request->textureWidth = 0;
+	request->textureHeight = 0;
+	request->textureInfo = DirectX::DDS_TEXTURE_INFO();
+	request->mesh = MeshData();
+	request->texture = nullptr;
+	request->residentBytes = 0;
+	request->residencyId = 0;
+	request->streamedMaxsize = 0;
+	request->residentMips = 0;
+
+	AssetHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		unsigned int slot;
+		if (!_freeSlots.empty())
+		{
+			slot = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+		else
+		{
+			slot = (unsigned int)_requests.size();
+			_requests.push_back(RequestSlot());
+			_requests.back().generation = 0;
+		}
+
+		handle = (_requests[slot].generation << HandleSlotBits) | (slot + 1);
+		request->handle = handle;
+
+		_requests[slot].request = std::move(request);
+		_queue.push_back(handle);
+	}
+
+	_workAvailable.notify_one();
+	return handle;
+}
+
+AssetHandle AssetLoader::Share(std::unique_ptr<Request> request)
+{
+	//The shard stays locked until the new asset is in it, so two threads asking for the same thing can't both load it
+	RegistryShard& shard = getShard(request->key);
+	std::lock_guard<std::mutex> shardLock(shard.lock);
+
+	auto found = shard.assets.find(request->key);
+	if (found != shard.assets.end())
+	{
+		Request& shared = *found->second;
+		++shared.references;
+
+		//Whoever wants it soonest decides how soon it's loaded
+		std::lock_guard<std::mutex> lock(_lock);
+		shared.priority = std::max(shared.priority, request->priority);
+
+		return shared.handle;
+	}
+
+	request->references = 1;
+	shard.assets[request->key] = request.get();
+
+	return Add(std::move(request));
+}
+
+AssetLoader::RegistryShard& AssetLoader::getShard(const std::string& key)
+{
+	return _registry[std::hash<std::string>()(key) % RegistryShardCount];
+}
+
+AssetLoader::Request* AssetLoader::getRequest(AssetHandle handle) const
+{
+	AssetHandle slot = handle & HandleSlotMask;
+	if (slot == 0 || slot > _requests.size())
+		return nullptr;
+
+	//Empty once the asset's been unloaded, or holding another asset with a handle of its own
+	Request* request = _requests[slot - 1].request.get();
+	return request && request->handle == handle ? request : nullptr;
+}
+
+AssetHandle AssetLoader::LoadMesh(const char* filename, AssetPriority priority, bool invertTexCoords, const OBJLoadOptions& options)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->isMesh = true;
+	request->filename = filename;
+	request->key = MeshKey(filename, invertTexCoords, options);
+	request->path = AssetPack::NormalizePath(filename);
+	request->invertTexCoords = invertTexCoords;
+	request->options = options;
+	request->maxsize = 0;
+	request->forceSRGB = false;
+	request->streaming = false;
+	request->priority = priority;
+
+	return Share(std::move(request));
+}
+
+AssetHandle AssetLoader::LoadTexture(const char* filename, AssetPriority priority, size_t maxsize, bool forceSRGB)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->isMesh = false;
+	request->filename = filename;
+	request->key = TextureKey(filename, maxsize, forceSRGB, false);
+	request->path = AssetPack::NormalizePath(filename);
+	request->invertTexCoords = false;
+	request->maxsize = maxsize;
+	request->forceSRGB = forceSRGB;
+	request->streaming = false;
+	request->priority = priority;
+
+	return Share(std::move(request));
+}
+
+AssetHandle AssetLoader::StreamTexture(const char* filename, AssetPriority priority, size_t firstMaxsize, bool forceSRGB)
+{
+	std::unique_ptr<Request> request(new Request());
+	request->isMesh = false;
+	request->filename = filename;
+	request->key = TextureKey(filename, firstMaxsize, forceSRGB, true);
+	request->path = AssetPack::NormalizePath(filename);
+	request->invertTexCoords = false;
+	request->maxsize = std::max<size_t>(1, firstMaxsize);
+	request->forceSRGB = forceSRGB;
+	request->streaming = true;
+	request->priority = priority;
+
+	return Share(std::move(request));
+}
+
+void AssetLoader::AddReference(AssetHandle handle)
+{
+	Request* request;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		request = getRequest(handle);
+	}
+
+	if (!request)
+		return;
+
+	//The key never changes once the request is made, so it can be read without the lock
+	std::lock_guard<std::mutex> shardLock(getShard(request->key).lock);
+
+	if (request->references > 0)
+		++request->references;
+}
+
+void AssetLoader::Release(AssetHandle handle)
+{
+	Request* request;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		request = getRequest(handle);
+	}
+
+	if (!request)
+		return;
+
+	{
+		RegistryShard& shard = getShard(request->key);
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+
+		if (request->references == 0 || --request->references > 0)
+			return;
+
+		//Gone from the registry straight away, so asking for it again loads it afresh rather than sharing what's being unloaded
+		shard.assets.erase(request->key);
+	}
+
+	std::lock_guard<std::mutex> lock(_lock);
+	_unloading.push_back(handle);
+}
+
+void AssetLoader::SetPriority(AssetHandle handle, AssetPriority priority)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (Request* request = getRequest(handle))
+		request->priority = priority;
+}
+
+bool AssetLoader::QueueReload(Request& request)
+{
+	//A streamed texture that's been edited is loaded whole from its file, rather than carrying on a mip at a time from a
+	//pack or the old version. Once it's whole the budget looks after it, and it's reloaded at the size it was given
+	bool wholeFromFile = request.streaming && request.reloading && request.residencyId == 0;
+
+	//Still to be read, so it'll be the new version anyway, as long as it's read from the file
+	if (std::find(_queue.begin(), _queue.end(), request.handle) != _queue.end())
+	{
+		if (wholeFromFile)
+			request.maxsize = 0;
+
+		//The texture's mips are from before the change, so none of them can be kept
+		request.upgrading = false;
+		request.residentMips = 0;
+		return false;
+	}
+
+	//Read already, maybe before the change, so have another go once it's done
+	if (request.status == AssetPreparing || request.status == AssetPrepared || request.reloading)
+	{
+		request.reloadAgain = true;
+		return false;
+	}
+
+	if (request.status != AssetLoaded && request.status != AssetFailed)
+		return false;
+
+	if (request.streaming && request.status == AssetLoaded && request.residencyId == 0)
+	{
+		request.maxsize = 0;
+		request.upgrading = false;
+	}
+
+	//A loaded asset keeps its status and resources until the new ones replace them, a failed one starts again
+	request.reloading = request.status == AssetLoaded;
+	request.status = request.reloading ? AssetLoaded : AssetQueued;
+	request.metrics = AssetLoadMetrics();
+	request.requestTime = Milliseconds();
+
+	_queue.push_back(request.handle);
+	return true;
+}
+
+void AssetLoader::Reload(AssetHandle handle)
+{
+	bool queued = false;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (Request* request = getRequest(handle))
+			queued = QueueReload(*request);
+	}
+
+	if (queued)
+		_workAvailable.notify_one();
+}
+
+unsigned int AssetLoader::ReloadFile(const char* filename)
+{
+	std::string path = AssetPack::NormalizePath(filename);
+	std::vector<AssetHandle> handles;
+
+	//The same file can be behind several assets, loaded with different options
+	for (RegistryShard& shard : _registry)
+	{
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+
+		for (const auto& asset : shard.assets)
+		{
+			if (asset.second->path == path)
+				handles.push_back(asset.second->handle);
+		}
+	}
+
+	for (AssetHandle handle : handles)
+		Reload(handle);
+
+	return (unsigned int)handles.size();
+}
+
+void AssetLoader::WorkerThread()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	while (true)
+	{
+		_workAvailable.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+
+		if (_stopping)
+			return;
+
+		//The first of the highest priority requests, so equal priorities go in the order they were asked for
+		auto next = _queue.begin();
+		for (auto i = _queue.begin(); i != _queue.end(); ++i)
+		{
+			if (getRequest(*i)->priority > getRequest(*next)->priority)
+				next = i;
+		}
+
+		AssetHandle handle = *next;
+		_queue.erase(next);
+
+		Request& request = *getRequest(handle);
+		bool reloading = request.reloading;
+		bool usePacks = !reloading || request.upgrading;
+
+		if (!reloading)
+			request.status = AssetPreparing;
+
+		lock.unlock();
+
+		//Nothing else touches the request while it's AssetPreparing (or reloading), apart from its metrics and status which stay
+		//behind the lock and the resources being handed out, which aren't touched here
+		double start = Milliseconds();
+		bool prepared = request.isMesh ? OBJLoader::Prepare(request.filename.c_str(), request.invertTexCoords, request.options, request.preparedMesh, usePacks)
+									   : PrepareTexture(request, usePacks);
+		double end = Milliseconds();
+
+		lock.lock();
+
+		request.preparedTime = end;
+		request.metrics.queuedMs = start - request.requestTime;
+		request.metrics.prepareMs = end - start;
+		request.metrics.mappedBytes = request.isMesh ? request.preparedMesh.mappedBytes : request.textureSize;
+
+		if (!prepared)
+		{
+			//A reload that fails leaves the version that was already loaded in place
+			request.status = reloading ? AssetLoaded : AssetFailed;
+			request.reloading = false;
+			request.upgrading = false;
+			request.residentMips = 0;
+			request.preparedMesh = PreparedMesh();
+			request.textureFile.reset();
+			request.generatedTexture = std::vector<uint8_t>();
+
+			char report[512];
+			sprintf_s(report, reloading ? "AssetLoader: couldn't reload %s, keeping the version already loaded\n" : "AssetLoader: couldn't load %s\n",
+					  request.filename.c_str());
+			OutputDebugStringA(report);
+
+			if (request.reloadAgain)
+			{
+				request.reloadAgain = false;
+				if (QueueReload(request))
+					_workAvailable.notify_one();
+			}
+
+			continue;
+		}
+
+		//Hold on to the prepared asset until there's room for it
+		_preparedSpace.wait(lock, [this]() { return _stopping || _prepared.size() < _preparedCapacity; });
+
+		if (_stopping)
+			return;
+
+		if (!reloading)
+			request.status = AssetPrepared;
+
+		_prepared.push_back(handle);
+	}
+}
+
+bool AssetLoader::PrepareTexture(Request& request, bool usePacks)
+{
+	//Straight out of a mounted pack if it's in one, otherwise mapped from its own file
+	request.textureData = usePacks ? AssetPack::Resolve(request.filename.c_str(), request.textureSize) : nullptr;
+
+	if (!request.textureData)
+	{
+		request.textureFile.reset(new MappedFile());
+
+		//A streamed texture's early steps only want a little of the file, so none of the rest should be read ahead
+		if (!request.textureFile->Open(request.filename.c_str(), !request.streaming || request.maxsize == 0))
+			return false;
+
+		request.textureData = request.textureFile->getData();
+		request.textureSize = request.textureFile->getSize();
+	}
+
+	//The same checks CreateDDSTextureFromMemory will make, so a bad file fails here rather than in Update
+	DirectX::DDS_TEXTURE_INFO info;
+	if (!DirectX::GetDDSTextureInfo(request.textureData, request.textureSize, info))
+		return false;
+
+	if (MipGenerator::NeedsMips(info) && (!PrepareMips(request, usePacks) || !DirectX::GetDDSTextureInfo(request.textureData, request.textureSize, info)))
+		return false;
+
+	//Once a step would keep every mip it's the last one
+	if (request.streaming && (info.mipCount <= 1 || request.maxsize >= std::max(info.width, std::max(info.height, info.depth))))
+		request.maxsize = 0;
+
+	//Where the mips CreateDDSTextureFromMemory will keep are, which are the only parts of the file it reads
+	std::unique_ptr<DirectX::DDS_SUBRESOURCE[]> subresources(new DirectX::DDS_SUBRESOURCE[info.mipCount * info.arraySize]);
+	size_t width, height, depth, skipMip;
+
+	size_t count = DirectX::FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, request.maxsize,
+											  request.textureSize - info.dataOffset, request.textureData + info.dataOffset, width, height, depth,
+											  skipMip, subresources.get());
+	if (count == 0)
+		return false;
+
+	request.textureBytes = 0;
+	request.textureReadBytes = 0;
+	request.textureMips = (unsigned int)(info.mipCount - skipMip);
+	request.textureMipCount = (unsigned int)info.mipCount;
+	request.textureWidth = width;
+	request.textureHeight = height;
+	request.textureInfo = info;
+
+	//A streaming step of a 2D texture only reads the mips it adds, and Create copies the rest from the texture it has
+	if (info.dimension != DirectX::DDS_DIMENSION_TEXTURE2D || request.residentMips >= request.textureMips)
+		request.residentMips = 0;
+
+	//FillSubresources gives each array slice's mips in turn, biggest first
+	unsigned int newMips = request.textureMips - request.residentMips;
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		request.textureBytes += subresources[i].bytes;
+
+		if (i % request.textureMips >= newMips)
+			continue;
+
+		if (request.textureFile)
+			request.textureFile->Prefetch(subresources[i].data - request.textureData, subresources[i].bytes);
+
+		request.textureReadBytes += subresources[i].bytes;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (i % request.textureMips < newMips)
+			TouchPages(subresources[i].data, subresources[i].bytes);
+	}
+
+	return true;
+}
+
+bool AssetLoader::PrepareMips(Request& request, bool usePacks)
+{
+	//Made with forceSRGB the same as the view will be created with, so they're filtered in the same space they're sampled in
+	MipOptions options;
+	options.srgb = request.forceSRGB;
+
+	//A mounted pack is looked in first, and what's in it is used without checking it against the source file, the same
+	//as OBJLoader does with cooked meshes
+	std::string cacheFilename = MipGenerator::getCacheFilename(request.filename, options);
+	size_t cacheSize = 0;
+	const uint8_t* packedCache = usePacks ? AssetPack::Resolve(cacheFilename.c_str(), cacheSize) : nullptr;
+
+	if (packedCache && MipGenerator::IsCacheOf(packedCache, cacheSize, nullptr, options))
+	{
+		request.textureFile.reset();
+		request.textureData = packedCache;
+		request.textureSize = cacheSize;
+		return true;
+	}
+
+	//Only a texture loaded from its own file has a cache next to it to check
+	if (request.textureFile)
+	{
+		std::unique_ptr<MappedFile> cacheFile(new MappedFile());
+
+		if (cacheFile->Open(cacheFilename.c_str(), !request.streaming || request.maxsize == 0) &&
+			MipGenerator::IsCacheOf(cacheFile->getData(), cacheFile->getSize(), request.filename.c_str(), options))
+		{
+			request.textureFile = std::move(cacheFile);
+			request.textureData = request.textureFile->getData();
+			request.textureSize = request.textureFile->getSize();
+			return true;
+		}
+	}
+
+	double start = Milliseconds();
+
+	if (!MipGenerator::GenerateDDS(request.textureData, request.textureSize, request.generatedTexture, options))
+		return false;
+
+	//Saved so the next load can skip all of it
+	bool saved = request.textureFile && MipGenerator::SaveCache(request.filename.c_str(), request.generatedTexture, options);
+
+	request.textureFile.reset();
+	request.textureData = request.generatedTexture.data();
+	request.textureSize = request.generatedTexture.size();
+
+	char report[512];
+	sprintf_s(report, "AssetLoader: %s has no mips, made them in %.2f ms%s\n", request.filename.c_str(), Milliseconds() - start,
+			  saved ? " and saved them for next time" : "");
+	OutputDebugStringA(report);
+
+	return true;
+}
+
+bool AssetLoader::CreateWithMoreMips(Request& request, ID3D11ShaderResourceView** outTexture)
+{
+	const DirectX::DDS_TEXTURE_INFO& info = request.textureInfo;
+	unsigned int newMips = request.textureMips - request.residentMips;
+
+	//Only the headers are looked at, so this reads nothing the worker didn't
+	std::unique_ptr<DirectX::DDS_SUBRESOURCE[]> subresources(new DirectX::DDS_SUBRESOURCE[info.mipCount * info.arraySize]);
+	size_t width, height, depth, skipMip;
+
+	if (DirectX::FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, request.maxsize,
+								  request.textureSize - info.dataOffset, request.textureData + info.dataOffset, width, height, depth,
+								  skipMip, subresources.get()) == 0)
+		return false;
+
+	ID3D11Resource* resource = nullptr;
+	ID3D11Texture2D* oldTexture = nullptr;
+	request.texture->GetResource(&resource);
+	HRESULT hr = resource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&oldTexture);
+	resource->Release();
+
+	if (FAILED(hr))
+		return false;
+
+	//The mips it has have to be the bottom ones of the new texture, which they won't be if DDSTextureLoader had to make
+	//it smaller than it was asked for
+	D3D11_TEXTURE2D_DESC desc;
+	oldTexture->GetDesc(&desc);
+
+	if (desc.MipLevels != request.residentMips || desc.ArraySize != info.arraySize ||
+		desc.Width != std::max<size_t>(1, width >> newMips) || desc.Height != std::max<size_t>(1, height >> newMips))
+	{
+		oldTexture->Release();
+		return false;
+	}
+
+	//Viewed the same way as before, sRGB or not, only with more mips
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	request.texture->GetDesc(&viewDesc);
+
+	switch (viewDesc.ViewDimension)
+	{
+	case D3D11_SRV_DIMENSION_TEXTURE2D: viewDesc.Texture2D.MipLevels = request.textureMips; break;
+	case D3D11_SRV_DIMENSION_TEXTURE2DARRAY: viewDesc.Texture2DArray.MipLevels = request.textureMips; break;
+	case D3D11_SRV_DIMENSION_TEXTURECUBE: viewDesc.TextureCube.MipLevels = request.textureMips; break;
+	case D3D11_SRV_DIMENSION_TEXTURECUBEARRAY: viewDesc.TextureCubeArray.MipLevels = request.textureMips; break;
+	default:
+		oldTexture->Release();
+		return false;
+	}
+
+	desc.Width = (UINT)width;
+	desc.Height = (UINT)height;
+	desc.MipLevels = request.textureMips;
+
+	ID3D11Texture2D* newTexture = nullptr;
+	if (FAILED(_pd3dDevice->CreateTexture2D(&desc, nullptr, &newTexture)))
+	{
+		oldTexture->Release();
+		return false;
+	}
+
+	//Update owns the device, so its immediate context is free to use here
+	ID3D11DeviceContext* context = nullptr;
+	_pd3dDevice->GetImmediateContext(&context);
+
+	for (UINT slice = 0; slice < desc.ArraySize; ++slice)
+	{
+		for (UINT mip = 0; mip < request.textureMips; ++mip)
+		{
+			UINT destination = D3D11CalcSubresource(mip, slice, request.textureMips);
+
+			if (mip < newMips)
+			{
+				const DirectX::DDS_SUBRESOURCE& subresource = subresources[slice * request.textureMips + mip];
+				context->UpdateSubresource(newTexture, destination, nullptr, subresource.data, (UINT)subresource.rowPitch,
+										   (UINT)subresource.slicePitch);
+			}
+			else
+			{
+				context->CopySubresourceRegion(newTexture, destination, 0, 0, 0, oldTexture,
+											   D3D11CalcSubresource(mip - newMips, slice, request.residentMips), nullptr);
+			}
+		}
+	}
+
+	context->Release();
+	oldTexture->Release();
+
+	hr = _pd3dDevice->CreateShaderResourceView(newTexture, &viewDesc, outTexture);
+	newTexture->Release();
+
+	return SUCCEEDED(hr);
+}
+
+void AssetLoader::Create(Request& request)
+{
+	double start = Milliseconds();
+	bool created;
+	size_t residentBytes;
+
+	//Made alongside whatever is loaded now, which is only swapped out if these are created
+	MeshData mesh = MeshData();
+	ID3D11ShaderResourceView* texture = nullptr;
+
+	if (request.isMesh)
+	{
+		//Empty, with nothing to release, if any of its buffers couldn't be created
+		mesh = OBJLoader::Create(_pd3dDevice, request.preparedMesh);
+		created = mesh.VertexBuffer != nullptr;
+		residentBytes = MeshBytes(request.preparedMesh.view.info, mesh);
+		request.preparedMesh = PreparedMesh();
+	}
+	else
+	{
+		created = request.residentMips > 0 && request.texture && CreateWithMoreMips(request, &texture);
+
+		if (!created)
+		{
+			//Whatever the worker didn't read is read now, as it's still mapped
+			if (request.residentMips > 0)
+				request.textureReadBytes = request.textureBytes;
+
+			created = SUCCEEDED(DirectX::CreateDDSTextureFromMemoryEx(_pd3dDevice, request.textureData, request.textureSize, request.maxsize,
+																	  D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, request.forceSRGB,
+																	  nullptr, &texture));
+		}
+
+		residentBytes = request.textureBytes;
+		request.residentMips = 0;
+		request.textureFile.reset();
+		request.textureData = nullptr;
+		request.generatedTexture = std::vector<uint8_t>();
+	}
+
+	double end = Milliseconds();
+
+	std::unique_lock<std::mutex> lock(_lock);
+	bool reloading = request.reloading;
+	MeshData oldMesh = MeshData();
+	ID3D11ShaderResourceView* oldTexture = nullptr;
+
+	if (created)
+	{
+		oldMesh = request.mesh;
+		oldTexture = request.texture;
+
+		request.mesh = mesh;
+		request.texture = texture;
+		request.residentBytes = residentBytes;
+		++request.version;
+	}
+
+	TextureStreamProgress& progress = request.streamProgress;
+	bool streamingOn = false;
+
+	if (created && !request.isMesh)
+	{
+		progress.mipsLoaded = request.textureMips;
+		progress.mipCount = request.textureMipCount;
+		progress.width = request.textureWidth;
+		progress.height = request.textureHeight;
+		progress.bytesRead += request.textureReadBytes;
+		progress.complete = progress.complete || !request.streaming || request.maxsize == 0;
+		request.streamedMaxsize = progress.complete ? 0 : request.maxsize;
+
+		if (progress.firstTextureMs == 0.0)
+			progress.firstTextureMs = end - request.firstRequestTime;
+
+		if (progress.complete && progress.completeMs == 0.0)
+			progress.completeMs = end - request.firstRequestTime;
+
+		//Unless nobody wants it any more, when it's waiting to be unloaded, or the budget has taken it over
+		streamingOn = request.streaming && !progress.complete && request.residencyId == 0 &&
+					  std::find(_unloading.begin(), _unloading.end(), request.handle) == _unloading.end();
+
+		//Once it's whole, or the budget took it over after a step failed, the budget decides how many of its mips it keeps
+		//(see EndFrame)
+		if (progress.complete || request.residencyId != 0)
+		{
+			if (request.residencyId == 0)
+				request.residencyId = _residency.Add(request.textureInfo, request.maxsize);
+			else
+				_residency.Loaded(request.residencyId, request.textureInfo, request.maxsize);
+
+			//The same mips, in the form getMaxsize gives, so EndFrame only remakes it when they change
+			request.maxsize = _residency.getMaxsize(request.residencyId);
+		}
+	}
+
+	request.status = created || reloading ? AssetLoaded : AssetFailed;
+	request.reloading = false;
+	request.upgrading = false;
+	request.metrics.waitingMs = start - request.preparedTime;
+	request.metrics.createMs = end - start;
+	request.metrics.totalMs = end - request.requestTime;
+
+	//Copied for the report, since either of these sends the request back to the workers
+	AssetLoadMetrics metrics = request.metrics;
+	TextureStreamProgress streamed = progress;
+
+	bool queued = false;
+	if (request.reloadAgain)
+	{
+		request.reloadAgain = false;
+		queued = QueueReload(request);
+	}
+	else if (streamingOn)
+	{
+		//The next step is prepared like a reload, keeping this one until it's created, and adds to the mips it has
+		request.maxsize *= 2;
+		request.reloading = true;
+		request.upgrading = true;
+		request.residentMips = request.textureMips;
+		request.metrics = AssetLoadMetrics();
+		request.requestTime = Milliseconds();
+
+		_queue.push_back(request.handle);
+		queued = true;
+	}
+
+	lock.unlock();
+
+	if (queued)
+		_workAvailable.notify_one();
+
+	//Whoever took the old version is told to stop using it by the version changing
+	ReleaseMesh(oldMesh);
+
+	if (oldTexture)
+		oldTexture->Release();
+
+	char report[512];
+	sprintf_s(report, "AssetLoader: %s %s in %.2f ms (%.2f queued, %.2f preparing, %.2f waiting, %.2f creating), %.1f KB mapped\n",
+			  request.filename.c_str(), created ? (reloading ? "reloaded" : "loaded") : "FAILED", metrics.totalMs, metrics.queuedMs,
+			  metrics.prepareMs, metrics.waitingMs, metrics.createMs, metrics.mappedBytes / 1024.0);
+	OutputDebugStringA(report);
+
+	if (created && request.streaming)
+	{
+		sprintf_s(report, "AssetLoader: %s streamed to %llu x %llu, %u of %u mips, %.1f KB read so far\n", request.filename.c_str(),
+				  (unsigned long long)streamed.width, (unsigned long long)streamed.height, streamed.mipsLoaded, streamed.mipCount,
+				  streamed.bytesRead / 1024.0);
+		OutputDebugStringA(report);
+	}
+}
+
+bool AssetLoader::Unload(Request& request)
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	//Anything a worker has hold of has to wait until it's been created
+	if (request.status == AssetPreparing || request.status == AssetPrepared || request.reloading)
+		return false;
+
+	if (request.status == AssetQueued)
+		_queue.erase(std::remove(_queue.begin(), _queue.end(), request.handle), _queue.end());
+
+	bool loaded = request.status == AssetLoaded;
+	request.status = AssetUnloaded;
+	request.residentBytes = 0;
+
+	_residency.Remove(request.residencyId);
+	request.residencyId = 0;
+
+	lock.unlock();
+
+	if (loaded)
+	{
+		ReleaseMesh(request.mesh);
+
+		if (request.texture)
+			request.texture->Release();
+
+		request.texture = nullptr;
+	}
+
+	return true;
+}
+
+void AssetLoader::Free(Request& request)
+{
+	std::unique_ptr<Request> freed;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		unsigned int index = (request.handle & HandleSlotMask) - 1;
+		RequestSlot& slot = _requests[index];
+
+		freed = std::move(slot.request);
+		slot.generation = (slot.generation + 1) & HandleGenerationMask;
+		_freeSlots.push_back(index);
+	}
+
+	//Deleted outside the lock, since that can mean closing its file
+}
+
+unsigned int AssetLoader::Update(double maxMilliseconds)
+{
+	double start = Milliseconds();
+	unsigned int finished = 0;
+
+	std::vector<Request*> unloading;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		for (AssetHandle handle : _unloading)
+			unloading.push_back(getRequest(handle));
+
+		_unloading.clear();
+	}
+
+	//Nothing in the loader refers to an unloaded asset any more, so its slot can go to the next request
+	for (Request* request : unloading)
+	{
+		if (Unload(*request))
+		{
+			Free(*request);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_unloading.push_back(request->handle);
+		}
+	}
+
+	do
+	{
+		Request* request;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+
+			if (_prepared.empty())
+				break;
+
+			request = getRequest(_prepared.front());
+			_prepared.pop_front();
+		}
+
+		_preparedSpace.notify_one();
+
+		Create(*request);
+		++finished;
+	} while (Milliseconds() - start < maxMilliseconds);
+
+	return finished;
+}
+
+void AssetLoader::WaitAll()
+{
+	while (true)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+
+			bool done = true;
+			for (const RequestSlot& slot : _requests)
+			{
+				const Request* request = slot.request.get();
+				done = done && (!request || (request->status == AssetLoaded && !request->reloading) || request->status == AssetFailed || request->status == AssetUnloaded);
+			}
+
+			if (done || _workers.empty())
+				return;
+		}
+
+		if (Update() == 0)
+			std::this_thread::yield();
+	}
+}
+
+void AssetLoader::SetTextureBudget(size_t budgetBytes)
+{
+	_residency.SetBudget(budgetBytes);
+}
+
+void AssetLoader::UseTexture(AssetHandle handle, size_t screenSize)
+{
+	unsigned int residencyId;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		Request* request = getRequest(handle);
+		residencyId = request ? request->residencyId : 0;
+	}
+
+	_residency.Use(residencyId, screenSize);
+}
+
+TextureResidencyStats AssetLoader::EndFrame()
+{
+	//A streamed texture whose last step failed, being read or created, isn't queued for another, and would be left with
+	//the mips it has. The budget takes it over from there instead, and gives it the rest like any other texture
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		for (const RequestSlot& slot : _requests)
+		{
+			Request* request = slot.request.get();
+
+			if (!request || !request->streaming || request->streamProgress.complete || request->residencyId != 0 ||
+				request->status != AssetLoaded || request->reloading)
+				continue;
+
+			request->residencyId = _residency.Add(request->textureInfo);
+			_residency.Loaded(request->residencyId, request->textureInfo, request->streamedMaxsize);
+			request->maxsize = _residency.getMaxsize(request->residencyId);
+
+			char report[512];
+			sprintf_s(report, "AssetLoader: %s stopped streaming at %u of %u mips, leaving the rest to the texture budget\n",
+					  request->filename.c_str(), request->streamProgress.mipsLoaded, request->streamProgress.mipCount);
+			OutputDebugStringA(report);
+		}
+	}
+
+	TextureResidencyStats stats = _residency.EndFrame();
+
+	//Any texture still being made at the size from an earlier frame gets its new one once that's done
+	bool queued = false;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+
+		for (const RequestSlot& slot : _requests)
+		{
+			Request* request = slot.request.get();
+
+			if (!request || request->residencyId == 0 || request->status != AssetLoaded || request->reloading)
+				continue;
+
+			size_t maxsize = _residency.getMaxsize(request->residencyId);
+			if (maxsize == request->maxsize)
+				continue;
+
+			//Made at the new size while the old one is still handed out, like a reload
+			request->maxsize = maxsize;
+			request->reloading = true;
+			request->upgrading = true;
+			request->metrics = AssetLoadMetrics();
+			request->requestTime = Milliseconds();
+
+			_queue.push_back(request->handle);
+			queued = true;
+		}
+	}
+
+	if (queued)
+		_workAvailable.notify_all();
+
+	return stats;
+}
+
+AssetStatus AssetLoader::getStatus(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	if (Request* request = getRequest(handle))
+		return request->status;
+
+	//Its slot has been freed since, and maybe used again
+	AssetHandle slot = handle & HandleSlotMask;
+	return slot != 0 && slot <= _requests.size() ? AssetUnloaded : AssetFailed;
+}
+
+unsigned int AssetLoader::getVersion(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Request* request = getRequest(handle);
+	return request ? request->version : 0;
+}
+
+AssetLoadMetrics AssetLoader::getMetrics(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Request* request = getRequest(handle);
+	return request ? request->metrics : AssetLoadMetrics();
+}
+
+TextureStreamProgress AssetLoader::getStreamProgress(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Request* request = getRequest(handle);
+	return request && !request->isMesh ? request->streamProgress : TextureStreamProgress();
+}
+
+AssetRegistryStats AssetLoader::getRegistryStats()
+{
+	AssetRegistryStats stats = {};
+
+	for (RegistryShard& shard : _registry)
+	{
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+		std::lock_guard<std::mutex> lock(_lock);
+
+		for (const auto& asset : shard.assets)
+		{
+			const Request& request = *asset.second;
+
+			++stats.assets;
+			stats.references += request.references;
+			stats.residentBytes += request.residentBytes;
+			stats.savedBytes += (request.references - 1) * request.residentBytes;
+		}
+	}
+
+	return stats;
+}
+
+void AssetLoader::ReportRegistry()
+{
+	AssetRegistryStats stats = getRegistryStats();
+
+	char report[256];
+	sprintf_s(report, "AssetLoader: %u assets shared by %u references, %.1f KB resident, %.1f KB saved by sharing\n", stats.assets,
+			  stats.references, stats.residentBytes / 1024.0, stats.savedBytes / 1024.0);
+	OutputDebugStringA(report);
+}
+
+void AssetLoader::ReportResidency()
+{
+	const TextureResidencyStats& stats = _residency.getStats();
+
+	char budget[64] = "no budget";
+	if (stats.budgetBytes != 0)
+		sprintf_s(budget, "a budget of %.1f MB", stats.budgetBytes / 1048576.0);
+
+	char report[512];
+	sprintf_s(report, "AssetLoader: frame %u, %.1f MB of textures resident with %s, %u of %u textures drawn taking %.1f MB of the %.1f MB "
+			  "they wanted, %u short of mips, %u mips dropped and %u restored\n", stats.frame, stats.residentBytes / 1048576.0, budget,
+			  stats.texturesUsed, stats.textures, stats.usedBytes / 1048576.0, stats.wantedBytes / 1048576.0, stats.texturesShort,
+			  stats.mipsDropped, stats.mipsRestored);
+	OutputDebugStringA(report);
+}
+
+MeshData AssetLoader::getMesh(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Request* request = getRequest(handle);
+	return request && request->status == AssetLoaded ? request->mesh : MeshData();
+}
+
+ID3D11ShaderResourceView* AssetLoader::getTexture(AssetHandle handle)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	Request* request = getRequest(handle);
+	return request && request->status == AssetLoaded ? request->texture : nullptr;
+}
@@ -0,0 +1,282 @@
+#pragma once
+//Its min and max macros would stop std::min and std::max compiling
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <d3d11_1.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "OBJLoader.h"
+#include "TextureResidency.h"
+
+//The low bits are the asset's slot in the loader and the rest how many times that slot has been used before, so a handle
+//kept after its asset was unloaded doesn't find whatever has the slot now. 0 is never handed out, so it can be used for
+//"nothing requested"
+typedef unsigned int AssetHandle;
+const AssetHandle InvalidAssetHandle = 0;
+
+enum AssetStatus
+{
+	AssetQueued,				//Waiting for a worker
+	AssetPreparing,				//Being read, parsed and decoded on a worker
+	AssetPrepared,				//Waiting for AssetLoader::Update to create its resources
+	AssetLoaded,
+	AssetFailed,
+	AssetUnloaded				//Every reference was released, and its resources with them. Stays that way for its handle
+};
+
+//Higher priorities are picked up by the workers first, requests with the same priority in the order they were made
+enum AssetPriority
+{
+	AssetPriorityLow,
+	AssetPriorityNormal,
+	AssetPriorityHigh
+};
+
+struct AssetLoadMetrics
+{
+	double queuedMs;			//From the request until a worker picked it up
+	double prepareMs;			//Reading, parsing and decoding on the worker
+	double waitingMs;			//Prepared, waiting for Update
+	double createMs;			//Creating the Direct3D resources in Update
+	double totalMs;
+	size_t mappedBytes;			//Of the file (or pack entry) it was loaded from
+};
+
+//How far a texture has got. One loaded with LoadTexture arrives whole, one with StreamTexture a mip at a time
+struct TextureStreamProgress
+{
+	unsigned int mipsLoaded;	//In the texture being handed out, 0 until there is one
+	unsigned int mipCount;		//In the file
+	size_t width;				//Of the biggest mip being handed out
+	size_t height;
+	size_t bytesRead;			//Of the file, for every step so far
+	double firstTextureMs;		//From the request until there was a texture to draw with
+	double completeMs;			//Until the whole texture was there, 0 until then
+	bool complete;
+};
+
+struct AssetRegistryStats
+{
+	unsigned int assets;		//Loaded or loading, each with its own resources
+	unsigned int references;	//Handed out for them, i.e. what would have been separate copies without sharing
+	size_t residentBytes;		//Of the loaded assets' resources, on the GPU and the CPU copies kept for them
+	size_t savedBytes;			//That the extra references would have taken as copies of their own
+};
+
+//Loads meshes and textures on a pool of worker threads. Requests return a handle straight away, and everything up to
+//creating the Direct3D resources (reading the file, cooking or mapping the mesh, checking the texture) happens on the
+//workers. The resources themselves are created by Update, on whichever thread owns the loader, so the device is only
+//ever used from there.
+//
+//Prepared assets wait in a queue of a fixed size, and workers stop preparing more while it's full, so a burst of loads
+//can't hold more than that many prepared assets in memory at once.
+//
+//Asking for the same file with the same options again shares the asset that's already there (or on its way) rather
+//than loading another copy. Each request counts a reference, and the asset is unloaded when the last one is released.
+//Lookups are spread over several separately locked maps, so many threads can ask for assets at once.
+//
+//A loaded asset can be reloaded from its file, after it's been edited. The new version is prepared on the workers like
+//any other load, and the old one is kept and handed out until Update has created the new one's resources, so nothing
+//drawing with it ever has to wait. If the new version can't be loaded the old one stays.
+//
+//A streamed texture is first created from only its smallest mips, then in steps of one more mip at a time until it's
+//whole, each step swapped in like a reload. A step only reads the part of the file holding the mip it adds, and the
+//smaller ones are copied across on the GPU from the texture it's replacing, so streaming a texture reads about as much
+//of the file as loading it whole. 1D and 3D textures read the smaller mips again each step.
+//
+//A texture saved with only its top mip has the rest made by MipGenerator on the worker, since DDSTextureLoader could
+//only make them on the GPU with a device context. They're saved next to the file, and used from there next time.
+//
+//Textures can be kept within a budget of GPU memory. Each frame the game says which it drew, and EndFrame has a
+//TextureResidency decide which of their biggest mips to leave out, the textures that have gone unused longest losing
+//theirs first. A texture that changes size is made again at the new size in the background and swapped in like a
+//reload. Streamed textures only count towards the budget once they're whole, or once a step has failed, when the budget
+//takes them over from the mips they have rather than leaving them there.
+class AssetLoader
+{
+private:
+	static const unsigned int RegistryShardCount = 16;
+
+	//Up to a million assets at once, each slot used 4096 times before a handle can come round again
+	static const unsigned int HandleSlotBits = 20;
+	static const AssetHandle HandleSlotMask = (1u << HandleSlotBits) - 1;
+	static const unsigned int HandleGenerationMask = (1u << (32 - HandleSlotBits)) - 1;
+
+	struct Request
+	{
+		bool isMesh;
+		std::string filename;
+		std::string key;				//Normalized path and everything else that changes the result
+		std::string path;				//Just the normalized path, for ReloadFile
+		AssetHandle handle;
+		bool invertTexCoords;
+		OBJLoadOptions options;
+		size_t maxsize;					//For a streamed texture, of the step being loaded, and 0 for the last. Once a texture
+										//is whole, whatever the budget gives it
+		bool forceSRGB;
+		bool streaming;
+		AssetPriority priority;
+		AssetStatus status;
+		bool reloading;					//Stays AssetLoaded with the old resources while the new ones are prepared
+		bool reloadAgain;				//Changed again after it was read, so reload it once this load is done
+		bool upgrading;					//Reloading at another size rather than because the file changed, so it can come from a pack
+		unsigned int version;			//Goes up each time it's created
+		AssetLoadMetrics metrics;
+		double requestTime;
+		double preparedTime;
+		double firstRequestTime;		//Of the first load, which reloads and streaming steps don't change
+		TextureStreamProgress streamProgress;
+
+		//Filled in by the worker
+		PreparedMesh preparedMesh;
+		std::unique_ptr<MappedFile> textureFile;
+		const uint8_t* textureData;		//Into textureFile, a mounted pack or generatedTexture
+		size_t textureSize;
+		std::vector<uint8_t> generatedTexture;	//A copy of a texture saved without its mips, with them made by MipGenerator
+		size_t textureBytes;			//Of the mips being kept
+		size_t textureReadBytes;		//Of those, what's read of the file, which for a streaming step is only the mips it adds
+		unsigned int textureMips;		//Being kept, of textureMipCount in the file
+		unsigned int textureMipCount;
+		size_t textureWidth;
+		size_t textureHeight;
+		DirectX::DDS_TEXTURE_INFO textureInfo;
+
+		//Filled in by Update
+		MeshData mesh;
+		ID3D11ShaderResourceView* texture;
+		size_t residentBytes;
+		unsigned int residencyId;		//In _residency once the texture is whole, 0 until then
+		size_t streamedMaxsize;			//Of the streaming step being handed out, while it isn't whole
+		unsigned int residentMips;		//In the texture a queued streaming step adds to, which Create copies rather than the
+										//worker reading them again. 0 for anything else
+
+		//Behind the lock of the registry shard the key is in
+		unsigned int references;
+	};
+
+	//Freed once the asset is unloaded, for the next request to use
+	struct RequestSlot
+	{
+		std::unique_ptr<Request> request;
+		unsigned int generation;		//Of the handle the next request in it gets
+	};
+
+	struct RegistryShard
+	{
+		std::mutex lock;
+		std::unordered_map<std::string, Request*> assets;
+	};
+
+	ID3D11Device* _pd3dDevice;
+	size_t _preparedCapacity;
+	bool _stopping;
+
+	std::mutex _lock;
+	std::condition_variable _workAvailable;
+	std::condition_variable _preparedSpace;
+
+	std::vector<std::thread> _workers;
+	std::vector<RequestSlot> _requests;					//Indexed by a handle's slot - 1
+	std::vector<unsigned int> _freeSlots;
+	std::vector<AssetHandle> _queue;					//Waiting for a worker
+	std::deque<AssetHandle> _prepared;					//Waiting for Update
+	std::vector<AssetHandle> _unloading;				//Released, waiting for Update to release their resources
+
+	RegistryShard _registry[RegistryShardCount];
+
+	//Only used on the thread that calls Update
+	TextureResidency _residency;
+
+	AssetHandle Share(std::unique_ptr<Request> request);
+	AssetHandle Add(std::unique_ptr<Request> request);
+	Request* getRequest(AssetHandle handle) const;
+	RegistryShard& getShard(const std::string& key);
+	bool QueueReload(Request& request);
+
+	void WorkerThread();
+	static bool PrepareTexture(Request& request, bool usePacks);
+	static bool PrepareMips(Request& request, bool usePacks);
+	bool CreateWithMoreMips(Request& request, ID3D11ShaderResourceView** outTexture);
+	void Create(Request& request);
+	bool Unload(Request& request);
+	void Free(Request& request);
+
+public:
+	AssetLoader();
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	//Starts the workers, one for each core but the one the game runs on if threadCount is 0
+	void Init(ID3D11Device* _pd3dDevice, unsigned int threadCount = 0, size_t preparedCapacity = 8);
+
+	//Stops the workers, abandoning anything that hasn't been loaded yet, and releases every asset's resources
+	void Shutdown();
+
+	//Each returns a new reference to the asset, to be released with Release
+	AssetHandle LoadMesh(const char* filename, AssetPriority priority = AssetPriorityNormal, bool invertTexCoords = true,
+						 const OBJLoadOptions& options = OBJLoadOptions());
+	AssetHandle LoadTexture(const char* filename, AssetPriority priority = AssetPriorityNormal, size_t maxsize = 0, bool forceSRGB = false);
+
+	//Loads the texture's mips no bigger than firstMaxsize first, so there's something to draw with as soon as possible,
+	//then the rest one at a time. Each step changes the version. Textures without mips arrive whole
+	AssetHandle StreamTexture(const char* filename, AssetPriority priority = AssetPriorityNormal, size_t firstMaxsize = 64, bool forceSRGB = false);
+
+	//Can be called from any thread, while the caller still holds a reference. The resources are released by Update, once
+	//the last reference is gone, and the handle's slot goes to the next request
+	void AddReference(AssetHandle handle);
+	void Release(AssetHandle handle);
+
+	//Only makes a difference while the asset is still queued
+	void SetPriority(AssetHandle handle, AssetPriority priority);
+
+	//Loads the asset again from its file, skipping any mounted packs, and swaps it in once it's been created. A failed
+	//asset is tried again, and a streamed texture is loaded whole. Can be called from any thread
+	void Reload(AssetHandle handle);
+
+	//Reloads every asset loaded from filename, however it was loaded. Returns how many there were
+	unsigned int ReloadFile(const char* filename);
+
+	//Creates the resources for prepared assets, on the calling thread, until there are none left or maxMilliseconds have
+	//gone by, after releasing those of any assets that have been unloaded. Returns how many it finished
+	unsigned int Update(double maxMilliseconds = 2.0);
+
+	//Keeps the textures within budgetBytes of GPU memory, 0 (the default) for no limit. Every texture keeps at least its
+	//mips up to 64 across, so with too many textures for the budget it's gone over
+	void SetTextureBudget(size_t budgetBytes);
+
+	//Marks the texture as drawn this frame. screenSize is the most pixels across the screen it covers, so mips bigger than
+	//that aren't needed, 0 to want them all. On the thread that calls Update
+	void UseTexture(AssetHandle handle, size_t screenSize = 0);
+
+	//Once a frame, after the textures drawn in it have been used. Decides which mips each texture keeps and starts
+	//making any that change size again, to be swapped in by Update. Returns how the budget went this frame
+	TextureResidencyStats EndFrame();
+
+	//Keeps calling Update until everything requested so far, reloads included, has loaded or failed
+	void WaitAll();
+
+	AssetStatus getStatus(AssetHandle handle);
+
+	//0 until it's loaded, then one more each time it's reloaded, so a change of version means the resources have changed
+	unsigned int getVersion(AssetHandle handle);
+	AssetLoadMetrics getMetrics(AssetHandle handle);
+	TextureStreamProgress getStreamProgress(AssetHandle handle);
+	AssetRegistryStats getRegistryStats();
+	void ReportRegistry();
+	void ReportResidency();
+
+	//Once the asset is AssetLoaded. The resources belong to the loader, and stay good until the asset's last reference is
+	//released or its version changes
+	MeshData getMesh(AssetHandle handle);
+	ID3D11ShaderResourceView* getTexture(AssetHandle handle);
+};
@@ -0,0 +1,292 @@
+#include "AssetPack.h"
+#include "MeshCache.h"
+#include <algorithm>
+#include <ctype.h>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+
+using namespace AssetPackFormat;
+
+namespace
+{
+	const uint32_t MaxEntries = 1 << 24;
+
+	std::mutex mountLock;
+	std::vector<const AssetPack*> mountedPacks;
+
+	uint64_t TableChecksum(AssetPackHeader header, const AssetPackEntry* entries, const char* names)
+	{
+		header.tableChecksum = 0;
+
+		uint64_t hash = MeshCache::Hash64(&header, sizeof(header));
+		hash = MeshCache::Hash64(entries, header.entryCount * sizeof(AssetPackEntry), hash);
+		return MeshCache::Hash64(names, (size_t)header.namesSize, hash);
+	}
+
+	uint64_t AlignUp(uint64_t offset)
+	{
+		return (offset + EntryAlignment - 1) / EntryAlignment * EntryAlignment;
+	}
+
+	//Pads the file with zeros up to offset
+	bool PadTo(FILE* file, uint64_t& position, uint64_t offset)
+	{
+		static const uint8_t zeros[EntryAlignment] = {};
+
+		size_t padding = (size_t)(offset - position);
+		position = offset;
+
+		return padding == 0 || fwrite(zeros, padding, 1, file) == 1;
+	}
+}
+
+AssetPack::AssetPack() : _entries(nullptr), _entryCount(0), _names(nullptr)
+{
+}
+
+bool AssetPack::Open(const char* filename)
+{
+	Close();
+
+	if (!_file.Open(filename))
+		return false;
+
+	const uint8_t* data = _file.getData();
+	uint64_t fileSize = _file.getSize();
+
+	if (fileSize < sizeof(AssetPackHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const AssetPackHeader& header = *(const AssetPackHeader*)data;
+
+	if (header.magic != Magic || header.version != Version || header.headerSize != sizeof(AssetPackHeader) || header.byteOrder != ByteOrderMark ||
+		header.entryCount > MaxEntries || fileSize < sizeof(AssetPackHeader) + (uint64_t)header.entryCount * sizeof(AssetPackEntry) ||
+		header.namesOffset > fileSize || header.namesSize > fileSize - header.namesOffset)
+	{
+		Close();
+		return false;
+	}
+
+	const AssetPackEntry* entries = (const AssetPackEntry*)(data + sizeof(AssetPackHeader));
+	const char* names = (const char*)(data + header.namesOffset);
+
+	if (TableChecksum(header, entries, names) != header.tableChecksum)
+	{
+		Close();
+		return false;
+	}
+
+	//With the table known to be intact, only a pack written wrongly could point outside the file, but it's cheap to be sure
+	for (uint32_t i = 0; i < header.entryCount; ++i)
+	{
+		if (entries[i].offset > fileSize || entries[i].size > fileSize - entries[i].offset ||
+			(uint64_t)entries[i].nameOffset + entries[i].nameLength > header.namesSize)
+		{
+			Close();
+			return false;
+		}
+	}
+
+	_entries = entries;
+	_entryCount = header.entryCount;
+	_names = names;
+
+	return true;
+}
+
+void AssetPack::Close()
+{
+	_file.Close();
+	_entries = nullptr;
+	_entryCount = 0;
+	_names = nullptr;
+}
+
+const uint8_t* AssetPack::Find(const char* path, size_t& outSize) const
+{
+	if (!isOpen())
+		return nullptr;
+
+	std::string name = NormalizePath(path);
+	uint64_t hash = MeshCache::Hash64(name.data(), name.size());
+
+	//Entries are sorted by hash, and any that share one are next to each other
+	const AssetPackEntry* end = _entries + _entryCount;
+	const AssetPackEntry* entry = std::lower_bound(_entries, end, hash, [](const AssetPackEntry& e, uint64_t h) { return e.pathHash < h; });
+
+	for (; entry != end && entry->pathHash == hash; ++entry)
+	{
+		if (entry->nameLength == name.size() && memcmp(_names + entry->nameOffset, name.data(), name.size()) == 0)
+		{
+			outSize = (size_t)entry->size;
+			return _file.getData() + entry->offset;
+		}
+	}
+
+	return nullptr;
+}
+
+uint32_t AssetPack::Verify() const
+{
+	uint32_t failures = 0;
+
+	for (uint32_t i = 0; i < _entryCount; ++i)
+	{
+		if (MeshCache::Hash64(_file.getData() + _entries[i].offset, (size_t)_entries[i].size) != _entries[i].checksum)
+			++failures;
+	}
+
+	return failures;
+}
+
+std::string AssetPack::getEntryPath(uint32_t index) const
+{
+	return std::string(_names + _entries[index].nameOffset, _entries[index].nameLength);
+}
+
+std::string AssetPack::NormalizePath(const char* path)
+{
+	while (path[0] == '.' && (path[1] == '/' || path[1] == '\\'))
+		path += 2;
+
+	std::string normalized = path;
+
+	for (char& c : normalized)
+		c = c == '\\' ? '/' : (char)tolower((unsigned char)c);
+
+	return normalized;
+}
+
+bool AssetPack::Build(const char* filename, const char* folder, const std::vector<std::string>& paths)
+{
+	//Lay out the table of contents first, so the contents can be streamed straight after it
+	std::vector<AssetPackEntry> entries(paths.size());
+	std::vector<std::string> names(paths.size());
+	std::string nameData;
+
+	for (size_t i = 0; i < paths.size(); ++i)
+	{
+		names[i] = NormalizePath(paths[i].c_str());
+
+		entries[i].pathHash = MeshCache::Hash64(names[i].data(), names[i].size());
+		entries[i].nameOffset = (uint32_t)nameData.size();
+		entries[i].nameLength = (uint32_t)names[i].size();
+		entries[i].checksum = 0;
+		nameData += names[i];
+	}
+
+	std::vector<size_t> order(paths.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	std::sort(order.begin(), order.end(), [&entries](size_t a, size_t b) { return entries[a].pathHash < entries[b].pathHash; });
+
+	for (size_t i = 1; i < order.size(); ++i)
+	{
+		if (names[order[i]] == names[order[i - 1]])
+			return false;
+	}
+
+	AssetPackHeader header = {};
+	header.magic = Magic;
+	header.version = Version;
+	header.headerSize = sizeof(AssetPackHeader);
+	header.byteOrder = ByteOrderMark;
+	header.entryCount = (uint32_t)paths.size();
+	header.namesOffset = sizeof(AssetPackHeader) + paths.size() * sizeof(AssetPackEntry);
+	header.namesSize = nameData.size();
+
+	std::string temporaryFilename = MeshCache::getTemporaryFilename(filename);
+	FILE* file = fopen(temporaryFilename.c_str(), "wb");
+
+	if (!file)
+		return false;
+
+	//The header and table are written once with the checksums still missing, then again at the end
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+				   (entries.empty() || fwrite(entries.data(), entries.size() * sizeof(AssetPackEntry), 1, file) == 1) &&
+				   (nameData.empty() || fwrite(nameData.data(), nameData.size(), 1, file) == 1);
+
+	uint64_t position = header.namesOffset + header.namesSize;
+
+	for (size_t i = 0; i < paths.size() && written; ++i)
+	{
+		AssetPackEntry& entry = entries[i];
+		entry.offset = AlignUp(position);
+		entry.size = 0;
+
+		std::string sourceFilename = std::string(folder) + "/" + paths[i];
+		MeshSourceInfo source;
+
+		if (!MeshCache::GetSourceInfo(sourceFilename.c_str(), source, false))
+		{
+			written = false;
+			break;
+		}
+
+		written = PadTo(file, position, entry.offset);
+
+		//Empty files can't be mapped, but they can still be in the pack
+		if (source.size > 0 && written)
+		{
+			MappedFile contents;
+			written = contents.Open(sourceFilename.c_str()) && fwrite(contents.getData(), contents.getSize(), 1, file) == 1;
+
+			entry.size = contents.getSize();
+			entry.checksum = MeshCache::Hash64(contents.getData(), contents.getSize());
+			position += entry.size;
+		}
+		else
+			entry.checksum = MeshCache::Hash64(nullptr, 0);
+	}
+
+	//End on an alignment boundary too, so the last entry can be mapped a page at a time
+	written = written && PadTo(file, position, AlignUp(position));
+
+	std::vector<AssetPackEntry> sortedEntries;
+	for (size_t i : order)
+		sortedEntries.push_back(entries[i]);
+
+	header.tableChecksum = TableChecksum(header, sortedEntries.data(), nameData.data());
+
+	written = written && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1 &&
+			  (sortedEntries.empty() || fwrite(sortedEntries.data(), sortedEntries.size() * sizeof(AssetPackEntry), 1, file) == 1);
+	written = fclose(file) == 0 && written;
+
+	if (!written)
+	{
+		remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	return MeshCache::RenameOver(temporaryFilename.c_str(), filename);
+}
+
+void AssetPack::Mount(const AssetPack* pack)
+{
+	std::lock_guard<std::mutex> lock(mountLock);
+	mountedPacks.insert(mountedPacks.begin(), pack);
+}
+
+void AssetPack::Unmount(const AssetPack* pack)
+{
+	std::lock_guard<std::mutex> lock(mountLock);
+	mountedPacks.erase(std::remove(mountedPacks.begin(), mountedPacks.end(), pack), mountedPacks.end());
+}
+
+const uint8_t* AssetPack::Resolve(const char* path, size_t& outSize)
+{
+	std::lock_guard<std::mutex> lock(mountLock);
+
+	for (const AssetPack* pack : mountedPacks)
+	{
+		if (const uint8_t* data = pack->Find(path, outSize))
+			return data;
+	}
+
+	return nullptr;
+}
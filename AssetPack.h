@@ -0,0 +1,92 @@
+#pragma once
+#include "MappedFile.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//One file holding many assets, so starting the game opens and maps one file rather than one (or two, for a mesh and its
+//cache) per asset. The layout is:
+//
+//	AssetPackHeader			magic, version, byte order, entry count, where the table of contents is
+//	AssetPackEntry[]		the table of contents, sorted by the hash of each entry's path
+//	names					each entry's path, so a hash collision can be told apart from a match
+//	entries					the contents of each file, each starting on an EntryAlignment boundary
+//
+//Entries start on page boundaries so that the caches in them can be used in place exactly like a mapped cache file.
+//Paths are stored normalized (lower case, / between folders), so "Textures\Crate_COLOR.dds" and
+//"textures/crate_color.dds" find the same entry.
+namespace AssetPackFormat
+{
+	const uint32_t Magic = 0x4b415041;			//"APAK"
+	const uint16_t Version = 1;
+	const uint32_t ByteOrderMark = 0x01020304;
+	const uint32_t EntryAlignment = 4096;
+
+	struct AssetPackHeader
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t headerSize;
+		uint32_t byteOrder;
+		uint32_t entryCount;
+
+		uint64_t namesOffset;
+		uint64_t namesSize;
+		uint64_t tableChecksum;		//Hash of the header (with this as 0), the table of contents and the names
+	};
+
+	struct AssetPackEntry
+	{
+		uint64_t pathHash;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t checksum;			//Of the entry's contents, only checked by AssetPack::Verify since it means reading all of it
+		uint32_t nameOffset;		//Into the names
+		uint32_t nameLength;
+	};
+};
+
+class AssetPack
+{
+private:
+	MappedFile _file;
+	const AssetPackFormat::AssetPackEntry* _entries;
+	uint32_t _entryCount;
+	const char* _names;
+
+public:
+	AssetPack();
+
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	//Maps the pack and checks its header and table of contents, returns false if it's missing or isn't a valid pack
+	bool Open(const char* filename);
+	void Close();
+
+	//Points at the contents of path inside the mapping, without copying anything. Returns nullptr if it isn't in the pack
+	const uint8_t* Find(const char* path, size_t& outSize) const;
+
+	//Checks every entry against its checksum, returning how many don't match
+	uint32_t Verify() const;
+
+	bool isOpen() const { return _file.isOpen(); }
+	uint32_t getEntryCount() const { return _entryCount; }
+	std::string getEntryPath(uint32_t index) const;
+	uint64_t getEntrySize(uint32_t index) const { return _entries[index].size; }
+
+	//Lower case with / between folders and no leading ./, the form paths are hashed and stored in
+	static std::string NormalizePath(const char* path);
+
+	//Writes the files at paths (relative to folder) into a new pack, through a temporary file that's renamed over
+	//filename once it's complete, like MeshCache::Save
+	static bool Build(const char* filename, const char* folder, const std::vector<std::string>& paths);
+
+	//Packs that Resolve looks in, the most recently mounted first. A mounted pack has to stay open until it's unmounted
+	static void Mount(const AssetPack* pack);
+	static void Unmount(const AssetPack* pack);
+
+	//Looks for path in the mounted packs, returns nullptr if none of them has it and it should be read from its own file
+	static const uint8_t* Resolve(const char* path, size_t& outSize);
+};
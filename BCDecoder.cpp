@@ -0,0 +1,964 @@
+#include "BCDecoder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BCDECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX2__
+#define BCDECODER_AVX2
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	enum BlockKind { KindBC1, KindBC2, KindBC3, KindBC4, KindBC4Signed, KindBC5, KindBC5Signed, KindBC7, KindUnsupported };
+
+	BlockKind getKind(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_TYPELESS:
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return KindBC1;
+
+		case DXGI_FORMAT_BC2_TYPELESS:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+			return KindBC2;
+
+		case DXGI_FORMAT_BC3_TYPELESS:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return KindBC3;
+
+		case DXGI_FORMAT_BC4_TYPELESS:
+		case DXGI_FORMAT_BC4_UNORM:
+			return KindBC4;
+
+		case DXGI_FORMAT_BC4_SNORM:
+			return KindBC4Signed;
+
+		case DXGI_FORMAT_BC5_TYPELESS:
+		case DXGI_FORMAT_BC5_UNORM:
+			return KindBC5;
+
+		case DXGI_FORMAT_BC5_SNORM:
+			return KindBC5Signed;
+
+		case DXGI_FORMAT_BC7_TYPELESS:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return KindBC7;
+
+		default:
+			return KindUnsupported;
+		}
+	}
+
+	size_t KindBlockBytes(BlockKind kind)
+	{
+		return kind == KindUnsupported ? 0 : kind == KindBC1 || kind == KindBC4 || kind == KindBC4Signed ? 8 : 16;
+	}
+
+	//Texels are handled as uint32_t, R in the lowest byte, which is how RGBA bytes load on every platform the framework
+	//runs on
+	inline uint32_t Load32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Load64(const uint8_t* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	inline void Store32(uint8_t* data, uint32_t value)
+	{
+		memcpy(data, &value, sizeof(value));
+	}
+
+	//BC7's modes: subsets, then bits of partition, rotation, index selection, colour and alpha endpoints, then whether each
+	//endpoint or each subset has a p-bit, then bits of each index and of the second set of indices
+	struct BC7Mode
+	{
+		unsigned int subsets;
+		unsigned int partitionBits;
+		unsigned int rotationBits;
+		unsigned int indexSelectionBits;
+		unsigned int colorBits;
+		unsigned int alphaBits;
+		unsigned int endpointPBits;
+		unsigned int sharedPBits;
+		unsigned int indexBits;
+		unsigned int indexBits2;
+	};
+
+	const BC7Mode BC7Modes[8] =
+	{
+		{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+		{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+		{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+		{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+		{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+		{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+		{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+		{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+	};
+
+	const uint8_t BC7Weights2[4] = { 0, 21, 43, 64 };
+	const uint8_t BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	const uint8_t BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	const uint8_t* BC7Weights(unsigned int indexBits)
+	{
+		return indexBits == 2 ? BC7Weights2 : indexBits == 3 ? BC7Weights3 : BC7Weights4;
+	}
+
+	//The subset each texel is in, for each partition
+	const uint8_t BC7Partitions1[16] = {};
+
+	const uint8_t BC7Partitions2[64][16] =
+	{
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1 }, { 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1 }, { 0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 1, 1 }, { 0, 0, 1, 1, 0, 1, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1 }, { 0, 0, 1, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1 },
+		{ 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1, 1 }, { 0, 1, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0 }, { 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0 },
+		{ 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 }, { 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0 }, { 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 1 },
+		{ 0, 0, 1, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0 }, { 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 0, 0 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0 }, { 0, 0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0 },
+		{ 0, 0, 0, 1, 0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0 },
+		{ 0, 1, 1, 1, 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0 }, { 0, 0, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 }, { 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1 },
+		{ 0, 1, 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0 }, { 0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0 },
+		{ 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0 }, { 0, 1, 0, 1, 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0 },
+		{ 0, 1, 1, 0, 1, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0, 1 }, { 0, 1, 0, 1, 1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 0, 1 },
+		{ 0, 1, 1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 1, 0 }, { 0, 0, 0, 1, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0, 0, 0 },
+		{ 0, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1, 0, 0 }, { 0, 0, 1, 1, 1, 0, 1, 1, 1, 1, 0, 1, 1, 1, 0, 0 },
+		{ 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 }, { 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 1, 1 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1 }, { 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0, 0 },
+		{ 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0, 0 }, { 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0, 0, 0, 0 },
+		{ 0, 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0 }, { 0, 0, 0, 0, 0, 1, 0, 0, 1, 1, 1, 0, 0, 1, 0, 0 },
+		{ 0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1, 0, 0, 1, 1 }, { 0, 0, 1, 1, 0, 1, 1, 0, 1, 1, 0, 0, 1, 0, 0, 1 },
+		{ 0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0 }, { 0, 0, 1, 1, 1, 0, 0, 1, 1, 1, 0, 0, 0, 1, 1, 0 },
+		{ 0, 1, 1, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 0, 0, 1 }, { 0, 1, 1, 0, 0, 0, 1, 1, 0, 0, 1, 1, 1, 0, 0, 1 },
+		{ 0, 1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1 }, { 0, 0, 0, 1, 1, 0, 0, 0, 1, 1, 1, 0, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0 },
+		{ 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 1, 0, 1, 1, 1, 0 }, { 0, 1, 0, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 1, 1 },
+	};
+
+	const uint8_t BC7Partitions3[64][16] =
+	{
+		{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 }, { 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 }, { 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+		{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 }, { 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+		{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 }, { 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+		{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 }, { 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+		{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 }, { 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 }, { 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+		{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 }, { 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+		{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 }, { 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+		{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 }, { 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+		{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 }, { 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+		{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 }, { 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 }, { 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+		{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 }, { 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+		{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 }, { 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+		{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 }, { 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+		{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 }, { 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+		{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 }, { 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 }, { 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+		{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 }, { 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+		{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 }, { 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 }, { 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+		{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+		{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 }, { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+		{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 }, { 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+		{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 }, { 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 },
+	};
+
+	//The texel whose index has one bit fewer (its top bit is always 0) in the second subset, and in the third
+	const uint8_t BC7Anchors2[64] =
+	{
+		15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+		15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+		15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+		 6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+	};
+
+	const uint8_t BC7Anchors3Second[64] =
+	{
+		 3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+		 3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+		 8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+		 3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3,
+	};
+
+	const uint8_t BC7Anchors3Third[64] =
+	{
+		15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+		15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+		15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+		15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8,
+	};
+
+	//Reads a block's fields, lowest bit first
+	struct BitReader
+	{
+		uint64_t low;
+		uint64_t high;
+		unsigned int position;
+
+		unsigned int Read(unsigned int count)
+		{
+			if (count == 0)
+				return 0;
+
+			uint64_t value = position >= 64 ? high >> (position - 64) : low >> position;
+
+			if (position < 64 && position + count > 64)
+				value |= high << (64 - position);
+
+			position += count;
+
+			return (unsigned int)(value & ((1u << count) - 1));
+		}
+
+		//The 64 bits from position on without moving past them, 0 past the end of the block. The mode always comes first,
+		//so position is never 0
+		uint64_t ReadLong() const
+		{
+			return position >= 64 ? high >> (position - 64) : (low >> position) | (high << (64 - position));
+		}
+	};
+
+	//A BC7 block's fields, with the endpoints (two for each subset) already expanded to 8 bits
+	struct BC7Block
+	{
+		unsigned int mode;				//8 for a block with no valid mode
+		unsigned int partition;
+		unsigned int rotation;
+		unsigned int indexSelection;
+		uint8_t endpoints[6][4];
+		uint8_t indices[16];
+		uint8_t indices2[16];
+	};
+
+	const uint8_t* BC7Subsets(const BC7Block& block)
+	{
+		unsigned int subsets = BC7Modes[block.mode].subsets;
+		return subsets == 1 ? BC7Partitions1 : subsets == 2 ? BC7Partitions2[block.partition] : BC7Partitions3[block.partition];
+	}
+
+	void UnpackBC7(const uint8_t* data, BC7Block& block)
+	{
+		block.mode = 0;
+		while (block.mode < 8 && !(data[0] & (1 << block.mode)))
+			++block.mode;
+
+		if (block.mode == 8)
+			return;
+
+		const BC7Mode& mode = BC7Modes[block.mode];
+		BitReader bits = { Load64(data), Load64(data + 8), block.mode + 1 };
+
+		block.partition = bits.Read(mode.partitionBits);
+		block.rotation = bits.Read(mode.rotationBits);
+		block.indexSelection = bits.Read(mode.indexSelectionBits);
+
+		//Each channel of every endpoint, then each alpha
+		unsigned int endpointCount = mode.subsets * 2;
+		unsigned int endpoints[6][4] = {};
+
+		for (unsigned int c = 0; c < 3; ++c)
+		{
+			for (unsigned int e = 0; e < endpointCount; ++e)
+				endpoints[e][c] = bits.Read(mode.colorBits);
+		}
+
+		for (unsigned int e = 0; e < endpointCount && mode.alphaBits != 0; ++e)
+			endpoints[e][3] = bits.Read(mode.alphaBits);
+
+		unsigned int pBits[6] = {};
+
+		for (unsigned int e = 0; e < endpointCount && mode.endpointPBits; ++e)
+			pBits[e] = bits.Read(1);
+
+		for (unsigned int s = 0; s < mode.subsets && mode.sharedPBits; ++s)
+			pBits[s * 2] = pBits[s * 2 + 1] = bits.Read(1);
+
+		//The p-bit goes under the endpoint's own bits, then the top bits are repeated below them to make up 8
+		for (unsigned int e = 0; e < endpointCount; ++e)
+		{
+			for (unsigned int c = 0; c < 4; ++c)
+			{
+				unsigned int count = c < 3 ? mode.colorBits : mode.alphaBits;
+
+				if (count == 0)
+				{
+					block.endpoints[e][c] = 255;
+					continue;
+				}
+
+				unsigned int value = endpoints[e][c];
+
+				if (mode.endpointPBits || mode.sharedPBits)
+				{
+					value = (value << 1) | pBits[e];
+					++count;
+				}
+
+				block.endpoints[e][c] = (uint8_t)((value << (8 - count)) | (value >> (2 * count - 8)));
+			}
+		}
+
+		unsigned int anchor2 = mode.subsets == 2 ? BC7Anchors2[block.partition] : mode.subsets == 3 ? BC7Anchors3Second[block.partition] : 0;
+		unsigned int anchor3 = mode.subsets == 3 ? BC7Anchors3Third[block.partition] : 0;
+
+		//Each set of indices is never more than 63 bits, so it's taken out in one go and shifted down a texel at a time
+		uint64_t indices = bits.ReadLong();
+		unsigned int used = 0;
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			unsigned int count = mode.indexBits - (i == 0 || i == anchor2 || i == anchor3);
+			block.indices[i] = (uint8_t)(indices & ((1u << count) - 1));
+			indices >>= count;
+			used += count;
+		}
+
+		if (mode.indexBits2 == 0)
+			return;
+
+		bits.position += used;
+		indices = bits.ReadLong();
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			unsigned int count = mode.indexBits2 - (i == 0);
+			block.indices2[i] = (uint8_t)(indices & ((1u << count) - 1));
+			indices >>= count;
+		}
+	}
+
+	//Which indices pick the colour and which the alpha, swapped over in mode 4 by the index selection bit
+	void BC7IndexSets(const BC7Block& block, const uint8_t*& colorIndices, unsigned int& colorBits,
+					  const uint8_t*& alphaIndices, unsigned int& alphaBits)
+	{
+		const BC7Mode& mode = BC7Modes[block.mode];
+
+		colorIndices = alphaIndices = block.indices;
+		colorBits = alphaBits = mode.indexBits;
+
+		if (mode.indexBits2 == 0)
+			return;
+
+		if (block.indexSelection)
+		{
+			colorIndices = block.indices2;
+			colorBits = mode.indexBits2;
+		}
+		else
+		{
+			alphaIndices = block.indices2;
+			alphaBits = mode.indexBits2;
+		}
+	}
+
+	//Swaps alpha with the channel the rotation names, which is how BC7 gets the most out of its higher precision alpha
+	inline uint32_t RotateBC7(uint32_t texel, unsigned int rotation)
+	{
+		if (rotation == 0)
+			return texel;
+
+		unsigned int shift = (rotation - 1) * 8;
+		uint32_t difference = ((texel >> shift) ^ (texel >> 24)) & 0xFF;
+
+		return texel ^ (difference << shift) ^ (difference << 24);
+	}
+
+	//The reference decoders, a texel at a time straight from the specifications
+
+	void Expand565(unsigned int color, uint8_t* rgba)
+	{
+		unsigned int r = (color >> 11) & 31;
+		unsigned int g = (color >> 5) & 63;
+		unsigned int b = color & 31;
+
+		rgba[0] = (uint8_t)((r << 3) | (r >> 2));
+		rgba[1] = (uint8_t)((g << 2) | (g >> 4));
+		rgba[2] = (uint8_t)((b << 3) | (b >> 2));
+		rgba[3] = 255;
+	}
+
+	//BC1's colours, or BC2 and BC3's, which always have 4. BC1 has 3 and transparent black when the first isn't bigger
+	void ReferenceColors(const uint8_t* block, bool alwaysFour, uint8_t* out)
+	{
+		unsigned int c0 = block[0] | (block[1] << 8);
+		unsigned int c1 = block[2] | (block[3] << 8);
+
+		uint8_t colors[4][4];
+		Expand565(c0, colors[0]);
+		Expand565(c1, colors[1]);
+
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			if (alwaysFour || c0 > c1)
+			{
+				colors[2][c] = (uint8_t)((2 * colors[0][c] + colors[1][c]) / 3);
+				colors[3][c] = (uint8_t)((colors[0][c] + 2 * colors[1][c]) / 3);
+			}
+			else
+			{
+				colors[2][c] = (uint8_t)((colors[0][c] + colors[1][c]) / 2);
+				colors[3][c] = 0;
+			}
+		}
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			unsigned int index = (block[4 + i / 4] >> ((i % 4) * 2)) & 3;
+			memcpy(out + i * 4, colors[index], 4);
+		}
+	}
+
+	//The 8 values a BC3 alpha or BC4 or BC5 channel block picks from. Signed, -128 is read as -127 so 0 is in the middle
+	void ChannelValues(const uint8_t* block, bool isSigned, int* values)
+	{
+		int v0 = isSigned ? std::max(-127, (int)(int8_t)block[0]) : block[0];
+		int v1 = isSigned ? std::max(-127, (int)(int8_t)block[1]) : block[1];
+
+		values[0] = v0;
+		values[1] = v1;
+
+		if (v0 > v1)
+		{
+			for (int i = 1; i < 7; ++i)
+				values[i + 1] = ((7 - i) * v0 + i * v1) / 7;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				values[i + 1] = ((5 - i) * v0 + i * v1) / 5;
+
+			values[6] = isSigned ? -127 : 0;
+			values[7] = isSigned ? 127 : 255;
+		}
+	}
+
+	//Writes one channel of every texel, 4 bytes apart from out
+	void ReferenceChannel(const uint8_t* block, bool isSigned, uint8_t* out)
+	{
+		int values[8];
+		ChannelValues(block, isSigned, values);
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			unsigned int bit = 16 + i * 3;
+			unsigned int index = ((block[bit / 8] | (bit / 8 + 1 < 8 ? block[bit / 8 + 1] << 8 : 0)) >> (bit % 8)) & 7;
+
+			out[i * 4] = (uint8_t)values[index];
+		}
+	}
+
+	void ReferenceBC7(const uint8_t* data, uint8_t* out)
+	{
+		BC7Block block;
+		UnpackBC7(data, block);
+
+		if (block.mode == 8)
+		{
+			memset(out, 0, 64);
+			return;
+		}
+
+		const uint8_t* subsets = BC7Subsets(block);
+		const uint8_t* colorIndices;
+		const uint8_t* alphaIndices;
+		unsigned int colorBits, alphaBits;
+		BC7IndexSets(block, colorIndices, colorBits, alphaIndices, alphaBits);
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			const uint8_t* e0 = block.endpoints[subsets[i] * 2];
+			const uint8_t* e1 = block.endpoints[subsets[i] * 2 + 1];
+
+			for (unsigned int c = 0; c < 4; ++c)
+			{
+				unsigned int weight = c < 3 ? BC7Weights(colorBits)[colorIndices[i]] : BC7Weights(alphaBits)[alphaIndices[i]];
+				out[i * 4 + c] = (uint8_t)(((64 - weight) * e0[c] + weight * e1[c] + 32) >> 6);
+			}
+
+			if (block.rotation != 0)
+				std::swap(out[i * 4 + block.rotation - 1], out[i * 4 + 3]);
+		}
+	}
+
+	void ReferenceBlock(BlockKind kind, const uint8_t* block, uint8_t* out)
+	{
+		switch (kind)
+		{
+		case KindBC1:
+			ReferenceColors(block, false, out);
+			break;
+
+		case KindBC2:
+			ReferenceColors(block + 8, true, out);
+
+			for (unsigned int i = 0; i < 16; ++i)
+				out[i * 4 + 3] = (uint8_t)(((block[i / 2] >> ((i % 2) * 4)) & 15) * 17);
+			break;
+
+		case KindBC3:
+			ReferenceColors(block + 8, true, out);
+			ReferenceChannel(block, false, out + 3);
+			break;
+
+		case KindBC4:
+		case KindBC4Signed:
+		case KindBC5:
+		case KindBC5Signed:
+		{
+			bool isSigned = kind == KindBC4Signed || kind == KindBC5Signed;
+			bool twoChannels = kind == KindBC5 || kind == KindBC5Signed;
+
+			for (unsigned int i = 0; i < 16; ++i)
+			{
+				out[i * 4 + 1] = out[i * 4 + 2] = 0;
+				out[i * 4 + 3] = 255;
+			}
+
+			ReferenceChannel(block, isSigned, out);
+
+			if (twoChannels)
+				ReferenceChannel(block + 8, isSigned, out + 1);
+			break;
+		}
+
+		case KindBC7:
+			ReferenceBC7(block, out);
+			break;
+
+		default:
+			memset(out, 0, 64);
+			break;
+		}
+	}
+
+	//The fast decoders work out each block's palette, in the same way as the reference but with SSE2 where there is
+	//it, then look every texel up in it, with AVX2 where there is it, writing straight into rows of the surface
+
+	//Colours 0 and 1 of BC1 to BC3 as texels
+	inline uint32_t Expand565(uint32_t color)
+	{
+		uint32_t r = (color >> 11) & 31;
+		uint32_t g = (color >> 5) & 63;
+		uint32_t b = color & 31;
+
+		return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16) | 0xFF000000u;
+	}
+
+	void ColorPalette(const uint8_t* block, bool alwaysFour, uint32_t* palette)
+	{
+		uint32_t c0 = block[0] | (block[1] << 8);
+		uint32_t c1 = block[2] | (block[3] << 8);
+		bool four = alwaysFour || c0 > c1;
+
+		palette[0] = Expand565(c0);
+		palette[1] = Expand565(c1);
+
+#ifdef BCDECODER_SSE2
+		//Colours 0 and 1 in the 16-bit lanes, then the other way round, to make 2 and 3 side by side
+		__m128i ends = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)palette), _mm_setzero_si128());
+		__m128i swapped = _mm_shuffle_epi32(ends, _MM_SHUFFLE(1, 0, 3, 2));
+		__m128i middle;
+
+		//Dividing by 3 is multiplying by 0xAAAB and dropping 17 bits, exact for anything under 2^16
+		if (four)
+			middle = _mm_srli_epi16(_mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(ends, ends), swapped), _mm_set1_epi16((short)0xAAAB)), 1);
+		else
+			middle = _mm_srli_epi16(_mm_add_epi16(ends, swapped), 1);
+
+		_mm_storel_epi64((__m128i*)(palette + 2), _mm_packus_epi16(middle, middle));
+#else
+		palette[2] = palette[3] = 0;
+
+		for (unsigned int shift = 0; shift < 32; shift += 8)
+		{
+			uint32_t a = (palette[0] >> shift) & 0xFF;
+			uint32_t b = (palette[1] >> shift) & 0xFF;
+
+			palette[2] |= (four ? (2 * a + b) / 3 : (a + b) / 2) << shift;
+			palette[3] |= ((a + 2 * b) / 3) << shift;
+		}
+#endif
+
+		if (!four)
+			palette[3] = 0;
+	}
+
+	//The values of a BC3 alpha or BC4 or BC5 channel block shifted into place in a texel, with fill ORed in
+	void ChannelPalette(const uint8_t* block, bool isSigned, unsigned int shift, uint32_t fill, uint32_t* palette)
+	{
+#ifdef BCDECODER_SSE2
+		if (!isSigned)
+		{
+			__m128i v0 = _mm_set1_epi16(block[0]);
+			__m128i v1 = _mm_set1_epi16(block[1]);
+			__m128i values;
+
+			//Dividing by 7 or 5 is multiplying by 2^16 / 7 or 2^16 / 5 rounded up and keeping the high 16 bits, exact
+			//for sums this small
+			if (block[0] > block[1])
+			{
+				__m128i sum = _mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(7, 0, 6, 5, 4, 3, 2, 1)),
+											_mm_mullo_epi16(v1, _mm_setr_epi16(0, 7, 1, 2, 3, 4, 5, 6)));
+				values = _mm_mulhi_epu16(sum, _mm_set1_epi16(9363));
+			}
+			else
+			{
+				__m128i sum = _mm_add_epi16(_mm_mullo_epi16(v0, _mm_setr_epi16(5, 0, 4, 3, 2, 1, 0, 0)),
+											_mm_mullo_epi16(v1, _mm_setr_epi16(0, 5, 1, 2, 3, 4, 0, 0)));
+				values = _mm_or_si128(_mm_mulhi_epu16(sum, _mm_set1_epi16(13108)), _mm_setr_epi16(0, 0, 0, 0, 0, 0, 0, 255));
+			}
+
+			__m128i count = _mm_cvtsi32_si128((int)shift);
+			__m128i fills = _mm_set1_epi32((int)fill);
+			__m128i zero = _mm_setzero_si128();
+
+			_mm_storeu_si128((__m128i*)palette, _mm_or_si128(_mm_sll_epi32(_mm_unpacklo_epi16(values, zero), count), fills));
+			_mm_storeu_si128((__m128i*)(palette + 4), _mm_or_si128(_mm_sll_epi32(_mm_unpackhi_epi16(values, zero), count), fills));
+			return;
+		}
+#endif
+
+		int values[8];
+		ChannelValues(block, isSigned, values);
+
+		for (unsigned int i = 0; i < 8; ++i)
+			palette[i] = ((uint32_t)(uint8_t)values[i] << shift) | fill;
+	}
+
+	//Writes the 16 texels whose 2-bit indices are in indices from a 4 entry palette
+	inline void Lookup2Bit(const uint32_t* palette, uint32_t indices, uint8_t* out, size_t outRowPitch)
+	{
+#ifdef BCDECODER_AVX2
+		//Two rows at a time, each lane shifting its own index down
+		__m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)palette));
+		__m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+		__m256i mask = _mm256_set1_epi32(3);
+
+		for (unsigned int y = 0; y < 4; y += 2)
+		{
+			__m256i index = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)(indices >> (y * 8))), shifts), mask);
+			__m256i texels = _mm256_permutevar8x32_epi32(table, index);
+
+			_mm_storeu_si128((__m128i*)(out + y * outRowPitch), _mm256_castsi256_si128(texels));
+			_mm_storeu_si128((__m128i*)(out + (y + 1) * outRowPitch), _mm256_extracti128_si256(texels, 1));
+		}
+#else
+		for (unsigned int y = 0; y < 4; ++y)
+		{
+			uint8_t* row = out + y * outRowPitch;
+
+			for (unsigned int x = 0; x < 4; ++x, indices >>= 2)
+				Store32(row + x * 4, palette[indices & 3]);
+		}
+#endif
+	}
+
+	//Writes the 16 texels whose 3-bit indices are in the low 48 bits of indices from an 8 entry palette, keeping the bits
+	//of keepMask from what's already there
+	inline void Lookup3Bit(const uint32_t* palette, uint64_t indices, uint32_t keepMask, uint8_t* out, size_t outRowPitch)
+	{
+#ifdef BCDECODER_AVX2
+		__m256i table = _mm256_loadu_si256((const __m256i*)palette);
+		__m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+		__m256i mask = _mm256_set1_epi32(7);
+		__m256i keep = _mm256_set1_epi32((int)keepMask);
+
+		for (unsigned int y = 0; y < 4; y += 2)
+		{
+			__m256i index = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32((int)(indices >> (y * 12))), shifts), mask);
+			__m256i texels = _mm256_permutevar8x32_epi32(table, index);
+
+			uint8_t* row0 = out + y * outRowPitch;
+			uint8_t* row1 = row0 + outRowPitch;
+
+			if (keepMask != 0)
+			{
+				__m256i existing = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)row0)),
+														   _mm_loadu_si128((const __m128i*)row1), 1);
+				texels = _mm256_or_si256(texels, _mm256_and_si256(existing, keep));
+			}
+
+			_mm_storeu_si128((__m128i*)row0, _mm256_castsi256_si128(texels));
+			_mm_storeu_si128((__m128i*)row1, _mm256_extracti128_si256(texels, 1));
+		}
+#else
+		for (unsigned int y = 0; y < 4; ++y)
+		{
+			uint8_t* row = out + y * outRowPitch;
+
+			for (unsigned int x = 0; x < 4; ++x, indices >>= 3)
+			{
+				uint32_t texel = palette[indices & 7];
+
+				if (keepMask != 0)
+					texel |= Load32(row + x * 4) & keepMask;
+
+				Store32(row + x * 4, texel);
+			}
+		}
+#endif
+	}
+
+	void FastBC1(const uint8_t* block, uint8_t* out, size_t outRowPitch)
+	{
+		uint32_t palette[4];
+		ColorPalette(block, false, palette);
+		Lookup2Bit(palette, Load32(block + 4), out, outRowPitch);
+	}
+
+	void FastBC2(const uint8_t* block, uint8_t* out, size_t outRowPitch)
+	{
+		uint32_t palette[4];
+		ColorPalette(block + 8, true, palette);
+		Lookup2Bit(palette, Load32(block + 12), out, outRowPitch);
+
+		for (unsigned int y = 0; y < 4; ++y)
+		{
+			unsigned int alphas = block[y * 2] | (block[y * 2 + 1] << 8);
+
+			for (unsigned int x = 0; x < 4; ++x, alphas >>= 4)
+				out[y * outRowPitch + x * 4 + 3] = (uint8_t)((alphas & 15) * 17);
+		}
+	}
+
+	void FastBC3(const uint8_t* block, uint8_t* out, size_t outRowPitch)
+	{
+		uint32_t colors[4];
+		ColorPalette(block + 8, true, colors);
+		Lookup2Bit(colors, Load32(block + 12), out, outRowPitch);
+
+		uint32_t alphas[8];
+		ChannelPalette(block, false, 24, 0, alphas);
+		Lookup3Bit(alphas, Load64(block) >> 16, 0x00FFFFFF, out, outRowPitch);
+	}
+
+	template<bool Signed>
+	void FastBC4(const uint8_t* block, uint8_t* out, size_t outRowPitch)
+	{
+		uint32_t palette[8];
+		ChannelPalette(block, Signed, 0, 0xFF000000, palette);
+		Lookup3Bit(palette, Load64(block) >> 16, 0, out, outRowPitch);
+	}
+
+	template<bool Signed>
+	void FastBC5(const uint8_t* block, uint8_t* out, size_t outRowPitch)
+	{
+		uint32_t palette[8];
+		ChannelPalette(block, Signed, 0, 0xFF000000, palette);
+		Lookup3Bit(palette, Load64(block) >> 16, 0, out, outRowPitch);
+
+		ChannelPalette(block + 8, Signed, 8, 0, palette);
+		Lookup3Bit(palette, Load64(block + 8) >> 16, 0xFFFF00FF, out, outRowPitch);
+	}
+
+	//count texels going from e0 to e1 by weights, a pair at a time
+	void BC7Palette(const uint8_t* e0, const uint8_t* e1, const uint8_t* weights, unsigned int count, uint32_t* palette)
+	{
+#ifdef BCDECODER_SSE2
+		__m128i zero = _mm_setzero_si128();
+		__m128i from = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Load32(e0)), zero);
+		__m128i to = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)Load32(e1)), zero);
+		from = _mm_unpacklo_epi64(from, from);
+		to = _mm_unpacklo_epi64(to, to);
+
+		__m128i sixtyFour = _mm_set1_epi16(64);
+		__m128i half = _mm_set1_epi16(32);
+
+		for (unsigned int i = 0; i < count; i += 2)
+		{
+			__m128i weight = _mm_unpacklo_epi64(_mm_set1_epi16(weights[i]), _mm_set1_epi16(weights[i + 1]));
+			__m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(sixtyFour, weight), from), _mm_mullo_epi16(weight, to));
+			__m128i texels = _mm_srli_epi16(_mm_add_epi16(sum, half), 6);
+
+			_mm_storel_epi64((__m128i*)(palette + i), _mm_packus_epi16(texels, texels));
+		}
+#else
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			palette[i] = 0;
+
+			for (unsigned int c = 0; c < 4; ++c)
+				palette[i] |= (((64 - weights[i]) * e0[c] + weights[i] * e1[c] + 32) >> 6) << (c * 8);
+		}
+#endif
+	}
+
+	void FastBC7(const uint8_t* data, uint8_t* out, size_t outRowPitch)
+	{
+		BC7Block block;
+		UnpackBC7(data, block);
+
+		if (block.mode == 8)
+		{
+			for (unsigned int y = 0; y < 4; ++y)
+				memset(out + y * outRowPitch, 0, 16);
+			return;
+		}
+
+		const BC7Mode& mode = BC7Modes[block.mode];
+		const uint8_t* subsets = BC7Subsets(block);
+		const uint8_t* colorIndices;
+		const uint8_t* alphaIndices;
+		unsigned int colorBits, alphaBits;
+		BC7IndexSets(block, colorIndices, colorBits, alphaIndices, alphaBits);
+
+		uint32_t palettes[3][16];
+		uint32_t alphas[16];
+
+		for (unsigned int s = 0; s < mode.subsets; ++s)
+			BC7Palette(block.endpoints[s * 2], block.endpoints[s * 2 + 1], BC7Weights(colorBits), 1 << colorBits, palettes[s]);
+
+		//Modes 4 and 5 pick alpha with indices of their own
+		if (mode.indexBits2 != 0)
+			BC7Palette(block.endpoints[0], block.endpoints[1], BC7Weights(alphaBits), 1 << alphaBits, alphas);
+
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			uint32_t texel = palettes[subsets[i]][colorIndices[i]];
+
+			if (mode.indexBits2 != 0)
+				texel = RotateBC7((texel & 0x00FFFFFF) | (alphas[alphaIndices[i]] & 0xFF000000), block.rotation);
+
+			Store32(out + (i / 4) * outRowPitch + (i % 4) * 4, texel);
+		}
+	}
+
+	typedef void (*FastDecoder)(const uint8_t* block, uint8_t* out, size_t outRowPitch);
+
+	FastDecoder getFastDecoder(BlockKind kind)
+	{
+		switch (kind)
+		{
+		case KindBC1: return FastBC1;
+		case KindBC2: return FastBC2;
+		case KindBC3: return FastBC3;
+		case KindBC4: return FastBC4<false>;
+		case KindBC4Signed: return FastBC4<true>;
+		case KindBC5: return FastBC5<false>;
+		case KindBC5Signed: return FastBC5<true>;
+		case KindBC7: return FastBC7;
+		default: return nullptr;
+		}
+	}
+
+	//Decodes rows firstRow to endRow - 1 of blocks. Blocks hanging over the right or bottom edge are decoded to the side
+	//and only the texels inside the surface copied
+	void DecodeRows(FastDecoder decode, size_t blockBytes, const uint8_t* data, size_t rowPitch, size_t width, size_t height,
+					size_t firstRow, size_t endRow, uint8_t* out, size_t outRowPitch)
+	{
+		size_t blocksWide = (width + 3) / 4;
+		uint8_t edge[64];
+
+		for (size_t by = firstRow; by < endRow; ++by)
+		{
+			const uint8_t* block = data + by * rowPitch;
+			uint8_t* row = out + by * 4 * outRowPitch;
+			size_t rows = std::min<size_t>(4, height - by * 4);
+
+			for (size_t bx = 0; bx < blocksWide; ++bx, block += blockBytes)
+			{
+				size_t columns = std::min<size_t>(4, width - bx * 4);
+
+				if (rows == 4 && columns == 4)
+				{
+					decode(block, row + bx * 16, outRowPitch);
+					continue;
+				}
+
+				decode(block, edge, 16);
+
+				for (size_t y = 0; y < rows; ++y)
+					memcpy(row + y * outRowPitch + bx * 16, edge + y * 16, columns * 4);
+			}
+		}
+	}
+
+	//Blocks fewer than this aren't worth handing to another thread
+	const size_t MinBlocksPerThread = 4096;
+}
+
+bool BCDecoder::IsSupported(DXGI_FORMAT format)
+{
+	return getKind(format) != KindUnsupported;
+}
+
+size_t BCDecoder::BlockBytes(DXGI_FORMAT format)
+{
+	return KindBlockBytes(getKind(format));
+}
+
+void BCDecoder::DecodeBlock(DXGI_FORMAT format, const uint8_t* block, uint8_t* outTexels)
+{
+	ReferenceBlock(getKind(format), block, outTexels);
+}
+
+bool BCDecoder::DecodeSurface(DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width, size_t height,
+							  uint8_t* out, size_t outRowPitch, unsigned int threadCount)
+{
+	BlockKind kind = getKind(format);
+
+	if (kind == KindUnsupported)
+		return false;
+
+	if (width == 0 || height == 0)
+		return true;
+
+	size_t blockBytes = KindBlockBytes(kind);
+	size_t blocksWide = (width + 3) / 4;
+	size_t blocksHigh = (height + 3) / 4;
+
+	if (!subresource.data || subresource.rowPitch < blocksWide * blockBytes ||
+		subresource.bytes < subresource.rowPitch * (blocksHigh - 1) + blocksWide * blockBytes)
+		return false;
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	unsigned int count = (unsigned int)std::min<size_t>(std::min<size_t>(threadCount, blocksHigh), blocksWide * blocksHigh / MinBlocksPerThread + 1);
+	FastDecoder decode = getFastDecoder(kind);
+
+	//Each thread takes a band of rows of blocks, which land in rows of the surface no other thread writes
+	RunParallel(count, [&](unsigned int i) {
+		DecodeRows(decode, blockBytes, subresource.data, subresource.rowPitch, width, height,
+				   blocksHigh * i / count, blocksHigh * (i + 1) / count, out, outRowPitch);
+	});
+
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "DDSFormat.h"
+
+//Decodes block compressed textures (BC1 to BC5 and BC7) to 8-bit RGBA on the CPU, for tools, thumbnails and checking
+//what a texture holds without a GPU.
+//
+//Every format decodes to 4 bytes a texel, laid out R, G, B, A. BC4 fills red and BC5 red and green, with the others 0
+//and alpha 255, the way Direct3D samples them. The SNORM formats give signed bytes from -127 to 127 in those channels
+//and the sRGB formats the same bytes as the UNORM ones, still sRGB encoded. Interpolated BC1 to BC5 values are rounded
+//down, as most software decoders do; GPUs are allowed to be out from that by one. BC7's interpolation is exact in its
+//specification, and an invalid BC7 block decodes to 0 in every channel.
+//
+//DecodeBlock follows the specifications a texel at a time, and is the reference DecodeSurface is checked against (see
+//Tools/BCDecoderBenchmark). DecodeSurface builds each block's palette with SSE2 where it's available, looks the texels up
+//in it with AVX2 if the compiler targets it (/arch:AVX2 or -mavx2), and shares rows of blocks out between threads.
+namespace BCDecoder
+{
+	bool IsSupported(DXGI_FORMAT format);
+
+	//Bytes a block of 4 x 4 texels takes, 0 if the format isn't supported
+	size_t BlockBytes(DXGI_FORMAT format);
+
+	//Decodes one block into 16 texels, a row of 4 after another, 64 bytes in all
+	void DecodeBlock(DXGI_FORMAT format, const uint8_t* block, uint8_t* outTexels);
+
+	//Decodes a width x height surface, e.g. one of the subresources FillSubresources lays out (a volume texture's holds a
+	//surface for each depth slice, slicePitch apart), into rows outRowPitch bytes apart. Rows of blocks are shared between
+	//threadCount threads, 0 for one a core. Returns false if the format isn't supported or the subresource is too small
+	bool DecodeSurface(DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width, size_t height,
+					   uint8_t* out, size_t outRowPitch, unsigned int threadCount = 0);
+};
@@ -0,0 +1,253 @@
+#include "BoundingVolumes.h"
+#include <math.h>
+#include <stdint.h>
+
+namespace
+{
+	inline XMVECTOR LoadPosition(const XMFLOAT3* positions, size_t stride, size_t i)
+	{
+		return XMLoadFloat3((const XMFLOAT3*)((const uint8_t*)positions + i * stride));
+	}
+
+	//Squared distance from center to the furthest position, four positions a loop with a running maximum for each so
+	//they don't wait on each other
+	float MaxDistanceSquared(const XMFLOAT3* positions, size_t count, size_t stride, FXMVECTOR center)
+	{
+		XMVECTOR furthest[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+		size_t i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			for (size_t j = 0; j < 4; ++j)
+				furthest[j] = XMVectorMax(furthest[j], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, stride, i + j), center)));
+		}
+
+		for (; i < count; ++i)
+			furthest[0] = XMVectorMax(furthest[0], XMVector3LengthSq(XMVectorSubtract(LoadPosition(positions, stride, i), center)));
+
+		return XMVectorGetX(XMVectorMax(XMVectorMax(furthest[0], furthest[1]), XMVectorMax(furthest[2], furthest[3])));
+	}
+
+	//Four positions side by side, one of x, y, z and w in each row
+	inline XMMATRIX LoadPositions(const XMFLOAT3* positions, size_t stride, size_t i)
+	{
+		XMMATRIX batch;
+
+		for (size_t j = 0; j < 4; ++j)
+			batch.r[j] = LoadPosition(positions, stride, i + j);
+
+		return XMMatrixTranspose(batch);
+	}
+
+	//Keeps position as the extreme for each face of the box it's on that doesn't have one yet. The masks are all ones in
+	//x, y and z for the faces still without one
+	inline void TakeExtremes(FXMVECTOR position, FXMVECTOR boxMin, FXMVECTOR boxMax, XMVECTOR& minPending, XMVECTOR& maxPending, XMVECTOR* extremes)
+	{
+		XMVECTOR atMin = XMVectorAndInt(XMVectorEqual(position, boxMin), minPending);
+		XMVECTOR atMax = XMVectorAndInt(XMVectorEqual(position, boxMax), maxPending);
+
+		uint32_t isMin[4];
+		uint32_t isMax[4];
+		XMStoreInt4(isMin, atMin);
+		XMStoreInt4(isMax, atMax);
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (isMin[axis])
+				extremes[axis * 2] = position;
+
+			if (isMax[axis])
+				extremes[axis * 2 + 1] = position;
+		}
+
+		minPending = XMVectorAndCInt(minPending, atMin);
+		maxPending = XMVectorAndCInt(maxPending, atMax);
+	}
+
+	//Ritter's algorithm: start with the sphere between the two furthest apart of the six extreme points along x, y and z,
+	//then grow it just enough to take in each position outside it. Only the centre is used, see Compute
+	XMVECTOR RitterCenter(const XMFLOAT3* positions, size_t count, size_t stride, FXMVECTOR boxMin, FXMVECTOR boxMax)
+	{
+		//The first position on each face of the box. There's always one, unless a position isn't a number
+		XMVECTOR first = LoadPosition(positions, stride, 0);
+		XMVECTOR extremes[6] = { first, first, first, first, first, first };
+		XMVECTOR minPending = XMVectorTrueInt();
+		XMVECTOR maxPending = XMVectorTrueInt();
+		size_t i = 0;
+
+		//Most batches of four touch no face still without an extreme and are passed over with one test, and the search
+		//stops once every face has one
+		for (; i + 4 <= count && !XMVector3EqualInt(XMVectorOrInt(minPending, maxPending), XMVectorFalseInt()); i += 4)
+		{
+			XMVECTOR batch[4];
+			XMVECTOR atMin = XMVectorFalseInt();
+			XMVECTOR atMax = XMVectorFalseInt();
+
+			for (size_t j = 0; j < 4; ++j)
+			{
+				batch[j] = LoadPosition(positions, stride, i + j);
+				atMin = XMVectorOrInt(atMin, XMVectorEqual(batch[j], boxMin));
+				atMax = XMVectorOrInt(atMax, XMVectorEqual(batch[j], boxMax));
+			}
+
+			XMVECTOR wanted = XMVectorOrInt(XMVectorAndInt(atMin, minPending), XMVectorAndInt(atMax, maxPending));
+
+			if (XMVector3EqualInt(wanted, XMVectorFalseInt()))
+				continue;
+
+			for (size_t j = 0; j < 4; ++j)
+				TakeExtremes(batch[j], boxMin, boxMax, minPending, maxPending, extremes);
+		}
+
+		for (; i < count && !XMVector3EqualInt(XMVectorOrInt(minPending, maxPending), XMVectorFalseInt()); ++i)
+			TakeExtremes(LoadPosition(positions, stride, i), boxMin, boxMax, minPending, maxPending, extremes);
+
+		XMVECTOR a = extremes[0];
+		XMVECTOR b = extremes[1];
+		float widest = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(b, a)));
+
+		for (int axis = 1; axis < 3; ++axis)
+		{
+			float width = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(extremes[axis * 2 + 1], extremes[axis * 2])));
+
+			if (width > widest)
+			{
+				a = extremes[axis * 2];
+				b = extremes[axis * 2 + 1];
+				widest = width;
+			}
+		}
+
+		XMVECTOR center = XMVectorScale(XMVectorAdd(a, b), 0.5f);
+		float radius = 0.5f * sqrtf(widest);
+		float radiusSquared = radius * radius;
+
+		//The centre moves towards each position outside by half of how far outside it is
+		auto grow = [&](FXMVECTOR position)
+		{
+			XMVECTOR toPosition = XMVectorSubtract(position, center);
+			float distanceSquared = XMVectorGetX(XMVector3LengthSq(toPosition));
+
+			if (distanceSquared <= radiusSquared)
+				return;
+
+			float distance = sqrtf(distanceSquared);
+			float grown = 0.5f * (radius + distance);
+
+			center = XMVectorAdd(center, XMVectorScale(toPosition, (grown - radius) / distance));
+			radius = grown;
+			radiusSquared = radius * radius;
+		};
+
+		//Once the sphere is near its final size almost every position is inside it, so four are measured at once and
+		//only a batch with one outside is gone through a position at a time
+		i = 0;
+
+		for (; i + 4 <= count; i += 4)
+		{
+			XMMATRIX batch = LoadPositions(positions, stride, i);
+
+			XMVECTOR dx = XMVectorSubtract(batch.r[0], XMVectorSplatX(center));
+			XMVECTOR dy = XMVectorSubtract(batch.r[1], XMVectorSplatY(center));
+			XMVECTOR dz = XMVectorSubtract(batch.r[2], XMVectorSplatZ(center));
+			XMVECTOR distancesSquared = XMVectorMultiplyAdd(dz, dz, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dx, dx)));
+
+			if (XMVector4LessOrEqual(distancesSquared, XMVectorReplicate(radiusSquared)))
+				continue;
+
+			for (size_t j = 0; j < 4; ++j)
+				grow(LoadPosition(positions, stride, i + j));
+		}
+
+		for (; i < count; ++i)
+			grow(LoadPosition(positions, stride, i));
+
+		return center;
+	}
+}
+
+MeshBounds BoundingVolumes::Compute(const XMFLOAT3* positions, size_t count, size_t stride)
+{
+	MeshBounds bounds = {};
+
+	if (count == 0)
+		return bounds;
+
+	//Four running minimums and maximums, combined at the end
+	XMVECTOR first = LoadPosition(positions, stride, 0);
+	XMVECTOR boxMin[4] = { first, first, first, first };
+	XMVECTOR boxMax[4] = { first, first, first, first };
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		for (size_t j = 0; j < 4; ++j)
+		{
+			XMVECTOR position = LoadPosition(positions, stride, i + j);
+			boxMin[j] = XMVectorMin(boxMin[j], position);
+			boxMax[j] = XMVectorMax(boxMax[j], position);
+		}
+	}
+
+	for (; i < count; ++i)
+	{
+		XMVECTOR position = LoadPosition(positions, stride, i);
+		boxMin[0] = XMVectorMin(boxMin[0], position);
+		boxMax[0] = XMVectorMax(boxMax[0], position);
+	}
+
+	XMVECTOR minimum = XMVectorMin(XMVectorMin(boxMin[0], boxMin[1]), XMVectorMin(boxMin[2], boxMin[3]));
+	XMVECTOR maximum = XMVectorMax(XMVectorMax(boxMax[0], boxMax[1]), XMVectorMax(boxMax[2], boxMax[3]));
+
+	XMStoreFloat3(&bounds.boxMin, minimum);
+	XMStoreFloat3(&bounds.boxMax, maximum);
+
+	//Ritter's sphere is usually the tighter one, but not always, e.g. for a box shaped mesh. Either way the radius comes
+	//from one last pass over every position rather than the algorithm's own, which can be a little bigger than needed
+	XMVECTOR centers[2] = { RitterCenter(positions, count, stride, minimum, maximum), XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f) };
+	float radiiSquared[2] = { MaxDistanceSquared(positions, count, stride, centers[0]), MaxDistanceSquared(positions, count, stride, centers[1]) };
+	int best = radiiSquared[0] <= radiiSquared[1] ? 0 : 1;
+
+	XMStoreFloat3(&bounds.sphereCenter, centers[best]);
+	bounds.sphereRadius = sqrtf(radiiSquared[best]);
+
+	return bounds;
+}
+
+MeshBounds BoundingVolumes::Expand(const MeshBounds& bounds, float distance)
+{
+	MeshBounds expanded = bounds;
+
+	expanded.boxMin = XMFLOAT3(bounds.boxMin.x - distance, bounds.boxMin.y - distance, bounds.boxMin.z - distance);
+	expanded.boxMax = XMFLOAT3(bounds.boxMax.x + distance, bounds.boxMax.y + distance, bounds.boxMax.z + distance);
+	expanded.sphereRadius += distance;
+
+	return expanded;
+}
+
+MeshBounds BoundingVolumes::Transform(const MeshBounds& bounds, const XMFLOAT4X4& world)
+{
+	XMMATRIX matrix = XMLoadFloat4x4(&world);
+
+	XMVECTOR boxMin = XMLoadFloat3(&bounds.boxMin);
+	XMVECTOR boxMax = XMLoadFloat3(&bounds.boxMax);
+	XMVECTOR center = XMVector3Transform(XMVectorScale(XMVectorAdd(boxMin, boxMax), 0.5f), matrix);
+	XMVECTOR extents = XMVectorScale(XMVectorSubtract(boxMax, boxMin), 0.5f);
+
+	//Each of the box's axes turns into a row of the matrix scaled by its extent, and reaches furthest along each world
+	//axis when all three point the same way along it (Arvo)
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorAbs(matrix.r[0]), XMVectorSplatX(extents));
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(matrix.r[1]), XMVectorSplatY(extents), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorAbs(matrix.r[2]), XMVectorSplatZ(extents), worldExtents);
+
+	MeshBounds transformed;
+	XMStoreFloat3(&transformed.boxMin, XMVectorSubtract(center, worldExtents));
+	XMStoreFloat3(&transformed.boxMax, XMVectorAdd(center, worldExtents));
+
+	XMVECTOR scale = XMVectorMax(XMVectorMax(XMVector3LengthSq(matrix.r[0]), XMVector3LengthSq(matrix.r[1])), XMVector3LengthSq(matrix.r[2]));
+
+	XMStoreFloat3(&transformed.sphereCenter, XMVector3Transform(XMLoadFloat3(&bounds.sphereCenter), matrix));
+	transformed.sphereRadius = bounds.sphereRadius * sqrtf(XMVectorGetX(scale));
+
+	return transformed;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <stddef.h>
+#include "Structures.h"
+
+//An axis aligned box and a sphere around every vertex of a mesh. Worked out when the mesh is cooked and kept in its
+//cache, so culling, picking and choosing levels of detail never need the vertices
+struct MeshBounds
+{
+	XMFLOAT3 boxMin;
+	XMFLOAT3 boxMax;
+	XMFLOAT3 sphereCenter;
+	float sphereRadius;
+};
+
+//Computes and transforms MeshBounds using DirectXMath vectors
+namespace BoundingVolumes
+{
+	//Bounds of count positions, each stride bytes after the one before (e.g. &vertices[0].Pos and sizeof(SimpleVertex)).
+	//The sphere is the smaller of Ritter's sphere and the one centred on the box, each with its radius taken from the
+	//furthest position, so it always fits tightly around its centre. All zero if count is 0
+	MeshBounds Compute(const XMFLOAT3* positions, size_t count, size_t stride = sizeof(XMFLOAT3));
+
+	//Grows bounds by distance in every direction
+	MeshBounds Expand(const MeshBounds& bounds, float distance);
+
+	//Bounds of the mesh once world has been applied to it, e.g. Application's _world. The box is the smallest axis aligned
+	//box around the transformed one, and the sphere is scaled by the world matrix's biggest axis
+	MeshBounds Transform(const MeshBounds& bounds, const XMFLOAT4X4& world);
+};
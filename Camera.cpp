@@ -48,6 +48,19 @@ XMFLOAT4X4 Camera::getViewProjectionMatrix()
 	return viewProjection;
 }
 
+FLOAT Camera::getProjectedSize(FLOAT size, XMFLOAT3 position) const
+{
+	XMVECTOR toPosition = XMVectorSubtract(XMLoadFloat3(&position), XMLoadFloat3(&_eye));
+	FLOAT distance = XMVectorGetX(XMVector3Length(toPosition));
+
+	// Anything this close covers the whole screen anyway
+	if (distance <= _nearDepth)
+		return _windowHeight;
+
+	// _22 of the projection is 1 / tan(fovY / 2), which maps view space height at distance 1 to the -1 to 1 range of the screen
+	return size * _projection._22 * 0.5f * _windowHeight / distance;
+}
+
 void Camera::Reshape(FLOAT windowWidth, FLOAT windowHeight, FLOAT nearDepth, FLOAT farDepth)
 {
 	_windowWidth = windowWidth;
@@ -51,6 +51,9 @@ public:
 
 	XMFLOAT4X4 getViewProjectionMatrix();
 
+	// How many pixels tall something of the given world space size looks when it's at position
+	FLOAT getProjectedSize(FLOAT size, XMFLOAT3 position) const;
+
 	// Reshape the camera volume if the window is resized
 	void Reshape(FLOAT windowWidth, FLOAT windowHeight, FLOAT nearDepth, FLOAT farDepth);
 };
@@ -0,0 +1,204 @@
+//--------------------------------------------------------------------------------------
+// File: DDSFormat.h
+//
+// The DDS file structures and format helpers from DDSTextureLoader, moved out of it so
+// they can be used without Direct3D (e.g. by Tools/AssetCooker on Linux). On Linux
+// dxgiformat.h comes from https://github.com/microsoft/DirectX-Headers (include/directx).
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248926
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <dxgiformat.h>
+
+#ifndef _In_
+#define _In_
+#endif
+#ifndef _Out_opt_
+#define _Out_opt_
+#endif
+#ifndef _In_reads_bytes_
+#define _In_reads_bytes_(exp)
+#endif
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+namespace DirectX
+{
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+#define DDS_WIDTH  0x00000004 // DDSD_WIDTH
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+//--------------------------------------------------------------------------------------
+// Values from D3D11_RESOURCE_DIMENSION
+//--------------------------------------------------------------------------------------
+enum DDS_DIMENSION
+{
+    DDS_DIMENSION_TEXTURE1D = 2,
+    DDS_DIMENSION_TEXTURE2D = 3,
+    DDS_DIMENSION_TEXTURE3D = 4,
+};
+
+//--------------------------------------------------------------------------------------
+// What a DDS file holds, as worked out from its headers
+//--------------------------------------------------------------------------------------
+struct DDS_TEXTURE_INFO
+{
+    DDS_DIMENSION   dimension;
+    size_t          width;
+    size_t          height;
+    size_t          depth;
+    size_t          arraySize;  // 6 per cube for cube maps
+    size_t          mipCount;
+    DXGI_FORMAT     format;
+    bool            isCubeMap;
+    size_t          dataOffset; // where the pixel data starts in the file
+    size_t          dataSize;   // bytes of pixel data all of the surfaces need
+};
+
+//--------------------------------------------------------------------------------------
+// Where one surface (a mip of an array slice, with all of its depth slices) is in a DDS
+// file. The same as D3D11_SUBRESOURCE_DATA, without needing d3d11.h
+//--------------------------------------------------------------------------------------
+struct DDS_SUBRESOURCE
+{
+    const uint8_t*  data;
+    size_t          rowPitch;
+    size_t          slicePitch;
+    size_t          bytes;      // of the file it covers, slicePitch for each depth slice
+};
+
+size_t BitsPerPixel( _In_ DXGI_FORMAT fmt );
+
+void GetSurfaceInfo( _In_ size_t width,
+                     _In_ size_t height,
+                     _In_ DXGI_FORMAT fmt,
+                     _Out_opt_ size_t* outNumBytes,
+                     _Out_opt_ size_t* outRowBytes,
+                     _Out_opt_ size_t* outNumRows );
+
+DXGI_FORMAT GetDXGIFormat( const DDS_PIXELFORMAT& ddpf );
+
+DXGI_FORMAT MakeSRGB( _In_ DXGI_FORMAT format );
+
+// Checks the magic value and headers of a DDS file, the same way DDSTextureLoader does
+// before creating a texture, and that the file is long enough for every surface they
+// describe. Returns false if it isn't a DDS file this code can use.
+bool GetDDSTextureInfo( _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+                        _In_ size_t ddsDataSize,
+                        DDS_TEXTURE_INFO& info );
+
+// Points subresources, which needs room for mipCount * arraySize of them, at each surface
+// in bitData in the order D3D11 numbers them, skipping mips bigger than maxsize (0 for no
+// limit). twidth, theight and tdepth are set to the size of the biggest mip kept and
+// skipMip to how many were skipped. Nothing is copied, so bitData can be a mapped file.
+// Returns how many subresources were filled in, 0 if bitData is too short for them.
+size_t FillSubresources( _In_ size_t width,
+                         _In_ size_t height,
+                         _In_ size_t depth,
+                         _In_ size_t mipCount,
+                         _In_ size_t arraySize,
+                         _In_ DXGI_FORMAT format,
+                         _In_ size_t maxsize,
+                         _In_ size_t bitSize,
+                         _In_reads_bytes_(bitSize) const uint8_t* bitData,
+                         size_t& twidth,
+                         size_t& theight,
+                         size_t& tdepth,
+                         size_t& skipMip,
+                         DDS_SUBRESOURCE* subresources );
+
+}
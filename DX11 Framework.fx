@@ -28,6 +28,10 @@ cbuffer ConstantBuffer : register( b0 )
 	float4 SpecularLight;
 	float3 EyePosW;
 	float SpecularPower;
+
+	// Only used by VSCompact, turns the 0-1 quantized positions back into model space
+	float4 PosScale;
+	float4 PosOffset;
 }
 
 //--------------------------------------------------------------------------------------
@@ -42,7 +46,7 @@ struct VS_OUTPUT
 //--------------------------------------------------------------------------------------
 // Vertex Shader -- Implements Gouraud Shading using Diffuse lighting only
 //--------------------------------------------------------------------------------------
-VS_OUTPUT VS( float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCOORD )
+VS_OUTPUT TransformVertex( float4 Pos, float3 NormalL, float2 Tex )
 {
 	VS_OUTPUT output = (VS_OUTPUT)0;
 	
@@ -62,6 +66,34 @@ VS_OUTPUT VS( float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCO
 	return output;
 }
 
+VS_OUTPUT VS( float4 Pos : POSITION, float3 NormalL : NORMAL, float2 Tex : TEXCOORD )
+{
+	return TransformVertex(Pos, NormalL, Tex);
+}
+
+//--------------------------------------------------------------------------------------
+// Compact vertices (CompactVertex in Structures.h) -- positions are 16-bit unorm within the mesh bounds,
+// normals are octahedral encoded in two 16-bit snorms and texture coordinates are halfs
+//--------------------------------------------------------------------------------------
+float3 DecodeOctahedral( float2 e )
+{
+	float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+
+	// The lower hemisphere was folded over the diagonals, unfold it
+	if (n.z < 0.0f)
+	{
+		n.xy = (1.0f - abs(n.yx)) * float2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return normalize(n);
+}
+
+VS_OUTPUT VSCompact( float4 Pos : POSITION, float2 NormalOct : NORMAL, float2 Tex : TEXCOORD )
+{
+	float4 posL = float4(Pos.xyz * PosScale.xyz + PosOffset.xyz, 1.0f);
+
+	return TransformVertex(posL, DecodeOctahedral(NormalOct), Tex);
+}
 
 //--------------------------------------------------------------------------------------
 // Pixel Shader
@@ -0,0 +1,225 @@
+#include "FileWatcher.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher()
+{
+	_pollMilliseconds = 250;
+	_stopping = false;
+	_notify = -1;
+}
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+std::string FileWatcher::getFolder(const std::string& filename)
+{
+	size_t slash = filename.find_last_of("/\\");
+	return slash == std::string::npos ? "." : filename.substr(0, slash);
+}
+
+std::string FileWatcher::getKey(const std::string& filename)
+{
+	size_t slash = filename.find_last_of("/\\");
+	return getFolder(filename) + "/" + (slash == std::string::npos ? filename : filename.substr(slash + 1));
+}
+
+void FileWatcher::Stamp(WatchedFile& file)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	file.exists = GetFileAttributesExA(file.filename.c_str(), GetFileExInfoStandard, &attributes) != 0;
+	file.size = file.exists ? ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow : 0;
+	file.modifiedTime = file.exists ? ((int64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime : 0;
+#else
+	struct stat status;
+	file.exists = stat(file.filename.c_str(), &status) == 0;
+	file.size = file.exists ? (uint64_t)status.st_size : 0;
+#ifdef __APPLE__
+	file.modifiedTime = file.exists ? (int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec : 0;
+#else
+	file.modifiedTime = file.exists ? (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec : 0;
+#endif
+#endif
+}
+
+void FileWatcher::Start(unsigned int pollMilliseconds)
+{
+	Stop();
+
+	_pollMilliseconds = pollMilliseconds;
+	_stopping = false;
+
+#ifdef __linux__
+	_notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+	std::lock_guard<std::mutex> lock(_lock);
+
+	//Anything watched before now still needs its folder watching
+	for (auto& file : _files)
+	{
+		WatchFolder(getFolder(file.second.filename));
+		Stamp(file.second);
+	}
+
+	_thread = std::thread(_notify >= 0 ? &FileWatcher::NotifyThread : &FileWatcher::PollThread, this);
+}
+
+void FileWatcher::Stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_stopping = true;
+	}
+
+	_wake.notify_all();
+	_thread.join();
+
+#ifdef __linux__
+	if (_notify >= 0)
+		close(_notify);
+#endif
+
+	_notify = -1;
+	_folders.clear();
+}
+
+void FileWatcher::Watch(const char* filename)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	std::string key = getKey(filename);
+	if (_files.count(key))
+		return;
+
+	WatchedFile& file = _files[key];
+	file.filename = filename;
+	Stamp(file);
+
+	if (_thread.joinable())
+		WatchFolder(getFolder(filename));
+}
+
+void FileWatcher::WatchFolder(const std::string& folder)
+{
+#ifdef __linux__
+	if (_notify < 0)
+		return;
+
+	for (const auto& watched : _folders)
+	{
+		if (std::find(watched.second.begin(), watched.second.end(), folder) != watched.second.end())
+			return;
+	}
+
+	//Closing after writing catches files written in place, moving in catches files written somewhere else and renamed over.
+	//The same folder spelled another way ("OBJ" and "./OBJ") gets the same descriptor back, and files are found under
+	//each spelling
+	int descriptor = inotify_add_watch(_notify, folder.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+	if (descriptor >= 0)
+		_folders[descriptor].push_back(folder);
+#else
+	(void)folder;
+#endif
+}
+
+std::vector<std::string> FileWatcher::TakeChanges()
+{
+	std::lock_guard<std::mutex> lock(_lock);
+
+	std::vector<std::string> changes(_changes.begin(), _changes.end());
+	_changes.clear();
+
+	return changes;
+}
+
+void FileWatcher::NotifyThread()
+{
+#ifdef __linux__
+	alignas(inotify_event) char buffer[16384];
+
+	while (true)
+	{
+		//Woken every so often even if nothing happens, to see whether it's been stopped
+		pollfd descriptor = { _notify, POLLIN, 0 };
+		poll(&descriptor, 1, (int)_pollMilliseconds);
+
+		std::lock_guard<std::mutex> lock(_lock);
+
+		if (_stopping)
+			return;
+
+		ssize_t length;
+		while ((length = read(_notify, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + ((inotify_event*)p)->len)
+			{
+				const inotify_event& event = *(const inotify_event*)p;
+
+				//Some changes were dropped, and there's no knowing which
+				if (event.mask & IN_Q_OVERFLOW)
+				{
+					Rescan();
+					continue;
+				}
+
+				auto folder = _folders.find(event.wd);
+
+				if (event.len == 0 || folder == _folders.end())
+					continue;
+
+				for (const std::string& spelling : folder->second)
+				{
+					auto file = _files.find(spelling + "/" + event.name);
+					if (file == _files.end())
+						continue;
+
+					//Kept up to date for Rescan
+					Stamp(file->second);
+					_changes.insert(file->second.filename);
+				}
+			}
+		}
+	}
+#endif
+}
+
+void FileWatcher::PollThread()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+
+	while (!_wake.wait_for(lock, std::chrono::milliseconds(_pollMilliseconds), [this]() { return _stopping; }))
+		Rescan();
+}
+
+void FileWatcher::Rescan()
+{
+	for (auto& watched : _files)
+	{
+		WatchedFile& file = watched.second;
+		WatchedFile before = file;
+		Stamp(file);
+
+		//A file that's gone isn't a change, but coming back is
+		if (file.exists && (!before.exists || file.size != before.size || file.modifiedTime != before.modifiedTime))
+			_changes.insert(file.filename);
+	}
+}
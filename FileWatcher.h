@@ -0,0 +1,70 @@
+#pragma once
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <stdint.h>
+#include <vector>
+
+//Watches files for changes on a thread of its own, for reloading assets while the game runs. On Linux it's told about
+//changes by inotify, as soon as whatever wrote the file closes it. Elsewhere, or if inotify can't be used, it checks the
+//size and modification time of every file it's watching every so often instead, to well under a second so saving twice
+//in quick succession isn't missed.
+//
+//A file that changes several times between calls to TakeChanges is only reported once. If inotify has more changes
+//than it can queue and drops some, every file is checked the way polling does, so none of them are missed.
+class FileWatcher
+{
+private:
+	struct WatchedFile
+	{
+		std::string filename;			//As it was given to Watch
+
+		//When it was last looked at, for polling and for when inotify drops changes
+		bool exists;
+		uint64_t size;
+		int64_t modifiedTime;			//In whatever units the platform gives, only ever compared
+	};
+
+	unsigned int _pollMilliseconds;
+	bool _stopping;
+	int _notify;						//inotify descriptor, -1 when polling
+
+	std::mutex _lock;
+	std::condition_variable _wake;
+	std::thread _thread;
+
+	std::map<std::string, WatchedFile> _files;		//By folder + "/" + name, the form inotify reports them in
+	std::map<int, std::vector<std::string>> _folders;	//inotify watch descriptor to each way its folder was spelled
+	std::set<std::string> _changes;
+
+	static std::string getFolder(const std::string& filename);
+	static std::string getKey(const std::string& filename);
+	static void Stamp(WatchedFile& file);
+
+	void WatchFolder(const std::string& folder);
+	void Rescan();
+	void NotifyThread();
+	void PollThread();
+
+public:
+	FileWatcher();
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	//Starts the thread. pollMilliseconds is how often files are checked when there's no inotify
+	void Start(unsigned int pollMilliseconds = 250);
+	void Stop();
+
+	//Can be called from any thread, before or after Start
+	void Watch(const char* filename);
+
+	//The files that have changed since the last call, as they were given to Watch
+	std::vector<std::string> TakeChanges();
+
+	bool isNotified() const { return _notify >= 0; }
+};
@@ -0,0 +1,178 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+	_data = nullptr;
+	_size = 0;
+
+#ifdef _WIN32
+	_file = nullptr;
+	_mapping = nullptr;
+#else
+	_file = -1;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* filename, bool sequential)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	_file = file;
+
+	return MapOpenedFile();
+}
+
+bool MappedFile::Open(const wchar_t* filename, bool sequential)
+{
+	Close();
+
+	HANDLE file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	_file = file;
+
+	return MapOpenedFile();
+}
+
+bool MappedFile::MapOpenedFile()
+{
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_file, &fileSize) || fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart > (size_t)-1)
+	{
+		Close();
+		return false;
+	}
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (!_mapping)
+	{
+		Close();
+		return false;
+	}
+
+	_data = (const uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!_data)
+	{
+		Close();
+		return false;
+	}
+
+	_size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const
+{
+#if _WIN32_WINNT >= 0x0602
+	if (!_data || offset >= _size)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range = { (void*)(_data + offset), size < _size - offset ? size : _size - offset };
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	// Windows 7 has no PrefetchVirtualMemory, so the pages are read as they're touched
+	(void)offset;
+	(void)size;
+#endif
+}
+
+void MappedFile::Close()
+{
+	if (_data) UnmapViewOfFile(_data);
+	if (_mapping) CloseHandle(_mapping);
+	if (_file) CloseHandle(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename, bool sequential)
+{
+	Close();
+
+	_file = open(filename, O_RDONLY);
+
+	if (_file < 0)
+		return false;
+
+	struct stat fileInfo;
+	if (fstat(_file, &fileInfo) != 0 || fileInfo.st_size == 0 || (unsigned long long)fileInfo.st_size > (size_t)-1)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, _file, 0);
+
+	if (data == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	// We walk the file front to back, so let the kernel read ahead aggressively. Otherwise only
+	// what's touched or prefetched is read
+	madvise(data, (size_t)fileInfo.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+	_data = (const uint8_t*)data;
+	_size = (size_t)fileInfo.st_size;
+
+	return true;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const
+{
+	if (!_data || offset >= _size)
+		return;
+
+	// madvise wants a page aligned start
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = offset - offset % pageSize;
+	size_t end = size < _size - offset ? offset + size : _size;
+
+	madvise((void*)(_data + start), end - start, MADV_WILLNEED);
+}
+
+void MappedFile::Close()
+{
+	if (_data) munmap((void*)_data, _size);
+	if (_file >= 0) close(_file);
+
+	_data = nullptr;
+	_size = 0;
+	_file = -1;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Read-only view of a whole file mapped into the address space. The OS pages the
+// contents in on demand, so nothing is copied until it is actually touched.
+class MappedFile
+{
+private:
+	const uint8_t* _data;
+	size_t _size;
+
+#ifdef _WIN32
+	void* _file;
+	void* _mapping;
+
+	bool MapOpenedFile();
+#else
+	int _file;
+#endif
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Maps the whole file, returns false if it can't be opened or mapped. Files bigger than
+	// 4 GB are fine in a 64-bit build, a 32-bit one hasn't the address space for them.
+	// Sequential files are read ahead of where they're touched, which only wastes reads if
+	// just a few parts of the file will be used
+	bool Open(const char* filename, bool sequential = true);
+#ifdef _WIN32
+	bool Open(const wchar_t* filename, bool sequential = true);
+#endif
+	void Close();
+
+	// Starts reading size bytes from offset in, ahead of them being touched
+	void Prefetch(size_t offset, size_t size) const;
+
+	bool isOpen() const { return _data != nullptr; }
+	const uint8_t* getData() const { return _data; }
+	size_t getSize() const { return _size; }
+};
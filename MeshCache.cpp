@@ -0,0 +1,761 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include "MeshCodec.h"
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace MeshCache;
+
+namespace
+{
+	static_assert(sizeof(MeshCacheHeader) == 144, "MeshCacheHeader is written as is, so its layout can't change without a new Version");
+	static_assert(sizeof(MeshCacheSection) == 48, "MeshCacheSection is written as is, so its layout can't change without a new Version");
+
+	//More sections than a valid cache could ever have, so a damaged count can't make Load read a huge table
+	const uint32_t MaxSections = 16;
+
+	//What a level of detail looks like on disk, its draw ranges are in the SectionDrawRanges section
+	struct CachedLOD
+	{
+		float error;
+		uint32_t rangeStart;
+		uint32_t rangeCount;
+		uint32_t padding;
+	};
+
+	const uint64_t Prime1 = 11400714785074694791ULL;
+	const uint64_t Prime2 = 14029467366897019727ULL;
+	const uint64_t Prime3 = 1609587929392839161ULL;
+	const uint64_t Prime4 = 9650029242287828579ULL;
+	const uint64_t Prime5 = 2870177450012600261ULL;
+
+	inline uint64_t RotateLeft(uint64_t x, int bits)
+	{
+		return (x << bits) | (x >> (64 - bits));
+	}
+
+	inline uint64_t Read64(const uint8_t* p)
+	{
+		uint64_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint32_t Read32(const uint8_t* p)
+	{
+		uint32_t value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	inline uint64_t Round(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * Prime2;
+		accumulator = RotateLeft(accumulator, 31);
+		return accumulator * Prime1;
+	}
+
+	inline uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+	{
+		accumulator ^= Round(0, value);
+		return accumulator * Prime1 + Prime4;
+	}
+
+	inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	//Sections are laid out one after the other in the order they're added
+	class SectionWriter
+	{
+	private:
+		std::vector<MeshCacheSection> _sections;
+		std::vector<const void*> _data;
+		uint64_t _end;
+
+	public:
+		SectionWriter(uint64_t start) : _end(start) {}
+
+		void Add(uint32_t type, uint32_t elementSize, const void* data, uint64_t size, uint32_t encoding = EncodingNone, uint64_t decodedSize = 0)
+		{
+			MeshCacheSection section;
+			section.type = type;
+			section.elementSize = elementSize;
+			section.encoding = encoding;
+			section.padding = 0;
+			section.offset = AlignUp(_end, SectionAlignment);
+			section.size = size;
+			section.decodedSize = encoding == EncodingNone ? size : decodedSize;
+			section.checksum = Hash64(data, (size_t)size);
+
+			_sections.push_back(section);
+			_data.push_back(data);
+			_end = section.offset + size;
+		}
+
+		const std::vector<MeshCacheSection>& getSections() const { return _sections; }
+		const void* getData(unsigned int i) const { return _data[i]; }
+	};
+
+	uint64_t TableChecksum(MeshCacheHeader header, const MeshCacheSection* sections, uint32_t sectionCount)
+	{
+		header.tableChecksum = 0;
+		return Hash64(sections, sectionCount * sizeof(MeshCacheSection), Hash64(&header, sizeof(header)));
+	}
+
+	const MeshCacheSection* FindSection(const std::vector<MeshCacheSection>& sections, uint32_t type)
+	{
+		for (const MeshCacheSection& section : sections)
+		{
+			if (section.type == type)
+				return &section;
+		}
+
+		return nullptr;
+	}
+
+	//Reads a whole section into out, returning false if the file is short or the checksum doesn't match
+	template<typename T>
+	bool ReadSection(std::ifstream& file, const MeshCacheSection& section, std::vector<T>& out, uint32_t elementSize = sizeof(T))
+	{
+		if (section.elementSize != elementSize || section.size % elementSize != 0 || section.encoding != EncodingNone)
+			return false;
+
+		out.resize((size_t)(section.size / sizeof(T)));
+
+		file.seekg((std::streamoff)section.offset);
+		file.read((char*)out.data(), (std::streamsize)section.size);
+
+		return file.good() && Hash64(out.data(), (size_t)section.size) == section.checksum;
+	}
+
+	//Decodes a section of count elements compressed with MeshCodec into out
+	bool DecodeSection(const MeshCacheSection& section, const uint8_t* data, uint32_t count, std::vector<uint8_t>& out)
+	{
+		if (section.decodedSize != (uint64_t)section.elementSize * count)
+			return false;
+
+		out.resize((size_t)section.decodedSize);
+
+		if (section.type == SectionVertices)
+			return MeshCodec::DecodeVertices(data, (size_t)section.size, count, section.elementSize, out.data());
+
+		return MeshCodec::DecodeIndices(data, (size_t)section.size, count, section.elementSize, out.data());
+	}
+
+	//Reads the vertex or index section, which unlike the others might be compressed
+	bool ReadStreamSection(std::ifstream& file, const MeshCacheSection& section, uint32_t elementSize, uint32_t count, std::vector<uint8_t>& out)
+	{
+		if (section.encoding == EncodingNone)
+			return ReadSection(file, section, out, elementSize);
+
+		if (section.encoding != EncodingMeshCodec || section.elementSize != elementSize)
+			return false;
+
+		std::vector<uint8_t> encoded((size_t)section.size);
+
+		file.seekg((std::streamoff)section.offset);
+		file.read((char*)encoded.data(), (std::streamsize)section.size);
+
+		return file.good() && Hash64(encoded.data(), encoded.size()) == section.checksum && DecodeSection(section, encoded.data(), count, out);
+	}
+
+	//The largest of count indices from start, 0 if there are none
+	uint32_t MaxIndex(const uint8_t* indices, uint32_t indexSize, uint64_t start, uint64_t count)
+	{
+		uint32_t largest = 0;
+
+		if (indexSize == 2)
+		{
+			const uint16_t* first = (const uint16_t*)indices + start;
+			for (uint64_t i = 0; i < count; ++i)
+				largest = first[i] > largest ? first[i] : largest;
+		}
+		else
+		{
+			const uint32_t* first = (const uint32_t*)indices + start;
+			for (uint64_t i = 0; i < count; ++i)
+				largest = first[i] > largest ? first[i] : largest;
+		}
+
+		return largest;
+	}
+
+	//Makes sure nothing in the mesh points outside of it, down to every index each draw range and meshlet draws, so a
+	//cache that passes its checksums but is from a buggy cooker can't read past the vertex buffer. Meshlets are drawn
+	//with no base vertex
+	bool IsConsistent(const CookedMeshView& mesh, uint64_t vertexBytes, uint64_t indexBytes)
+	{
+		const CookedMeshInfo& info = mesh.info;
+
+		if (vertexBytes != (uint64_t)info.vertexStride * info.vertexCount || indexBytes != (uint64_t)info.indexSize * info.indexCount)
+			return false;
+
+		if (mesh.lods.empty())
+			return false;
+
+		for (const MeshLOD& lod : mesh.lods)
+		{
+			for (const MeshDrawRange& range : lod.DrawRanges)
+			{
+				if ((uint64_t)range.IndexStart + range.IndexCount > info.indexCount || range.BaseVertex < 0)
+					return false;
+
+				if (range.IndexCount > 0 &&
+					(uint64_t)range.BaseVertex + MaxIndex(mesh.indices, info.indexSize, range.IndexStart, range.IndexCount) >= info.vertexCount)
+				{
+					return false;
+				}
+			}
+		}
+
+		for (uint32_t i = 0; i < mesh.meshletCount; ++i)
+		{
+			const Meshlet& meshlet = mesh.meshlets[i];
+
+			if ((uint64_t)meshlet.indexStart + meshlet.indexCount > info.indexCount)
+				return false;
+
+			if (meshlet.indexCount > 0 && MaxIndex(mesh.indices, info.indexSize, meshlet.indexStart, meshlet.indexCount) >= info.vertexCount)
+				return false;
+		}
+
+		return true;
+	}
+
+	//Everything that can be checked from the header and section table alone, plus whether the source has changed
+	MeshCacheStatus CheckHeader(const MeshCacheHeader& header, const MeshCacheSection* sections, uint64_t fileSize,
+								const char* sourceFilename, uint64_t settingsHash)
+	{
+		if (TableChecksum(header, sections, header.sectionCount) != header.tableChecksum)
+			return MeshCacheCorrupt;
+
+		for (uint32_t i = 0; i < header.sectionCount; ++i)
+		{
+			if (sections[i].offset > fileSize || sections[i].size > fileSize - sections[i].offset)
+				return MeshCacheCorrupt;
+		}
+
+		if (header.settingsHash != settingsHash)
+			return MeshCacheStale;
+
+		//Caches in a pack are trusted to match whatever they were cooked from
+		if (!sourceFilename)
+			return MeshCacheValid;
+
+		MeshSourceInfo recorded;
+		recorded.size = header.sourceSize;
+		recorded.modifiedTime = header.sourceModifiedTime;
+		recorded.hash = header.sourceHash;
+
+		return CheckSource(sourceFilename, recorded);
+	}
+
+	//Checks the parts of the header that say whether this is a cache this code can read at all
+	MeshCacheStatus CheckFormat(const MeshCacheHeader& header)
+	{
+		if (header.magic != Magic || header.version != Version || header.headerSize != sizeof(MeshCacheHeader) || header.byteOrder != ByteOrderMark)
+			return MeshCacheIncompatible;
+
+		uint32_t expectedStride = (header.flags & FlagCompactVertices) ? sizeof(CompactVertex) : sizeof(SimpleVertex);
+
+		if (header.vertexStride != expectedStride || (header.indexSize != 2 && header.indexSize != 4))
+			return MeshCacheIncompatible;
+
+		if (header.sectionCount > MaxSections)
+			return MeshCacheCorrupt;
+
+		return MeshCacheValid;
+	}
+
+	CookedMeshInfo GetInfo(const MeshCacheHeader& header)
+	{
+		CookedMeshInfo info;
+		info.vertexStride = header.vertexStride;
+		info.vertexCount = header.vertexCount;
+		info.indexSize = header.indexSize;
+		info.indexCount = header.indexCount;
+		info.compactVertices = (header.flags & FlagCompactVertices) != 0;
+		memcpy(&info.posScale, header.posScale, sizeof(header.posScale));
+		memcpy(&info.posOffset, header.posOffset, sizeof(header.posOffset));
+		memcpy(&info.bounds.boxMin, header.boxMin, sizeof(header.boxMin));
+		memcpy(&info.bounds.boxMax, header.boxMax, sizeof(header.boxMax));
+		memcpy(&info.bounds.sphereCenter, header.sphereCenter, sizeof(header.sphereCenter));
+		info.bounds.sphereRadius = header.sphereRadius;
+
+		return info;
+	}
+
+	//Turns the flattened levels of detail back into MeshLODs
+	bool UnflattenLODs(const CachedLOD* lods, size_t lodCount, const MeshDrawRange* ranges, size_t rangeCount, std::vector<MeshLOD>& outLODs)
+	{
+		for (size_t i = 0; i < lodCount; ++i)
+		{
+			if ((uint64_t)lods[i].rangeStart + lods[i].rangeCount > rangeCount)
+				return false;
+
+			MeshLOD lod;
+			lod.Error = lods[i].error;
+			lod.DrawRanges.assign(ranges + lods[i].rangeStart, ranges + lods[i].rangeStart + lods[i].rangeCount);
+			outLODs.push_back(lod);
+		}
+
+		return true;
+	}
+
+	//Points at a section of a mapped file, after checking its element size and checksum
+	template<typename T>
+	bool MapSection(const uint8_t* data, const MeshCacheSection& section, const T*& out, size_t& outCount, uint32_t elementSize = sizeof(T))
+	{
+		if (section.elementSize != elementSize || section.size % elementSize != 0 || section.offset % SectionAlignment != 0 || section.encoding != EncodingNone)
+			return false;
+
+		out = (const T*)(data + section.offset);
+		outCount = (size_t)(section.size / sizeof(T));
+
+		return Hash64(out, (size_t)section.size) == section.checksum;
+	}
+
+	//Points at the vertex or index section of a mapped file, or decodes it into decoded if it's compressed
+	bool MapStreamSection(const uint8_t* data, const MeshCacheSection& section, uint32_t elementSize, uint32_t count,
+						  const uint8_t*& out, size_t& outSize, std::vector<uint8_t>& decoded)
+	{
+		if (section.encoding == EncodingNone)
+			return MapSection(data, section, out, outSize, elementSize);
+
+		if (section.encoding != EncodingMeshCodec || section.elementSize != elementSize)
+			return false;
+
+		const uint8_t* encoded = data + section.offset;
+
+		if (Hash64(encoded, (size_t)section.size) != section.checksum || !DecodeSection(section, encoded, count, decoded))
+			return false;
+
+		out = decoded.data();
+		outSize = decoded.size();
+
+		return true;
+	}
+}
+
+uint64_t MeshCache::Hash64(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	const uint8_t* end = p + size;
+	uint64_t hash;
+
+	if (size >= 32)
+	{
+		uint64_t v1 = seed + Prime1 + Prime2;
+		uint64_t v2 = seed + Prime2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - Prime1;
+
+		//Four independent lanes of 8 bytes each, so the multiplies can overlap
+		for (; p + 32 <= end; p += 32)
+		{
+			v1 = Round(v1, Read64(p));
+			v2 = Round(v2, Read64(p + 8));
+			v3 = Round(v3, Read64(p + 16));
+			v4 = Round(v4, Read64(p + 24));
+		}
+
+		hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+		hash = MergeRound(hash, v1);
+		hash = MergeRound(hash, v2);
+		hash = MergeRound(hash, v3);
+		hash = MergeRound(hash, v4);
+	}
+	else
+	{
+		hash = seed + Prime5;
+	}
+
+	hash += size;
+
+	for (; p + 8 <= end; p += 8)
+	{
+		hash ^= Round(0, Read64(p));
+		hash = RotateLeft(hash, 27) * Prime1 + Prime4;
+	}
+
+	if (p + 4 <= end)
+	{
+		hash ^= Read32(p) * Prime1;
+		hash = RotateLeft(hash, 23) * Prime2 + Prime3;
+		p += 4;
+	}
+
+	for (; p < end; ++p)
+	{
+		hash ^= *p * Prime5;
+		hash = RotateLeft(hash, 11) * Prime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= Prime2;
+	hash ^= hash >> 29;
+	hash *= Prime3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+bool MeshCache::GetSourceInfo(const char* filename, MeshSourceInfo& outInfo, bool hashContents)
+{
+	//As finely as the file system records it, since in whole seconds an edit that kept the size and was saved in the same
+	//second as the cook would look like the file the cache was cooked from
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &attributes))
+		return false;
+
+	outInfo.size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	outInfo.modifiedTime = ((int64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat status;
+	if (stat(filename, &status) != 0)
+		return false;
+
+	outInfo.size = (uint64_t)status.st_size;
+#ifdef __APPLE__
+	outInfo.modifiedTime = (int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+	outInfo.modifiedTime = (int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif
+#endif
+
+	outInfo.hash = 0;
+
+	if (hashContents && outInfo.size > 0)
+	{
+		MappedFile file;
+
+		if (!file.Open(filename))
+			return false;
+
+		outInfo.hash = Hash64(file.getData(), file.getSize());
+	}
+
+	return true;
+}
+
+MeshCacheStatus MeshCache::CheckSource(const char* sourceFilename, const MeshSourceInfo& recorded)
+{
+	MeshSourceInfo source;
+
+	if (!GetSourceInfo(sourceFilename, source, false))
+		return MeshCacheMissing;
+
+	if (source.size != recorded.size)
+		return MeshCacheStale;
+
+	if (source.modifiedTime != recorded.modifiedTime)
+	{
+		if (!GetSourceInfo(sourceFilename, source, true) || source.hash != recorded.hash)
+			return MeshCacheStale;
+	}
+
+	return MeshCacheValid;
+}
+
+std::string MeshCache::getTemporaryFilename(const char* filename)
+{
+	static std::atomic<unsigned int> count(0);
+
+#ifdef _WIN32
+	unsigned long process = GetCurrentProcessId();
+#else
+	unsigned long process = (unsigned long)getpid();
+#endif
+
+	char suffix[48];
+	snprintf(suffix, sizeof(suffix), ".%lu-%u.tmp", process, count++);
+
+	return filename + std::string(suffix);
+}
+
+bool MeshCache::RenameOver(const char* temporaryFilename, const char* filename)
+{
+#ifdef _WIN32
+	bool renamed = MoveFileExA(temporaryFilename, filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	bool renamed = rename(temporaryFilename, filename) == 0;
+#endif
+
+	if (!renamed)
+		remove(temporaryFilename);
+
+	return renamed;
+}
+
+bool MeshCache::Save(const char* filename, const CookedMesh& mesh, const MeshSourceInfo& source, uint64_t settingsHash, bool compress)
+{
+	//Levels of detail are flattened into one list of draw ranges
+	std::vector<CachedLOD> lods;
+	std::vector<MeshDrawRange> ranges;
+
+	for (const MeshLOD& lod : mesh.lods)
+	{
+		CachedLOD cached = { lod.Error, (uint32_t)ranges.size(), (uint32_t)lod.DrawRanges.size(), 0 };
+		lods.push_back(cached);
+		ranges.insert(ranges.end(), lod.DrawRanges.begin(), lod.DrawRanges.end());
+	}
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = Magic;
+	header.version = Version;
+	header.headerSize = sizeof(MeshCacheHeader);
+	header.byteOrder = ByteOrderMark;
+	header.sourceSize = source.size;
+	header.sourceModifiedTime = source.modifiedTime;
+	header.sourceHash = source.hash;
+	header.settingsHash = settingsHash;
+	header.vertexStride = mesh.info.vertexStride;
+	header.vertexCount = mesh.info.vertexCount;
+	header.indexSize = mesh.info.indexSize;
+	header.indexCount = mesh.info.indexCount;
+	header.flags = mesh.info.compactVertices ? FlagCompactVertices : 0;
+	memcpy(header.posScale, &mesh.info.posScale, sizeof(header.posScale));
+	memcpy(header.posOffset, &mesh.info.posOffset, sizeof(header.posOffset));
+	memcpy(header.boxMin, &mesh.info.bounds.boxMin, sizeof(header.boxMin));
+	memcpy(header.boxMax, &mesh.info.bounds.boxMax, sizeof(header.boxMax));
+	memcpy(header.sphereCenter, &mesh.info.bounds.sphereCenter, sizeof(header.sphereCenter));
+	header.sphereRadius = mesh.info.bounds.sphereRadius;
+
+	//The table always has room for every section type, empty ones included, so its size is known up front
+	const uint32_t sectionCount = 5;
+	SectionWriter writer(sizeof(MeshCacheHeader) + sectionCount * sizeof(MeshCacheSection));
+
+	std::vector<uint8_t> encodedVertices, encodedIndices;
+
+	if (compress)
+	{
+		MeshCodec::EncodeVertices(mesh.vertices.data(), mesh.info.vertexCount, mesh.info.vertexStride, encodedVertices);
+		MeshCodec::EncodeIndices(mesh.indices.data(), mesh.info.indexCount, mesh.info.indexSize, encodedIndices);
+
+		writer.Add(SectionVertices, mesh.info.vertexStride, encodedVertices.data(), encodedVertices.size(), EncodingMeshCodec, mesh.vertices.size());
+		writer.Add(SectionIndices, mesh.info.indexSize, encodedIndices.data(), encodedIndices.size(), EncodingMeshCodec, mesh.indices.size());
+	}
+	else
+	{
+		writer.Add(SectionVertices, mesh.info.vertexStride, mesh.vertices.data(), mesh.vertices.size());
+		writer.Add(SectionIndices, mesh.info.indexSize, mesh.indices.data(), mesh.indices.size());
+	}
+
+	writer.Add(SectionLODs, sizeof(CachedLOD), lods.data(), lods.size() * sizeof(CachedLOD));
+	writer.Add(SectionDrawRanges, sizeof(MeshDrawRange), ranges.data(), ranges.size() * sizeof(MeshDrawRange));
+	writer.Add(SectionMeshlets, sizeof(Meshlet), mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+
+	const std::vector<MeshCacheSection>& sections = writer.getSections();
+	header.sectionCount = sectionCount;
+	header.tableChecksum = TableChecksum(header, sections.data(), sectionCount);
+
+	std::string temporaryFilename = getTemporaryFilename(filename);
+	std::ofstream file(temporaryFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)sections.data(), sectionCount * sizeof(MeshCacheSection));
+
+	uint64_t position = sizeof(header) + sectionCount * sizeof(MeshCacheSection);
+	const char zeros[SectionAlignment] = {};
+
+	for (uint32_t i = 0; i < sectionCount; ++i)
+	{
+		file.write(zeros, (std::streamsize)(sections[i].offset - position));
+		file.write((const char*)writer.getData(i), (std::streamsize)sections[i].size);
+		position = sections[i].offset + sections[i].size;
+	}
+
+	file.close();
+
+	if (file.fail())
+	{
+		remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	return RenameOver(temporaryFilename.c_str(), filename);
+}
+
+MeshCacheStatus MeshCache::Load(const char* filename, const char* sourceFilename, uint64_t settingsHash, CookedMesh& outMesh)
+{
+	std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+	if (!file.is_open())
+		return MeshCacheMissing;
+
+	file.seekg(0, std::ios::end);
+	uint64_t fileSize = (uint64_t)file.tellg();
+	file.seekg(0, std::ios::beg);
+
+	//Header first, anything that isn't this exact version of the format is turned away before looking any further
+	MeshCacheHeader header;
+
+	if (fileSize < sizeof(header) || !file.read((char*)&header, sizeof(header)))
+		return MeshCacheIncompatible;
+
+	MeshCacheStatus status = CheckFormat(header);
+	if (status != MeshCacheValid)
+		return status;
+
+	std::vector<MeshCacheSection> sections(header.sectionCount);
+
+	if (!file.read((char*)sections.data(), header.sectionCount * sizeof(MeshCacheSection)))
+		return MeshCacheCorrupt;
+
+	status = CheckHeader(header, sections.data(), fileSize, sourceFilename, settingsHash);
+	if (status != MeshCacheValid)
+		return status;
+
+	const MeshCacheSection* vertexSection = FindSection(sections, SectionVertices);
+	const MeshCacheSection* indexSection = FindSection(sections, SectionIndices);
+	const MeshCacheSection* lodSection = FindSection(sections, SectionLODs);
+	const MeshCacheSection* rangeSection = FindSection(sections, SectionDrawRanges);
+	const MeshCacheSection* meshletSection = FindSection(sections, SectionMeshlets);
+
+	if (!vertexSection || !indexSection || !lodSection || !rangeSection || !meshletSection)
+		return MeshCacheCorrupt;
+
+	//Then the sections, each straight into where it ends up
+	CookedMesh mesh;
+	mesh.info = GetInfo(header);
+
+	std::vector<CachedLOD> lods;
+	std::vector<MeshDrawRange> ranges;
+
+	if (!ReadStreamSection(file, *vertexSection, mesh.info.vertexStride, mesh.info.vertexCount, mesh.vertices) ||
+		!ReadStreamSection(file, *indexSection, mesh.info.indexSize, mesh.info.indexCount, mesh.indices) ||
+		!ReadSection(file, *lodSection, lods) || !ReadSection(file, *rangeSection, ranges) || !ReadSection(file, *meshletSection, mesh.meshlets))
+	{
+		return MeshCacheCorrupt;
+	}
+
+	if (!UnflattenLODs(lods.data(), lods.size(), ranges.data(), ranges.size(), mesh.lods) ||
+		!IsConsistent(getView(mesh), mesh.vertices.size(), mesh.indices.size()))
+	{
+		return MeshCacheCorrupt;
+	}
+
+	outMesh = std::move(mesh);
+	return MeshCacheValid;
+}
+
+MeshCacheStatus MeshCache::MapData(const uint8_t* data, size_t size, const char* sourceFilename, uint64_t settingsHash, CookedMeshView& outView)
+{
+	if (size < sizeof(MeshCacheHeader))
+		return MeshCacheIncompatible;
+
+	//Mappings start on a page boundary, and packs keep each cache on one, so the header and table can be used where they are
+	const MeshCacheHeader& header = *(const MeshCacheHeader*)data;
+
+	MeshCacheStatus status = CheckFormat(header);
+	if (status != MeshCacheValid)
+		return status;
+
+	if (size < sizeof(MeshCacheHeader) + header.sectionCount * sizeof(MeshCacheSection))
+		return MeshCacheCorrupt;
+
+	const MeshCacheSection* table = (const MeshCacheSection*)(data + sizeof(MeshCacheHeader));
+	std::vector<MeshCacheSection> sections(table, table + header.sectionCount);
+
+	status = CheckHeader(header, sections.data(), size, sourceFilename, settingsHash);
+	if (status != MeshCacheValid)
+		return status;
+
+	const MeshCacheSection* vertexSection = FindSection(sections, SectionVertices);
+	const MeshCacheSection* indexSection = FindSection(sections, SectionIndices);
+	const MeshCacheSection* lodSection = FindSection(sections, SectionLODs);
+	const MeshCacheSection* rangeSection = FindSection(sections, SectionDrawRanges);
+	const MeshCacheSection* meshletSection = FindSection(sections, SectionMeshlets);
+
+	if (!vertexSection || !indexSection || !lodSection || !rangeSection || !meshletSection)
+		return MeshCacheCorrupt;
+
+	//Checking the checksums reads every page of the sections, which the upload would have to do anyway.
+	//Compressed sections are decoded straight into view, so the pointers into them stay good when it's moved out
+	CookedMeshView view;
+	view.info = GetInfo(header);
+
+	const CachedLOD* lods;
+	const MeshDrawRange* ranges;
+	size_t vertexBytes, indexBytes, lodCount, rangeCount, meshletCount;
+
+	if (!MapStreamSection(data, *vertexSection, view.info.vertexStride, view.info.vertexCount, view.vertices, vertexBytes, view.decodedVertices) ||
+		!MapStreamSection(data, *indexSection, view.info.indexSize, view.info.indexCount, view.indices, indexBytes, view.decodedIndices) ||
+		!MapSection(data, *lodSection, lods, lodCount) || !MapSection(data, *rangeSection, ranges, rangeCount) ||
+		!MapSection(data, *meshletSection, view.meshlets, meshletCount))
+	{
+		return MeshCacheCorrupt;
+	}
+
+	view.meshletCount = (uint32_t)meshletCount;
+
+	if (!UnflattenLODs(lods, lodCount, ranges, rangeCount, view.lods) || !IsConsistent(view, vertexBytes, indexBytes))
+		return MeshCacheCorrupt;
+
+	outView = std::move(view);
+	return MeshCacheValid;
+}
+
+MeshCacheStatus MeshCache::Map(const char* filename, const char* sourceFilename, uint64_t settingsHash, MappedFile& outFile, CookedMeshView& outView)
+{
+	if (!outFile.Open(filename))
+		return MeshCacheMissing;
+
+	MeshCacheStatus status = MapData(outFile.getData(), outFile.getSize(), sourceFilename, settingsHash, outView);
+
+	//Don't keep a bad cache open, on Windows that would stop it being replaced
+	if (status != MeshCacheValid)
+		outFile.Close();
+
+	return status;
+}
+
+CookedMeshView MeshCache::getView(const CookedMesh& mesh)
+{
+	CookedMeshView view;
+	view.info = mesh.info;
+	view.vertices = mesh.vertices.data();
+	view.indices = mesh.indices.data();
+	view.meshlets = mesh.meshlets.data();
+	view.meshletCount = (uint32_t)mesh.meshlets.size();
+	view.lods = mesh.lods;
+
+	return view;
+}
+
+const char* MeshCache::getStatusName(MeshCacheStatus status)
+{
+	switch (status)
+	{
+	case MeshCacheValid:
+		return "valid";
+	case MeshCacheMissing:
+		return "missing";
+	case MeshCacheIncompatible:
+		return "incompatible";
+	case MeshCacheStale:
+		return "stale";
+	case MeshCacheCorrupt:
+		return "corrupt";
+	}
+
+	return "unknown";
+}
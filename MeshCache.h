@@ -0,0 +1,193 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Structures.h"
+#include "BoundingVolumes.h"
+#include "MeshletBuilder.h"
+#include "MappedFile.h"
+
+//Counts and formats of a cooked mesh
+struct CookedMeshInfo
+{
+	uint32_t vertexStride;		//sizeof(SimpleVertex), or sizeof(CompactVertex) if compactVertices is set
+	uint32_t vertexCount;
+	uint32_t indexSize;			//2 or 4 bytes
+	uint32_t indexCount;
+
+	bool compactVertices;
+	XMFLOAT3 posScale;
+	XMFLOAT3 posOffset;
+
+	//Of the positions as they're drawn, dequantized if compactVertices is set
+	MeshBounds bounds;
+};
+
+//A mesh exactly as it goes into its vertex and index buffers, which is what the cache stores
+struct CookedMesh
+{
+	CookedMeshInfo info;
+
+	std::vector<uint8_t> vertices;
+	std::vector<uint8_t> indices;
+	std::vector<MeshLOD> lods;
+	std::vector<Meshlet> meshlets;
+};
+
+//A cooked mesh whose vertices, indices and meshlets belong to something else, either a CookedMesh or a cache file
+//mapped with MeshCache::Map. The levels of detail are tiny so they're always copied. If the cache was compressed the
+//vertices and indices can't be used in place, so they're decoded into decodedVertices and decodedIndices and point there
+//instead, which means a view can be moved but not copied
+struct CookedMeshView
+{
+	CookedMeshInfo info;
+
+	const uint8_t* vertices;
+	const uint8_t* indices;
+	const Meshlet* meshlets;
+	uint32_t meshletCount;
+	std::vector<MeshLOD> lods;
+
+	std::vector<uint8_t> decodedVertices;
+	std::vector<uint8_t> decodedIndices;
+};
+
+//What a cache was cooked from. The size and modification time are a quick check, the hash of the contents
+//is what decides in the end, so a file that was only touched or copied doesn't need cooking again
+struct MeshSourceInfo
+{
+	uint64_t size;
+	int64_t modifiedTime;		//In whatever units the platform gives, 100 ns on Windows and 1 ns elsewhere, only ever compared
+	uint64_t hash;
+};
+
+enum MeshCacheStatus
+{
+	MeshCacheValid,
+	MeshCacheMissing,			//No cache file, or the source file can't be read
+	MeshCacheIncompatible,		//Not a cache, or written by a different version or on a machine with a different byte order
+	MeshCacheStale,				//The source file or the settings it was cooked with have changed
+	MeshCacheCorrupt			//Truncated, or a checksum doesn't match
+};
+
+//Cooked mesh files. The layout is:
+//
+//	MeshCacheHeader			magic, version, byte order, what it was cooked from, the mesh's counts and formats
+//	MeshCacheSection[]		type, encoding, offset, size and checksum of each section
+//	sections				vertices, indices, levels of detail, draw ranges, meshlets, each starting on a
+//							SectionAlignment boundary so they can be handed to Direct3D in place
+//
+//The vertex and index sections can be compressed with MeshCodec, which makes the file smaller and quicker to read from
+//disk but means they have to be decoded rather than used in place.
+//
+//The header and section table are checked before anything else is read, then each section is checked against its
+//checksum as it's read (Load) or where it is in the mapped file (Map).
+namespace MeshCache
+{
+	const uint32_t Magic = 0x4853454d;			//"MESH"
+	const uint16_t Version = 4;
+	const uint32_t ByteOrderMark = 0x01020304;
+	const uint32_t SectionAlignment = 64;
+
+	enum SectionType
+	{
+		SectionVertices = 1,
+		SectionIndices,
+		SectionLODs,
+		SectionDrawRanges,
+		SectionMeshlets
+	};
+
+	enum SectionEncoding
+	{
+		EncodingNone,
+		EncodingMeshCodec			//Only for SectionVertices and SectionIndices
+	};
+
+	enum HeaderFlags
+	{
+		FlagCompactVertices = 1
+	};
+
+	struct MeshCacheHeader
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t headerSize;
+		uint32_t byteOrder;			//ByteOrderMark as written by the machine that cooked it
+		uint32_t sectionCount;
+
+		uint64_t sourceSize;
+		int64_t sourceModifiedTime;
+		uint64_t sourceHash;
+		uint64_t settingsHash;		//Anything else the cooked data depends on, e.g. load options and vertex layouts
+
+		uint32_t vertexStride;
+		uint32_t vertexCount;
+		uint32_t indexSize;
+		uint32_t indexCount;
+		uint32_t flags;
+		float posScale[3];
+		float posOffset[3];
+		float boxMin[3];
+		float boxMax[3];
+		float sphereCenter[3];
+		float sphereRadius;
+		uint32_t padding;
+
+		uint64_t tableChecksum;		//Hash of the header (with this as 0) followed by the section table
+	};
+
+	struct MeshCacheSection
+	{
+		uint32_t type;
+		uint32_t elementSize;
+		uint32_t encoding;
+		uint32_t padding;
+		uint64_t offset;
+		uint64_t size;				//In the file
+		uint64_t decodedSize;		//Once decoded, the same as size if encoding is EncodingNone
+		uint64_t checksum;			//Of the bytes in the file
+	};
+
+	//xxHash64 of size bytes
+	uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+	//Size and modification time of a file, plus the hash of its contents if hashContents is set
+	bool GetSourceInfo(const char* filename, MeshSourceInfo& outInfo, bool hashContents);
+
+	//Whether sourceFilename is still what recorded was taken from: MeshCacheValid, MeshCacheStale or MeshCacheMissing if
+	//it can't be read. Only hashes it if the size matches but the time doesn't, i.e. it was touched or copied rather than
+	//edited. MipGenerator checks its caches with this too
+	MeshCacheStatus CheckSource(const char* sourceFilename, const MeshSourceInfo& recorded);
+
+	//A name next to filename for writing it under before renaming it over filename, different for every call in every
+	//process, so two threads or processes writing the same file at once can't truncate each other's
+	std::string getTemporaryFilename(const char* filename);
+
+	//Renames temporaryFilename over filename, which is replaced if it's there, and on Windows doesn't return until the
+	//rename is on the disk. temporaryFilename is removed if that fails. Not ReplaceFile, which windows.h defines as a macro
+	bool RenameOver(const char* temporaryFilename, const char* filename);
+
+	//Writes the mesh to a temporary file next to filename and then renames it over filename, so a crash half way
+	//through never leaves a broken cache behind and nothing reading the cache sees it half written. compress encodes
+	//the vertices and indices with MeshCodec
+	bool Save(const char* filename, const CookedMesh& mesh, const MeshSourceInfo& source, uint64_t settingsHash, bool compress = false);
+
+	//Loads filename into outMesh if it's a valid cache of sourceFilename cooked with settingsHash
+	MeshCacheStatus Load(const char* filename, const char* sourceFilename, uint64_t settingsHash, CookedMesh& outMesh);
+
+	//Same checks as Load, but maps the file into outFile instead of reading it, and points outView straight at the
+	//sections inside it. Nothing but the levels of detail (and compressed sections, decoded) is copied, and outView is
+	//only good while outFile stays open
+	MeshCacheStatus Map(const char* filename, const char* sourceFilename, uint64_t settingsHash, MappedFile& outFile, CookedMeshView& outView);
+
+	//Same as Map, for a cache that's already in memory, e.g. inside a mounted AssetPack. data has to be aligned to at
+	//least SectionAlignment. A null sourceFilename skips checking the cache against its source
+	MeshCacheStatus MapData(const uint8_t* data, size_t size, const char* sourceFilename, uint64_t settingsHash, CookedMeshView& outView);
+
+	CookedMeshView getView(const CookedMesh& mesh);
+
+	const char* getStatusName(MeshCacheStatus status);
+};
@@ -0,0 +1,614 @@
+#include "MeshCodec.h"
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHCODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	//Values are packed in blocks of BlockSize, and the 2-bit modes of ChunkSize / BlockSize blocks share a header
+	const size_t BlockSize = 16;
+	const size_t ChunkSize = 256;
+	const size_t BlocksPerChunk = ChunkSize / BlockSize;
+	const size_t ChunkHeaderSize = BlocksPerChunk * 2 / 8;
+
+	//Bytes of packed data for each block mode: all zero, 2 bits, 4 bits and 8 bits a value
+	const size_t ModeSizes[4] = { 0, 4, 8, 16 };
+
+	//Index codes. 0 is the next unused vertex, 1 to FifoCodes is a hit in the FIFO, and Escape means the
+	//index follows as a varint of the difference from the index before
+	const uint8_t NextVertexCode = 0;
+	const uint8_t FifoCodes = 14;
+	const uint8_t EscapeCode = 15;
+	const unsigned int FifoSize = 16;
+
+	inline uint8_t ZigZag(uint8_t delta)
+	{
+		return (uint8_t)((delta << 1) ^ (uint8_t)((int8_t)delta >> 7));
+	}
+
+	inline uint8_t UnZigZag(uint8_t value)
+	{
+		return (uint8_t)((value >> 1) ^ (uint8_t)(0 - (value & 1)));
+	}
+
+	inline uint32_t ReadIndex(const void* indices, size_t i, size_t indexSize)
+	{
+		return indexSize == 2 ? ((const uint16_t*)indices)[i] : ((const uint32_t*)indices)[i];
+	}
+
+	//Packs ChunkSize values, each block of BlockSize with the fewest bits that fit all of them
+	void EncodeChunk(const uint8_t* values, std::vector<uint8_t>& out)
+	{
+		size_t header = out.size();
+		out.resize(out.size() + ChunkHeaderSize, 0);
+
+		for (size_t b = 0; b < BlocksPerChunk; ++b)
+		{
+			const uint8_t* block = values + b * BlockSize;
+			uint8_t largest = *std::max_element(block, block + BlockSize);
+
+			unsigned int mode = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+			out[header + b / 4] |= (uint8_t)(mode << ((b % 4) * 2));
+
+			//Laid out so the decoder can pull a whole block apart with a few shifts and masks, e.g. with 4 bits the low
+			//nibbles of the 8 bytes are values 0 to 7 and the high nibbles are values 8 to 15
+			if (mode == 1)
+			{
+				for (size_t j = 0; j < 4; ++j)
+					out.push_back((uint8_t)(block[j] | (block[j + 4] << 2) | (block[j + 8] << 4) | (block[j + 12] << 6)));
+			}
+			else if (mode == 2)
+			{
+				for (size_t j = 0; j < 8; ++j)
+					out.push_back((uint8_t)(block[j] | (block[j + 8] << 4)));
+			}
+			else if (mode == 3)
+			{
+				out.insert(out.end(), block, block + BlockSize);
+			}
+		}
+	}
+
+#ifdef MESHCODEC_SSE2
+
+	inline __m128i DecodeBlock(const uint8_t* data, unsigned int mode)
+	{
+		switch (mode)
+		{
+		case 1:
+		{
+			int packed;
+			memcpy(&packed, data, sizeof(packed));
+
+			__m128i x = _mm_cvtsi32_si128(packed);
+			__m128i mask = _mm_set1_epi8(3);
+
+			__m128i a = _mm_and_si128(x, mask);
+			__m128i b = _mm_and_si128(_mm_srli_epi16(x, 2), mask);
+			__m128i c = _mm_and_si128(_mm_srli_epi16(x, 4), mask);
+			__m128i d = _mm_and_si128(_mm_srli_epi16(x, 6), mask);
+
+			return _mm_unpacklo_epi64(_mm_unpacklo_epi32(a, b), _mm_unpacklo_epi32(c, d));
+		}
+		case 2:
+		{
+			__m128i x = _mm_loadl_epi64((const __m128i*)data);
+			__m128i mask = _mm_set1_epi8(15);
+
+			return _mm_unpacklo_epi64(_mm_and_si128(x, mask), _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+		}
+		case 3:
+			return _mm_loadu_si128((const __m128i*)data);
+		default:
+			return _mm_setzero_si128();
+		}
+	}
+
+	//Turns a block of zigzagged differences back into bytes, carry holds the byte before the block in every lane
+	inline __m128i UndoDelta(__m128i x, __m128i& carry)
+	{
+		__m128i one = _mm_set1_epi8(1);
+		__m128i v = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(0x7f)), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(x, one)));
+
+		//Prefix sum across the 16 bytes in four steps
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+		v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+		v = _mm_add_epi8(v, carry);
+
+		//Broadcast the last byte for the next block
+		__m128i last = _mm_unpackhi_epi8(v, v);
+		last = _mm_unpackhi_epi16(last, last);
+		carry = _mm_shuffle_epi32(last, 0xff);
+
+		return v;
+	}
+
+	//Unpacks a chunk into out (ChunkSize bytes), returning where the next one starts or nullptr if data runs out.
+	//With delta set, carry is the byte before the chunk and is updated to its last byte
+	template<bool Delta>
+	const uint8_t* DecodeChunk(const uint8_t* data, const uint8_t* end, uint8_t* out, uint8_t& carry)
+	{
+		if ((size_t)(end - data) < ChunkHeaderSize)
+			return nullptr;
+
+		const uint8_t* header = data;
+		data += ChunkHeaderSize;
+
+		__m128i carryLanes = _mm_set1_epi8((char)carry);
+
+		for (size_t b = 0; b < BlocksPerChunk; ++b)
+		{
+			unsigned int mode = (header[b / 4] >> ((b % 4) * 2)) & 3;
+
+			//DecodeBlock never reads more than the mode says is there
+			if ((size_t)(end - data) < ModeSizes[mode])
+				return nullptr;
+
+			__m128i values = DecodeBlock(data, mode);
+			data += ModeSizes[mode];
+
+			if (Delta)
+				values = UndoDelta(values, carryLanes);
+
+			_mm_storeu_si128((__m128i*)(out + b * BlockSize), values);
+		}
+
+		if (Delta)
+			carry = out[ChunkSize - 1];
+
+		return data;
+	}
+
+#else
+
+	template<bool Delta>
+	const uint8_t* DecodeChunk(const uint8_t* data, const uint8_t* end, uint8_t* out, uint8_t& carry)
+	{
+		if ((size_t)(end - data) < ChunkHeaderSize)
+			return nullptr;
+
+		const uint8_t* header = data;
+		data += ChunkHeaderSize;
+
+		for (size_t b = 0; b < BlocksPerChunk; ++b)
+		{
+			unsigned int mode = (header[b / 4] >> ((b % 4) * 2)) & 3;
+
+			if ((size_t)(end - data) < ModeSizes[mode])
+				return nullptr;
+
+			uint8_t* block = out + b * BlockSize;
+
+			for (size_t j = 0; j < BlockSize; ++j)
+			{
+				switch (mode)
+				{
+				case 0: block[j] = 0; break;
+				case 1: block[j] = (data[j % 4] >> ((j / 4) * 2)) & 3; break;
+				case 2: block[j] = (data[j % 8] >> ((j / 8) * 4)) & 15; break;
+				default: block[j] = data[j]; break;
+				}
+
+				if (Delta)
+				{
+					carry = (uint8_t)(carry + UnZigZag(block[j]));
+					block[j] = carry;
+				}
+			}
+
+			data += ModeSizes[mode];
+		}
+
+		return data;
+	}
+
+#endif
+
+	//Interleaves count vertices back together out of the byte planes, each plane being ChunkSize bytes
+	void Transpose(const uint8_t* planes, size_t count, size_t vertexSize, uint8_t* out)
+	{
+		size_t v = 0;
+
+#ifdef MESHCODEC_SSE2
+		//Four planes and sixteen vertices at a time, unpacking bytes into 4-byte groups
+		if (vertexSize % 4 == 0)
+		{
+			for (; v + 16 <= count; v += 16)
+			{
+				for (size_t p = 0; p < vertexSize; p += 4)
+				{
+					__m128i p0 = _mm_loadu_si128((const __m128i*)(planes + (p + 0) * ChunkSize + v));
+					__m128i p1 = _mm_loadu_si128((const __m128i*)(planes + (p + 1) * ChunkSize + v));
+					__m128i p2 = _mm_loadu_si128((const __m128i*)(planes + (p + 2) * ChunkSize + v));
+					__m128i p3 = _mm_loadu_si128((const __m128i*)(planes + (p + 3) * ChunkSize + v));
+
+					__m128i low01 = _mm_unpacklo_epi8(p0, p1);
+					__m128i low23 = _mm_unpacklo_epi8(p2, p3);
+					__m128i high01 = _mm_unpackhi_epi8(p0, p1);
+					__m128i high23 = _mm_unpackhi_epi8(p2, p3);
+
+					uint32_t groups[16];
+					_mm_storeu_si128((__m128i*)(groups + 0), _mm_unpacklo_epi16(low01, low23));
+					_mm_storeu_si128((__m128i*)(groups + 4), _mm_unpackhi_epi16(low01, low23));
+					_mm_storeu_si128((__m128i*)(groups + 8), _mm_unpacklo_epi16(high01, high23));
+					_mm_storeu_si128((__m128i*)(groups + 12), _mm_unpackhi_epi16(high01, high23));
+
+					uint8_t* destination = out + v * vertexSize + p;
+
+					for (size_t k = 0; k < 16; ++k)
+						memcpy(destination + k * vertexSize, &groups[k], sizeof(uint32_t));
+				}
+			}
+		}
+#endif
+
+		for (; v < count; ++v)
+		{
+			for (size_t p = 0; p < vertexSize; ++p)
+				out[v * vertexSize + p] = planes[p * ChunkSize + v];
+		}
+	}
+
+	void WriteVarint(uint64_t value, std::vector<uint8_t>& out)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+
+		out.push_back((uint8_t)value);
+	}
+
+	const uint8_t* ReadVarint(const uint8_t* data, const uint8_t* end, uint64_t& value)
+	{
+		value = 0;
+
+		for (unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			if (data == end)
+				return nullptr;
+
+			uint8_t byte = *data++;
+			value |= (uint64_t)(byte & 0x7f) << shift;
+
+			if (byte < 0x80)
+				return data;
+		}
+
+		return nullptr;
+	}
+
+	//The FIFO of recently used vertices that index codes refer to, as the encoder keeps it. DecodeIndexCodes keeps the
+	//same entries in the same order
+	class IndexFifo
+	{
+	private:
+		uint32_t _entries[FifoSize];
+		unsigned int _head;
+
+	public:
+		IndexFifo() : _head(0)
+		{
+			for (unsigned int i = 0; i < FifoSize; ++i)
+				_entries[i] = 0xffffffff;
+		}
+
+		void Push(uint32_t index)
+		{
+			_entries[_head++ & (FifoSize - 1)] = index;
+		}
+
+		//Position of index counting back from the newest entry, or -1
+		int Find(uint32_t index) const
+		{
+			for (unsigned int i = 0; i < FifoCodes; ++i)
+			{
+				if (_entries[(_head - 1 - i) & (FifoSize - 1)] == index)
+					return (int)i;
+			}
+
+			return -1;
+		}
+	};
+
+	//Where the escapes start, after chunkCount chunks of codes, or nullptr if data runs out first. Only the chunk
+	//headers are read
+	const uint8_t* SkipChunks(const uint8_t* data, const uint8_t* end, size_t chunkCount)
+	{
+		for (size_t c = 0; c < chunkCount; ++c)
+		{
+			if ((size_t)(end - data) < ChunkHeaderSize)
+				return nullptr;
+
+			size_t size = ChunkHeaderSize;
+			for (size_t b = 0; b < BlocksPerChunk; ++b)
+				size += ModeSizes[(data[b / 4] >> ((b % 4) * 2)) & 3];
+
+			if ((size_t)(end - data) < size)
+				return nullptr;
+
+			data += size;
+		}
+
+		return data;
+	}
+
+	//Whether any of the BlockSize codes is an escape. Anything above FifoCodes is taken as one, as EncodeIndices never
+	//writes more than EscapeCode
+	inline bool HasEscape(const uint8_t* codes)
+	{
+#ifdef MESHCODEC_SSE2
+		__m128i x = _mm_loadu_si128((const __m128i*)codes);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(x, _mm_set1_epi8(EscapeCode)), x)) != 0;
+#else
+		uint8_t largest = 0;
+		for (size_t j = 0; j < BlockSize; ++j)
+			largest = std::max(largest, codes[j]);
+
+		return largest > FifoCodes;
+#endif
+	}
+
+	//For each of the BlockSize codes, how many new vertices come before it in the block less the code, which is where
+	//what it decodes to is in the window, counting from the first index pushed in this block. Also returns how many new
+	//vertices there are in all
+	inline unsigned int FindInWindow(const uint8_t* codes, int8_t* positions)
+	{
+#ifdef MESHCODEC_SSE2
+		__m128i x = _mm_loadu_si128((const __m128i*)codes);
+		__m128i isNext = _mm_and_si128(_mm_cmpeq_epi8(x, _mm_setzero_si128()), _mm_set1_epi8(1));
+
+		//Prefix sum across the 16 bytes, as in UndoDelta, then shifted along one so each code counts only those before it
+		__m128i before = _mm_slli_si128(isNext, 1);
+		before = _mm_add_epi8(before, _mm_slli_si128(before, 1));
+		before = _mm_add_epi8(before, _mm_slli_si128(before, 2));
+		before = _mm_add_epi8(before, _mm_slli_si128(before, 4));
+		before = _mm_add_epi8(before, _mm_slli_si128(before, 8));
+
+		_mm_storeu_si128((__m128i*)positions, _mm_sub_epi8(before, x));
+		return (unsigned int)_mm_extract_epi16(_mm_add_epi8(before, isNext), 7) >> 8;
+#else
+		unsigned int count = 0;
+
+		for (size_t j = 0; j < BlockSize; ++j)
+		{
+			positions[j] = (int8_t)(count - codes[j]);
+			count += codes[j] == NextVertexCode;
+		}
+
+		return count;
+#endif
+	}
+
+	//window holds the last FifoSize indices pushed to the FIFO, oldest first, and room for up to BlockSize more after them.
+	//Moves the newest FifoSize along to the start once pushed of those have been added
+	inline void SlideWindow(uint32_t* window, unsigned int pushed)
+	{
+		uint32_t newest[FifoSize];
+		memcpy(newest, window + pushed, sizeof(newest));
+		memcpy(window, newest, sizeof(newest));
+	}
+
+	//Decodes the indices a window at a time, so FIFO hits are lookups in an array that only changes between blocks. A
+	//block with no escapes can only push new vertices, which are known before it starts, so where each code's index is
+	//comes out of a prefix sum and every index in it is decoded independently. Blocks with escapes go a code at a time
+	template<typename Index>
+	bool DecodeIndexCodes(const uint8_t* data, const uint8_t* end, size_t indexCount, Index* out)
+	{
+		//Nothing at all, and data may well be null
+		if (indexCount == 0)
+			return data == end;
+
+		const uint8_t* escapes = SkipChunks(data, end, (indexCount + ChunkSize - 1) / ChunkSize);
+
+		if (!escapes)
+			return false;
+
+		uint32_t window[FifoSize + BlockSize];
+		for (unsigned int i = 0; i < FifoSize; ++i)
+			window[i] = 0xffffffff;
+
+		const uint32_t largest = (Index)~0u;
+		uint32_t next = 0;
+		bool tooLarge = false;
+
+		uint8_t codes[ChunkSize];
+		int8_t positions[BlockSize];
+		uint8_t unused = 0;
+
+		for (size_t start = 0; start < indexCount; start += ChunkSize)
+		{
+			//Chunks end where the escapes start, so they can't run into them
+			data = DecodeChunk<false>(data, escapes, codes, unused);
+
+			if (!data)
+				return false;
+
+			size_t count = std::min(ChunkSize, indexCount - start);
+
+			for (size_t b = 0; b < count; b += BlockSize)
+			{
+				const uint8_t* blockCodes = codes + b;
+				Index* blockOut = out + start + b;
+				size_t blockCount = std::min(BlockSize, count - b);
+				uint32_t* pushedHere = window + FifoSize;
+				unsigned int pushed = 0;
+
+				if (!HasEscape(blockCodes))
+				{
+					for (unsigned int j = 0; j < BlockSize; ++j)
+						pushedHere[j] = next + j;
+
+					pushed = FindInWindow(blockCodes, positions);
+
+					//The codes past the end of the last chunk are zeros, which aren't to be pushed
+					if (blockCount < BlockSize)
+					{
+						pushed = 0;
+						for (size_t j = 0; j < blockCount; ++j)
+							pushed += blockCodes[j] == NextVertexCode;
+					}
+
+					for (size_t j = 0; j < blockCount; ++j)
+					{
+						uint32_t index = pushedHere[positions[j]];
+						tooLarge |= index > largest;
+						blockOut[j] = (Index)index;
+					}
+
+					next += pushed;
+				}
+				else
+				{
+					for (size_t j = 0; j < blockCount; ++j)
+					{
+						uint8_t code = blockCodes[j];
+						uint32_t index;
+
+						if (code > FifoCodes)
+						{
+							uint64_t zigzag;
+							escapes = ReadVarint(escapes, end, zigzag);
+
+							if (!escapes)
+								return false;
+
+							size_t i = start + b + j;
+							uint32_t last = i > 0 ? out[i - 1] : 0;
+							int64_t difference = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+
+							index = (uint32_t)((int64_t)last + difference);
+							pushedHere[pushed++] = index;
+							next = std::max(next, index + 1);
+						}
+						else
+						{
+							//A new vertex is found where it's about to be pushed
+							uint32_t isNext = code == NextVertexCode;
+							pushedHere[pushed] = next;
+
+							index = pushedHere[(int)pushed - code];
+							pushed += isNext;
+							next += isNext;
+						}
+
+						tooLarge |= index > largest;
+						blockOut[j] = (Index)index;
+					}
+				}
+
+				SlideWindow(window, pushed);
+			}
+		}
+
+		return !tooLarge && escapes == end;
+	}
+}
+
+void MeshCodec::EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>& out)
+{
+	const uint8_t* bytes = (const uint8_t*)vertices;
+
+	std::vector<uint8_t> last(vertexSize, 0);
+	uint8_t plane[ChunkSize];
+
+	for (size_t start = 0; start < vertexCount; start += ChunkSize)
+	{
+		size_t count = std::min(ChunkSize, vertexCount - start);
+
+		for (size_t p = 0; p < vertexSize; ++p)
+		{
+			for (size_t v = 0; v < count; ++v)
+			{
+				uint8_t value = bytes[(start + v) * vertexSize + p];
+				plane[v] = ZigZag((uint8_t)(value - last[p]));
+				last[p] = value;
+			}
+
+			std::fill(plane + count, plane + ChunkSize, (uint8_t)0);
+			EncodeChunk(plane, out);
+		}
+	}
+}
+
+bool MeshCodec::DecodeVertices(const uint8_t* data, size_t size, size_t vertexCount, size_t vertexSize, void* outVertices)
+{
+	const uint8_t* end = data + size;
+	uint8_t* out = (uint8_t*)outVertices;
+
+	std::vector<uint8_t> last(vertexSize, 0);
+	std::vector<uint8_t> planes(vertexSize * ChunkSize);
+
+	for (size_t start = 0; start < vertexCount; start += ChunkSize)
+	{
+		for (size_t p = 0; p < vertexSize; ++p)
+		{
+			data = DecodeChunk<true>(data, end, &planes[p * ChunkSize], last[p]);
+
+			if (!data)
+				return false;
+		}
+
+		Transpose(planes.data(), std::min(ChunkSize, vertexCount - start), vertexSize, out + start * vertexSize);
+	}
+
+	return data == end || vertexCount == 0;
+}
+
+void MeshCodec::EncodeIndices(const void* indices, size_t indexCount, size_t indexSize, std::vector<uint8_t>& out)
+{
+	std::vector<uint8_t> codes((indexCount + ChunkSize - 1) / ChunkSize * ChunkSize, 0);
+	std::vector<uint8_t> escapes;
+
+	IndexFifo fifo;
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t index = ReadIndex(indices, i, indexSize);
+		int position = fifo.Find(index);
+
+		if (index == next)
+		{
+			codes[i] = NextVertexCode;
+			fifo.Push(index);
+			++next;
+		}
+		else if (position >= 0)
+		{
+			codes[i] = (uint8_t)(1 + position);
+		}
+		else
+		{
+			int64_t difference = (int64_t)index - (int64_t)last;
+
+			codes[i] = EscapeCode;
+			WriteVarint((uint64_t)((difference << 1) ^ (difference >> 63)), escapes);
+			fifo.Push(index);
+			next = std::max(next, index + 1);
+		}
+
+		last = index;
+	}
+
+	for (size_t start = 0; start < codes.size(); start += ChunkSize)
+		EncodeChunk(&codes[start], out);
+
+	out.insert(out.end(), escapes.begin(), escapes.end());
+}
+
+bool MeshCodec::DecodeIndices(const uint8_t* data, size_t size, size_t indexCount, size_t indexSize, void* outIndices)
+{
+	if (indexSize == 2)
+		return DecodeIndexCodes(data, data + size, indexCount, (uint16_t*)outIndices);
+
+	return DecodeIndexCodes(data, data + size, indexCount, (uint32_t*)outIndices);
+}
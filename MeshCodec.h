@@ -0,0 +1,28 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+//Lossless compression for vertex and index buffers, used for the sections of compressed mesh caches.
+//
+//Vertices are split into byte planes (byte 0 of every vertex, then byte 1...), and each byte is stored as the zigzagged
+//difference from the same byte of the vertex before. Neighbouring vertices are close together after
+//MeshOptimizer::OptimizeVertexFetch, so most of those differences are small. They're then packed in blocks of 16 with
+//0, 2, 4 or 8 bits each, whichever is the smallest that fits the whole block.
+//
+//Indices become one code per index: the next vertex that hasn't been used yet, a hit in a FIFO of the most recently
+//used vertices, or an escape followed by the difference from the index before. The codes go through the same block packing.
+//
+//Decoding uses SSE2 where it's available.
+namespace MeshCodec
+{
+	void EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexSize, std::vector<uint8_t>& out);
+
+	//Returns false if data is too short or damaged, outVertices needs room for vertexCount * vertexSize bytes
+	bool DecodeVertices(const uint8_t* data, size_t size, size_t vertexCount, size_t vertexSize, void* outVertices);
+
+	//indexSize is 2 or 4 bytes
+	void EncodeIndices(const void* indices, size_t indexCount, size_t indexSize, std::vector<uint8_t>& out);
+
+	bool DecodeIndices(const uint8_t* data, size_t size, size_t indexCount, size_t indexSize, void* outIndices);
+};
@@ -0,0 +1,667 @@
+#include "MeshCooker.h"
+#include <algorithm>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	static_assert(sizeof(SimpleVertex) == 8 * sizeof(float), "Vertex welding assumes SimpleVertex is 8 tightly packed floats");
+
+	//The bits that decide whether two vertices are the same. Either the raw float bits, or each attribute
+	//snapped to a grid of size weldEpsilon so that near-duplicates end up with the same key. Near-duplicates either
+	//side of a cell boundary get different keys, however close they are, so they aren't welded
+	struct VertexKey
+	{
+		uint32_t bits[8];
+	};
+
+	inline VertexKey MakeKey(const SimpleVertex& vertex, float invEpsilon)
+	{
+		VertexKey key;
+
+		if (invEpsilon == 0.0f)
+		{
+			memcpy(key.bits, &vertex, sizeof(SimpleVertex));
+		}
+		else
+		{
+			const float* attributes = &vertex.Pos.x;
+
+			//Converting a float outside the range of int32_t is undefined, so anything over 2^31 cells from the origin
+			//(and NaN) is clamped to the outermost cell, and welded with anything else that far out
+			for (int i = 0; i < 8; ++i)
+			{
+				float cell = floorf(attributes[i] * invEpsilon + 0.5f);
+				int32_t clamped = cell < 2147483648.0f ? (cell >= -2147483648.0f ? (int32_t)cell : INT32_MIN) : INT32_MAX;
+
+				key.bits[i] = (uint32_t)clamped;
+			}
+		}
+
+		return key;
+	}
+
+	inline uint32_t HashKey(const VertexKey& key)
+	{
+		//Murmur style mixing of each 32-bit word
+		uint32_t hash = 0x9747b28c;
+
+		for (int i = 0; i < 8; ++i)
+		{
+			uint32_t k = key.bits[i] * 0xcc9e2d51;
+			k = (k << 15) | (k >> 17);
+			hash ^= k * 0x1b873593;
+			hash = ((hash << 13) | (hash >> 19)) * 5 + 0xe6546b64;
+		}
+
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6b;
+		hash ^= hash >> 13;
+
+		return hash;
+	}
+
+	const uint32_t EmptySlot = 0xffffffff;
+
+	//Open addressing hash table (linear probing) from a vertex key to the index of the vertex in the output buffer.
+	//Kept at most half full so probe sequences stay short and lookups are expected O(1)
+	class VertexHashTable
+	{
+	private:
+		std::vector<uint32_t> _slots;
+		std::vector<VertexKey> _keys;
+		std::vector<uint32_t> _hashes;
+		uint32_t _mask;
+
+		void Grow()
+		{
+			size_t capacity = _slots.size() * 2;
+
+			_slots.assign(capacity, EmptySlot);
+			_mask = (uint32_t)capacity - 1;
+
+			for (uint32_t index = 0; index < (uint32_t)_keys.size(); ++index)
+			{
+				uint32_t slot = _hashes[index] & _mask;
+
+				while (_slots[slot] != EmptySlot)
+					slot = (slot + 1) & _mask;
+
+				_slots[slot] = index;
+			}
+		}
+
+	public:
+		VertexHashTable(size_t expectedCount)
+		{
+			size_t capacity = 64;
+			while (capacity < expectedCount * 2)
+				capacity *= 2;
+
+			_slots.assign(capacity, EmptySlot);
+			_mask = (uint32_t)capacity - 1;
+			_keys.reserve(expectedCount);
+			_hashes.reserve(expectedCount);
+		}
+
+		//Returns the index of a vertex with the same key, or adds the key as index newIndex and returns that
+		uint32_t FindOrAdd(const VertexKey& key, uint32_t newIndex)
+		{
+			uint32_t hash = HashKey(key);
+			uint32_t slot = hash & _mask;
+
+			while (_slots[slot] != EmptySlot)
+			{
+				uint32_t index = _slots[slot];
+
+				if (_hashes[index] == hash && memcmp(&_keys[index], &key, sizeof(VertexKey)) == 0)
+					return index;
+
+				slot = (slot + 1) & _mask;
+			}
+
+			_slots[slot] = newIndex;
+			_keys.push_back(key);
+			_hashes.push_back(hash);
+
+			if (_keys.size() * 2 > _slots.size())
+				Grow();
+
+			return newIndex;
+		}
+
+		size_t getAllocatedBytes() const
+		{
+			return _slots.capacity() * sizeof(uint32_t) + _keys.capacity() * sizeof(VertexKey) + _hashes.capacity() * sizeof(uint32_t);
+		}
+	};
+
+	template<typename T>
+	size_t AllocatedBytes(const std::vector<T>& v)
+	{
+		return v.capacity() * sizeof(T);
+	}
+
+	size_t AllocatedBytes(const OBJData& data)
+	{
+		return AllocatedBytes(data.verts) + AllocatedBytes(data.normals) + AllocatedBytes(data.texCoords) +
+			   AllocatedBytes(data.vertIndices) + AllocatedBytes(data.textureIndices) + AllocatedBytes(data.normalIndices);
+	}
+
+	//Welds face corners into the final vertex and index lists as the parser reads them, so the per corner
+	//copies of the attributes that CreateIndices needs are never made
+	class VertexAssembler : public OBJCornerSink
+	{
+	private:
+		VertexHashTable _table;
+		float _invEpsilon;
+		std::vector<SimpleVertex>& _vertices;
+		std::vector<unsigned int>& _indices;
+
+	public:
+		VertexAssembler(std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices, float weldEpsilon)
+			: _table(0), _invEpsilon(weldEpsilon > 0.0f ? 1.0f / weldEpsilon : 0.0f), _vertices(vertices), _indices(indices)
+		{
+		}
+
+		virtual void AddCorner(const OBJData& data, unsigned int v, unsigned int t, unsigned int n)
+		{
+			//Attributes a corner leaves out (or points past the end of the file) are zero
+			SimpleVertex vertex = {};
+
+			if (v < data.verts.size())
+				vertex.Pos = data.verts[v];
+			if (n < data.normals.size())
+				vertex.Normal = data.normals[n];
+			if (t < data.texCoords.size())
+				vertex.TexC = data.texCoords[t];
+
+			uint32_t newIndex = (uint32_t)_vertices.size();
+			uint32_t index = _table.FindOrAdd(MakeKey(vertex, _invEpsilon), newIndex);
+
+			if (index == newIndex)
+				_vertices.push_back(vertex);
+
+			_indices.push_back(index);
+		}
+
+		size_t getAllocatedBytes() const { return _table.getAllocatedBytes(); }
+	};
+
+	//The most memory the process has had at any one time, for comparing the two ways of assembling vertices
+	size_t PeakWorkingSet()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+
+		return counters.PeakWorkingSetSize;
+#else
+		struct rusage usage;
+
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+
+		return (size_t)usage.ru_maxrss * 1024;
+#endif
+	}
+
+	//Cooking reports go to the debugger's output window in the game, and to stderr in tools
+	void Report(const char* format, ...)
+	{
+		char report[256];
+
+		va_list args;
+		va_start(args, format);
+		vsnprintf(report, sizeof(report), format, args);
+		va_end(args);
+
+#ifdef _WIN32
+		OutputDebugStringA(report);
+#else
+		fputs(report, stderr);
+#endif
+	}
+}
+
+void MeshCooker::CreateIndices(const std::vector<XMFLOAT3>& inVertices, 
+							  const std::vector<XMFLOAT2>& inTexCoords, 
+							  const std::vector<XMFLOAT3>& inNormals, 
+							  std::vector<unsigned int>& outIndices, 
+							  std::vector<XMFLOAT3>& outVertices, 
+							  std::vector<XMFLOAT2>& outTexCoords, 
+							  std::vector<XMFLOAT3>& outNormals,
+							  float weldEpsilon)
+{
+	// Mapping from an already-existing SimpleVertex to its corresponding index
+	VertexHashTable vertToIndexTable(inVertices.size());
+
+	float invEpsilon = weldEpsilon > 0.0f ? 1.0f / weldEpsilon : 0.0f;
+
+	int numVertices = inVertices.size();
+	
+	for(int i = 0; i < numVertices; ++i) //For each vertex
+	{
+		SimpleVertex vertex = {inVertices[i], inNormals[i],  inTexCoords[i]}; 
+
+		// See if a vertex already exists in the buffer that has the same attributes as this one, if so re-use it's index
+		// for the index buffer, if not it gets added to the table with the next free index and added to the buffer
+		uint32_t newIndex = (uint32_t)outVertices.size();
+		uint32_t index = vertToIndexTable.FindOrAdd(MakeKey(vertex, invEpsilon), newIndex);
+
+		if(index == newIndex)
+		{
+			outVertices.push_back(vertex.Pos);
+			outTexCoords.push_back(vertex.TexC);
+			outNormals.push_back(vertex.Normal);
+		}
+
+		outIndices.push_back(index);
+	}
+}
+
+void MeshCooker::SplitForShortIndices(const std::vector<SimpleVertex>& inVertices,
+									 const std::vector<unsigned int>& inIndices,
+									 std::vector<SimpleVertex>& outVertices,
+									 std::vector<unsigned short>& outIndices,
+									 std::vector<MeshDrawRange>& outRanges)
+{
+	//Which submesh each vertex was last added to, and its index within that submesh
+	std::vector<unsigned int> vertSubmesh(inVertices.size(), (unsigned int)-1);
+	std::vector<unsigned short> vertLocalIndex(inVertices.size());
+
+	outIndices.reserve(inIndices.size());
+
+	MeshDrawRange range = { 0, 0, 0 };
+	unsigned int submesh = 0;
+	unsigned int numLocalVertices = 0;
+
+	unsigned int numIndices = inIndices.size();
+	for(unsigned int i = 0; i + 2 < numIndices; i += 3) //For each triangle
+	{
+		//Count how many new vertices this triangle would add to the current submesh
+		unsigned int numNew = 0;
+		for(unsigned int corner = 0; corner < 3; ++corner)
+		{
+			numNew += vertSubmesh[inIndices[i + corner]] != submesh;
+		}
+
+		//Start a new submesh if they won't fit
+		if(numLocalVertices + numNew > MaxShortIndexVertices)
+		{
+			outRanges.push_back(range);
+
+			range.IndexStart = outIndices.size();
+			range.IndexCount = 0;
+			range.BaseVertex = outVertices.size();
+
+			++submesh;
+			numLocalVertices = 0;
+		}
+
+		for(unsigned int corner = 0; corner < 3; ++corner)
+		{
+			unsigned int index = inIndices[i + corner];
+
+			//Vertices shared between two submeshes get copied into both
+			if(vertSubmesh[index] != submesh)
+			{
+				vertSubmesh[index] = submesh;
+				vertLocalIndex[index] = (unsigned short)numLocalVertices++;
+				outVertices.push_back(inVertices[index]);
+			}
+
+			outIndices.push_back(vertLocalIndex[index]);
+		}
+
+		range.IndexCount += 3;
+	}
+
+	outRanges.push_back(range);
+}
+
+namespace
+{
+	//Puts the vertices into cooked as they'll go into the vertex buffer, converted to CompactVertex first if compactVertices is set
+	void CookVertices(const char* filename, const std::vector<SimpleVertex>& vertices, bool compactVertices, CookedMesh& cooked)
+	{
+		cooked.info.vertexCount = vertices.size();
+		cooked.info.compactVertices = compactVertices;
+		cooked.info.posScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+		cooked.info.posOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		cooked.info.bounds = BoundingVolumes::Compute((const XMFLOAT3*)vertices.data(), vertices.size(), sizeof(SimpleVertex));
+
+		if (!compactVertices)
+		{
+			cooked.info.vertexStride = sizeof(SimpleVertex);
+			cooked.vertices.assign((const uint8_t*)vertices.data(), (const uint8_t*)(vertices.data() + vertices.size()));
+			return;
+		}
+
+		std::vector<CompactVertex> compactVerts;
+		QuantizationStats stats;
+		VertexQuantizer::Quantize(vertices, compactVerts, cooked.info.posScale, cooked.info.posOffset, &stats);
+
+		Report("MeshCooker: %s compact vertices %u -> %u bytes (stride %u -> %u), max error position %g, normal %.3f degrees, texcoord %g\n",
+			   filename, stats.originalBytes, stats.compactBytes, stats.originalStride, stats.compactStride,
+			   stats.maxPositionError, stats.maxNormalErrorDegrees, stats.maxTexCoordError);
+
+		//Quantized positions can move by up to the error, so the bounds grow by as much to still hold them
+		cooked.info.bounds = BoundingVolumes::Expand(cooked.info.bounds, stats.maxPositionError);
+
+		cooked.info.vertexStride = sizeof(CompactVertex);
+		cooked.vertices.assign((const uint8_t*)compactVerts.data(), (const uint8_t*)(compactVerts.data() + compactVerts.size()));
+	}
+}
+
+uint64_t MeshCooker::SettingsHash(bool invertTexCoords, const OBJLoadOptions& options)
+{
+	std::vector<uint32_t> settings;
+	settings.push_back(CookVersion);
+	settings.push_back(sizeof(SimpleVertex));
+	settings.push_back(sizeof(CompactVertex));
+	settings.push_back(sizeof(Meshlet));
+	settings.push_back(invertTexCoords);
+	settings.push_back(options.splitLargeMeshes);
+	settings.push_back(options.optimizeVertexCache);
+	settings.push_back(options.compactVertices);
+	settings.push_back(options.buildMeshlets);
+	settings.push_back(options.compressCache);
+
+	std::vector<float> values(1, options.weldEpsilon);
+	values.push_back(options.overdrawThreshold);
+	values.insert(values.end(), options.lodRatios.begin(), options.lodRatios.end());
+
+	uint64_t hash = MeshCache::Hash64(settings.data(), settings.size() * sizeof(uint32_t));
+	return MeshCache::Hash64(values.data(), values.size() * sizeof(float), hash);
+}
+
+bool MeshCooker::CookOBJ(const char* filename, bool invertTexCoords, const OBJLoadOptions& options, CookedMesh& outMesh)
+{
+	//Vectors to store the vertex positions, normals and texture coordinates, along with the 3 index buffers that the OBJ file uses.
+	//DirectX uses 1 index buffer, OBJ is optimized for storage and not rendering and so uses 3 smaller index buffers.....great...
+	//We'll have to merge this into 1 index buffer which we'll do after loading in all of the required data.
+	OBJData data;
+
+	//Either way ends with the welded vertices in finalVerts and one index per face corner in meshIndices
+	std::vector<SimpleVertex> finalVerts;
+	std::vector<unsigned int> meshIndices;
+	size_t assemblyBytes = 0;
+
+	if(options.streamingAssembly)
+	{
+		VertexAssembler assembler(finalVerts, meshIndices, options.weldEpsilon);
+
+		if(!OBJParser::ParseMappedStreaming(filename, data, invertTexCoords, assembler))
+		{
+			return false;
+		}
+
+		assemblyBytes = AllocatedBytes(data) + AllocatedBytes(finalVerts) + AllocatedBytes(meshIndices) + assembler.getAllocatedBytes();
+	}
+	else
+	{
+		if(!OBJParser::ParseMappedParallel(filename, data, invertTexCoords))
+		{
+			return false;
+		}
+
+		//Get vectors to be of same size, ready for singular indexing
+		std::vector<XMFLOAT3> expandedVertices;
+		std::vector<XMFLOAT3> expandedNormals;
+		std::vector<XMFLOAT2> expandedTexCoords;
+		//Attributes a corner leaves out (or points past the end of the file) are zero, the same as VertexAssembler::AddCorner
+		unsigned int numIndices = data.vertIndices.size();
+		for(unsigned int i = 0; i < numIndices; i++)
+		{
+			unsigned int v = data.vertIndices[i];
+			unsigned int t = data.textureIndices[i];
+			unsigned int n = data.normalIndices[i];
+
+			expandedVertices.push_back(v < data.verts.size() ? data.verts[v] : XMFLOAT3(0.0f, 0.0f, 0.0f));
+			expandedTexCoords.push_back(t < data.texCoords.size() ? data.texCoords[t] : XMFLOAT2(0.0f, 0.0f));
+			expandedNormals.push_back(n < data.normals.size() ? data.normals[n] : XMFLOAT3(0.0f, 0.0f, 0.0f));
+		}
+
+		//Now to (finally) form the final vertex, texture coord, normal list and single index buffer using the above expanded vectors
+		meshIndices.reserve(numIndices);
+		std::vector<XMFLOAT3> meshVertices;
+		meshVertices.reserve(expandedVertices.size());
+		std::vector<XMFLOAT3> meshNormals;
+		meshNormals.reserve(expandedNormals.size());
+		std::vector<XMFLOAT2> meshTexCoords;
+		meshTexCoords.reserve(expandedTexCoords.size());
+
+		CreateIndices(expandedVertices, expandedTexCoords, expandedNormals, meshIndices, meshVertices, meshTexCoords, meshNormals, options.weldEpsilon);
+
+		//Turn data from vector form to a single array of vertices
+		unsigned int numMeshVertices = meshVertices.size();
+		finalVerts.resize(numMeshVertices);
+		for(unsigned int i = 0; i < numMeshVertices; ++i)
+		{
+			finalVerts[i].Pos = meshVertices[i];
+			finalVerts[i].Normal = meshNormals[i];
+			finalVerts[i].TexC = meshTexCoords[i];
+		}
+
+		assemblyBytes = AllocatedBytes(data) + AllocatedBytes(expandedVertices) + AllocatedBytes(expandedNormals) + AllocatedBytes(expandedTexCoords) +
+						AllocatedBytes(meshIndices) + AllocatedBytes(meshVertices) + AllocatedBytes(meshNormals) + AllocatedBytes(meshTexCoords) +
+						AllocatedBytes(finalVerts);
+	}
+
+	//Report how much welding saved, and how much memory it took to get there
+	Report("MeshCooker: %s welded %u vertices down to %u\n", filename, (unsigned int)meshIndices.size(), (unsigned int)finalVerts.size());
+
+	Report("MeshCooker: %s %s assembly peaked at %.1f MB, process peak working set %.1f MB\n", filename,
+		   options.streamingAssembly ? "streaming" : "expanded", assemblyBytes / (1024.0 * 1024.0), PeakWorkingSet() / (1024.0 * 1024.0));
+
+	unsigned int numMeshVertices = finalVerts.size();
+
+	//Simpler versions of the mesh for drawing it further away. LOD 0 is the mesh itself, and the
+	//simplified ones index into the same vertices so they can all share one vertex buffer
+	std::vector<SimplifiedLOD> lods(1);
+	lods[0].indices.swap(meshIndices);
+	lods[0].error = 0.0f;
+
+	if(!options.lodRatios.empty())
+	{
+		std::vector<SimplifiedLOD> simplified;
+		MeshSimplifier::GenerateLODs(lods[0].indices, finalVerts, options.lodRatios, simplified);
+
+		for(unsigned int i = 0; i < simplified.size(); ++i)
+		{
+			//Each level is made from the full mesh, so drop any that didn't get much smaller than the previous one,
+			//and keep the errors going up so the renderer can stop at the first level that's good enough
+			if(simplified[i].indices.empty() || simplified[i].indices.size() * 10 >= lods.back().indices.size() * 9)
+				continue;
+
+			Report("MeshCooker: %s LOD %u has %u triangles, error %g\n", filename, (unsigned int)lods.size(),
+				   (unsigned int)simplified[i].indices.size() / 3, simplified[i].error);
+
+			lods.push_back(SimplifiedLOD());
+			lods.back().indices.swap(simplified[i].indices);
+			lods.back().error = std::max(simplified[i].error, lods[lods.size() - 2].error);
+		}
+	}
+
+	unsigned int numLODs = lods.size();
+
+	VertexCacheStats before;
+	if(options.optimizeVertexCache)
+	{
+		before = MeshOptimizer::AnalyzeVertexCache(lods[0].indices, numMeshVertices);
+
+		for(unsigned int i = 0; i < numLODs; ++i)
+		{
+			MeshOptimizer::OptimizeVertexCache(lods[i].indices, numMeshVertices);
+		}
+
+		if(options.overdrawThreshold > 0.0f)
+		{
+			OverdrawStats overdrawBefore = MeshOptimizer::AnalyzeOverdraw(lods[0].indices, finalVerts);
+			MeshOptimizer::OptimizeOverdraw(lods[0].indices, finalVerts, options.overdrawThreshold);
+			OverdrawStats overdrawAfter = MeshOptimizer::AnalyzeOverdraw(lods[0].indices, finalVerts);
+
+			Report("MeshCooker: %s overdraw %.3f -> %.3f\n", filename, overdrawBefore.overdraw, overdrawAfter.overdraw);
+		}
+	}
+
+	//All the levels go one after the other in the index buffer
+	std::vector<unsigned int> lodStart(numLODs + 1, 0);
+	for(unsigned int i = 0; i < numLODs; ++i)
+	{
+		lodStart[i + 1] = lodStart[i] + lods[i].indices.size();
+	}
+
+	meshIndices.resize(lodStart[numLODs]);
+	for(unsigned int i = 0; i < numLODs; ++i)
+	{
+		std::copy(lods[i].indices.begin(), lods[i].indices.end(), meshIndices.begin() + lodStart[i]);
+		lods[i].indices.clear();
+	}
+
+	unsigned int numMeshIndices = meshIndices.size();
+
+	if(options.optimizeVertexCache)
+	{
+		MeshOptimizer::OptimizeVertexFetch(finalVerts, meshIndices);
+		numMeshVertices = finalVerts.size();
+
+		std::vector<unsigned int> fullDetail(meshIndices.begin(), meshIndices.begin() + lodStart[1]);
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(fullDetail, numMeshVertices);
+
+		Report("MeshCooker: %s ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", filename, before.acmr, after.acmr, before.atvr, after.atvr);
+	}
+
+	std::vector<MeshLOD> meshLODs(numLODs);
+	for(unsigned int i = 0; i < numLODs; ++i)
+	{
+		meshLODs[i].Error = lods[i].error;
+	}
+
+	//Clusters of LOD 0 for culling. Meshes that get split are left out, as a cluster can't span submeshes
+	std::vector<Meshlet> meshlets;
+	if(options.buildMeshlets && !(numMeshVertices > MaxShortIndexVertices && options.splitLargeMeshes))
+	{
+		std::vector<unsigned int> fullDetail(meshIndices.begin(), meshIndices.begin() + lodStart[1]);
+		MeshletBuilder::Build(fullDetail, finalVerts, meshlets);
+
+		Report("MeshCooker: %s built %u meshlets, %.1f triangles each\n", filename, (unsigned int)meshlets.size(),
+			   (float)fullDetail.size() / 3.0f / std::max((size_t)1, meshlets.size()));
+	}
+
+	CookedMesh cooked;
+
+	//Meshes with more vertices than a 16-bit index can address either need 32-bit indices, or to be split
+	//into several submeshes that each use at most MaxShortIndexVertices of their own vertices
+	if(numMeshVertices > MaxShortIndexVertices && !options.splitLargeMeshes)
+	{
+		for(unsigned int i = 0; i < numLODs; ++i)
+		{
+			MeshDrawRange range = { lodStart[i], lodStart[i + 1] - lodStart[i], 0 };
+			meshLODs[i].DrawRanges.push_back(range);
+		}
+
+		cooked.info.indexSize = sizeof(unsigned int);
+		cooked.indices.assign((const uint8_t*)meshIndices.data(), (const uint8_t*)(meshIndices.data() + numMeshIndices));
+	}
+	else
+	{
+		std::vector<unsigned short> indicesArray;
+
+		if(numMeshVertices > MaxShortIndexVertices)
+		{
+			//Each level is split on its own, with its submeshes after the ones of the level before
+			std::vector<SimpleVertex> splitVerts;
+
+			for(unsigned int i = 0; i < numLODs; ++i)
+			{
+				std::vector<unsigned int> lodIndices(meshIndices.begin() + lodStart[i], meshIndices.begin() + lodStart[i + 1]);
+				std::vector<SimpleVertex> lodVerts;
+				std::vector<unsigned short> lodShortIndices;
+				std::vector<MeshDrawRange> lodRanges;
+				SplitForShortIndices(finalVerts, lodIndices, lodVerts, lodShortIndices, lodRanges);
+
+				for(MeshDrawRange& range : lodRanges)
+				{
+					range.IndexStart += indicesArray.size();
+					range.BaseVertex += splitVerts.size();
+				}
+
+				meshLODs[i].DrawRanges.swap(lodRanges);
+				splitVerts.insert(splitVerts.end(), lodVerts.begin(), lodVerts.end());
+				indicesArray.insert(indicesArray.end(), lodShortIndices.begin(), lodShortIndices.end());
+			}
+
+			finalVerts.swap(splitVerts);
+			numMeshVertices = finalVerts.size();
+		}
+		else
+		{
+			indicesArray.assign(meshIndices.begin(), meshIndices.end());
+
+			for(unsigned int i = 0; i < numLODs; ++i)
+			{
+				MeshDrawRange range = { lodStart[i], lodStart[i + 1] - lodStart[i], 0 };
+				meshLODs[i].DrawRanges.push_back(range);
+			}
+		}
+
+		cooked.info.indexSize = sizeof(unsigned short);
+		cooked.indices.assign((const uint8_t*)indicesArray.data(), (const uint8_t*)(indicesArray.data() + numMeshIndices));
+	}
+
+	cooked.info.indexCount = numMeshIndices;
+	CookVertices(filename, finalVerts, options.compactVertices, cooked);
+	cooked.lods.swap(meshLODs);
+	cooked.meshlets.swap(meshlets);
+
+	outMesh = std::move(cooked);
+	return true;
+}
+
+std::string MeshCooker::getCacheFilename(const char* filename, bool invertTexCoords, const OBJLoadOptions& options)
+{
+	char settings[32];
+	snprintf(settings, sizeof(settings), ".%016llx.meshcache", (unsigned long long)SettingsHash(invertTexCoords, options));
+
+	return std::string(filename) + settings;
+}
+
+bool MeshCooker::Save(const char* filename, const CookedMesh& mesh, bool invertTexCoords, const OBJLoadOptions& options)
+{
+	std::string cacheFilename = getCacheFilename(filename, invertTexCoords, options);
+
+	MeshSourceInfo source;
+	if(!MeshCache::GetSourceInfo(filename, source, true) || !MeshCache::Save(cacheFilename.c_str(), mesh, source, SettingsHash(invertTexCoords, options), options.compressCache))
+	{
+		Report("MeshCooker: %s couldn't write %s\n", filename, cacheFilename.c_str());
+		return false;
+	}
+
+	if(options.compressCache)
+	{
+		MeshSourceInfo cacheInfo;
+		MeshCache::GetSourceInfo(cacheFilename.c_str(), cacheInfo, false);
+
+		Report("MeshCooker: %s compressed vertices and indices %u KB -> cache file %u KB\n", filename,
+			   (unsigned int)((mesh.vertices.size() + mesh.indices.size()) / 1024), (unsigned int)(cacheInfo.size / 1024));
+	}
+
+	return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Structures.h"
+#include "OBJParser.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshCache.h"
+#include "VertexQuantizer.h"
+
+//Optional settings for OBJLoader::Load and MeshCooker::CookOBJ
+struct OBJLoadOptions
+{
+	//Vertices whose positions, normals and texture coordinates all snap to the same grid cell of this size
+	//are welded together. 0 only welds vertices that are exactly the same. Two vertices much closer than this
+	//still aren't welded if a cell boundary falls between them
+	float weldEpsilon = 0.0f;
+
+	//Meshes with more vertices than 16-bit indices can address normally use 32-bit indices. If this is set they are
+	//split into several submeshes instead, each drawn with 16-bit indices relative to its own base vertex
+	bool splitLargeMeshes = false;
+
+	//Reorders triangles for the post-transform vertex cache and then vertices into the order they're first used
+	bool optimizeVertexCache = true;
+
+	//If above 0 (and optimizeVertexCache is set), triangles are also reordered to reduce overdraw, letting the ACMR get
+	//up to this many times worse, e.g. 1.05. Only worth it for opaque meshes with a lot of self occlusion
+	float overdrawThreshold = 0.0f;
+
+	//Stores the vertices as CompactVertex (16 bytes) instead of SimpleVertex (32 bytes), drawn with the VSCompact shader
+	bool compactVertices = false;
+
+	//Fraction of the triangles to keep for each extra level of detail, e.g. { 0.5f, 0.25f, 0.125f }.
+	//Levels the simplifier can't make noticeably smaller than the one before are left out
+	std::vector<float> lodRatios;
+
+	//Splits LOD 0 into meshlets (see MeshletBuilder) so it can be culled in small pieces with MeshletCuller
+	bool buildMeshlets = false;
+
+	//Welds each face corner into the final vertices as the file is parsed, instead of parsing every index first and then
+	//expanding them into per corner copies of the attributes. Needs far less memory for big files, but parsing is single threaded
+	bool streamingAssembly = false;
+
+	//Compresses the vertices and indices in the .meshcache file (see MeshCodec). The file is usually a third to a half
+	//smaller, which loads quicker from a slow disk, but they have to be decoded instead of uploaded straight from the file
+	bool compressCache = false;
+};
+
+//Turns an OBJ file into a CookedMesh: welding, levels of detail, vertex cache and overdraw optimization, meshlets,
+//index and vertex formats. OBJLoader::Load does this the first time a mesh is loaded and Tools/AssetCooker does it ahead
+//of time for a whole folder.
+//
+//WARNING: This code makes a big assumption -- that your models have texture coordinates AND normals which they should have anyway (else you can't do texturing and lighting!)
+//If your .obj file has no lines beginning with "vt" or "vn", then you'll need to change the Export settings in your modelling software so that it exports the texture coordinates
+//and normals. If you still have no "vt" lines, you'll need to do some texture unwrapping, also known as UV unwrapping.
+namespace MeshCooker
+{
+	//The most vertices a mesh can have and still be drawn with 16-bit indices
+	const unsigned int MaxShortIndexVertices = 65535;
+
+	//Bumped whenever the cooker starts producing different data from the same file and options, so old caches get cooked again
+	const uint32_t CookVersion = 2;
+
+	//Hash of everything besides the source file that the cooked mesh depends on
+	uint64_t SettingsHash(bool invertTexCoords, const OBJLoadOptions& options);
+
+	//Returns false if the file can't be read
+	bool CookOBJ(const char* filename, bool invertTexCoords, const OBJLoadOptions& options, CookedMesh& outMesh);
+
+	//The cooked mesh is kept next to the source file, and is only used if it was cooked from this version of it with the same options.
+	//The name has SettingsHash in it, so loading the same file with different options keeps a cache for each rather than
+	//cooking over one cache every time
+	std::string getCacheFilename(const char* filename, bool invertTexCoords, const OBJLoadOptions& options);
+
+	//Writes mesh to filename's cache, marked as cooked with these options
+	bool Save(const char* filename, const CookedMesh& mesh, bool invertTexCoords, const OBJLoadOptions& options);
+
+	//Re-creates a single index buffer from the 3 given in the OBJ file. Vertices that already exist in the buffer
+	//(looked up through a hash table) re-use that index, see OBJLoadOptions::weldEpsilon for near-duplicates
+	void CreateIndices(const std::vector<XMFLOAT3>& inVertices, const std::vector<XMFLOAT2>& inTexCoords, const std::vector<XMFLOAT3>& inNormals, std::vector<unsigned int>& outIndices, std::vector<XMFLOAT3>& outVertices, std::vector<XMFLOAT2>& outTexCoords, std::vector<XMFLOAT3>& outNormals, float weldEpsilon = 0.0f);
+
+	//Splits a mesh into submeshes that use at most MaxShortIndexVertices vertices each, so it can be drawn with 16-bit indices.
+	//Vertices used by more than one submesh are duplicated, outRanges gets one entry per submesh
+	void SplitForShortIndices(const std::vector<SimpleVertex>& inVertices, const std::vector<unsigned int>& inIndices, std::vector<SimpleVertex>& outVertices, std::vector<unsigned short>& outIndices, std::vector<MeshDrawRange>& outRanges);
+};
@@ -0,0 +1,549 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+
+void VertexTriangles::Build(const std::vector<unsigned int>& indices, unsigned int numVertices)
+{
+	offsets.assign(numVertices + 1, 0);
+
+	for (unsigned int index : indices)
+		++offsets[index + 1];
+
+	for (unsigned int v = 0; v < numVertices; ++v)
+		offsets[v + 1] += offsets[v];
+
+	triangles.resize(indices.size());
+
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	unsigned int numIndices = indices.size();
+	for (unsigned int i = 0; i < numIndices; ++i)
+		triangles[fill[indices[i]]++] = i / 3;
+}
+
+namespace
+{
+	//Picks the vertex to fan around next. Prefers vertices that will still be in the cache after their remaining
+	//triangles are emitted, and out of those the one that entered the cache first
+	int GetNextVertex(const std::vector<unsigned int>& candidates, const std::vector<unsigned int>& liveTriangles,
+					  const std::vector<unsigned int>& cacheTime, unsigned int time, unsigned int cacheSize,
+					  std::vector<unsigned int>& deadEnds, unsigned int& cursor)
+	{
+		int best = -1;
+		int bestPriority = -1;
+
+		for (unsigned int v : candidates)
+		{
+			if (liveTriangles[v] == 0)
+				continue;
+
+			int priority = 0;
+			if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = time - cacheTime[v];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				best = v;
+			}
+		}
+
+		if (best != -1)
+			return best;
+
+		//Dead end, go back to a recently used vertex that still has triangles left
+		while (!deadEnds.empty())
+		{
+			unsigned int v = deadEnds.back();
+			deadEnds.pop_back();
+
+			if (liveTriangles[v] > 0)
+				return v;
+		}
+
+		//Otherwise carry on from the next vertex in input order that has triangles left
+		unsigned int numVertices = liveTriangles.size();
+		while (cursor < numVertices)
+		{
+			if (liveTriangles[cursor] > 0)
+				return cursor;
+
+			++cursor;
+		}
+
+		return -1;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize)
+{
+	unsigned int numTriangles = indices.size() / 3;
+
+	if (numTriangles == 0)
+		return;
+
+	VertexTriangles adjacency;
+	adjacency.Build(indices, numVertices);
+
+	std::vector<unsigned int> liveTriangles(numVertices);
+	for (unsigned int v = 0; v < numVertices; ++v)
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<unsigned int> cacheTime(numVertices, 0);
+	std::vector<bool> emitted(numTriangles, false);
+	std::vector<unsigned int> deadEnds;
+	std::vector<unsigned int> candidates;
+
+	std::vector<unsigned int> result;
+	result.reserve(numTriangles * 3);
+
+	unsigned int time = cacheSize + 1;
+	unsigned int cursor = 0;
+	int fanVertex = indices[0];
+
+	while (fanVertex >= 0)
+	{
+		candidates.clear();
+
+		//Emit every triangle around the fan vertex that hasn't been emitted yet
+		for (unsigned int i = adjacency.offsets[fanVertex]; i < adjacency.offsets[fanVertex + 1]; ++i)
+		{
+			unsigned int triangle = adjacency.triangles[i];
+
+			if (emitted[triangle])
+				continue;
+
+			for (unsigned int corner = 0; corner < 3; ++corner)
+			{
+				unsigned int v = indices[triangle * 3 + corner];
+
+				result.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+
+				--liveTriangles[v];
+
+				//Not in the cache any more, so this use puts it back in
+				if (time - cacheTime[v] > cacheSize)
+					cacheTime[v] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		fanVertex = GetNextVertex(candidates, liveTriangles, cacheTime, time, cacheSize, deadEnds, cursor);
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), (unsigned int)-1);
+	std::vector<SimpleVertex> result;
+	result.reserve(vertices.size());
+
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == (unsigned int)-1)
+		{
+			remap[index] = result.size();
+			result.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(result);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize, CacheModel model)
+{
+	VertexCacheStats stats = { 0, 0.0f, 0.0f };
+
+	if (indices.empty() || cacheSize == 0)
+		return stats;
+
+	//FIFO: a vertex is in the cache if it was added less than cacheSize misses ago
+	//LRU: a vertex is in the cache if it was used less than cacheSize distinct vertices ago, tracked with a small move-to-front list
+	std::vector<unsigned int> missTime(numVertices, 0);
+	std::vector<unsigned int> lru;
+	lru.reserve(cacheSize + 1);
+
+	std::vector<bool> used(numVertices, false);
+	unsigned int numUsed = 0;
+
+	for (unsigned int index : indices)
+	{
+		if (!used[index])
+		{
+			used[index] = true;
+			++numUsed;
+		}
+
+		bool hit;
+
+		if (model == CacheFIFO)
+		{
+			hit = missTime[index] != 0 && stats.vertexTransforms + 1 - missTime[index] <= cacheSize;
+
+			if (!hit)
+				missTime[index] = stats.vertexTransforms + 1;
+		}
+		else
+		{
+			hit = false;
+
+			for (size_t i = 0; i < lru.size(); ++i)
+			{
+				if (lru[i] == index)
+				{
+					lru.erase(lru.begin() + i);
+					hit = true;
+					break;
+				}
+			}
+
+			lru.insert(lru.begin(), index);
+
+			if (lru.size() > cacheSize)
+				lru.pop_back();
+		}
+
+		if (!hit)
+			++stats.vertexTransforms;
+	}
+
+	stats.acmr = (float)stats.vertexTransforms / (indices.size() / 3);
+	stats.atvr = (float)stats.vertexTransforms / numUsed;
+
+	return stats;
+}
+
+namespace
+{
+	inline XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	inline XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	inline float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//Simulates a FIFO cache one triangle at a time, used to find where clusters can start
+	class FIFOCache
+	{
+	private:
+		std::vector<unsigned int> _missTime;
+		unsigned int _misses;
+		unsigned int _cacheSize;
+
+	public:
+		FIFOCache(unsigned int numVertices, unsigned int cacheSize) : _missTime(numVertices, 0), _misses(0), _cacheSize(cacheSize) {}
+
+		//Forgets everything, as if the cache was flushed
+		void Clear() { _misses += _cacheSize; }
+
+		//Returns how many of the triangle's vertices missed
+		unsigned int AddTriangle(const unsigned int* triangle)
+		{
+			unsigned int misses = 0;
+
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				unsigned int v = triangle[corner];
+
+				if (_missTime[v] == 0 || _misses + 1 - _missTime[v] > _cacheSize)
+				{
+					_missTime[v] = ++_misses;
+					++misses;
+				}
+			}
+
+			return misses;
+		}
+	};
+
+	struct TriangleCluster
+	{
+		unsigned int start;		//First triangle
+		unsigned int count;
+		float sortKey;
+	};
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, float threshold, unsigned int cacheSize)
+{
+	unsigned int numTriangles = indices.size() / 3;
+	unsigned int numVertices = vertices.size();
+
+	if (numTriangles == 0)
+		return;
+
+	//Hard boundaries: triangles where all three vertices miss, Tipsify has just jumped somewhere new so nothing is lost by cutting here
+	std::vector<unsigned int> hardStarts;
+	std::vector<unsigned int> triangleMisses(numTriangles);
+	{
+		FIFOCache cache(numVertices, cacheSize);
+
+		for (unsigned int t = 0; t < numTriangles; ++t)
+		{
+			triangleMisses[t] = cache.AddTriangle(&indices[t * 3]);
+
+			if (t == 0 || triangleMisses[t] == 3)
+				hardStarts.push_back(t);
+		}
+
+		hardStarts.push_back(numTriangles);
+	}
+
+	//Soft boundaries: split hard clusters further wherever the triangles so far, drawn starting from an empty cache,
+	//have an ACMR within threshold of the cluster as a whole
+	std::vector<TriangleCluster> clusters;
+	{
+		FIFOCache cache(numVertices, cacheSize);
+
+		for (size_t h = 0; h + 1 < hardStarts.size(); ++h)
+		{
+			unsigned int start = hardStarts[h];
+			unsigned int end = hardStarts[h + 1];
+
+			unsigned int clusterMisses = 0;
+			for (unsigned int t = start; t < end; ++t)
+				clusterMisses += triangleMisses[t];
+
+			float clusterACMR = (float)clusterMisses / (end - start);
+
+			unsigned int softStart = start;
+			unsigned int softMisses = 0;
+			cache.Clear();
+
+			for (unsigned int t = start; t < end; ++t)
+			{
+				softMisses += cache.AddTriangle(&indices[t * 3]);
+
+				unsigned int count = t - softStart + 1;
+
+				if (t + 1 == end || (softMisses <= clusterACMR * threshold * count && end - t > 1))
+				{
+					TriangleCluster cluster = { softStart, count, 0.0f };
+					clusters.push_back(cluster);
+
+					softStart = t + 1;
+					softMisses = 0;
+					cache.Clear();
+				}
+			}
+		}
+	}
+
+	//Sort key: how far the cluster sits out from the middle of the mesh along its own normal. Clusters on the outside
+	//of the mesh facing out occlude the most, so they're drawn first
+	XMFLOAT3 meshCentroid(0.0f, 0.0f, 0.0f);
+	float meshArea = 0.0f;
+
+	std::vector<XMFLOAT3> clusterCentroids(clusters.size());
+	std::vector<XMFLOAT3> clusterNormals(clusters.size());
+
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		XMFLOAT3 centroid(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 normal(0.0f, 0.0f, 0.0f);
+		float area = 0.0f;
+
+		for (unsigned int t = clusters[c].start; t < clusters[c].start + clusters[c].count; ++t)
+		{
+			const XMFLOAT3& a = vertices[indices[t * 3 + 0]].Pos;
+			const XMFLOAT3& b = vertices[indices[t * 3 + 1]].Pos;
+			const XMFLOAT3& p = vertices[indices[t * 3 + 2]].Pos;
+
+			//Length of the cross product is twice the triangle area, so the sum is an area weighted normal
+			XMFLOAT3 n = Cross(Subtract(b, a), Subtract(p, a));
+			float triangleArea = sqrtf(Dot(n, n));
+
+			normal.x += n.x;
+			normal.y += n.y;
+			normal.z += n.z;
+
+			centroid.x += (a.x + b.x + p.x) / 3.0f * triangleArea;
+			centroid.y += (a.y + b.y + p.y) / 3.0f * triangleArea;
+			centroid.z += (a.z + b.z + p.z) / 3.0f * triangleArea;
+			area += triangleArea;
+		}
+
+		meshCentroid.x += centroid.x;
+		meshCentroid.y += centroid.y;
+		meshCentroid.z += centroid.z;
+		meshArea += area;
+
+		float invArea = area > 0.0f ? 1.0f / area : 0.0f;
+		clusterCentroids[c] = XMFLOAT3(centroid.x * invArea, centroid.y * invArea, centroid.z * invArea);
+
+		float length = sqrtf(Dot(normal, normal));
+		float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+		clusterNormals[c] = XMFLOAT3(normal.x * invLength, normal.y * invLength, normal.z * invLength);
+	}
+
+	float invMeshArea = meshArea > 0.0f ? 1.0f / meshArea : 0.0f;
+	meshCentroid = XMFLOAT3(meshCentroid.x * invMeshArea, meshCentroid.y * invMeshArea, meshCentroid.z * invMeshArea);
+
+	for (size_t c = 0; c < clusters.size(); ++c)
+		clusters[c].sortKey = Dot(Subtract(clusterCentroids[c], meshCentroid), clusterNormals[c]);
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<unsigned int> result;
+	result.reserve(indices.size());
+
+	for (const TriangleCluster& cluster : clusters)
+		result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + (cluster.start + cluster.count) * 3);
+
+	indices.swap(result);
+}
+
+namespace
+{
+	//Orthographic depth tested rasterizer that counts how many fragments pass the depth test
+	class OverdrawRasterizer
+	{
+	private:
+		unsigned int _resolution;
+		std::vector<float> _depth;
+		std::vector<unsigned int> _fragments;
+
+	public:
+		OverdrawRasterizer(unsigned int resolution) : _resolution(resolution) {}
+
+		void Clear()
+		{
+			_depth.assign(_resolution * _resolution, FLT_MAX);
+			_fragments.assign(_resolution * _resolution, 0);
+		}
+
+		//Vertices are already in pixel coordinates in x and y, z is depth
+		void DrawTriangle(const XMFLOAT3& a, const XMFLOAT3& b, const XMFLOAT3& c)
+		{
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+			if (area == 0.0f)
+				return;
+
+			float invArea = 1.0f / area;
+
+			int minX = std::max((int)floorf(std::min(a.x, std::min(b.x, c.x))), 0);
+			int minY = std::max((int)floorf(std::min(a.y, std::min(b.y, c.y))), 0);
+			int maxX = std::min((int)ceilf(std::max(a.x, std::max(b.x, c.x))), (int)_resolution - 1);
+			int maxY = std::min((int)ceilf(std::max(a.y, std::max(b.y, c.y))), (int)_resolution - 1);
+
+			for (int y = minY; y <= maxY; ++y)
+			{
+				for (int x = minX; x <= maxX; ++x)
+				{
+					//Barycentric coordinates of the pixel centre
+					float px = x + 0.5f;
+					float py = y + 0.5f;
+
+					float w0 = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * invArea;
+					float w1 = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * invArea;
+					float w2 = 1.0f - w0 - w1;
+
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					float depth = w0 * a.z + w1 * b.z + w2 * c.z;
+					unsigned int pixel = y * _resolution + x;
+
+					if (depth < _depth[pixel])
+					{
+						_depth[pixel] = depth;
+						++_fragments[pixel];
+					}
+				}
+			}
+		}
+
+		void Accumulate(OverdrawStats& stats) const
+		{
+			for (unsigned int fragments : _fragments)
+			{
+				stats.pixelsCovered += fragments > 0;
+				stats.pixelsShaded += fragments;
+			}
+		}
+	};
+}
+
+OverdrawStats MeshOptimizer::AnalyzeOverdraw(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, unsigned int resolution)
+{
+	OverdrawStats stats = { 0, 0, 0.0f };
+
+	if (indices.empty() || vertices.empty())
+		return stats;
+
+	//Centre and radius of the mesh, so every view direction can fit it in the same size target
+	XMFLOAT3 minPos = vertices[0].Pos;
+	XMFLOAT3 maxPos = vertices[0].Pos;
+
+	for (const SimpleVertex& vertex : vertices)
+	{
+		minPos = XMFLOAT3(std::min(minPos.x, vertex.Pos.x), std::min(minPos.y, vertex.Pos.y), std::min(minPos.z, vertex.Pos.z));
+		maxPos = XMFLOAT3(std::max(maxPos.x, vertex.Pos.x), std::max(maxPos.y, vertex.Pos.y), std::max(maxPos.z, vertex.Pos.z));
+	}
+
+	XMFLOAT3 centre((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+	XMFLOAT3 halfExtents = Subtract(maxPos, centre);
+	float radius = sqrtf(Dot(halfExtents, halfExtents));
+
+	if (radius == 0.0f)
+		return stats;
+
+	float scale = resolution * 0.5f / radius;
+
+	const float d = 0.57735027f;
+	const XMFLOAT3 directions[14] =
+	{
+		XMFLOAT3(1, 0, 0), XMFLOAT3(-1, 0, 0), XMFLOAT3(0, 1, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 0, 1), XMFLOAT3(0, 0, -1),
+		XMFLOAT3(d, d, d), XMFLOAT3(-d, d, d), XMFLOAT3(d, -d, d), XMFLOAT3(-d, -d, d),
+		XMFLOAT3(d, d, -d), XMFLOAT3(-d, d, -d), XMFLOAT3(d, -d, -d), XMFLOAT3(-d, -d, -d),
+	};
+
+	OverdrawRasterizer rasterizer(resolution);
+	std::vector<XMFLOAT3> projected(vertices.size());
+
+	for (const XMFLOAT3& forward : directions)
+	{
+		//Build a basis around the view direction
+		XMFLOAT3 up = fabsf(forward.y) > 0.9f ? XMFLOAT3(1, 0, 0) : XMFLOAT3(0, 1, 0);
+		XMFLOAT3 right = Cross(up, forward);
+		float invLength = 1.0f / sqrtf(Dot(right, right));
+		right = XMFLOAT3(right.x * invLength, right.y * invLength, right.z * invLength);
+		up = Cross(forward, right);
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			XMFLOAT3 p = Subtract(vertices[i].Pos, centre);
+			projected[i] = XMFLOAT3(Dot(p, right) * scale + resolution * 0.5f, Dot(p, up) * scale + resolution * 0.5f, Dot(p, forward));
+		}
+
+		rasterizer.Clear();
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			rasterizer.DrawTriangle(projected[indices[i]], projected[indices[i + 1]], projected[indices[i + 2]]);
+
+		rasterizer.Accumulate(stats);
+	}
+
+	stats.overdraw = stats.pixelsCovered > 0 ? (float)stats.pixelsShaded / stats.pixelsCovered : 0.0f;
+
+	return stats;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include "Structures.h"
+
+//Post-transform vertex cache statistics for an index buffer
+struct VertexCacheStats
+{
+	unsigned int vertexTransforms;	//How many times the vertex shader would run (cache misses)
+	float acmr;						//Average cache miss ratio, transforms per triangle. 0.5 is the best possible, 3 the worst
+	float atvr;						//Average transform to vertex ratio, transforms per vertex. 1 is the best possible
+};
+
+//Overdraw statistics averaged over several view directions
+struct OverdrawStats
+{
+	unsigned int pixelsCovered;		//Pixels with at least one triangle in them
+	unsigned int pixelsShaded;		//Times the pixel shader would run, i.e. fragments that passed the depth test
+	float overdraw;					//pixelsShaded / pixelsCovered, 1 is the best possible
+};
+
+//For each vertex, the list of triangles that use it. MeshSimplifier uses it too
+struct VertexTriangles
+{
+	std::vector<unsigned int> offsets;		//numVertices + 1 entries, triangles of vertex v are in [offsets[v], offsets[v + 1])
+	std::vector<unsigned int> triangles;
+
+	void Build(const std::vector<unsigned int>& indices, unsigned int numVertices);
+};
+
+//Reordering passes that make meshes cheaper to draw without changing what they look like
+namespace MeshOptimizer
+{
+	//Cache size assumed when optimizing, small enough to suit pretty much any GPU
+	const unsigned int DefaultCacheSize = 16;
+
+	enum CacheModel
+	{
+		CacheFIFO,
+		CacheLRU,
+	};
+
+	//Reorders the triangles so vertices are re-used while they're still in the post-transform cache,
+	//using Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+	void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize = DefaultCacheSize);
+
+	//Reorders the triangles of an opaque mesh so the outward facing parts tend to be drawn first and hide what's behind
+	//them, which reduces overdraw from any view direction. Run it on the output of OptimizeVertexCache: the triangles are
+	//split into clusters at the points where the cache would be starting over anyway, or where the cluster so far is within
+	//threshold of the original ACMR, so the ACMR goes up by at most that factor (e.g. 1.05 allows 5% worse)
+	void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, float threshold = 1.05f, unsigned int cacheSize = DefaultCacheSize);
+
+	//Reorders the vertices into the order the index buffer first uses them, so vertex fetch walks through memory
+	//sequentially. The indices are remapped to match and vertices that aren't used at all are dropped
+	void OptimizeVertexFetch(std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& indices);
+
+	//Runs the index buffer through a simulated post-transform cache
+	VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int numVertices, unsigned int cacheSize = DefaultCacheSize, CacheModel model = CacheFIFO);
+
+	//Rasterizes the mesh in index order on the CPU from a fixed set of 14 view directions (the axes and the cube diagonals)
+	//with a depth test and no backface culling, matching the solid rasterizer state the game uses
+	OverdrawStats AnalyzeOverdraw(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, unsigned int resolution = 256);
+};
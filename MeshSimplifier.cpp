@@ -0,0 +1,524 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <stdint.h>
+#include <thread>
+
+namespace
+{
+	//Border edges are weighted heavily so the silhouette of open meshes holds its shape
+	const float BorderWeight = 10.0f;
+
+	//Only the cheapest part of the candidate list is collapsed in each pass, the rest wait until the costs are updated
+	const unsigned int PassFraction = 3;
+
+	enum VertexKind
+	{
+		KindManifold,		//Can collapse onto any neighbour
+		KindBorder,			//On an open edge, can only collapse along it
+		KindLocked,			//On an attribute seam or somewhere too complex, never moves
+	};
+
+	//Symmetric 4x4 matrix for the sum of squared distances to a set of planes, plus the total weight of those planes
+	struct Quadric
+	{
+		float a00, a11, a22;
+		float a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		float w;
+	};
+
+	void QuadricFromPlane(Quadric& q, float a, float b, float c, float d, float weight)
+	{
+		q.a00 = a * a * weight;
+		q.a11 = b * b * weight;
+		q.a22 = c * c * weight;
+		q.a10 = a * b * weight;
+		q.a20 = a * c * weight;
+		q.a21 = b * c * weight;
+		q.b0 = a * d * weight;
+		q.b1 = b * d * weight;
+		q.b2 = c * d * weight;
+		q.c = d * d * weight;
+		q.w = weight;
+	}
+
+	void QuadricAdd(Quadric& q, const Quadric& r)
+	{
+		q.a00 += r.a00;
+		q.a11 += r.a11;
+		q.a22 += r.a22;
+		q.a10 += r.a10;
+		q.a20 += r.a20;
+		q.a21 += r.a21;
+		q.b0 += r.b0;
+		q.b1 += r.b1;
+		q.b2 += r.b2;
+		q.c += r.c;
+		q.w += r.w;
+	}
+
+	//Weighted mean squared distance from p to the planes
+	float QuadricError(const Quadric& q, const XMFLOAT3& p)
+	{
+		float rx = q.b0;
+		float ry = q.b1;
+		float rz = q.b2;
+
+		rx += q.a10 * p.y;
+		ry += q.a21 * p.z;
+		rz += q.a20 * p.x;
+
+		rx *= 2.0f;
+		ry *= 2.0f;
+		rz *= 2.0f;
+
+		rx += q.a00 * p.x;
+		ry += q.a11 * p.y;
+		rz += q.a22 * p.z;
+
+		float r = q.c + rx * p.x + ry * p.y + rz * p.z;
+
+		return q.w > 0.0f ? fabsf(r) / q.w : 0.0f;
+	}
+
+	inline XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	inline XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	inline float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline float Length(const XMFLOAT3& a)
+	{
+		return sqrtf(Dot(a, a));
+	}
+
+	inline uint64_t EdgeKey(unsigned int a, unsigned int b)
+	{
+		return ((uint64_t)a << 32) | b;
+	}
+
+	//Gives every vertex the index of the first vertex with exactly the same position, so vertices that were only
+	//kept apart by their normals or texture coordinates can be treated as one point
+	void BuildPositionRemap(const std::vector<SimpleVertex>& vertices, std::vector<unsigned int>& remap)
+	{
+		unsigned int numVertices = vertices.size();
+
+		std::vector<unsigned int> order(numVertices);
+		for (unsigned int i = 0; i < numVertices; ++i)
+			order[i] = i;
+
+		auto less = [&](unsigned int a, unsigned int b)
+		{
+			const XMFLOAT3& pa = vertices[a].Pos;
+			const XMFLOAT3& pb = vertices[b].Pos;
+
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			if (pa.z != pb.z) return pa.z < pb.z;
+			return a < b;
+		};
+
+		std::sort(order.begin(), order.end(), less);
+
+		remap.resize(numVertices);
+
+		for (unsigned int i = 0; i < numVertices; )
+		{
+			const XMFLOAT3& first = vertices[order[i]].Pos;
+
+			unsigned int j = i;
+			while (j < numVertices && vertices[order[j]].Pos.x == first.x && vertices[order[j]].Pos.y == first.y && vertices[order[j]].Pos.z == first.z)
+			{
+				remap[order[j]] = order[i];
+				++j;
+			}
+
+			i = j;
+		}
+	}
+
+	//Sorted list of directed edges between positions, an edge is open if its reverse isn't in here.
+	//Edges are compared by position so seams don't look like borders
+	void BuildEdges(const std::vector<unsigned int>& indices, const std::vector<unsigned int>& positionRemap, std::vector<uint64_t>& edges)
+	{
+		unsigned int numIndices = indices.size();
+
+		edges.clear();
+		edges.reserve(numIndices);
+
+		for (unsigned int i = 0; i < numIndices; i += 3)
+		{
+			for (unsigned int e = 0; e < 3; ++e)
+			{
+				unsigned int a = positionRemap[indices[i + e]];
+				unsigned int b = positionRemap[indices[i + (e + 1) % 3]];
+				edges.push_back(EdgeKey(a, b));
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+	}
+
+	//Works out which vertices can move, from the edges of the original mesh
+	void ClassifyVertices(const std::vector<unsigned int>& positionRemap, const std::vector<uint64_t>& edges, std::vector<unsigned char>& kinds)
+	{
+		unsigned int numVertices = positionRemap.size();
+
+		//Count the open edges at each position, a simple border vertex has one going out and one coming in
+		std::vector<unsigned int> openOut(numVertices, 0);
+		std::vector<unsigned int> openIn(numVertices, 0);
+
+		for (uint64_t edge : edges)
+		{
+			unsigned int a = (unsigned int)(edge >> 32);
+			unsigned int b = (unsigned int)edge;
+
+			if (!std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a)))
+			{
+				++openOut[a];
+				++openIn[b];
+			}
+		}
+
+		//Count how many vertices share each position, more than one means a seam
+		std::vector<unsigned int> copies(numVertices, 0);
+		for (unsigned int v = 0; v < numVertices; ++v)
+			++copies[positionRemap[v]];
+
+		kinds.resize(numVertices);
+
+		for (unsigned int v = 0; v < numVertices; ++v)
+		{
+			unsigned int p = positionRemap[v];
+
+			if (copies[p] > 1)
+				kinds[v] = KindLocked;
+			else if (openOut[p] == 0 && openIn[p] == 0)
+				kinds[v] = KindManifold;
+			else if (openOut[p] == 1 && openIn[p] == 1)
+				kinds[v] = KindBorder;
+			else
+				kinds[v] = KindLocked;
+		}
+	}
+
+	bool IsOpenEdge(const std::vector<uint64_t>& edges, unsigned int a, unsigned int b)
+	{
+		bool forward = std::binary_search(edges.begin(), edges.end(), EdgeKey(a, b));
+		bool backward = std::binary_search(edges.begin(), edges.end(), EdgeKey(b, a));
+
+		return forward != backward;
+	}
+
+	void BuildQuadrics(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices,
+					   const std::vector<unsigned int>& positionRemap, const std::vector<uint64_t>& edges, std::vector<Quadric>& quadrics)
+	{
+		Quadric zero = {};
+		quadrics.assign(vertices.size(), zero);
+
+		unsigned int numIndices = indices.size();
+
+		for (unsigned int i = 0; i < numIndices; i += 3)
+		{
+			unsigned int i0 = indices[i + 0];
+			unsigned int i1 = indices[i + 1];
+			unsigned int i2 = indices[i + 2];
+
+			const XMFLOAT3& p0 = vertices[i0].Pos;
+			const XMFLOAT3& p1 = vertices[i1].Pos;
+			const XMFLOAT3& p2 = vertices[i2].Pos;
+
+			XMFLOAT3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+			float area = Length(normal);
+
+			if (area > 0.0f)
+			{
+				normal = XMFLOAT3(normal.x / area, normal.y / area, normal.z / area);
+
+				//Weight by area so big triangles count for more than slivers
+				Quadric q;
+				QuadricFromPlane(q, normal.x, normal.y, normal.z, -Dot(normal, p0), area * 0.5f);
+
+				QuadricAdd(quadrics[i0], q);
+				QuadricAdd(quadrics[i1], q);
+				QuadricAdd(quadrics[i2], q);
+			}
+
+			//Open edges also get a plane through the edge at right angles to the triangle, which stops border
+			//vertices wandering inwards
+			unsigned int corners[3] = { i0, i1, i2 };
+
+			for (unsigned int e = 0; e < 3; ++e)
+			{
+				unsigned int a = corners[e];
+				unsigned int b = corners[(e + 1) % 3];
+
+				if (!IsOpenEdge(edges, positionRemap[a], positionRemap[b]))
+					continue;
+
+				XMFLOAT3 edge = Subtract(vertices[b].Pos, vertices[a].Pos);
+				float length = Length(edge);
+
+				XMFLOAT3 perpendicular = Cross(edge, normal);
+				float perpendicularLength = Length(perpendicular);
+
+				if (length == 0.0f || perpendicularLength == 0.0f)
+					continue;
+
+				perpendicular = XMFLOAT3(perpendicular.x / perpendicularLength, perpendicular.y / perpendicularLength, perpendicular.z / perpendicularLength);
+
+				Quadric q;
+				QuadricFromPlane(q, perpendicular.x, perpendicular.y, perpendicular.z, -Dot(perpendicular, vertices[a].Pos), length * length * BorderWeight);
+
+				QuadricAdd(quadrics[a], q);
+				QuadricAdd(quadrics[b], q);
+			}
+		}
+	}
+
+	//Moving source onto target must not turn any of source's other triangles over or squash them flat
+	bool CollapseFlipsTriangles(unsigned int source, unsigned int target, const std::vector<unsigned int>& indices,
+								const std::vector<SimpleVertex>& vertices, const VertexTriangles& adjacency)
+	{
+		const XMFLOAT3& targetPos = vertices[target].Pos;
+
+		for (unsigned int t = adjacency.offsets[source]; t < adjacency.offsets[source + 1]; ++t)
+		{
+			unsigned int triangle = adjacency.triangles[t];
+
+			unsigned int i0 = indices[triangle * 3 + 0];
+			unsigned int i1 = indices[triangle * 3 + 1];
+			unsigned int i2 = indices[triangle * 3 + 2];
+
+			//Triangles on the collapsing edge disappear, so they can't flip
+			if (i0 == target || i1 == target || i2 == target)
+				continue;
+
+			//Rotate so source comes first
+			if (i1 == source) { unsigned int r = i0; i0 = i1; i1 = i2; i2 = r; }
+			else if (i2 == source) { unsigned int r = i2; i2 = i1; i1 = i0; i0 = r; }
+
+			const XMFLOAT3& p1 = vertices[i1].Pos;
+			const XMFLOAT3& p2 = vertices[i2].Pos;
+
+			XMFLOAT3 before = Cross(Subtract(p1, vertices[source].Pos), Subtract(p2, vertices[source].Pos));
+			XMFLOAT3 after = Cross(Subtract(p1, targetPos), Subtract(p2, targetPos));
+
+			float beforeLength = Length(before);
+			float afterLength = Length(after);
+
+			//A quarter of the way to perpendicular is as far as a triangle is allowed to turn
+			if (afterLength == 0.0f || Dot(before, after) <= 0.25f * beforeLength * afterLength)
+				return true;
+		}
+
+		return false;
+	}
+
+	struct Collapse
+	{
+		unsigned int source;
+		unsigned int target;
+		float error;
+	};
+}
+
+float MeshSimplifier::Simplify(std::vector<unsigned int>& outIndices, const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, unsigned int targetIndexCount, float targetError)
+{
+	outIndices = indices;
+
+	unsigned int numVertices = vertices.size();
+
+	std::vector<unsigned int> positionRemap;
+	BuildPositionRemap(vertices, positionRemap);
+
+	std::vector<uint64_t> edges;
+	BuildEdges(indices, positionRemap, edges);
+
+	std::vector<unsigned char> kinds;
+	ClassifyVertices(positionRemap, edges, kinds);
+
+	std::vector<Quadric> quadrics;
+	BuildQuadrics(indices, vertices, positionRemap, edges, quadrics);
+
+	//Quadric errors are squared distances
+	float errorLimit = targetError < FLT_MAX ? targetError * targetError : FLT_MAX;
+	float resultError = 0.0f;
+
+	VertexTriangles adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> remap(numVertices);
+	std::vector<unsigned char> touched(numVertices);
+
+	while (outIndices.size() > targetIndexCount)
+	{
+		unsigned int numIndices = outIndices.size();
+		adjacency.Build(outIndices, numVertices);
+
+		//Collapses along the border make new border edges, so these are rebuilt every pass
+		if (numIndices != indices.size())
+			BuildEdges(outIndices, positionRemap, edges);
+
+		//Find the cheapest allowed direction for every edge
+		collapses.clear();
+
+		for (unsigned int i = 0; i < numIndices; i += 3)
+		{
+			for (unsigned int e = 0; e < 3; ++e)
+			{
+				unsigned int a = outIndices[i + e];
+				unsigned int b = outIndices[i + (e + 1) % 3];
+
+				//Each interior edge shows up in two triangles, only look at it from one of them
+				if (a > b && !IsOpenEdge(edges, positionRemap[a], positionRemap[b]))
+					continue;
+
+				Collapse best = { 0, 0, FLT_MAX };
+				bool found = false;
+
+				for (unsigned int direction = 0; direction < 2; ++direction)
+				{
+					unsigned int source = direction == 0 ? a : b;
+					unsigned int target = direction == 0 ? b : a;
+
+					if (kinds[source] == KindLocked)
+						continue;
+
+					if (kinds[source] == KindBorder && !IsOpenEdge(edges, positionRemap[source], positionRemap[target]))
+						continue;
+
+					float error = QuadricError(quadrics[source], vertices[target].Pos);
+
+					if (!found || error < best.error)
+					{
+						found = true;
+						best.source = source;
+						best.target = target;
+						best.error = error;
+					}
+				}
+
+				if (found && best.error <= errorLimit)
+					collapses.push_back(best);
+			}
+		}
+
+		if (collapses.empty())
+			break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+		//Collapse the cheapest edges that don't touch each other. Each collapse usually removes two triangles
+		unsigned int trianglesToRemove = (numIndices - targetIndexCount) / 3;
+		unsigned int candidates = std::max(1u, (unsigned int)collapses.size() / PassFraction);
+		unsigned int removed = 0;
+		unsigned int applied = 0;
+
+		for (unsigned int v = 0; v < numVertices; ++v)
+			remap[v] = v;
+
+		std::fill(touched.begin(), touched.end(), 0);
+
+		for (unsigned int c = 0; c < candidates && removed < trianglesToRemove; ++c)
+		{
+			const Collapse& collapse = collapses[c];
+
+			if (touched[collapse.source] || touched[collapse.target])
+				continue;
+
+			if (CollapseFlipsTriangles(collapse.source, collapse.target, outIndices, vertices, adjacency))
+				continue;
+
+			remap[collapse.source] = collapse.target;
+			QuadricAdd(quadrics[collapse.target], quadrics[collapse.source]);
+			resultError = std::max(resultError, collapse.error);
+			++applied;
+
+			//Lock every vertex around the source for the rest of the pass, so the adjacency stays correct
+			for (unsigned int t = adjacency.offsets[collapse.source]; t < adjacency.offsets[collapse.source + 1]; ++t)
+			{
+				unsigned int triangle = adjacency.triangles[t];
+				bool onEdge = false;
+
+				for (unsigned int k = 0; k < 3; ++k)
+				{
+					unsigned int index = outIndices[triangle * 3 + k];
+					touched[index] = 1;
+					onEdge |= index == collapse.target;
+				}
+
+				if (onEdge)
+					++removed;
+			}
+		}
+
+		if (applied == 0)
+			break;
+
+		//Apply the collapses and drop the triangles that became degenerate
+		unsigned int write = 0;
+
+		for (unsigned int i = 0; i < numIndices; i += 3)
+		{
+			unsigned int i0 = remap[outIndices[i + 0]];
+			unsigned int i1 = remap[outIndices[i + 1]];
+			unsigned int i2 = remap[outIndices[i + 2]];
+
+			if (i0 == i1 || i1 == i2 || i2 == i0)
+				continue;
+
+			outIndices[write + 0] = i0;
+			outIndices[write + 1] = i1;
+			outIndices[write + 2] = i2;
+			write += 3;
+		}
+
+		outIndices.resize(write);
+	}
+
+	return sqrtf(resultError);
+}
+
+void MeshSimplifier::GenerateLODs(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, const std::vector<float>& ratios,
+								  std::vector<SimplifiedLOD>& outLODs, unsigned int threadCount)
+{
+	unsigned int numLODs = ratios.size();
+	outLODs.resize(numLODs);
+
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	//Each thread takes the next level nobody has started on until there are none left
+	std::atomic<unsigned int> next(0);
+
+	auto worker = [&]()
+	{
+		for (unsigned int i = next++; i < numLODs; i = next++)
+		{
+			unsigned int targetIndexCount = (unsigned int)(indices.size() / 3 * ratios[i]) * 3;
+			outLODs[i].error = Simplify(outLODs[i].indices, indices, vertices, targetIndexCount);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < std::min(threadCount, numLODs); ++i)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <float.h>
+#include <vector>
+#include "Structures.h"
+
+//One level of detail made by MeshSimplifier
+struct SimplifiedLOD
+{
+	std::vector<unsigned int> indices;	//Triangle list that indexes into the same vertices as the original mesh
+	float error;						//Roughly how far (in model space units) the surface moved from the original
+};
+
+//Reduces the triangle count of meshes for drawing them further away, using quadric error metrics
+//(Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+//Edges are collapsed onto one of their existing vertices, so the simplified index buffers keep using the original
+//vertex buffer. Vertices on UV/normal seams are never moved and vertices on open borders only slide along the border,
+//so neither cracks open up.
+namespace MeshSimplifier
+{
+	//Simplifies the mesh until it has at most targetIndexCount indices, or stops early if the next collapse would move
+	//the surface more than targetError. Returns the error of the result, in the same units as the positions
+	float Simplify(std::vector<unsigned int>& outIndices, const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, unsigned int targetIndexCount, float targetError = FLT_MAX);
+
+	//Makes one LOD per entry in ratios (the fraction of triangles to keep, e.g. 0.5, 0.25, 0.125).
+	//Each level is simplified from the original mesh, shared between up to threadCount threads (the calling thread one
+	//of them), one a core if it's 0. Only the levels of one mesh are spread out here. Several meshes are cooked at once
+	//by the callers, AssetLoader's workers and Tools/AssetCooker, so each of those can have this many threads of its own
+	void GenerateLODs(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, const std::vector<float>& ratios,
+					  std::vector<SimplifiedLOD>& outLODs, unsigned int threadCount = 0);
+};
@@ -0,0 +1,172 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+	//Triangles spread further than this from the average normal make the cone useless, so it's turned off
+	const float MinConeDot = 0.1f;
+
+	inline XMFLOAT3 Subtract(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.x - b.x, a.y - b.y, a.z - b.z);
+	}
+
+	inline XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	inline float Dot(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline float Length(const XMFLOAT3& a)
+	{
+		return sqrtf(Dot(a, a));
+	}
+
+	void ComputeBounds(Meshlet& meshlet, const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices)
+	{
+		unsigned int begin = meshlet.indexStart;
+		unsigned int end = meshlet.indexStart + meshlet.indexCount;
+
+		//Sphere around the centre of the bounding box
+		XMFLOAT3 minPos = vertices[indices[begin]].Pos;
+		XMFLOAT3 maxPos = minPos;
+
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			const XMFLOAT3& p = vertices[indices[i]].Pos;
+			minPos = XMFLOAT3(std::min(minPos.x, p.x), std::min(minPos.y, p.y), std::min(minPos.z, p.z));
+			maxPos = XMFLOAT3(std::max(maxPos.x, p.x), std::max(maxPos.y, p.y), std::max(maxPos.z, p.z));
+		}
+
+		XMFLOAT3 center((minPos.x + maxPos.x) * 0.5f, (minPos.y + maxPos.y) * 0.5f, (minPos.z + maxPos.z) * 0.5f);
+		float radius = 0.0f;
+
+		for (unsigned int i = begin; i < end; ++i)
+			radius = std::max(radius, Length(Subtract(vertices[indices[i]].Pos, center)));
+
+		meshlet.center = center;
+		meshlet.radius = radius;
+
+		//Average the triangle normals for the cone axis, each one turned to agree with its vertex normals
+		std::vector<XMFLOAT3> normals;
+		normals.reserve(meshlet.indexCount / 3);
+
+		XMFLOAT3 axis(0.0f, 0.0f, 0.0f);
+
+		for (unsigned int i = begin; i < end; i += 3)
+		{
+			const SimpleVertex& v0 = vertices[indices[i + 0]];
+			const SimpleVertex& v1 = vertices[indices[i + 1]];
+			const SimpleVertex& v2 = vertices[indices[i + 2]];
+
+			XMFLOAT3 normal = Cross(Subtract(v1.Pos, v0.Pos), Subtract(v2.Pos, v0.Pos));
+			float length = Length(normal);
+
+			if (length == 0.0f)
+				continue;
+
+			XMFLOAT3 shading(v0.Normal.x + v1.Normal.x + v2.Normal.x, v0.Normal.y + v1.Normal.y + v2.Normal.y, v0.Normal.z + v1.Normal.z + v2.Normal.z);
+			if (Dot(normal, shading) < 0.0f)
+				length = -length;
+
+			normal = XMFLOAT3(normal.x / length, normal.y / length, normal.z / length);
+			normals.push_back(normal);
+
+			axis = XMFLOAT3(axis.x + normal.x, axis.y + normal.y, axis.z + normal.z);
+		}
+
+		meshlet.coneApex = center;
+		meshlet.coneAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		meshlet.coneCutoff = 2.0f;
+
+		float axisLength = Length(axis);
+		if (axisLength == 0.0f)
+			return;
+
+		axis = XMFLOAT3(axis.x / axisLength, axis.y / axisLength, axis.z / axisLength);
+
+		float minDot = 1.0f;
+		for (const XMFLOAT3& normal : normals)
+			minDot = std::min(minDot, Dot(normal, axis));
+
+		if (minDot <= MinConeDot)
+			return;
+
+		//Move the apex back along the axis until every triangle's plane is in front of it, so a camera that sees
+		//the apex from behind the cone sees every triangle from behind too
+		float maxT = 0.0f;
+
+		for (unsigned int i = begin, t = 0; i < end; i += 3)
+		{
+			const XMFLOAT3& p0 = vertices[indices[i]].Pos;
+			XMFLOAT3 edge = Cross(Subtract(vertices[indices[i + 1]].Pos, p0), Subtract(vertices[indices[i + 2]].Pos, p0));
+
+			if (Length(edge) == 0.0f)
+				continue;
+
+			const XMFLOAT3& normal = normals[t++];
+			maxT = std::max(maxT, Dot(Subtract(center, p0), normal) / Dot(axis, normal));
+		}
+
+		meshlet.coneApex = XMFLOAT3(center.x - axis.x * maxT, center.y - axis.y * maxT, center.z - axis.z * maxT);
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+void MeshletBuilder::Build(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, std::vector<Meshlet>& outMeshlets,
+						   unsigned int maxVertices, unsigned int maxTriangles)
+{
+	outMeshlets.clear();
+
+	unsigned int numIndices = indices.size();
+	if (numIndices == 0)
+		return;
+
+	//The meshlet each vertex was last added to, so checking whether a triangle brings new vertices is a lookup
+	std::vector<unsigned int> lastMeshlet(vertices.size(), ~0u);
+
+	Meshlet current = {};
+
+	for (unsigned int i = 0; i < numIndices; i += 3)
+	{
+		unsigned int newVertices = 0;
+
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			if (lastMeshlet[indices[i + k]] != outMeshlets.size())
+				++newVertices;
+		}
+
+		//Repeated vertices in a degenerate triangle get counted twice, which only makes the check a little conservative
+		if (current.indexCount > 0 && (current.vertexCount + newVertices > maxVertices || current.indexCount / 3 + 1 > maxTriangles))
+		{
+			ComputeBounds(current, indices, vertices);
+			outMeshlets.push_back(current);
+
+			current = Meshlet();
+			current.indexStart = i;
+		}
+
+		unsigned int id = outMeshlets.size();
+
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			if (lastMeshlet[indices[i + k]] != id)
+			{
+				lastMeshlet[indices[i + k]] = id;
+				++current.vertexCount;
+			}
+		}
+
+		current.indexCount += 3;
+	}
+
+	ComputeBounds(current, indices, vertices);
+	outMeshlets.push_back(current);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "Structures.h"
+
+//A small cluster of neighbouring triangles that is culled as a whole. Its triangles are a contiguous part
+//of the mesh's index list, so drawing the visible clusters is just copying their ranges of indices together
+struct Meshlet
+{
+	unsigned int indexStart;
+	unsigned int indexCount;
+	unsigned int vertexCount;		//Unique vertices the cluster uses
+
+	//Bounding sphere, for frustum culling
+	XMFLOAT3 center;
+	float radius;
+
+	//Normal cone, for backface culling. Every triangle faces away from any camera position p where
+	//dot(normalize(coneApex - p), coneAxis) >= coneCutoff. The cutoff is above 1 when the triangles face too
+	//many different ways for that to ever happen
+	XMFLOAT3 coneApex;
+	XMFLOAT3 coneAxis;
+	float coneCutoff;
+};
+
+//Splits meshes into meshlets
+namespace MeshletBuilder
+{
+	//Limits that also suit mesh shaders, if the renderer ever moves to them
+	const unsigned int MaxVertices = 64;
+	const unsigned int MaxTriangles = 124;
+
+	//Walks the triangles in order, starting a new meshlet whenever the current one would go over either limit,
+	//so run it after MeshOptimizer::OptimizeVertexCache to get tight clusters. Facing is taken from the vertex normals
+	//rather than the winding, so it works whatever winding order the file used
+	void Build(const std::vector<unsigned int>& indices, const std::vector<SimpleVertex>& vertices, std::vector<Meshlet>& outMeshlets,
+			   unsigned int maxVertices = MaxVertices, unsigned int maxTriangles = MaxTriangles);
+};
@@ -0,0 +1,181 @@
+#include "MeshletCuller.h"
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace
+{
+	//Frustum planes pulled out of the combined matrix (Gribb and Hartmann), pointing inwards and normalized so
+	//plane . p is the distance to the plane in model space
+	void ExtractFrustumPlanes(const XMFLOAT4X4& m, XMFLOAT4* planes)
+	{
+		//Left, right, bottom, top, near (Direct3D's clip space z starts at 0) and far
+		planes[0] = XMFLOAT4(m._14 + m._11, m._24 + m._21, m._34 + m._31, m._44 + m._41);
+		planes[1] = XMFLOAT4(m._14 - m._11, m._24 - m._21, m._34 - m._31, m._44 - m._41);
+		planes[2] = XMFLOAT4(m._14 + m._12, m._24 + m._22, m._34 + m._32, m._44 + m._42);
+		planes[3] = XMFLOAT4(m._14 - m._12, m._24 - m._22, m._34 - m._32, m._44 - m._42);
+		planes[4] = XMFLOAT4(m._13, m._23, m._33, m._43);
+		planes[5] = XMFLOAT4(m._14 - m._13, m._24 - m._23, m._34 - m._33, m._44 - m._43);
+
+		for (unsigned int i = 0; i < 6; ++i)
+		{
+			float length = sqrtf(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+
+			if (length > 0.0f)
+				planes[i] = XMFLOAT4(planes[i].x / length, planes[i].y / length, planes[i].z / length, planes[i].w / length);
+		}
+	}
+
+	inline XMVECTOR Load4(const std::vector<float>& values, unsigned int i)
+	{
+		return XMLoadFloat4((const XMFLOAT4*)&values[i]);
+	}
+}
+
+void MeshletCuller::Init(const std::vector<Meshlet>& meshlets)
+{
+	_meshlets = meshlets;
+
+	unsigned int count = meshlets.size();
+	unsigned int padded = (count + 3) & ~3u;
+
+	//Padding meshlets have a negative radius so they're outside every plane
+	_centerX.assign(padded, 0.0f);
+	_centerY.assign(padded, 0.0f);
+	_centerZ.assign(padded, 0.0f);
+	_radius.assign(padded, -FLT_MAX);
+
+	_apexX.assign(padded, 0.0f);
+	_apexY.assign(padded, 0.0f);
+	_apexZ.assign(padded, 0.0f);
+	_axisX.assign(padded, 0.0f);
+	_axisY.assign(padded, 0.0f);
+	_axisZ.assign(padded, 0.0f);
+	_cutoff.assign(padded, 2.0f);
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		const Meshlet& meshlet = meshlets[i];
+
+		_centerX[i] = meshlet.center.x;
+		_centerY[i] = meshlet.center.y;
+		_centerZ[i] = meshlet.center.z;
+		_radius[i] = meshlet.radius;
+
+		_apexX[i] = meshlet.coneApex.x;
+		_apexY[i] = meshlet.coneApex.y;
+		_apexZ[i] = meshlet.coneApex.z;
+		_axisX[i] = meshlet.coneAxis.x;
+		_axisY[i] = meshlet.coneAxis.y;
+		_axisZ[i] = meshlet.coneAxis.z;
+		_cutoff[i] = meshlet.coneCutoff;
+	}
+}
+
+void MeshletCuller::Cull(const XMFLOAT4X4& worldViewProjection, const XMFLOAT3& cameraPosition, bool cullBackfaces,
+						 std::vector<unsigned int>& outVisible, MeshletCullStats* stats) const
+{
+	outVisible.clear();
+
+	XMFLOAT4 planes[6];
+	ExtractFrustumPlanes(worldViewProjection, planes);
+
+	XMVECTOR cameraX = XMVectorReplicate(cameraPosition.x);
+	XMVECTOR cameraY = XMVectorReplicate(cameraPosition.y);
+	XMVECTOR cameraZ = XMVectorReplicate(cameraPosition.z);
+
+	unsigned int count = _meshlets.size();
+	unsigned int padded = _centerX.size();
+
+	MeshletCullStats totals = {};
+	totals.meshlets = count;
+
+	for (unsigned int i = 0; i < padded; i += 4)
+	{
+		XMVECTOR centerX = Load4(_centerX, i);
+		XMVECTOR centerY = Load4(_centerY, i);
+		XMVECTOR centerZ = Load4(_centerZ, i);
+		XMVECTOR negativeRadius = XMVectorNegate(Load4(_radius, i));
+
+		//A sphere is outside if it's entirely behind any one of the planes
+		XMVECTOR outside = XMVectorFalseInt();
+
+		for (unsigned int p = 0; p < 6; ++p)
+		{
+			XMVECTOR distance = XMVectorMultiplyAdd(centerX, XMVectorReplicate(planes[p].x), XMVectorReplicate(planes[p].w));
+			distance = XMVectorMultiplyAdd(centerY, XMVectorReplicate(planes[p].y), distance);
+			distance = XMVectorMultiplyAdd(centerZ, XMVectorReplicate(planes[p].z), distance);
+
+			outside = XMVectorOrInt(outside, XMVectorLess(distance, negativeRadius));
+		}
+
+		//Backfacing if the camera is inside the cone behind the apex: dot(apex - camera, axis) >= cutoff * |apex - camera|
+		XMVECTOR backfacing = XMVectorFalseInt();
+
+		if (cullBackfaces)
+		{
+			XMVECTOR toApexX = XMVectorSubtract(Load4(_apexX, i), cameraX);
+			XMVECTOR toApexY = XMVectorSubtract(Load4(_apexY, i), cameraY);
+			XMVECTOR toApexZ = XMVectorSubtract(Load4(_apexZ, i), cameraZ);
+
+			XMVECTOR along = XMVectorMultiply(toApexX, Load4(_axisX, i));
+			along = XMVectorMultiplyAdd(toApexY, Load4(_axisY, i), along);
+			along = XMVectorMultiplyAdd(toApexZ, Load4(_axisZ, i), along);
+
+			XMVECTOR lengthSquared = XMVectorMultiply(toApexX, toApexX);
+			lengthSquared = XMVectorMultiplyAdd(toApexY, toApexY, lengthSquared);
+			lengthSquared = XMVectorMultiplyAdd(toApexZ, toApexZ, lengthSquared);
+
+			backfacing = XMVectorGreaterOrEqual(along, XMVectorMultiply(Load4(_cutoff, i), XMVectorSqrt(lengthSquared)));
+		}
+
+		uint32_t outsideMask[4];
+		uint32_t backfacingMask[4];
+		XMStoreInt4(outsideMask, outside);
+		XMStoreInt4(backfacingMask, backfacing);
+
+		for (unsigned int k = 0; k < 4 && i + k < count; ++k)
+		{
+			unsigned int triangles = _meshlets[i + k].indexCount / 3;
+			totals.triangles += triangles;
+
+			if (outsideMask[k])
+			{
+				totals.trianglesOutsideFrustum += triangles;
+			}
+			else if (backfacingMask[k])
+			{
+				totals.trianglesBackfacing += triangles;
+			}
+			else
+			{
+				outVisible.push_back(i + k);
+				totals.trianglesVisible += triangles;
+			}
+		}
+	}
+
+	totals.meshletsVisible = outVisible.size();
+
+	if (stats)
+		*stats = totals;
+}
+
+unsigned int MeshletCuller::CompactIndices(const std::vector<unsigned int>& visible, const void* indices, unsigned int indexSize, void* outIndices) const
+{
+	const unsigned char* source = (const unsigned char*)indices;
+	unsigned char* destination = (unsigned char*)outIndices;
+
+	unsigned int written = 0;
+
+	for (unsigned int id : visible)
+	{
+		const Meshlet& meshlet = _meshlets[id];
+
+		memcpy(destination + written * indexSize, source + meshlet.indexStart * indexSize, meshlet.indexCount * indexSize);
+		written += meshlet.indexCount;
+	}
+
+	return written;
+}
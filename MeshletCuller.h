@@ -0,0 +1,54 @@
+#pragma once
+#include <directxmath.h>
+#include <vector>
+#include "MeshletBuilder.h"
+
+using namespace DirectX;
+
+//What one call to MeshletCuller::Cull got rid of
+struct MeshletCullStats
+{
+	unsigned int meshlets;
+	unsigned int meshletsVisible;
+	unsigned int triangles;
+	unsigned int trianglesVisible;
+	unsigned int trianglesOutsideFrustum;
+	unsigned int trianglesBackfacing;		//Inside the frustum but culled by the normal cone
+};
+
+//Culls a mesh's meshlets against the view frustum and their normal cones on the CPU, four meshlets at a time using
+//DirectXMath vectors. The meshlet data is kept as separate arrays of x, y, z etc. so each vector holds the same value
+//for four different meshlets
+class MeshletCuller
+{
+private:
+	std::vector<Meshlet> _meshlets;
+
+	//Padded to a multiple of 4 with meshlets that are always culled
+	std::vector<float> _centerX;
+	std::vector<float> _centerY;
+	std::vector<float> _centerZ;
+	std::vector<float> _radius;
+
+	std::vector<float> _apexX;
+	std::vector<float> _apexY;
+	std::vector<float> _apexZ;
+	std::vector<float> _axisX;
+	std::vector<float> _axisY;
+	std::vector<float> _axisZ;
+	std::vector<float> _cutoff;
+
+public:
+	void Init(const std::vector<Meshlet>& meshlets);
+
+	const std::vector<Meshlet>& getMeshlets() const { return _meshlets; }
+
+	// Finds the meshlets that can be seen. worldViewProjection is the matrix the vertex shader uses, cameraPosition is in
+	// the mesh's model space. Backface culling is only right for closed meshes (or with a rasterizer that culls backfaces)
+	void Cull(const XMFLOAT4X4& worldViewProjection, const XMFLOAT3& cameraPosition, bool cullBackfaces,
+			  std::vector<unsigned int>& outVisible, MeshletCullStats* stats = nullptr) const;
+
+	// Copies the indices of the visible meshlets one after the other into outIndices, which needs room for all of the
+	// mesh's indices. indexSize is 2 or 4 bytes. Returns how many indices were copied
+	unsigned int CompactIndices(const std::vector<unsigned int>& visible, const void* indices, unsigned int indexSize, void* outIndices) const;
+};
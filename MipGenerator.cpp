@@ -0,0 +1,586 @@
+#include "MipGenerator.h"
+#include "MeshCache.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <fstream>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPGENERATOR_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef __AVX__
+#define MIPGENERATOR_AVX
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	const double Pi = 3.14159265358979323846;
+
+	//How far the Kaiser filter reaches either side, in texels of the mip being made, and how quickly its window falls away
+	const double KaiserRadius = 3.0;
+	const double KaiserAlpha = 4.0;
+
+	//Below this many texels of a mip it isn't worth starting another thread
+	const size_t MinTexelsPerThread = 16384;
+
+	//The header flags and caps a DDS file with mips has
+	const uint32_t HeaderFlagsMipMapCount = 0x00020000;		//DDSD_MIPMAPCOUNT
+	const uint32_t CapsComplex = 0x00000008;				//DDSCAPS_COMPLEX
+	const uint32_t CapsMipMap = 0x00400000;					//DDSCAPS_MIPMAP
+
+	//Which texels of a row (or column) of one mip make each texel of the next, and how much of each. Texel i of the mip is
+	//count[i] texels from first[i], whose weights start at weights[i * stride] and add up to 1
+	struct Taps
+	{
+		std::vector<uint32_t> first;
+		std::vector<uint32_t> count;
+		std::vector<float> weights;
+		size_t stride;
+	};
+
+	//Enough that a bucket of linear values never spans more than one sRGB code, the steepest part of the curve being
+	//12.92 * 255 codes across the whole of linear
+	const int SRGBBuckets = 4096;
+
+	struct SRGBTables
+	{
+		float toLinear[256];
+		float thresholds[257];		//thresholds[c] is the lowest linear value that encodes to c, with one past 255 none reach
+		uint8_t start[SRGBBuckets];	//The lowest code of the values in each SRGBBuckets'th of linear
+	};
+
+	double BesselI0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+
+		for (int k = 1; k < 50; ++k)
+		{
+			double factor = x / (2.0 * k);
+			term *= factor * factor;
+			sum += term;
+
+			if (term < sum * 1e-12)
+				break;
+		}
+
+		return sum;
+	}
+
+	//t is in texels of the mip being made, from the centre of the texel
+	double Kaiser(double t)
+	{
+		if (fabs(t) >= KaiserRadius)
+			return 0.0;
+
+		double sinc = t == 0.0 ? 1.0 : sin(Pi * t) / (Pi * t);
+		double r = t / KaiserRadius;
+
+		return sinc * BesselI0(KaiserAlpha * sqrt(1.0 - r * r)) / BesselI0(KaiserAlpha);
+	}
+
+	Taps MakeTaps(size_t sourceSize, size_t size, MipFilter filter)
+	{
+		double scale = (double)sourceSize / size;
+		double radius = filter == MipFilterBox ? scale * 0.5 : KaiserRadius * scale;
+
+		Taps taps;
+		taps.stride = std::min((size_t)ceil(radius * 2.0) + 2, sourceSize);
+		taps.first.resize(size);
+		taps.count.resize(size);
+		taps.weights.assign(size * taps.stride, 0.0f);
+
+		std::vector<double> weights(sourceSize, 0.0);
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			double center = (i + 0.5) * scale;
+			long long low = (long long)floor(center - radius);
+			long long high = (long long)ceil(center + radius);
+			size_t first = sourceSize;
+			size_t last = 0;
+			double sum = 0.0;
+
+			for (long long s = low; s < high; ++s)
+			{
+				double weight;
+
+				if (filter == MipFilterBox)
+					weight = std::max(std::min(s + 1.0, center + radius) - std::max((double)s, center - radius), 0.0);
+				else
+					weight = Kaiser((s + 0.5 - center) / scale);
+
+				//Texels past the edges are the edge texel again
+				size_t clamped = (size_t)std::min(std::max(s, 0LL), (long long)sourceSize - 1);
+				weights[clamped] += weight;
+				sum += weight;
+				first = std::min(first, clamped);
+				last = std::max(last, clamped);
+			}
+
+			taps.first[i] = (uint32_t)first;
+			taps.count[i] = (uint32_t)(last - first + 1);
+
+			for (size_t s = first; s <= last; ++s)
+			{
+				taps.weights[i * taps.stride + s - first] = (float)(weights[s] / sum);
+				weights[s] = 0.0;
+			}
+		}
+
+		return taps;
+	}
+
+	double SRGBToLinear(double value)
+	{
+		return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	const SRGBTables& getSRGBTables()
+	{
+		static const SRGBTables tables = []() {
+			SRGBTables made;
+
+			for (int c = 0; c < 256; ++c)
+			{
+				made.toLinear[c] = (float)SRGBToLinear(c / 255.0);
+				made.thresholds[c] = c == 0 ? 0.0f : (float)SRGBToLinear((c - 0.5) / 255.0);
+			}
+
+			made.thresholds[256] = 2.0f;
+			int code = 0;
+
+			for (int i = 0; i < SRGBBuckets; ++i)
+			{
+				while (made.thresholds[code + 1] <= (float)i / SRGBBuckets)
+					++code;
+
+				made.start[i] = (uint8_t)code;
+			}
+
+			return made;
+		}();
+
+		return tables;
+	}
+
+	//Rounds to the nearest sRGB code, exactly: it's either the lowest code in the value's bucket or the one after
+	inline uint8_t LinearToSRGB(const SRGBTables& tables, float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+
+		int code = tables.start[std::min((int)(value * SRGBBuckets), SRGBBuckets - 1)];
+
+		return (uint8_t)(code + (value >= tables.thresholds[code + 1]));
+	}
+
+	inline uint8_t ToUNORM(float value)
+	{
+		return (uint8_t)lrintf(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+	}
+
+	//Converts count texels to 4 floats each, decoding the first three channels from sRGB if srgb is set
+	void ToLinear(const uint8_t* texels, size_t count, bool srgb, float* out)
+	{
+		size_t i = 0;
+
+		if (srgb)
+		{
+			const float* table = getSRGBTables().toLinear;
+
+			for (; i < count; ++i)
+			{
+				out[i * 4 + 0] = table[texels[i * 4 + 0]];
+				out[i * 4 + 1] = table[texels[i * 4 + 1]];
+				out[i * 4 + 2] = table[texels[i * 4 + 2]];
+				out[i * 4 + 3] = texels[i * 4 + 3] * (1.0f / 255.0f);
+			}
+
+			return;
+		}
+
+#ifdef MIPGENERATOR_SSE2
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+		const __m128i zero = _mm_setzero_si128();
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i bytes = _mm_loadu_si128((const __m128i*)(texels + i * 4));
+			__m128i low = _mm_unpacklo_epi8(bytes, zero);
+			__m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+			_mm_storeu_ps(out + i * 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), scale));
+			_mm_storeu_ps(out + i * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), scale));
+			_mm_storeu_ps(out + i * 4 + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), scale));
+			_mm_storeu_ps(out + i * 4 + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), scale));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				out[i * 4 + c] = texels[i * 4 + c] * (1.0f / 255.0f);
+		}
+	}
+
+	//The opposite of ToLinear, rounding to the nearest code
+	void FromLinear(const float* texels, size_t count, bool srgb, uint8_t* out)
+	{
+		size_t i = 0;
+
+		if (srgb)
+		{
+			const SRGBTables& tables = getSRGBTables();
+
+			for (; i < count; ++i)
+			{
+				out[i * 4 + 0] = LinearToSRGB(tables, texels[i * 4 + 0]);
+				out[i * 4 + 1] = LinearToSRGB(tables, texels[i * 4 + 1]);
+				out[i * 4 + 2] = LinearToSRGB(tables, texels[i * 4 + 2]);
+				out[i * 4 + 3] = ToUNORM(texels[i * 4 + 3]);
+			}
+
+			return;
+		}
+
+#ifdef MIPGENERATOR_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i values[4];
+
+			//Rounds to nearest, ties to even, the same as lrintf
+			for (int j = 0; j < 4; ++j)
+				values[j] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(texels + (i + j) * 4), zero), one), scale));
+
+			__m128i words = _mm_packs_epi32(values[0], values[1]);
+			_mm_storeu_si128((__m128i*)(out + i * 4), _mm_packus_epi16(words, _mm_packs_epi32(values[2], values[3])));
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+				out[i * 4 + c] = ToUNORM(texels[i * 4 + c]);
+		}
+	}
+
+	//Filters a row of count source texels (as 4 floats each) down to a row of the mip
+	void FilterRow(const float* source, const Taps& taps, size_t width, float* out)
+	{
+		for (size_t x = 0; x < width; ++x)
+		{
+			const float* texel = source + (size_t)taps.first[x] * 4;
+			const float* weight = &taps.weights[x * taps.stride];
+			uint32_t count = taps.count[x];
+
+#ifdef MIPGENERATOR_SSE2
+			__m128 sum = _mm_mul_ps(_mm_loadu_ps(texel), _mm_set1_ps(weight[0]));
+
+			for (uint32_t k = 1; k < count; ++k)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(texel + k * 4), _mm_set1_ps(weight[k])));
+
+			_mm_storeu_ps(out + x * 4, sum);
+#else
+			float sum[4] = { texel[0] * weight[0], texel[1] * weight[0], texel[2] * weight[0], texel[3] * weight[0] };
+
+			for (uint32_t k = 1; k < count; ++k)
+			{
+				for (int c = 0; c < 4; ++c)
+					sum[c] += texel[k * 4 + c] * weight[k];
+			}
+
+			for (int c = 0; c < 4; ++c)
+				out[x * 4 + c] = sum[c];
+#endif
+		}
+	}
+
+	//sum = row * weight if first is set, otherwise sum += row * weight, over count floats
+	void AddRow(float* sum, const float* row, float weight, size_t count, bool first)
+	{
+		size_t i = 0;
+
+#if defined(MIPGENERATOR_AVX)
+		const __m256 weights = _mm256_set1_ps(weight);
+
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 value = _mm256_mul_ps(_mm256_loadu_ps(row + i), weights);
+			_mm256_storeu_ps(sum + i, first ? value : _mm256_add_ps(_mm256_loadu_ps(sum + i), value));
+		}
+#elif defined(MIPGENERATOR_SSE2)
+		const __m128 weights = _mm_set1_ps(weight);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 value = _mm_mul_ps(_mm_loadu_ps(row + i), weights);
+			_mm_storeu_ps(sum + i, first ? value : _mm_add_ps(_mm_loadu_ps(sum + i), value));
+		}
+#endif
+
+		for (; i < count; ++i)
+			sum[i] = first ? row[i] * weight : sum[i] + row[i] * weight;
+	}
+
+	//Makes rows firstRow to lastRow (not included) of a mip. Each row of the source it needs is converted and filtered
+	//across once, into a ring of as many rows as the filter reaches down, then the ring's rows are added together
+	void FilterBand(const uint8_t* source, size_t sourceWidth, uint8_t* out, size_t width, const Taps& horizontal,
+					const Taps& vertical, bool srgb, size_t firstRow, size_t lastRow)
+	{
+		size_t ringRows = vertical.stride;
+		size_t rowFloats = width * 4;
+
+		std::vector<float> sourceRow(sourceWidth * 4);
+		std::vector<float> ring(ringRows * rowFloats);
+		std::vector<size_t> ringSource(ringRows, SIZE_MAX);
+		std::vector<float> sum(rowFloats);
+
+		for (size_t y = firstRow; y < lastRow; ++y)
+		{
+			for (uint32_t k = 0; k < vertical.count[y]; ++k)
+			{
+				size_t s = vertical.first[y] + k;
+				size_t slot = s % ringRows;
+				float* row = &ring[slot * rowFloats];
+
+				if (ringSource[slot] != s)
+				{
+					ToLinear(source + s * sourceWidth * 4, sourceWidth, srgb, sourceRow.data());
+					FilterRow(sourceRow.data(), horizontal, width, row);
+					ringSource[slot] = s;
+				}
+
+				AddRow(sum.data(), row, vertical.weights[y * vertical.stride + k], rowFloats, k == 0);
+			}
+
+			FromLinear(sum.data(), width, srgb, out + y * rowFloats);
+		}
+	}
+
+	bool IsSRGB(DXGI_FORMAT format)
+	{
+		return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+	}
+
+	//What SaveCache stamps into reserved1 of the header, after CacheMagic and Version and before the filter, which is only
+	//there for anyone looking at the file
+	struct CacheStamp
+	{
+		uint64_t settingsHash;
+		uint64_t sourceSize;
+		int64_t sourceModifiedTime;
+		uint64_t sourceHash;
+	};
+
+	static_assert(sizeof(CacheStamp) + 3 * sizeof(uint32_t) <= sizeof(DirectX::DDS_HEADER::reserved1), "The stamp has to fit in reserved1");
+}
+
+bool MipGenerator::IsSupported(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8X8_UNORM:
+	case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool MipGenerator::NeedsMips(const DirectX::DDS_TEXTURE_INFO& info)
+{
+	return info.mipCount == 1 && IsSupported(info.format) && info.dimension != DirectX::DDS_DIMENSION_TEXTURE3D &&
+		   (info.width > 1 || info.height > 1);
+}
+
+size_t MipGenerator::getMipCount(size_t width, size_t height)
+{
+	size_t count = 1;
+
+	while (width > 1 || height > 1)
+	{
+		width = std::max<size_t>(width / 2, 1);
+		height = std::max<size_t>(height / 2, 1);
+		++count;
+	}
+
+	return count;
+}
+
+bool MipGenerator::GenerateChain(DXGI_FORMAT format, size_t width, size_t height, uint8_t* const* levels, size_t levelCount,
+								 const MipOptions& options)
+{
+	if (!IsSupported(format) || width == 0 || height == 0 || levelCount > getMipCount(width, height))
+		return false;
+
+	bool srgb = options.srgb || IsSRGB(format);
+	unsigned int threadCount = options.threadCount ? options.threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (size_t level = 1; level < levelCount; ++level)
+	{
+		size_t sourceWidth = std::max<size_t>(width >> (level - 1), 1);
+		size_t sourceHeight = std::max<size_t>(height >> (level - 1), 1);
+		size_t mipWidth = std::max<size_t>(width >> level, 1);
+		size_t mipHeight = std::max<size_t>(height >> level, 1);
+
+		Taps horizontal = MakeTaps(sourceWidth, mipWidth, options.filter);
+		Taps vertical = MakeTaps(sourceHeight, mipHeight, options.filter);
+
+		unsigned int count = (unsigned int)std::min<size_t>(std::min<size_t>(threadCount, mipHeight), mipWidth * mipHeight / MinTexelsPerThread + 1);
+
+		//Each thread takes a band of rows of the mip, which no other thread writes
+		RunParallel(count, [&](unsigned int i) {
+			FilterBand(levels[level - 1], sourceWidth, levels[level], mipWidth, horizontal, vertical, srgb,
+					   mipHeight * i / count, mipHeight * (i + 1) / count);
+		});
+	}
+
+	return true;
+}
+
+bool MipGenerator::GenerateDDS(const uint8_t* ddsData, size_t ddsDataSize, std::vector<uint8_t>& outFile, const MipOptions& options)
+{
+	DirectX::DDS_TEXTURE_INFO info;
+
+	if (!DirectX::GetDDSTextureInfo(ddsData, ddsDataSize, info) || !NeedsMips(info))
+		return false;
+
+	std::vector<DirectX::DDS_SUBRESOURCE> subresources(info.arraySize);
+	size_t width, height, depth, skipMip;
+
+	if (DirectX::FillSubresources(info.width, info.height, info.depth, 1, info.arraySize, info.format, 0, ddsDataSize - info.dataOffset,
+								  ddsData + info.dataOffset, width, height, depth, skipMip, subresources.data()) != info.arraySize)
+		return false;
+
+	//Each array slice's mips follow each other, tightly packed, the way FillSubresources will lay them out again
+	size_t mipCount = getMipCount(info.width, info.height);
+	std::vector<size_t> offsets(mipCount);
+	size_t sliceBytes = 0;
+
+	for (size_t mip = 0; mip < mipCount; ++mip)
+	{
+		offsets[mip] = sliceBytes;
+		sliceBytes += std::max<size_t>(info.width >> mip, 1) * std::max<size_t>(info.height >> mip, 1) * 4;
+	}
+
+	outFile.assign(ddsData, ddsData + info.dataOffset);
+	outFile.resize(info.dataOffset + sliceBytes * info.arraySize);
+
+	DirectX::DDS_HEADER header;
+	memcpy(&header, &outFile[sizeof(uint32_t)], sizeof(header));
+	header.flags |= HeaderFlagsMipMapCount;
+	header.mipMapCount = (uint32_t)mipCount;
+	header.caps |= CapsComplex | CapsMipMap;
+	memcpy(&outFile[sizeof(uint32_t)], &header, sizeof(header));
+
+	std::vector<uint8_t*> levels(mipCount);
+	size_t rowBytes = info.width * 4;
+
+	for (size_t slice = 0; slice < info.arraySize; ++slice)
+	{
+		uint8_t* chain = &outFile[info.dataOffset + slice * sliceBytes];
+
+		for (size_t mip = 0; mip < mipCount; ++mip)
+			levels[mip] = chain + offsets[mip];
+
+		for (size_t y = 0; y < info.height; ++y)
+			memcpy(levels[0] + y * rowBytes, subresources[slice].data + y * subresources[slice].rowPitch, rowBytes);
+
+		if (!GenerateChain(info.format, info.width, info.height, levels.data(), mipCount, options))
+			return false;
+	}
+
+	return true;
+}
+
+std::string MipGenerator::getCacheFilename(const std::string& filename, const MipOptions& options)
+{
+	return filename + (options.srgb ? ".srgb.mips.dds" : ".mips.dds");
+}
+
+uint64_t MipGenerator::SettingsHash(const MipOptions& options)
+{
+	uint32_t settings[2] = { Version, options.srgb ? 1u : 0u };
+
+	return MeshCache::Hash64(settings, sizeof(settings));
+}
+
+bool MipGenerator::SaveCache(const char* sourceFilename, std::vector<uint8_t>& ddsFile, const MipOptions& options)
+{
+	MeshSourceInfo source;
+
+	if (ddsFile.size() < sizeof(uint32_t) + sizeof(DirectX::DDS_HEADER) || !MeshCache::GetSourceInfo(sourceFilename, source, true))
+		return false;
+
+	CacheStamp stamp = { SettingsHash(options), source.size, source.modifiedTime, source.hash };
+
+	DirectX::DDS_HEADER header;
+	memcpy(&header, &ddsFile[sizeof(uint32_t)], sizeof(header));
+	header.reserved1[0] = CacheMagic;
+	header.reserved1[1] = Version;
+	memcpy(&header.reserved1[2], &stamp, sizeof(stamp));
+	header.reserved1[10] = (uint32_t)options.filter;
+	memcpy(&ddsFile[sizeof(uint32_t)], &header, sizeof(header));
+
+	std::string filename = getCacheFilename(sourceFilename, options);
+	std::string temporaryFilename = MeshCache::getTemporaryFilename(filename.c_str());
+	std::ofstream file(temporaryFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if (!file.is_open())
+		return false;
+
+	file.write((const char*)ddsFile.data(), (std::streamsize)ddsFile.size());
+	file.close();
+
+	if (file.fail())
+	{
+		remove(temporaryFilename.c_str());
+		return false;
+	}
+
+	return MeshCache::RenameOver(temporaryFilename.c_str(), filename.c_str());
+}
+
+bool MipGenerator::IsCacheOf(const uint8_t* data, size_t size, const char* sourceFilename, const MipOptions& options)
+{
+	uint32_t magic;
+	DirectX::DDS_HEADER header;
+	CacheStamp stamp;
+
+	if (!data || size < sizeof(uint32_t) + sizeof(header))
+		return false;
+
+	memcpy(&magic, data, sizeof(magic));
+	memcpy(&header, data + sizeof(uint32_t), sizeof(header));
+	memcpy(&stamp, &header.reserved1[2], sizeof(stamp));
+
+	if (magic != DirectX::DDS_MAGIC || header.reserved1[0] != CacheMagic || header.reserved1[1] != Version ||
+		stamp.settingsHash != SettingsHash(options))
+		return false;
+
+	//Caches in a pack are trusted to match whatever they were made from
+	if (!sourceFilename)
+		return true;
+
+	MeshSourceInfo recorded;
+	recorded.size = stamp.sourceSize;
+	recorded.modifiedTime = stamp.sourceModifiedTime;
+	recorded.hash = stamp.sourceHash;
+
+	return MeshCache::CheckSource(sourceFilename, recorded) == MeshCacheValid;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "DDSFormat.h"
+
+enum MipFilter
+{
+	MipFilterBox,				//Averages the texels each one covers, quickest and softest
+	MipFilterKaiser				//Windowed sinc over 3 texels of the smaller mip either side, keeps more detail without aliasing
+};
+
+struct MipOptions
+{
+	MipFilter filter = MipFilterKaiser;
+	bool srgb = false;			//Treat UNORM colours as sRGB, for a texture loaded with forceSRGB. _SRGB formats always are
+	unsigned int threadCount = 0;	//0 for one a core
+};
+
+//Makes the mips of an uncompressed texture on the CPU, for a DDS file saved with only its top mip. DDSTextureLoader can
+//only make them with a device context, on the GPU, which the loader's workers and the cooker don't have, so without
+//this a texture like that would be drawn without mips at all.
+//
+//Each mip is filtered from the one above it, a row of texels then a column of rows, in linear light: sRGB colours are
+//decoded before they're filtered and encoded again afterwards, so a mip of a texture isn't darker than the texture
+//itself. Alpha is always linear. Texels past the edges are clamped to the edge, and mips of odd sizes are filtered
+//from all of the texels above them rather than dropping the last row or column. Rows are converted and filtered with
+//SSE2 (and AVX if the compiler targets it) where it's available, and each mip is shared out between threads in bands
+//of rows, which doesn't change the result.
+//
+//The finished chain can be saved as a DDS file next to the source (getCacheFilename), stamped with what it was made
+//from and how, so the loader can map it rather than make the mips again.
+namespace MipGenerator
+{
+	const uint32_t CacheMagic = 0x4750494d;		//"MIPG", in reserved1[0] of the cache's header
+	const uint32_t Version = 2;
+
+	//8-bit RGBA and BGRA, UNORM or sRGB
+	bool IsSupported(DXGI_FORMAT format);
+
+	//Whether a texture has only its top mip and this can make the rest: supported, not a volume, and bigger than 1 x 1
+	bool NeedsMips(const DirectX::DDS_TEXTURE_INFO& info);
+
+	//Of a full chain, down to 1 x 1
+	size_t getMipCount(size_t width, size_t height);
+
+	//Fills levels[1] to levels[levelCount - 1] from levels[0], each tightly packed at 4 bytes a texel and half the size
+	//of the one before (rounded down, at least 1)
+	bool GenerateChain(DXGI_FORMAT format, size_t width, size_t height, uint8_t* const* levels, size_t levelCount,
+					   const MipOptions& options = MipOptions());
+
+	//Makes a copy of the DDS file in ddsData with every array slice's full chain of mips. Returns false if it isn't a
+	//DDS file or doesn't NeedsMips
+	bool GenerateDDS(const uint8_t* ddsData, size_t ddsDataSize, std::vector<uint8_t>& outFile, const MipOptions& options = MipOptions());
+
+	//Where the mips made for filename are cached, a file for linear and another for sRGB so a texture loaded both ways
+	//doesn't keep replacing one with the other
+	std::string getCacheFilename(const std::string& filename, const MipOptions& options);
+
+	//Of the options a cache has to have been made with to be used: only srgb, since which filter made it is a choice
+	//of quality, made when it was cooked, that the mips are good with either way
+	uint64_t SettingsHash(const MipOptions& options);
+
+	//Stamps the file GenerateDDS made with the source it was made from and the settings, then writes it to
+	//getCacheFilename(sourceFilename, options) by way of a temporary file, the same way MeshCache::Save does
+	bool SaveCache(const char* sourceFilename, std::vector<uint8_t>& ddsFile, const MipOptions& options);
+
+	//Whether data is a cache made with options from sourceFilename as it is now. A null sourceFilename skips checking
+	//the source, for a cache in a pack
+	bool IsCacheOf(const uint8_t* data, size_t size, const char* sourceFilename, const MipOptions& options);
+};
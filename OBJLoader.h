@@ -4,8 +4,9 @@
 #include <directxmath.h>
 #include <fstream>		//For loading in an external file
 #include <vector>		//For storing the XMFLOAT3/2 variables
-#include <map>			//For fast searching when re-creating the index buffer
+#include <memory>
 #include "Structures.h"
+#include "MeshCooker.h"
 
 using namespace DirectX;
 
@@ -16,17 +17,48 @@ struct MeshData
 	UINT VBStride;
 	UINT VBOffset;
 	UINT IndexCount;
+	DXGI_FORMAT IndexFormat;		//DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT
+	std::vector<MeshLOD> LODs;		//Full detail first, then simpler and simpler versions. Always has at least one entry
+
+	//Set if the vertex buffer holds CompactVertex rather than SimpleVertex. The shader gets positions back with Pos * PosScale + PosOffset
+	bool CompactVertices;
+	XMFLOAT3 PosScale;
+	XMFLOAT3 PosOffset;
+
+	//Clusters of LOD 0 for culling on the CPU, empty unless OBJLoadOptions::buildMeshlets was set. MeshletIndices is a copy of
+	//LOD 0's indices (in IndexFormat) that the visible meshlets are copied out of into CulledIndexBuffer each frame
+	std::vector<Meshlet> Meshlets;
+	std::vector<unsigned char> MeshletIndices;
+	ID3D11Buffer * CulledIndexBuffer;
+
+	//In model space, see BoundingVolumes::Transform for world space
+	MeshBounds Bounds;
+};
+
+//What OBJLoader::Prepare leaves for OBJLoader::Create: a cooked mesh, mapped from its cache or a mounted pack, or
+//cooked just now if there wasn't a valid cache
+struct PreparedMesh
+{
+	std::unique_ptr<MappedFile> cacheFile;		//Open while view points into it
+	CookedMesh cooked;							//Only filled in if the mesh had to be cooked, view points into it then
+	CookedMeshView view;
+	size_t mappedBytes;
+	bool fromCache;
+	bool fromPack;
 };
 
 namespace OBJLoader
 {
-	//The only method you'll need to call
-	MeshData Load(char* filename, ID3D11Device* _pd3dDevice, bool invertTexCoords = true);
+	//The most vertices a mesh can have and still be drawn with 16-bit indices
+	const unsigned int MaxShortIndexVertices = MeshCooker::MaxShortIndexVertices;
 
-	//Helper methods for the above method
-	//Searhes to see if a similar vertex already exists in the buffer -- if true, we re-use that index
-	bool FindSimilarVertex(const SimpleVertex& vertex, std::map<SimpleVertex, unsigned short>& vertToIndexMap, unsigned short& index);
+	//The only method you'll need to call. Cooks the mesh with MeshCooker the first time, and after that maps the cache it left
+	MeshData Load(char* filename, ID3D11Device* _pd3dDevice, bool invertTexCoords = true, const OBJLoadOptions& options = OBJLoadOptions());
 
-	//Re-creates a single index buffer from the 3 given in the OBJ file
-	void CreateIndices(const std::vector<XMFLOAT3>& inVertices, const std::vector<XMFLOAT2>& inTexCoords, const std::vector<XMFLOAT3>& inNormals, std::vector<unsigned short>& outIndices, std::vector<XMFLOAT3>& outVertices, std::vector<XMFLOAT2>& outTexCoords, std::vector<XMFLOAT3>& outNormals);
-};
\ No newline at end of file
+	//Load in two halves, for loading on another thread (see AssetLoader). Prepare does everything that doesn't need the
+	//device and can be called from any thread, Create makes the buffers. Reloading a mesh whose source has changed passes
+	//usePacks as false, since a pack never sees the change. Create gives back an empty MeshData, with no buffers to release,
+	//if any of them can't be created
+	bool Prepare(const char* filename, bool invertTexCoords, const OBJLoadOptions& options, PreparedMesh& outMesh, bool usePacks = true);
+	MeshData Create(ID3D11Device* _pd3dDevice, const PreparedMesh& mesh);
+};
@@ -0,0 +1,541 @@
+#include "OBJParser.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <fstream>		//For the original ifstream parser
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+namespace
+{
+	inline bool IsBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline bool IsDigit(char c)
+	{
+		return (unsigned char)(c - '0') < 10;
+	}
+
+	inline const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && IsBlank(*p))
+			++p;
+
+		return p;
+	}
+
+	inline const char* SkipToken(const char* p, const char* end)
+	{
+		while (p < end && !IsBlank(*p))
+			++p;
+
+		return p;
+	}
+
+	//Powers of ten that are exactly representable as a float
+	const float PowersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+	//Slow path for anything the fast path can't round exactly, copies the token so strtof sees a terminated string
+	const char* ParseFloatSlow(const char* p, const char* end, float& value)
+	{
+		char buffer[64];
+		const char* tokenEnd = SkipToken(p, end);
+		size_t length = tokenEnd - p;
+
+		if (length >= sizeof(buffer))
+		{
+			std::string token(p, length);
+			value = strtof(token.c_str(), nullptr);
+		}
+		else
+		{
+			memcpy(buffer, p, length);
+			buffer[length] = '\0';
+			value = strtof(buffer, nullptr);
+		}
+
+		return tokenEnd;
+	}
+
+	//Parses a float in place. Numbers with up to 7 significant digits and a small exponent (i.e. everything
+	//modelling packages write out) are converted with a single correctly rounded multiply or divide, so
+	//the result is bit-identical to what strtof/operator>> give. Anything else falls back to strtof.
+	const char* ParseFloat(const char* p, const char* end, float& value)
+	{
+		const char* start = p;
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		uint64_t mantissa = 0;
+		int exponent = 0;
+		int digits = 0;
+
+		while (p < end && IsDigit(*p))
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+			++p;
+		}
+
+		if (p < end && *p == '.')
+		{
+			++p;
+
+			while (p < end && IsDigit(*p))
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+				--exponent;
+				++p;
+			}
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+			return ParseFloatSlow(start, end, value);
+
+		if (digits > 7 || exponent < -10 || p == start || (p < end && !IsBlank(*p)))
+			return ParseFloatSlow(start, end, value);
+
+		float result = exponent < 0 ? (float)mantissa / PowersOfTen[-exponent] : (float)mantissa;
+		value = negative ? -result : result;
+
+		return p;
+	}
+
+	//Parses a (possibly negative) OBJ index, leaves index at 0 if there isn't one
+	inline const char* ParseIndex(const char* p, const char* end, int& index)
+	{
+		bool negative = p < end && *p == '-';
+		if (negative)
+			++p;
+
+		int result = 0;
+		while (p < end && IsDigit(*p))
+		{
+			result = result * 10 + (*p - '0');
+			++p;
+		}
+
+		index = negative ? -result : result;
+
+		return p;
+	}
+
+	//OBJ indices start from 1, negative ones count back from the most recently read element
+	inline unsigned int ResolveIndex(int index, size_t count)
+	{
+		if (index > 0)
+			return (unsigned int)(index - 1);
+
+		if (index < 0)
+			return (unsigned int)(count + index);
+
+		return (unsigned int)-1;
+	}
+
+	struct FaceCorner
+	{
+		unsigned int v;
+		unsigned int t;
+		unsigned int n;
+		bool relativeV; //true if the index was negative, i.e. relative to the end of the list rather than the start
+		bool relativeT;
+		bool relativeN;
+	};
+
+	//Positions in each index list of the indices that were negative. When a chunk is parsed on its own these only
+	//resolve against the elements in that chunk, so the parallel parser adds the counts from the previous chunks to them when merging
+	struct RelativeIndices
+	{
+		std::vector<size_t> vertPositions;
+		std::vector<size_t> texCoordPositions;
+		std::vector<size_t> normalPositions;
+	};
+
+	//Parses a single "v/t/n", "v//n", "v/t" or "v" face corner
+	inline const char* ParseCorner(const char* p, const char* end, const OBJData& data, FaceCorner& corner)
+	{
+		int v = 0;
+		int t = 0;
+		int n = 0;
+
+		p = ParseIndex(p, end, v);
+
+		if (p < end && *p == '/')
+		{
+			p = ParseIndex(p + 1, end, t);
+
+			if (p < end && *p == '/')
+				p = ParseIndex(p + 1, end, n);
+		}
+
+		corner.relativeV = v < 0;
+		corner.relativeT = t < 0;
+		corner.relativeN = n < 0;
+		corner.v = ResolveIndex(v, data.verts.size());
+		corner.t = ResolveIndex(t, data.texCoords.size());
+		corner.n = ResolveIndex(n, data.normals.size());
+
+		return SkipToken(p, end);
+	}
+
+	inline void PushCorner(const FaceCorner& corner, OBJData& data, RelativeIndices* relative, OBJCornerSink* sink)
+	{
+		if (sink)
+		{
+			sink->AddCorner(data, corner.v, corner.t, corner.n);
+			return;
+		}
+
+		if (relative)
+		{
+			size_t position = data.vertIndices.size();
+
+			if (corner.relativeV) relative->vertPositions.push_back(position);
+			if (corner.relativeT) relative->texCoordPositions.push_back(position);
+			if (corner.relativeN) relative->normalPositions.push_back(position);
+		}
+
+		data.vertIndices.push_back(corner.v);
+		data.textureIndices.push_back(corner.t);
+		data.normalIndices.push_back(corner.n);
+	}
+
+	//Parses every line between begin and end, appending to data. Face corners go to sink instead if there is one
+	void ParseLines(const char* begin, const char* end, OBJData& data, bool invertTexCoords, RelativeIndices* relative, OBJCornerSink* sink = nullptr)
+	{
+		const char* p = begin;
+
+		while (p < end)
+		{
+			const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+			if (!lineEnd)
+				lineEnd = end;
+
+			p = SkipBlanks(p, lineEnd);
+
+			//Only lines starting with "v ", "vt ", "vn " or "f " are of interest, everything else (comments,
+			//groups, materials, smoothing groups...) is skipped without looking any further than the keyword
+			if (lineEnd - p >= 2)
+			{
+				if (p[0] == 'v' && IsBlank(p[1])) //Vertex position
+				{
+					XMFLOAT3 vert;
+					p = ParseFloat(SkipBlanks(p + 1, lineEnd), lineEnd, vert.x);
+					p = ParseFloat(SkipBlanks(p, lineEnd), lineEnd, vert.y);
+					p = ParseFloat(SkipBlanks(p, lineEnd), lineEnd, vert.z);
+
+					data.verts.push_back(vert);
+				}
+				else if (p[0] == 'v' && p[1] == 't' && lineEnd - p >= 3 && IsBlank(p[2])) //Texture coordinate
+				{
+					XMFLOAT2 texCoord;
+					p = ParseFloat(SkipBlanks(p + 2, lineEnd), lineEnd, texCoord.x);
+					p = ParseFloat(SkipBlanks(p, lineEnd), lineEnd, texCoord.y);
+
+					if (invertTexCoords) texCoord.y = 1.0f - texCoord.y;
+
+					data.texCoords.push_back(texCoord);
+				}
+				else if (p[0] == 'v' && p[1] == 'n' && lineEnd - p >= 3 && IsBlank(p[2])) //Normal
+				{
+					XMFLOAT3 normal;
+					p = ParseFloat(SkipBlanks(p + 2, lineEnd), lineEnd, normal.x);
+					p = ParseFloat(SkipBlanks(p, lineEnd), lineEnd, normal.y);
+					p = ParseFloat(SkipBlanks(p, lineEnd), lineEnd, normal.z);
+
+					data.normals.push_back(normal);
+				}
+				else if (p[0] == 'f' && IsBlank(p[1])) //Face
+				{
+					//Polygons with more than 3 corners are split into a triangle fan around the first corner
+					FaceCorner first;
+					FaceCorner previous;
+					FaceCorner corner;
+					int numCorners = 0;
+
+					p = SkipBlanks(p + 1, lineEnd);
+
+					while (p < lineEnd)
+					{
+						p = SkipBlanks(ParseCorner(p, lineEnd, data, corner), lineEnd);
+
+						if (numCorners >= 2)
+						{
+							PushCorner(first, data, relative, sink);
+							PushCorner(previous, data, relative, sink);
+							PushCorner(corner, data, relative, sink);
+						}
+						else if (numCorners == 0)
+						{
+							first = corner;
+						}
+
+						previous = corner;
+						++numCorners;
+					}
+				}
+			}
+
+			p = lineEnd + 1;
+		}
+	}
+
+	//Chunks smaller than this aren't worth handing to another thread
+	const size_t MinChunkSize = 1 << 20;
+
+	template<typename T>
+	void CopyChunk(const std::vector<T>& source, std::vector<T>& destination, size_t offset)
+	{
+		std::copy(source.begin(), source.end(), destination.begin() + offset);
+	}
+
+	void OffsetIndices(const std::vector<size_t>& positions, std::vector<unsigned int>& indices, size_t offset)
+	{
+		for (size_t position : positions)
+			indices[position] += (unsigned int)offset;
+	}
+}
+
+bool OBJParser::ParseStream(const char* filename, OBJData& data, bool invertTexCoords)
+{
+	std::ifstream inFile;
+	inFile.open(filename);
+
+	if(!inFile.good())
+	{
+		return false;
+	}
+
+	std::string input;
+
+	XMFLOAT3 vert;
+	XMFLOAT2 texCoord;
+	XMFLOAT3 normal;
+	unsigned int vInd[3]; //indices for the vertex position
+	unsigned int tInd[3]; //indices for the texture coordinate
+	unsigned int nInd[3]; //indices for the normal
+	std::string beforeFirstSlash;
+	std::string afterFirstSlash;
+	std::string afterSecondSlash;
+
+	while(!inFile.eof()) //While we have yet to reach the end of the file...
+	{
+		inFile >> input; //Get the next input from the file
+
+		//Check what type of input it was, we are only interested in vertex positions, texture coordinates, normals and indices, nothing else
+		if(input.compare("v") == 0) //Vertex position
+		{
+			inFile >> vert.x;
+			inFile >> vert.y;
+			inFile >> vert.z;
+
+			data.verts.push_back(vert);
+		}
+		else if(input.compare("vt") == 0) //Texture coordinate
+		{
+			inFile >> texCoord.x;
+			inFile >> texCoord.y;
+
+			if(invertTexCoords) texCoord.y = 1.0f - texCoord.y;
+
+			data.texCoords.push_back(texCoord);
+		}
+		else if(input.compare("vn") == 0) //Normal
+		{
+			inFile >> normal.x;
+			inFile >> normal.y;
+			inFile >> normal.z;
+
+			data.normals.push_back(normal);
+		}
+		else if(input.compare("f") == 0) //Face
+		{
+			//Read up to the end of the line, so polygons with more than 3 corners are split into a triangle fan around the
+			//first corner the same way ParseLines does. [0] is the first corner, [1] the previous one and [2] the latest
+			int numCorners = 0;
+
+			while(true)
+			{
+				while(inFile.peek() == ' ' || inFile.peek() == '\t' || inFile.peek() == '\r')
+					inFile.get();
+
+				if(inFile.peek() == '\n' || inFile.peek() == std::ifstream::traits_type::eof())
+					break;
+
+				inFile >> input;
+				size_t slash = input.find("/"); //Find first forward slash
+				size_t secondSlash = slash == std::string::npos ? slash : input.find("/", slash + 1); //Find second forward slash
+
+				//Extract from string. "v", "v/t" and "v//n" leave out the indices they don't have
+				beforeFirstSlash = input.substr(0, slash); //The vertex position index
+				afterFirstSlash = slash == std::string::npos ? std::string() : input.substr(slash + 1, secondSlash - slash - 1); //The texture coordinate index
+				afterSecondSlash = secondSlash == std::string::npos ? std::string() : input.substr(secondSlash + 1); //The normal index
+
+				//Parse into int (atoi = "ASCII to int"). OBJ indexes start from 1 whereas C++ arrays start from 0, negative ones
+				//count back from the end, and ones left out come out as -1, all exactly as ParseCorner resolves them
+				int i = std::min(numCorners, 2);
+				vInd[i] = ResolveIndex(atoi(beforeFirstSlash.c_str()), data.verts.size());
+				tInd[i] = ResolveIndex(atoi(afterFirstSlash.c_str()), data.texCoords.size());
+				nInd[i] = ResolveIndex(atoi(afterSecondSlash.c_str()), data.normals.size());
+
+				//Place into vectors
+				if(numCorners >= 2)
+				{
+					for(int j = 0; j < 3; ++j)
+					{
+						data.vertIndices.push_back(vInd[j]);
+						data.textureIndices.push_back(tInd[j]);
+						data.normalIndices.push_back(nInd[j]);
+					}
+
+					vInd[1] = vInd[2];
+					tInd[1] = tInd[2];
+					nInd[1] = nInd[2];
+				}
+
+				++numCorners;
+			}
+		}
+	}
+	inFile.close(); //Finished with input file now, all the data we need has now been loaded in
+
+	return true;
+}
+
+bool OBJParser::ParseMapped(const char* filename, OBJData& data, bool invertTexCoords)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	const char* begin = (const char*)file.getData();
+	ParseBuffer(begin, begin + file.getSize(), data, invertTexCoords);
+
+	return true;
+}
+
+void OBJParser::ParseBuffer(const char* begin, const char* end, OBJData& data, bool invertTexCoords)
+{
+	ParseLines(begin, end, data, invertTexCoords, nullptr);
+}
+
+bool OBJParser::ParseMappedStreaming(const char* filename, OBJData& data, bool invertTexCoords, OBJCornerSink& sink)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	const char* begin = (const char*)file.getData();
+	ParseLines(begin, begin + file.getSize(), data, invertTexCoords, nullptr, &sink);
+
+	return true;
+}
+
+bool OBJParser::ParseMappedParallel(const char* filename, OBJData& data, bool invertTexCoords, unsigned int numThreads)
+{
+	MappedFile file;
+
+	if (!file.Open(filename))
+	{
+		return false;
+	}
+
+	const char* begin = (const char*)file.getData();
+	ParseBufferParallel(begin, begin + file.getSize(), data, invertTexCoords, numThreads);
+
+	return true;
+}
+
+void OBJParser::ParseBufferParallel(const char* begin, const char* end, OBJData& data, bool invertTexCoords, unsigned int numThreads)
+{
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	size_t size = end - begin;
+	unsigned int numChunks = (unsigned int)std::min<size_t>(numThreads, size / MinChunkSize + 1);
+
+	if (numChunks <= 1)
+	{
+		ParseLines(begin, end, data, invertTexCoords, nullptr);
+		return;
+	}
+
+	//Split the file into chunks of roughly equal size, moving each split point forward to the start of the next line
+	std::vector<const char*> bounds(numChunks + 1);
+	bounds[0] = begin;
+	bounds[numChunks] = end;
+
+	for (unsigned int i = 1; i < numChunks; ++i)
+	{
+		const char* split = std::max(begin + size / numChunks * i, bounds[i - 1]);
+		const char* newline = (const char*)memchr(split, '\n', end - split);
+
+		bounds[i] = newline ? newline + 1 : end;
+	}
+
+	//Parse every chunk on its own thread. Positive indices are already absolute, negative ones are
+	//resolved against the chunk and recorded so they can be fixed up once we know how much came before
+	std::vector<OBJData> chunks(numChunks);
+	std::vector<RelativeIndices> relative(numChunks);
+
+	RunParallel(numChunks, [&](unsigned int i)
+	{
+		ParseLines(bounds[i], bounds[i + 1], chunks[i], invertTexCoords, &relative[i]);
+	});
+
+	//Prefix sum the counts from each chunk to find where its data goes in the final lists
+	std::vector<size_t> vertStart(numChunks + 1, data.verts.size());
+	std::vector<size_t> texCoordStart(numChunks + 1, data.texCoords.size());
+	std::vector<size_t> normalStart(numChunks + 1, data.normals.size());
+	std::vector<size_t> indexStart(numChunks + 1, data.vertIndices.size());
+
+	for (unsigned int i = 0; i < numChunks; ++i)
+	{
+		vertStart[i + 1] = vertStart[i] + chunks[i].verts.size();
+		texCoordStart[i + 1] = texCoordStart[i] + chunks[i].texCoords.size();
+		normalStart[i + 1] = normalStart[i] + chunks[i].normals.size();
+		indexStart[i + 1] = indexStart[i] + chunks[i].vertIndices.size();
+	}
+
+	data.verts.resize(vertStart[numChunks]);
+	data.texCoords.resize(texCoordStart[numChunks]);
+	data.normals.resize(normalStart[numChunks]);
+	data.vertIndices.resize(indexStart[numChunks]);
+	data.textureIndices.resize(indexStart[numChunks]);
+	data.normalIndices.resize(indexStart[numChunks]);
+
+	//Merge, again one thread per chunk since the destinations don't overlap
+	RunParallel(numChunks, [&](unsigned int i)
+	{
+		OBJData& chunk = chunks[i];
+
+		OffsetIndices(relative[i].vertPositions, chunk.vertIndices, vertStart[i]);
+		OffsetIndices(relative[i].texCoordPositions, chunk.textureIndices, texCoordStart[i]);
+		OffsetIndices(relative[i].normalPositions, chunk.normalIndices, normalStart[i]);
+
+		CopyChunk(chunk.verts, data.verts, vertStart[i]);
+		CopyChunk(chunk.texCoords, data.texCoords, texCoordStart[i]);
+		CopyChunk(chunk.normals, data.normals, normalStart[i]);
+		CopyChunk(chunk.vertIndices, data.vertIndices, indexStart[i]);
+		CopyChunk(chunk.textureIndices, data.textureIndices, indexStart[i]);
+		CopyChunk(chunk.normalIndices, data.normalIndices, indexStart[i]);
+
+		chunk = OBJData();
+	});
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <directxmath.h>
+#include <vector>		//For storing the XMFLOAT3/2 variables
+
+using namespace DirectX;
+
+//Everything an OBJ file gives us before any processing: the three attribute lists and the
+//three index lists that the faces use to reference them. Indices are already converted to start from 0.
+struct OBJData
+{
+	std::vector<XMFLOAT3> verts;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> texCoords;
+
+	std::vector<unsigned int> vertIndices;
+	std::vector<unsigned int> textureIndices;
+	std::vector<unsigned int> normalIndices;
+};
+
+//Receives face corners as they're parsed, instead of them being stored in OBJData's index lists.
+//Corners arrive three at a time, one triangle after another, with their indices already resolved against data
+class OBJCornerSink
+{
+public:
+	virtual ~OBJCornerSink() {}
+
+	virtual void AddCorner(const OBJData& data, unsigned int v, unsigned int t, unsigned int n) = 0;
+};
+
+//Parsing of .obj files into OBJData
+namespace OBJParser
+{
+	//The original parser, reads the file through an ifstream one token at a time.
+	//Much slower than ParseMapped, it's kept around so the two can be compared against each other (Tools/OBJParserBenchmark)
+	bool ParseStream(const char* filename, OBJData& data, bool invertTexCoords);
+
+	//Memory maps the file and tokenizes it in place, nothing is allocated per token
+	bool ParseMapped(const char* filename, OBJData& data, bool invertTexCoords);
+
+	//Tokenizes an OBJ file that is already in memory, appending to data
+	void ParseBuffer(const char* begin, const char* end, OBJData& data, bool invertTexCoords);
+
+	//Same as ParseMapped, but splits the file at line boundaries and parses the chunks on numThreads threads
+	//(0 = one per core). The result is exactly the same as the single threaded version
+	bool ParseMappedParallel(const char* filename, OBJData& data, bool invertTexCoords, unsigned int numThreads = 0);
+
+	void ParseBufferParallel(const char* begin, const char* end, OBJData& data, bool invertTexCoords, unsigned int numThreads = 0);
+
+	//Same as ParseMapped, but every face corner goes straight to sink and only the attribute lists of data are filled in,
+	//so the index lists never exist. Single threaded, since the corners have to arrive in file order
+	bool ParseMappedStreaming(const char* filename, OBJData& data, bool invertTexCoords, OBJCornerSink& sink);
+};
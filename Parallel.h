@@ -0,0 +1,20 @@
+#pragma once
+#include <thread>
+#include <vector>
+
+//Runs task(0) ... task(count - 1) with one thread each, the calling thread takes task 0. The callers decide how many
+//tasks are worth it, so count should already be no more than the work can be split into
+template<typename Task>
+void RunParallel(unsigned int count, const Task& task)
+{
+	std::vector<std::thread> threads;
+	threads.reserve(count);
+
+	for (unsigned int i = 1; i < count; ++i)
+		threads.push_back(std::thread(task, i));
+
+	task(0);
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
@@ -1,8 +1,8 @@
 #pragma once
 
-#include <windows.h>
-#include <d3d11_1.h>
 #include <directxmath.h>
+#include <stdint.h>
+#include <vector>
 
 using namespace DirectX;
 
@@ -11,9 +11,27 @@ struct SimpleVertex
 	XMFLOAT3 Pos;
 	XMFLOAT3 Normal;
 	XMFLOAT2 TexC;
+};
 
-	bool operator<(const SimpleVertex other) const 
-	{
-		return memcmp((void*)this, (void*)&other, sizeof(SimpleVertex)) > 0;
-	};
-};
\ No newline at end of file
+//Compact version of SimpleVertex, 16 bytes instead of 32. See VertexQuantizer
+struct CompactVertex
+{
+	uint16_t Pos[4];	//Position normalized to the mesh's bounding box, w is always 1 (DXGI_FORMAT_R16G16B16A16_UNORM)
+	int16_t Normal[2];	//Octahedral encoded normal (DXGI_FORMAT_R16G16_SNORM)
+	uint16_t TexC[2];	//Half precision texture coordinates (DXGI_FORMAT_R16G16_FLOAT)
+};
+
+//A part of the index buffer that is drawn with a single DrawIndexed call
+struct MeshDrawRange
+{
+	unsigned int IndexStart;
+	unsigned int IndexCount;
+	int BaseVertex;
+};
+
+//One level of detail of a mesh, all levels share the mesh's vertex and index buffers
+struct MeshLOD
+{
+	std::vector<MeshDrawRange> DrawRanges;
+	float Error;					//How far the surface is from the full detail mesh, in model space units. 0 for LOD 0
+};
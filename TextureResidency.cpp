@@ -0,0 +1,356 @@
+#include "TextureResidency.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace
+{
+	size_t MipSize(size_t size, unsigned int mip)
+	{
+		return std::max<size_t>(1, size >> mip);
+	}
+
+	//Mips are skipped while any side is bigger than maxsize, and the last is always kept
+	unsigned int SkipFor(size_t size, size_t mipCount, size_t maxsize)
+	{
+		unsigned int mip = 0;
+
+		while (maxsize != 0 && mip + 1 < mipCount && MipSize(size, mip) > maxsize)
+			++mip;
+
+		return mip;
+	}
+
+	//Bytes of each mip, with every array slice and depth slice, the way FillSubresources lays them out
+	void MipChainBytes(const DirectX::DDS_TEXTURE_INFO& info, std::vector<size_t>& bytes)
+	{
+		size_t mipCount = std::max<size_t>(1, info.mipCount);
+		bytes.assign(mipCount, 0);
+
+		size_t w = info.width;
+		size_t h = info.height;
+		size_t d = info.depth;
+
+		for (size_t i = 0; i < mipCount; ++i)
+		{
+			size_t numBytes = 0;
+			DirectX::GetSurfaceInfo(w, h, info.format, &numBytes, nullptr, nullptr);
+
+			bytes[i] = numBytes * d * info.arraySize;
+
+			w = std::max<size_t>(1, w >> 1);
+			h = std::max<size_t>(1, h >> 1);
+			d = std::max<size_t>(1, d >> 1);
+		}
+
+		//Summed from the bottom up, so bytes[i] is everything kept when i mips are skipped
+		for (size_t i = mipCount - 1; i > 0; --i)
+			bytes[i - 1] += bytes[i];
+	}
+}
+
+TextureResidency::TextureResidency(size_t budgetBytes, size_t minSize)
+{
+	_budget = budgetBytes;
+	_minSize = std::max<size_t>(1, minSize);
+	_frame = 0;
+	_stats = TextureResidencyStats();
+}
+
+void TextureResidency::SetBudget(size_t budgetBytes)
+{
+	_budget = budgetBytes;
+}
+
+TextureResidency::Texture* TextureResidency::getTexture(unsigned int id)
+{
+	return id != 0 && id <= _textures.size() && _textures[id - 1].live ? &_textures[id - 1] : nullptr;
+}
+
+const TextureResidency::Texture* TextureResidency::getTexture(unsigned int id) const
+{
+	return id != 0 && id <= _textures.size() && _textures[id - 1].live ? &_textures[id - 1] : nullptr;
+}
+
+unsigned int TextureResidency::Add(const DirectX::DDS_TEXTURE_INFO& info, size_t maxsize)
+{
+	unsigned int id;
+
+	if (!_free.empty())
+	{
+		id = _free.back();
+		_free.pop_back();
+	}
+	else
+	{
+		_textures.push_back(Texture());
+		id = (unsigned int)_textures.size();
+	}
+
+	Texture& texture = _textures[id - 1];
+	texture = Texture();
+	texture.live = true;
+	texture.maxsize = maxsize;
+	texture.lastUsedFrame = _frame;
+
+	Loaded(id, info, maxsize);
+	texture.wantedMip = texture.topMip;
+
+	return id;
+}
+
+void TextureResidency::Remove(unsigned int id)
+{
+	Texture* texture = getTexture(id);
+
+	if (!texture)
+		return;
+
+	*texture = Texture();
+	_free.push_back(id);
+}
+
+void TextureResidency::Loaded(unsigned int id, const DirectX::DDS_TEXTURE_INFO& info, size_t loadedMaxsize)
+{
+	Texture* texture = getTexture(id);
+
+	if (!texture)
+		return;
+
+	texture->size = std::max(info.width, std::max(info.height, info.depth));
+	MipChainBytes(info, texture->bytes);
+
+	texture->topMip = SkipFor(texture->size, texture->bytes.size(), texture->maxsize);
+	texture->lowestMip = texture->topMip;
+
+	while (texture->lowestMip + 1 < texture->bytes.size() && MipSize(texture->size, texture->lowestMip + 1) >= _minSize)
+		++texture->lowestMip;
+
+	texture->mip = std::max(texture->topMip, SkipFor(texture->size, texture->bytes.size(), loadedMaxsize));
+	texture->wantedMip = std::min(std::max(texture->wantedMip, texture->topMip), texture->lowestMip);
+}
+
+void TextureResidency::Use(unsigned int id, size_t screenSize)
+{
+	Texture* texture = getTexture(id);
+
+	if (!texture)
+		return;
+
+	//The smallest mip that still has a texel for every pixel it covers
+	unsigned int wanted = texture->topMip;
+
+	while (screenSize != 0 && wanted < texture->lowestMip && MipSize(texture->size, wanted + 1) >= screenSize)
+		++wanted;
+
+	//Drawn more than once, it needs the mips of the biggest
+	texture->wantedMip = texture->uses > 0 ? std::min(texture->wantedMip, wanted) : wanted;
+	texture->lastUsedFrame = _frame;
+	++texture->uses;
+}
+
+const TextureResidencyStats& TextureResidency::EndFrame()
+{
+	TextureResidencyStats stats = {};
+	stats.frame = _frame;
+	stats.budgetBytes = _budget;
+
+	std::vector<unsigned int> target(_textures.size());
+	std::vector<unsigned int> unused;
+
+	for (unsigned int i = 0; i < _textures.size(); ++i)
+	{
+		const Texture& texture = _textures[i];
+
+		if (!texture.live)
+			continue;
+
+		target[i] = texture.mip;
+		stats.residentBytes += texture.bytes[texture.mip];
+		++stats.textures;
+
+		if (texture.uses > 0)
+			++stats.texturesUsed;
+		else
+			unused.push_back(i);
+	}
+
+	//Each drop takes the mip off the top, the cost being what that frees
+	auto dropCost = [this, &target](unsigned int i) { return _textures[i].bytes[target[i]] - _textures[i].bytes[target[i] + 1]; };
+	auto restoreCost = [this, &target](unsigned int i) { return _textures[i].bytes[target[i] - 1] - _textures[i].bytes[target[i]]; };
+
+	typedef std::pair<size_t, unsigned int> Candidate;
+
+	//Spare mips are the ones nothing drawn this frame needs, from the textures that have gone unused longest first, each
+	//right down to its lowest mip before the next is touched, then those bigger than the textures being drawn want,
+	//the biggest first
+	std::stable_sort(unused.begin(), unused.end(), [this](unsigned int a, unsigned int b) {
+		return _textures[a].lastUsedFrame < _textures[b].lastUsedFrame;
+	});
+
+	std::priority_queue<Candidate> surplus;
+	size_t spareBytes = 0;
+	size_t nextUnused = 0;
+
+	for (unsigned int i : unused)
+		spareBytes += _textures[i].bytes[target[i]] - _textures[i].bytes[_textures[i].lowestMip];
+
+	for (unsigned int i = 0; i < _textures.size(); ++i)
+	{
+		const Texture& texture = _textures[i];
+
+		if (texture.live && texture.uses > 0 && target[i] < texture.wantedMip)
+		{
+			spareBytes += texture.bytes[target[i]] - texture.bytes[texture.wantedMip];
+			surplus.push(Candidate(dropCost(i), i));
+		}
+	}
+
+	auto dropSpare = [&](size_t limit) {
+		while (stats.residentBytes > limit && nextUnused < unused.size())
+		{
+			unsigned int i = unused[nextUnused];
+
+			if (target[i] == _textures[i].lowestMip)
+			{
+				++nextUnused;
+				continue;
+			}
+
+			spareBytes -= dropCost(i);
+			stats.residentBytes -= dropCost(i);
+			++target[i];
+		}
+
+		while (stats.residentBytes > limit && !surplus.empty())
+		{
+			unsigned int i = surplus.top().second;
+			surplus.pop();
+
+			spareBytes -= dropCost(i);
+			stats.residentBytes -= dropCost(i);
+			++target[i];
+
+			if (target[i] < _textures[i].wantedMip)
+				surplus.push(Candidate(dropCost(i), i));
+		}
+	};
+
+	if (_budget != 0 && stats.residentBytes > _budget)
+	{
+		dropSpare(_budget);
+
+		//Then the mips the textures being drawn need, the biggest first each time so they all lose detail evenly
+		std::priority_queue<Candidate> drops;
+
+		for (unsigned int i = 0; i < _textures.size(); ++i)
+		{
+			if (_textures[i].live && _textures[i].uses > 0 && target[i] < _textures[i].lowestMip)
+				drops.push(Candidate(dropCost(i), i));
+		}
+
+		while (stats.residentBytes > _budget && !drops.empty())
+		{
+			unsigned int i = drops.top().second;
+			drops.pop();
+
+			stats.residentBytes -= dropCost(i);
+			++target[i];
+
+			if (target[i] < _textures[i].lowestMip)
+				drops.push(Candidate(dropCost(i), i));
+		}
+	}
+	else
+	{
+		//The textures being drawn get back the mips they want, the cheapest first, for as long as there's room or spare
+		//mips to make room with
+		std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> restores;
+
+		for (unsigned int i = 0; i < _textures.size(); ++i)
+		{
+			if (_textures[i].live && _textures[i].uses > 0 && target[i] > _textures[i].wantedMip)
+				restores.push(Candidate(restoreCost(i), i));
+		}
+
+		//Later mips only cost more, so once the cheapest can't be made room for nothing can
+		while (!restores.empty())
+		{
+			unsigned int i = restores.top().second;
+			size_t cost = restores.top().first;
+
+			if (_budget != 0 && stats.residentBytes + cost > _budget)
+			{
+				if (stats.residentBytes + cost - spareBytes > _budget)
+					break;
+
+				dropSpare(_budget - cost);
+			}
+
+			restores.pop();
+
+			stats.residentBytes += cost;
+			--target[i];
+
+			if (target[i] > _textures[i].wantedMip)
+				restores.push(Candidate(restoreCost(i), i));
+		}
+	}
+
+	for (unsigned int i = 0; i < _textures.size(); ++i)
+	{
+		Texture& texture = _textures[i];
+
+		if (!texture.live)
+			continue;
+
+		if (target[i] > texture.mip)
+			stats.mipsDropped += target[i] - texture.mip;
+		else
+			stats.mipsRestored += texture.mip - target[i];
+
+		if (target[i] != texture.mip)
+			++stats.texturesChanged;
+
+		texture.mip = target[i];
+
+		if (texture.uses > 0)
+		{
+			stats.usedBytes += texture.bytes[texture.mip];
+			stats.wantedBytes += texture.bytes[texture.wantedMip];
+
+			if (texture.mip > texture.wantedMip)
+				++stats.texturesShort;
+		}
+
+		texture.uses = 0;
+	}
+
+	++_frame;
+	_stats = stats;
+
+	return _stats;
+}
+
+size_t TextureResidency::getMaxsize(unsigned int id) const
+{
+	const Texture* texture = getTexture(id);
+
+	//The top mip's own size skips exactly the mips above it
+	return texture && texture->mip > 0 ? MipSize(texture->size, texture->mip) : 0;
+}
+
+size_t TextureResidency::getBytes(unsigned int id) const
+{
+	const Texture* texture = getTexture(id);
+	return texture ? texture->bytes[texture->mip] : 0;
+}
+
+size_t TextureResidency::TextureBytes(const DirectX::DDS_TEXTURE_INFO& info, size_t maxsize)
+{
+	std::vector<size_t> bytes;
+	MipChainBytes(info, bytes);
+
+	return bytes[SkipFor(std::max(info.width, std::max(info.height, info.depth)), bytes.size(), maxsize)];
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+#include "DDSFormat.h"
+
+//What TextureResidency::EndFrame decided, for a report each frame
+struct TextureResidencyStats
+{
+	unsigned int frame;
+	unsigned int textures;
+	unsigned int texturesUsed;		//This frame
+	size_t budgetBytes;				//0 for no budget
+	size_t residentBytes;			//Of every texture, with the mips it was left with
+	size_t usedBytes;				//Of just the ones used this frame
+	size_t wantedBytes;				//The ones used this frame would have taken with every mip they wanted
+	unsigned int texturesShort;		//Used this frame with fewer mips than they wanted
+	unsigned int mipsDropped;
+	unsigned int mipsRestored;
+	unsigned int texturesChanged;	//To be created again with a different maxsize
+};
+
+//Keeps textures within a budget of GPU memory by choosing how many of the biggest mips of each to leave out, as the
+//maxsize DDSTextureLoader takes. Textures are marked as used each frame they're drawn, and EndFrame then drops mips from
+//the ones that have gone unused longest, followed by any mips bigger than the ones drawn this frame need, and only then
+//from the ones being drawn, a mip at a time from the biggest. Mips are given back to the textures being drawn, cheapest
+//first, while there's room. Nothing is dropped while under the budget and nothing given back that would go over it, so
+//a texture can't keep changing size from one frame to the next.
+//
+//Sizes are worked out from the DDS headers with GetSurfaceInfo, the same way the loader does, so nothing here needs
+//Direct3D or the textures themselves.
+class TextureResidency
+{
+private:
+	struct Texture
+	{
+		bool live;
+		size_t size;					//The biggest of the top mip's width, height and depth
+		size_t maxsize;					//The texture's own, which it never goes over
+		std::vector<size_t> bytes;		//Of all of the mips from each one down, indexed by how many are skipped
+		unsigned int topMip;			//Skipped because of maxsize
+		unsigned int lowestMip;			//Never skipped past, so there's always something to draw with
+		unsigned int mip;				//Skipped now
+		unsigned int wantedMip;			//When it was last used
+		unsigned int lastUsedFrame;
+		unsigned int uses;				//This frame
+	};
+
+	std::vector<Texture> _textures;		//Indexed by id - 1
+	std::vector<unsigned int> _free;
+	size_t _budget;
+	size_t _minSize;
+	unsigned int _frame;
+	TextureResidencyStats _stats;
+
+	Texture* getTexture(unsigned int id);
+	const Texture* getTexture(unsigned int id) const;
+
+public:
+	//Textures never lose the mips minSize across or smaller
+	TextureResidency(size_t budgetBytes = 0, size_t minSize = 64);
+
+	//0 for no budget, when mips are only ever given back
+	void SetBudget(size_t budgetBytes);
+	size_t getBudget() const { return _budget; }
+
+	//Starts tracking a texture created with maxsize, and returns an id for it that's never 0. It counts as used this frame
+	unsigned int Add(const DirectX::DDS_TEXTURE_INFO& info, size_t maxsize = 0);
+	void Remove(unsigned int id);
+
+	//The texture was created again with loadedMaxsize, maybe from a file that has changed size
+	void Loaded(unsigned int id, const DirectX::DDS_TEXTURE_INFO& info, size_t loadedMaxsize);
+
+	//Marks it as drawn this frame. screenSize is the most pixels across the screen it covers, so mips bigger than that
+	//aren't needed, 0 to want them all
+	void Use(unsigned int id, size_t screenSize = 0);
+
+	//Decides which mips every texture keeps, ready for getMaxsize, and starts the next frame
+	const TextureResidencyStats& EndFrame();
+
+	//The maxsize to create the texture with to get the mips it's been given, 0 for all of them
+	size_t getMaxsize(unsigned int id) const;
+	size_t getBytes(unsigned int id) const;
+	unsigned int getFrame() const { return _frame; }
+	const TextureResidencyStats& getStats() const { return _stats; }
+
+	//Bytes of every surface of a texture created with maxsize
+	static size_t TextureBytes(const DirectX::DDS_TEXTURE_INFO& info, size_t maxsize);
+};
@@ -0,0 +1,574 @@
+//Cooks every OBJ and DDS file under a folder ahead of time, in parallel, so the game never has to on its first run.
+//OBJ files are cooked into the same .meshcache files OBJLoader::Load would write (see MeshCooker), DDS files are checked
+//the same way DDSTextureLoader checks them before creating a texture, and those saved without mips have them made into
+//the same cache AssetLoader would write (see MipGenerator). Nothing here needs Direct3D, so it runs on Linux too.
+//
+//Each input is hashed, and skipped if the manifest from the last run says it was cooked from the same contents with the
+//same settings and its cache is still there. The manifest (cook_manifest.txt in the asset folder unless --manifest says
+//otherwise) lists every input with its hash, the settings it was cooked with and what came out of it.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. AssetCooker.cpp ..\MeshCooker.cpp ..\OBJParser.cpp ..\MappedFile.cpp ..\MeshOptimizer.cpp ..\MeshSimplifier.cpp
+//	   ..\MeshletBuilder.cpp ..\VertexQuantizer.cpp ..\BoundingVolumes.cpp ..\MeshCache.cpp ..\MeshCodec.cpp ..\DDSFormat.cpp
+//	   ..\MipGenerator.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath and dxgiformat.h from
+//https://github.com/microsoft/DirectX-Headers:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc -I<DirectX-Headers>/include/directx AssetCooker.cpp ../MeshCooker.cpp ../OBJParser.cpp
+//	    ../MappedFile.cpp ../MeshOptimizer.cpp ../MeshSimplifier.cpp ../MeshletBuilder.cpp ../VertexQuantizer.cpp ../BoundingVolumes.cpp
+//	    ../MeshCache.cpp ../MeshCodec.cpp ../DDSFormat.cpp ../MipGenerator.cpp -pthread -o AssetCooker
+//
+//Usage: AssetCooker <asset folder> [-j threads] [--force] [--manifest file] [--rules file] [mesh options] [texture options]
+//
+//Mesh options are the OBJLoadOptions, and must match what the game passes to OBJLoader::Load or it will cook the mesh again:
+//	--weld <epsilon> --split --no-vertex-cache --overdraw <threshold> --compact --lods <ratio,ratio...> --meshlets --compress
+//	--keep-texcoords (invertTexCoords = false)
+//
+//They apply to every mesh, except those listed in the rules file. Each line of that has the options for one mesh followed
+//by its path relative to the asset folder, e.g. for Application.cpp's torus knot:
+//	--lods 0.5,0.25,0.125 --meshlets OBJ/torusKnot.obj
+//
+//Texture options are the MipOptions, for every texture without mips. --srgb-mips must match the forceSRGB the game loads
+//them with or it will make the mips again, the filter can be either:
+//	--mip-filter <box|kaiser> --srgb-mips
+#include "MeshCooker.h"
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include "ToolCommon.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	//Bumped whenever DDS files start being cooked differently
+	const uint32_t TextureCookVersion = 2;
+
+	const char* const ManifestHeader = "# AssetCooker manifest 1";
+
+	enum AssetType
+	{
+		AssetMesh,
+		AssetTexture
+	};
+
+	struct MeshSettings
+	{
+		OBJLoadOptions options;
+		bool invertTexCoords;
+	};
+
+	//One line of the manifest
+	struct ManifestEntry
+	{
+		std::string type;
+		std::string status;			//"cooked", "skipped" (already up to date) or "failed"
+		uint64_t sourceSize;
+		uint64_t sourceHash;
+		uint64_t settingsHash;
+		std::string output;			//The file that was written, "-" if none
+		uint64_t outputSize;
+		std::string detail;
+		std::string path;			//Relative to the asset folder
+	};
+
+	struct Asset
+	{
+		AssetType type;
+		std::string path;
+		MeshSettings settings;
+		MipOptions mipOptions;
+		ManifestEntry result;
+	};
+
+	bool EndsWith(const std::string& text, const char* suffix)
+	{
+		size_t length = strlen(suffix);
+		if (text.size() < length)
+			return false;
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (tolower((unsigned char)text[text.size() - length + i]) != suffix[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	bool FileExists(const std::string& filename)
+	{
+		MeshSourceInfo info;
+		return MeshCache::GetSourceInfo(filename.c_str(), info, false);
+	}
+
+	//Parses one mesh option at args[i], moving i past its value. Returns false if it isn't one
+	bool ParseMeshOption(const std::vector<std::string>& args, size_t& i, MeshSettings& settings)
+	{
+		const std::string& arg = args[i];
+		bool hasValue = i + 1 < args.size();
+
+		if (arg == "--weld" && hasValue)
+			settings.options.weldEpsilon = (float)atof(args[++i].c_str());
+		else if (arg == "--split")
+			settings.options.splitLargeMeshes = true;
+		else if (arg == "--no-vertex-cache")
+			settings.options.optimizeVertexCache = false;
+		else if (arg == "--overdraw" && hasValue)
+			settings.options.overdrawThreshold = (float)atof(args[++i].c_str());
+		else if (arg == "--compact")
+			settings.options.compactVertices = true;
+		else if (arg == "--meshlets")
+			settings.options.buildMeshlets = true;
+		else if (arg == "--compress")
+			settings.options.compressCache = true;
+		else if (arg == "--keep-texcoords")
+			settings.invertTexCoords = false;
+		else if (arg == "--lods" && hasValue)
+		{
+			std::vector<float> ratios;
+
+			const char* ratio = args[i + 1].c_str();
+			while (*ratio)
+			{
+				char* end;
+				ratios.push_back(strtof(ratio, &end));
+
+				if (end == ratio || (*end && *end != ','))
+					return false;
+
+				ratio = *end ? end + 1 : end;
+			}
+
+			settings.options.lodRatios = ratios;
+			++i;
+		}
+		else
+			return false;
+
+		return true;
+	}
+
+	//Parses one texture option at args[i], moving i past its value. Returns false if it isn't one
+	bool ParseTextureOption(const std::vector<std::string>& args, size_t& i, MipOptions& options)
+	{
+		const std::string& arg = args[i];
+
+		if (arg == "--mip-filter" && i + 1 < args.size() && (args[i + 1] == "box" || args[i + 1] == "kaiser"))
+			options.filter = args[++i] == "box" ? MipFilterBox : MipFilterKaiser;
+		else if (arg == "--srgb-mips")
+			options.srgb = true;
+		else
+			return false;
+
+		return true;
+	}
+
+	uint64_t TextureSettingsHash(const MipOptions& options)
+	{
+		uint32_t settings[3] = { TextureCookVersion, (uint32_t)options.filter, options.srgb ? 1u : 0u };
+
+		return MeshCache::Hash64(settings, sizeof(settings));
+	}
+
+	//Lines of "<options> <path>", the path being everything after the last option so it can have spaces in it
+	bool LoadRules(const char* filename, const MeshSettings& defaults, std::map<std::string, MeshSettings>& outRules)
+	{
+		FILE* file = fopen(filename, "r");
+		if (!file)
+			return false;
+
+		char line[1024];
+		while (fgets(line, sizeof(line), file))
+		{
+			std::string text = line;
+			while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+				text.pop_back();
+
+			if (text.empty() || text[0] == '#')
+				continue;
+
+			std::vector<std::string> tokens;
+			std::vector<size_t> starts;
+			size_t position = 0;
+
+			while ((position = text.find_first_not_of(' ', position)) != std::string::npos)
+			{
+				size_t end = std::min(text.find(' ', position), text.size());
+				tokens.push_back(text.substr(position, end - position));
+				starts.push_back(position);
+				position = end;
+			}
+
+			//Options and their values come first, and the first token that's neither starts the path
+			MeshSettings settings = defaults;
+			std::string path;
+
+			for (size_t i = 0; i < tokens.size(); ++i)
+			{
+				if (tokens[i].compare(0, 2, "--") != 0)
+				{
+					path = text.substr(starts[i]);
+					break;
+				}
+
+				if (!ParseMeshOption(tokens, i, settings))
+				{
+					printf("%s: unknown option %s\n", filename, tokens[i].c_str());
+					fclose(file);
+					return false;
+				}
+			}
+
+			if (!path.empty())
+				outRules[path] = settings;
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	bool LoadManifest(const std::string& filename, std::map<std::string, ManifestEntry>& outEntries)
+	{
+		FILE* file = fopen(filename.c_str(), "r");
+		if (!file)
+			return false;
+
+		char line[2048];
+		bool valid = fgets(line, sizeof(line), file) && strncmp(line, ManifestHeader, strlen(ManifestHeader)) == 0;
+
+		while (valid && fgets(line, sizeof(line), file))
+		{
+			std::string text = line;
+			while (!text.empty() && (text.back() == '\n' || text.back() == '\r'))
+				text.pop_back();
+
+			//Eight tab separated fields, then the path
+			std::vector<std::string> fields;
+			size_t position = 0;
+
+			for (int i = 0; i < 8; ++i)
+			{
+				size_t tab = text.find('\t', position);
+				if (tab == std::string::npos)
+					break;
+
+				fields.push_back(text.substr(position, tab - position));
+				position = tab + 1;
+			}
+
+			if (fields.size() != 8)
+				continue;
+
+			ManifestEntry entry;
+			entry.type = fields[0];
+			entry.status = fields[1];
+			entry.sourceSize = strtoull(fields[2].c_str(), nullptr, 10);
+			entry.sourceHash = strtoull(fields[3].c_str(), nullptr, 16);
+			entry.settingsHash = strtoull(fields[4].c_str(), nullptr, 16);
+			entry.output = fields[5];
+			entry.outputSize = strtoull(fields[6].c_str(), nullptr, 10);
+			entry.detail = fields[7];
+			entry.path = text.substr(position);
+
+			outEntries[entry.path] = entry;
+		}
+
+		fclose(file);
+		return valid;
+	}
+
+	//Written next to the manifest and renamed over it, like MeshCache::Save, so a cook that's stopped half way
+	//through leaves the old manifest behind rather than half of a new one
+	bool SaveManifest(const std::string& filename, const std::vector<Asset>& assets)
+	{
+		std::string temporaryFilename = MeshCache::getTemporaryFilename(filename.c_str());
+		FILE* file = fopen(temporaryFilename.c_str(), "w");
+
+		if (!file)
+			return false;
+
+		fprintf(file, "%s\n", ManifestHeader);
+		fprintf(file, "# type\tstatus\tsource size\tsource hash\tsettings hash\toutput\toutput size\tdetail\tpath\n");
+
+		for (const Asset& asset : assets)
+		{
+			const ManifestEntry& entry = asset.result;
+			fprintf(file, "%s\t%s\t%llu\t%016llx\t%016llx\t%s\t%llu\t%s\t%s\n", entry.type.c_str(), entry.status.c_str(),
+					(unsigned long long)entry.sourceSize, (unsigned long long)entry.sourceHash, (unsigned long long)entry.settingsHash,
+					entry.output.c_str(), (unsigned long long)entry.outputSize, entry.detail.c_str(), entry.path.c_str());
+		}
+
+		if (fclose(file) != 0)
+		{
+			remove(temporaryFilename.c_str());
+			return false;
+		}
+
+		return MeshCache::RenameOver(temporaryFilename.c_str(), filename.c_str());
+	}
+
+	bool CookMesh(const std::string& filename, const MeshSettings& settings, ManifestEntry& result)
+	{
+		CookedMesh mesh;
+
+		if (!MeshCooker::CookOBJ(filename.c_str(), settings.invertTexCoords, settings.options, mesh))
+		{
+			result.detail = "can't be read";
+			return false;
+		}
+
+		if (!MeshCooker::Save(filename.c_str(), mesh, settings.invertTexCoords, settings.options))
+		{
+			result.detail = "can't write the cache";
+			return false;
+		}
+
+		char detail[128];
+		snprintf(detail, sizeof(detail), "%u vertices, %u indices, %u LODs, %u meshlets", mesh.info.vertexCount, mesh.info.indexCount,
+				 (unsigned int)mesh.lods.size(), (unsigned int)mesh.meshlets.size());
+
+		result.detail = detail;
+		result.output = MeshCooker::getCacheFilename(result.path.c_str(), settings.invertTexCoords, settings.options);
+
+		MeshSourceInfo cacheInfo;
+		if (MeshCache::GetSourceInfo(MeshCooker::getCacheFilename(filename.c_str(), settings.invertTexCoords, settings.options).c_str(), cacheInfo, false))
+			result.outputSize = cacheInfo.size;
+
+		return true;
+	}
+
+	bool CookTexture(const std::string& filename, const MipOptions& options, ManifestEntry& result)
+	{
+		MappedFile file;
+		DirectX::DDS_TEXTURE_INFO info;
+
+		if (!file.Open(filename.c_str()) || !DirectX::GetDDSTextureInfo(file.getData(), file.getSize(), info))
+		{
+			result.detail = "not a DDS file DDSTextureLoader can load";
+			return false;
+		}
+
+		static const char* const dimensions[] = { "", "", "1D", "2D", "3D" };
+
+		char detail[128];
+		snprintf(detail, sizeof(detail), "%s%s %ux%ux%u, %u mips, %u in array, DXGI format %u, %llu bytes of pixels",
+				 dimensions[info.dimension], info.isCubeMap ? " cube" : "", (unsigned int)info.width, (unsigned int)info.height,
+				 (unsigned int)info.depth, (unsigned int)info.mipCount, (unsigned int)info.arraySize, (unsigned int)info.format,
+				 (unsigned long long)info.dataSize);
+
+		result.detail = detail;
+
+		if (!MipGenerator::NeedsMips(info))
+			return true;
+
+		std::vector<uint8_t> mips;
+
+		if (!MipGenerator::GenerateDDS(file.getData(), file.getSize(), mips, options) || !MipGenerator::SaveCache(filename.c_str(), mips, options))
+		{
+			result.detail += ", can't write its mips";
+			return false;
+		}
+
+		snprintf(detail, sizeof(detail), ", made %u mips", (unsigned int)MipGenerator::getMipCount(info.width, info.height) - 1);
+
+		result.detail += detail;
+		result.output = MipGenerator::getCacheFilename(result.path, options);
+		result.outputSize = mips.size();
+		return true;
+	}
+
+	//Hashes the asset, and cooks it unless the manifest says that's already been done
+	void Cook(const std::string& folder, Asset& asset, const std::map<std::string, ManifestEntry>& previous, bool force)
+	{
+		ManifestEntry& result = asset.result;
+		std::string filename = folder + "/" + asset.path;
+
+		result.type = asset.type == AssetMesh ? "mesh" : "texture";
+		result.status = "failed";
+		result.sourceSize = 0;
+		result.sourceHash = 0;
+		result.settingsHash = asset.type == AssetMesh ? MeshCooker::SettingsHash(asset.settings.invertTexCoords, asset.settings.options)
+													  : TextureSettingsHash(asset.mipOptions);
+		result.output = "-";
+		result.outputSize = 0;
+		result.path = asset.path;
+
+		MeshSourceInfo source;
+		if (!MeshCache::GetSourceInfo(filename.c_str(), source, true))
+		{
+			result.detail = "can't be read";
+			return;
+		}
+
+		result.sourceSize = source.size;
+		result.sourceHash = source.hash;
+
+		auto last = previous.find(asset.path);
+
+		if (!force && last != previous.end() && last->second.status != "failed" && last->second.sourceHash == source.hash &&
+			last->second.settingsHash == result.settingsHash && (last->second.output == "-" || FileExists(folder + "/" + last->second.output)))
+		{
+			result = last->second;
+			result.status = "skipped";
+			return;
+		}
+
+		bool cooked = asset.type == AssetMesh ? CookMesh(filename, asset.settings, result) : CookTexture(filename, asset.mipOptions, result);
+		result.status = cooked ? "cooked" : "failed";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: AssetCooker <asset folder> [-j threads] [--force] [--manifest file] [--rules file] [mesh options] [texture options]\n");
+		return 1;
+	}
+
+	std::string folder = argv[1];
+	while (folder.size() > 1 && (folder.back() == '/' || folder.back() == '\\'))
+		folder.pop_back();
+
+	std::string manifestFilename = folder + "/cook_manifest.txt";
+	const char* rulesFilename = nullptr;
+	unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+	bool force = false;
+
+	MeshSettings defaults;
+	defaults.invertTexCoords = true;
+
+	MipOptions textureDefaults;
+
+	std::vector<std::string> args(argv + 2, argv + argc);
+	for (size_t i = 0; i < args.size(); ++i)
+	{
+		if (args[i] == "-j" && i + 1 < args.size())
+			threadCount = std::max(1, atoi(args[++i].c_str()));
+		else if (args[i] == "--force")
+			force = true;
+		else if (args[i] == "--manifest" && i + 1 < args.size())
+			manifestFilename = args[++i];
+		else if (args[i] == "--rules" && i + 1 < args.size())
+			rulesFilename = args[++i].c_str();
+		else if (!ParseMeshOption(args, i, defaults) && !ParseTextureOption(args, i, textureDefaults))
+		{
+			printf("Unknown option %s\n", args[i].c_str());
+			return 1;
+		}
+	}
+
+	//Meshes are parsed with streaming assembly, one thread each, since there's already a thread per mesh.
+	//It gives exactly the same result so it isn't part of the settings hash
+	defaults.options.streamingAssembly = true;
+
+	//Mips are made on one thread for the same reason, which doesn't change them either
+	textureDefaults.threadCount = 1;
+
+	std::map<std::string, MeshSettings> rules;
+	if (rulesFilename && !LoadRules(rulesFilename, defaults, rules))
+	{
+		printf("Couldn't read the rules in %s\n", rulesFilename);
+		return 1;
+	}
+
+	std::vector<std::string> files;
+	ListFiles(folder, "", files);
+	std::sort(files.begin(), files.end());
+
+	std::vector<Asset> assets;
+	for (const std::string& file : files)
+	{
+		Asset asset;
+
+		if (EndsWith(file, ".obj"))
+			asset.type = AssetMesh;
+		else if (EndsWith(file, ".dds") && !EndsWith(file, ".mips.dds"))
+			asset.type = AssetTexture;
+		else
+			continue;
+
+		auto rule = rules.find(file);
+		asset.path = file;
+		asset.settings = rule != rules.end() ? rule->second : defaults;
+		asset.settings.options.streamingAssembly = true;
+		asset.mipOptions = textureDefaults;
+		assets.push_back(asset);
+	}
+
+	std::map<std::string, ManifestEntry> previous;
+	LoadManifest(manifestFilename, previous);
+
+	//Biggest first, so one big mesh doesn't start last and hold everything up
+	std::vector<uint64_t> sizes(assets.size(), 0);
+	for (size_t i = 0; i < assets.size(); ++i)
+	{
+		MeshSourceInfo info;
+		if (MeshCache::GetSourceInfo((folder + "/" + assets[i].path).c_str(), info, false))
+			sizes[i] = info.size;
+	}
+
+	std::vector<size_t> order(assets.size());
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+	auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next(0);
+	std::mutex printLock;
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < order.size(); i = next++)
+		{
+			Asset& asset = assets[order[i]];
+			auto assetStart = std::chrono::steady_clock::now();
+
+			Cook(folder, asset, previous, force);
+
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - assetStart).count();
+
+			std::lock_guard<std::mutex> lock(printLock);
+			printf("%-8s %8.1f ms  %s: %s\n", asset.result.status.c_str(), milliseconds, asset.path.c_str(), asset.result.detail.c_str());
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < std::min<size_t>(threadCount, assets.size()); ++i)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	unsigned int cooked = 0, skipped = 0, failed = 0;
+	for (const Asset& asset : assets)
+	{
+		cooked += asset.result.status == "cooked";
+		skipped += asset.result.status == "skipped";
+		failed += asset.result.status == "failed";
+	}
+
+	bool savedManifest = SaveManifest(manifestFilename, assets);
+
+	printf("%u assets: %u cooked, %u up to date, %u failed in %.2f s on %u threads\n", (unsigned int)assets.size(), cooked, skipped,
+		   failed, seconds, (unsigned int)std::max<size_t>(1, std::min<size_t>(threadCount, assets.size())));
+
+	if (!savedManifest)
+		printf("Couldn't write %s\n", manifestFilename.c_str());
+
+	return failed || !savedManifest ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+//Times starting up from loose files against starting up from an AssetPack holding the same files, with the files cold
+//(not in the OS file cache, see README.md) and warm. Each asset is a cooked mesh, mapped and checked the way
+//OBJLoader::Load does it, or a small DDS texture, mapped and read the way uploading it would. It makes its own assets,
+//so it only needs an empty directory.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. AssetPackBenchmark.cpp ..\AssetPack.cpp ..\MeshCache.cpp ..\MeshCodec.cpp ..\MappedFile.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc AssetPackBenchmark.cpp ../AssetPack.cpp ../MeshCache.cpp ../MeshCodec.cpp ../MappedFile.cpp -pthread -o AssetPackBenchmark
+//
+//Usage: AssetPackBenchmark <directory> [meshes = 1000] [textures = 1000] [vertices per mesh = 2000]
+#include "AssetPack.h"
+#include "MeshCache.h"
+#include "ToolCommon.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char* const PackName = "Assets.pack";
+
+	//A 64x64 DXT1 texture with a full mip chain, about the size of a small prop's texture
+	const uint32_t TextureSize = 64;
+
+	struct RunResult
+	{
+		double milliseconds;
+		unsigned int filesOpened;
+		unsigned int failures;
+		uint64_t checksum;			//Of the texture contents, so reading them can't be optimized away
+	};
+
+	std::string AssetPath(const char* kind, unsigned int i, const char* extension)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "%s%04u%s", kind, i, extension);
+		return name;
+	}
+
+	//A wavy grid, so the vertices aren't all the same bytes
+	void MakeMesh(unsigned int vertexCount, unsigned int seed, CookedMesh& outMesh)
+	{
+		unsigned int side = 2;
+		while (side * side < vertexCount)
+			++side;
+
+		std::vector<SimpleVertex> vertices(side * side);
+		for (unsigned int y = 0; y < side; ++y)
+		{
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				SimpleVertex& v = vertices[y * side + x];
+				v.Pos = XMFLOAT3((float)x, (float)((x * 7 + y * 13 + seed) % 17) * 0.1f, (float)y);
+				v.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				v.TexC = XMFLOAT2((float)x / side, (float)y / side);
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		for (unsigned int y = 0; y + 1 < side; ++y)
+		{
+			for (unsigned int x = 0; x + 1 < side; ++x)
+			{
+				uint32_t i = y * side + x;
+				uint32_t quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		outMesh.info.vertexStride = sizeof(SimpleVertex);
+		outMesh.info.vertexCount = (uint32_t)vertices.size();
+		outMesh.info.indexSize = sizeof(uint32_t);
+		outMesh.info.indexCount = (uint32_t)indices.size();
+		outMesh.info.compactVertices = false;
+		outMesh.info.posScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+		outMesh.info.posOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+		outMesh.vertices.assign((const uint8_t*)vertices.data(), (const uint8_t*)(vertices.data() + vertices.size()));
+		outMesh.indices.assign((const uint8_t*)indices.data(), (const uint8_t*)(indices.data() + indices.size()));
+
+		MeshDrawRange range = { 0, outMesh.info.indexCount, 0 };
+		MeshLOD lod;
+		lod.DrawRanges.push_back(range);
+		lod.Error = 0.0f;
+		outMesh.lods.assign(1, lod);
+		outMesh.meshlets.clear();
+	}
+
+	//Only the fields DDSTextureLoader looks at for a legacy DXT1 file are filled in
+	bool WriteTexture(const std::string& filename, unsigned int seed)
+	{
+		uint32_t header[32] = {};
+		header[0] = 0x20534444;						//"DDS "
+		header[1] = 124;							//Header size
+		header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000;
+		header[3] = TextureSize;
+		header[4] = TextureSize;
+		header[19] = 32;							//Pixel format size
+		header[20] = 0x4;							//DDS_FOURCC
+		header[21] = 0x31545844;					//"DXT1"
+		header[27] = 0x1000 | 0x400000 | 0x8;		//Texture, mipmap, complex
+
+		std::vector<uint8_t> pixels;
+		uint32_t mipCount = 0;
+
+		for (uint32_t size = TextureSize; size > 0; size /= 2, ++mipCount)
+		{
+			uint32_t blocks = (size + 3) / 4;
+			for (uint32_t i = 0; i < blocks * blocks * 8; ++i)
+				pixels.push_back((uint8_t)(i * 31 + seed));
+		}
+
+		header[7] = mipCount;
+
+		FILE* file = fopen(filename.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(header, sizeof(header), 1, file) == 1 && fwrite(pixels.data(), pixels.size(), 1, file) == 1;
+		return fclose(file) == 0 && written;
+	}
+
+	RunResult LoadLoose(const std::string& directory, unsigned int meshCount, unsigned int textureCount)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < meshCount; ++i)
+		{
+			std::string cacheFilename = directory + "/" + AssetPath("mesh", i, ".obj.meshcache");
+			std::string sourceFilename = directory + "/" + AssetPath("mesh", i, ".obj");
+
+			MappedFile file;
+			CookedMeshView view;
+
+			//The source is looked at too, to check the cache is still up to date
+			result.filesOpened += 2;
+
+			if (MeshCache::Map(cacheFilename.c_str(), sourceFilename.c_str(), 0, file, view) != MeshCacheValid)
+				++result.failures;
+		}
+
+		for (unsigned int i = 0; i < textureCount; ++i)
+		{
+			MappedFile file;
+			++result.filesOpened;
+
+			if (!file.Open((directory + "/" + AssetPath("texture", i, ".dds")).c_str()))
+			{
+				++result.failures;
+				continue;
+			}
+
+			result.checksum += MeshCache::Hash64(file.getData(), file.getSize());
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	RunResult LoadPacked(const std::string& directory, unsigned int meshCount, unsigned int textureCount)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+
+		AssetPack pack;
+		result.filesOpened = 1;
+
+		if (!pack.Open((directory + "/" + PackName).c_str()))
+		{
+			result.failures = meshCount + textureCount;
+			return result;
+		}
+
+		for (unsigned int i = 0; i < meshCount; ++i)
+		{
+			size_t size;
+			const uint8_t* data = pack.Find(AssetPath("mesh", i, ".obj.meshcache").c_str(), size);
+			CookedMeshView view;
+
+			if (!data || MeshCache::MapData(data, size, nullptr, 0, view) != MeshCacheValid)
+				++result.failures;
+		}
+
+		for (unsigned int i = 0; i < textureCount; ++i)
+		{
+			size_t size;
+			const uint8_t* data = pack.Find(AssetPath("texture", i, ".dds").c_str(), size);
+
+			if (!data)
+			{
+				++result.failures;
+				continue;
+			}
+
+			result.checksum += MeshCache::Hash64(data, size);
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	void Report(const char* name, const RunResult& result, unsigned int count, uint64_t totalBytes)
+	{
+		printf("%-12s %9.1f ms %8.1f us/asset %8.1f MB/s %6u files opened%s\n", name, result.milliseconds, result.milliseconds * 1000.0 / count,
+			   totalBytes / (1024.0 * 1024.0) / (result.milliseconds / 1000.0), result.filesOpened, result.failures ? " (some assets failed to load)" : "");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: AssetPackBenchmark <directory> [meshes = 1000] [textures = 1000] [vertices per mesh = 2000]\n");
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	unsigned int meshCount = argc > 2 ? (unsigned int)atoi(argv[2]) : 1000;
+	unsigned int textureCount = argc > 3 ? (unsigned int)atoi(argv[3]) : 1000;
+	unsigned int vertexCount = argc > 4 ? (unsigned int)atoi(argv[4]) : 2000;
+
+	//Make everything first, each mesh with a tiny stand in for its source file, then pack what the game would load
+	std::vector<std::string> looseFiles, packedPaths;
+	uint64_t totalBytes = 0;
+
+	for (unsigned int i = 0; i < meshCount; ++i)
+	{
+		std::string sourceFilename = directory + "/" + AssetPath("mesh", i, ".obj");
+		FILE* source = fopen(sourceFilename.c_str(), "wb");
+
+		if (!source)
+		{
+			printf("Couldn't write %s\n", sourceFilename.c_str());
+			return 1;
+		}
+
+		fprintf(source, "# mesh %u\n", i);
+		fclose(source);
+
+		CookedMesh mesh;
+		MakeMesh(vertexCount, i, mesh);
+
+		MeshSourceInfo info;
+		std::string cachePath = AssetPath("mesh", i, ".obj.meshcache");
+
+		if (!MeshCache::GetSourceInfo(sourceFilename.c_str(), info, true) || !MeshCache::Save((directory + "/" + cachePath).c_str(), mesh, info, 0))
+		{
+			printf("Couldn't write %s\n", cachePath.c_str());
+			return 1;
+		}
+
+		looseFiles.push_back(sourceFilename);
+		looseFiles.push_back(directory + "/" + cachePath);
+		packedPaths.push_back(cachePath);
+	}
+
+	for (unsigned int i = 0; i < textureCount; ++i)
+	{
+		std::string texturePath = AssetPath("texture", i, ".dds");
+
+		if (!WriteTexture(directory + "/" + texturePath, i))
+		{
+			printf("Couldn't write %s\n", texturePath.c_str());
+			return 1;
+		}
+
+		looseFiles.push_back(directory + "/" + texturePath);
+		packedPaths.push_back(texturePath);
+	}
+
+	for (const std::string& path : packedPaths)
+	{
+		MeshSourceInfo info;
+		MeshCache::GetSourceInfo((directory + "/" + path).c_str(), info, false);
+		totalBytes += info.size;
+	}
+
+	std::string packFilename = directory + "/" + PackName;
+	if (!AssetPack::Build(packFilename.c_str(), directory.c_str(), packedPaths))
+	{
+		printf("Couldn't write %s\n", packFilename.c_str());
+		return 1;
+	}
+
+	MeshSourceInfo packInfo;
+	MeshCache::GetSourceInfo(packFilename.c_str(), packInfo, false);
+
+	unsigned int count = meshCount + textureCount;
+	printf("%u meshes and %u textures, %.1f MB loose, %.1f MB packed\n", meshCount, textureCount, totalBytes / (1024.0 * 1024.0),
+		   packInfo.size / (1024.0 * 1024.0));
+
+	for (int packed = 0; packed < 2; ++packed)
+	{
+		const char* name = packed ? "Pack" : "Loose";
+		char label[32];
+
+		bool evicted = true;
+		if (packed)
+			evicted = EvictFromFileCache(packFilename);
+		else
+		{
+			for (const std::string& filename : looseFiles)
+				evicted = EvictFromFileCache(filename) && evicted;
+		}
+
+		if (evicted)
+		{
+			snprintf(label, sizeof(label), "%s cold", name);
+			Report(label, packed ? LoadPacked(directory, meshCount, textureCount) : LoadLoose(directory, meshCount, textureCount), count, totalBytes);
+		}
+
+		//The first pass warms the file cache
+		RunResult warm = packed ? LoadPacked(directory, meshCount, textureCount) : LoadLoose(directory, meshCount, textureCount);
+
+		snprintf(label, sizeof(label), "%s warm", name);
+		Report(label, packed ? LoadPacked(directory, meshCount, textureCount) : LoadLoose(directory, meshCount, textureCount), count, totalBytes);
+
+		if (packed)
+			printf("Textures read the same from both: %s\n", warm.checksum == LoadLoose(directory, meshCount, textureCount).checksum ? "yes" : "NO");
+	}
+
+	return 0;
+}
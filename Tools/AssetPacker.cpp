@@ -0,0 +1,96 @@
+//Builds the Assets.pack the game mounts at startup, and lists or checks existing packs.
+//
+//Packing only takes what the game actually opens: cooked meshes (.meshcache, see Tools/AssetCooker) and DDS textures,
+//the mips cooked for those saved without them (.mips.dds) included.
+//Source .obj files are left out, since a mesh in a pack is used without checking it against its source. Run it from the
+//folder the game runs in, after cooking:
+//	AssetCooker . && AssetPacker build . Assets.pack
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. AssetPacker.cpp ..\AssetPack.cpp ..\MeshCache.cpp ..\MeshCodec.cpp ..\MappedFile.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc AssetPacker.cpp ../AssetPack.cpp ../MeshCache.cpp ../MeshCodec.cpp ../MappedFile.cpp -pthread -o AssetPacker
+//
+//Usage: AssetPacker build <asset folder> <pack>
+//       AssetPacker list <pack>
+//       AssetPacker verify <pack>
+#include "AssetPack.h"
+#include "ToolCommon.h"
+#include <algorithm>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	bool EndsWith(const std::string& text, const char* suffix)
+	{
+		size_t length = strlen(suffix);
+		if (text.size() < length)
+			return false;
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (tolower((unsigned char)text[text.size() - length + i]) != suffix[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	int Build(const char* folder, const char* packFilename)
+	{
+		std::vector<std::string> files, paths;
+		ListFiles(folder, "", files);
+		std::sort(files.begin(), files.end());
+
+		for (const std::string& file : files)
+		{
+			if (EndsWith(file, ".meshcache") || EndsWith(file, ".dds"))
+				paths.push_back(file);
+		}
+
+		if (!AssetPack::Build(packFilename, folder, paths))
+		{
+			printf("Couldn't write %s\n", packFilename);
+			return 1;
+		}
+
+		printf("Packed %u files into %s\n", (unsigned int)paths.size(), packFilename);
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 4 && strcmp(argv[1], "build") == 0)
+		return Build(argv[2], argv[3]);
+
+	if (argc != 3 || (strcmp(argv[1], "list") != 0 && strcmp(argv[1], "verify") != 0))
+	{
+		printf("Usage: AssetPacker build <asset folder> <pack>\n       AssetPacker list <pack>\n       AssetPacker verify <pack>\n");
+		return 1;
+	}
+
+	AssetPack pack;
+	if (!pack.Open(argv[2]))
+	{
+		printf("%s is missing or isn't a valid pack\n", argv[2]);
+		return 1;
+	}
+
+	if (strcmp(argv[1], "list") == 0)
+	{
+		for (uint32_t i = 0; i < pack.getEntryCount(); ++i)
+			printf("%12llu  %s\n", (unsigned long long)pack.getEntrySize(i), pack.getEntryPath(i).c_str());
+
+		return 0;
+	}
+
+	uint32_t failures = pack.Verify();
+	printf("%u of %u entries %s\n", failures, pack.getEntryCount(), failures ? "DON'T MATCH THEIR CHECKSUMS" : "are damaged");
+
+	return failures ? 1 : 0;
+}
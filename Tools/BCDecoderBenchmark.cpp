@@ -0,0 +1,409 @@
+//Checks BCDecoder against reference decodes and measures how many megapixels a second it decodes. Blocks of every format
+//are generated the same way each run, and their decodes must match, bit for bit, hashes of the same blocks decoded by
+//another decoder (Pillow 12's). The fast path has to give exactly what DecodeBlock, the plain reference, does, with one
+//thread and with several, including surfaces that end part way through a block. Any DDS files it's given in a format
+//BCDecoder supports are decoded too, every subresource FillSubresources lays out, and checked the same way. It exits
+//with 1 if anything doesn't match.
+//
+//Build on Windows from a Developer Command Prompt in this folder (add /arch:AVX2 for the AVX2 lookups):
+//	cl /O2 /EHsc /I.. BCDecoderBenchmark.cpp ..\BCDecoder.cpp ..\DDSFormat.cpp ..\MappedFile.cpp
+//Build on Linux, with dxgiformat.h from https://github.com/microsoft/DirectX-Headers (include/directx):
+//	g++ -std=c++14 -O2 -mavx2 -pthread -I.. -I<DirectX-Headers>/include/directx BCDecoderBenchmark.cpp ../BCDecoder.cpp ../DDSFormat.cpp ../MappedFile.cpp -o BCDecoderBenchmark
+//
+//Usage: BCDecoderBenchmark [size = 2048] [threads = one a core] [file.dds...]
+#include "BCDecoder.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const int DecodeRepeats = 5;
+
+	//Blocks a side of the surfaces checked against the reference hashes, 256 x 256 texels
+	const size_t ReferenceSide = 64;
+
+	struct Format
+	{
+		const char* name;
+		DXGI_FORMAT format;
+		uint64_t referenceHash;		//Of the ReferenceSide surface from another decoder, 0 where it has none
+	};
+
+	//Pillow has no BC4 SNORM and reads BC5 SNORM another way, so they're only checked against DecodeBlock and the known
+	//blocks below
+	const Format Formats[] =
+	{
+		{ "BC1", DXGI_FORMAT_BC1_UNORM, 0xcef6177392879fdeull },
+		{ "BC2", DXGI_FORMAT_BC2_UNORM, 0xb1302731d67b456aull },
+		{ "BC3", DXGI_FORMAT_BC3_UNORM, 0xebf354641837abaeull },
+		{ "BC4", DXGI_FORMAT_BC4_UNORM, 0xc1e6e538a66203afull },
+		{ "BC4 SNORM", DXGI_FORMAT_BC4_SNORM, 0 },
+		{ "BC5", DXGI_FORMAT_BC5_UNORM, 0x86529a9c9768efbcull },
+		{ "BC5 SNORM", DXGI_FORMAT_BC5_SNORM, 0 },
+		{ "BC7", DXGI_FORMAT_BC7_UNORM, 0x50bb3f48efad7b90ull },
+	};
+
+	//Blocks worked out by hand from the specifications, with the red channel of each texel they decode to
+	struct KnownBlock
+	{
+		const char* name;
+		DXGI_FORMAT format;
+		uint8_t block[8];
+		uint8_t red[16];
+	};
+
+	const KnownBlock KnownBlocks[] =
+	{
+		//127 and -127, so 8 values rounding towards 0 each side of it
+		{ "BC4 SNORM 8 values", DXGI_FORMAT_BC4_SNORM, { 0x7F, 0x81, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+		  { 127, 129, 90, 54, 18, 238, 202, 166, 127, 129, 90, 54, 18, 238, 202, 166 } },
+		//-128 is read as -127, and then there are 6 values with -1 and 1 as the last two
+		{ "BC4 SNORM 6 values", DXGI_FORMAT_BC4_SNORM, { 0x80, 0x80, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+		  { 129, 129, 129, 129, 129, 129, 129, 127, 129, 129, 129, 129, 129, 129, 129, 127 } },
+		{ "BC4 8 values", DXGI_FORMAT_BC4_UNORM, { 255, 0, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+		  { 255, 0, 218, 182, 145, 109, 72, 36, 255, 0, 218, 182, 145, 109, 72, 36 } },
+		{ "BC4 6 values", DXGI_FORMAT_BC4_UNORM, { 10, 200, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA },
+		  { 10, 200, 48, 86, 124, 162, 0, 255, 10, 200, 48, 86, 124, 162, 0, 255 } },
+	};
+
+	double Seconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t Hash(const uint8_t* data, size_t size)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ data[i]) * 0x100000001b3ull;
+
+		return hash;
+	}
+
+	//The same blocks every run. BC7 blocks take each of its 8 modes in turn, where random bytes would nearly always
+	//be mode 0 or 1
+	void MakeBlocks(DXGI_FORMAT format, size_t count, std::vector<uint8_t>& blocks)
+	{
+		size_t blockBytes = BCDecoder::BlockBytes(format);
+		bool bc7 = format == DXGI_FORMAT_BC7_UNORM;
+		uint32_t state = 12345;
+
+		blocks.resize(count * blockBytes);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			uint8_t* block = &blocks[i * blockBytes];
+
+			for (size_t j = 0; j < blockBytes; ++j)
+			{
+				state = state * 1664525u + 1013904223u;
+				block[j] = (uint8_t)(state >> 24);
+			}
+
+			if (bc7)
+			{
+				unsigned int mode = i % 8;
+				block[0] = (uint8_t)((block[0] << (mode + 1)) | (1 << mode));
+			}
+		}
+	}
+
+	//Decodes every block with DecodeBlock into a surface laid out like DecodeSurface's
+	void ReferenceDecode(DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width, size_t height,
+						 std::vector<uint8_t>& out)
+	{
+		size_t blockBytes = BCDecoder::BlockBytes(format);
+		uint8_t texels[64];
+
+		out.assign(width * height * 4, 0);
+
+		for (size_t by = 0; by * 4 < height; ++by)
+		{
+			for (size_t bx = 0; bx * 4 < width; ++bx)
+			{
+				BCDecoder::DecodeBlock(format, subresource.data + by * subresource.rowPitch + bx * blockBytes, texels);
+
+				for (size_t y = 0; y < 4 && by * 4 + y < height; ++y)
+				{
+					for (size_t x = 0; x < 4 && bx * 4 + x < width; ++x)
+						memcpy(&out[((by * 4 + y) * width + bx * 4 + x) * 4], texels + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	bool Decode(DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width, size_t height,
+				unsigned int threads, std::vector<uint8_t>& out)
+	{
+		out.assign(width * height * 4, 0);
+		return BCDecoder::DecodeSurface(format, subresource, width, height, out.data(), width * 4, threads);
+	}
+
+	//DecodeSurface with 1 thread and with threads must give what DecodeBlock does, for the whole surface and for it
+	//cut off part way through a block each way
+	bool MatchesReference(const char* name, DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width,
+						  size_t height, unsigned int threads)
+	{
+		std::vector<uint8_t> reference, fast;
+		ReferenceDecode(format, subresource, width, height, reference);
+
+		for (unsigned int threadCount : { 1u, threads })
+		{
+			if (!Decode(format, subresource, width, height, threadCount, fast) || fast != reference)
+			{
+				printf("%s: %zu x %zu with %u threads doesn't match DecodeBlock\n", name, width, height, threadCount);
+				return false;
+			}
+		}
+
+		if (width < 4 || height < 4)
+			return true;
+
+		size_t cutWidth = width - 3;
+		size_t cutHeight = height - 1;
+		std::vector<uint8_t> cut;
+
+		if (!Decode(format, subresource, cutWidth, cutHeight, threads, cut))
+		{
+			printf("%s: %zu x %zu failed\n", name, cutWidth, cutHeight);
+			return false;
+		}
+
+		for (size_t y = 0; y < cutHeight; ++y)
+		{
+			if (memcmp(&cut[y * cutWidth * 4], &reference[y * width * 4], cutWidth * 4) != 0)
+			{
+				printf("%s: %zu x %zu doesn't match the whole surface\n", name, cutWidth, cutHeight);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool CheckFormat(const Format& format, unsigned int threads)
+	{
+		std::vector<uint8_t> blocks;
+		MakeBlocks(format.format, ReferenceSide * ReferenceSide, blocks);
+
+		size_t side = ReferenceSide * 4;
+		DirectX::DDS_SUBRESOURCE subresource = { blocks.data(), ReferenceSide * BCDecoder::BlockBytes(format.format), blocks.size(), blocks.size() };
+
+		if (!MatchesReference(format.name, format.format, subresource, side, side, threads))
+			return false;
+
+		if (format.referenceHash == 0)
+			return true;
+
+		std::vector<uint8_t> texels;
+		Decode(format.format, subresource, side, side, threads, texels);
+
+		uint64_t hash = Hash(texels.data(), texels.size());
+
+		if (hash != format.referenceHash)
+		{
+			printf("%s: hash 0x%016llx, the reference decoder's is 0x%016llx\n", format.name, (unsigned long long)hash,
+				   (unsigned long long)format.referenceHash);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool CheckKnownBlocks()
+	{
+		bool ok = true;
+
+		for (const KnownBlock& known : KnownBlocks)
+		{
+			uint8_t texels[64];
+			BCDecoder::DecodeBlock(known.format, known.block, texels);
+
+			for (size_t i = 0; i < 16; ++i)
+			{
+				if (texels[i * 4] != known.red[i])
+				{
+					printf("%s: texel %zu is %u, should be %u\n", known.name, i, texels[i * 4], known.red[i]);
+					ok = false;
+					break;
+				}
+			}
+		}
+
+		//A BC7 block with no mode bit set is invalid, and decodes to 0 in every channel
+		uint8_t invalid[16] = {};
+		memset(invalid + 1, 0xFF, sizeof(invalid) - 1);
+
+		uint8_t texels[64];
+		uint8_t zero[64] = {};
+		DirectX::DDS_SUBRESOURCE subresource = { invalid, sizeof(invalid), sizeof(invalid), sizeof(invalid) };
+
+		BCDecoder::DecodeBlock(DXGI_FORMAT_BC7_UNORM, invalid, texels);
+		bool referenceZero = memcmp(texels, zero, sizeof(zero)) == 0;
+
+		memset(texels, 0xFF, sizeof(texels));
+		BCDecoder::DecodeSurface(DXGI_FORMAT_BC7_UNORM, subresource, 4, 4, texels, 16, 1);
+
+		if (!referenceZero || memcmp(texels, zero, sizeof(zero)) != 0)
+		{
+			printf("BC7: an invalid block doesn't decode to 0\n");
+			ok = false;
+		}
+
+		return ok;
+	}
+
+	//Megapixels a second decoding subresource, the best of DecodeRepeats, with DecodeBlock and with DecodeSurface
+	void Measure(DXGI_FORMAT format, const DirectX::DDS_SUBRESOURCE& subresource, size_t width, size_t height, unsigned int threads,
+				 double& reference, double& oneThread, double& allThreads)
+	{
+		std::vector<uint8_t> out(width * height * 4);
+		double megapixels = width * height / 1e6;
+		double best[3] = { 1e30, 1e30, 1e30 };
+
+		for (int r = 0; r < DecodeRepeats; ++r)
+		{
+			double start = Seconds();
+			ReferenceDecode(format, subresource, width, height, out);
+			best[0] = std::min(best[0], Seconds() - start);
+
+			start = Seconds();
+			BCDecoder::DecodeSurface(format, subresource, width, height, out.data(), width * 4, 1);
+			best[1] = std::min(best[1], Seconds() - start);
+
+			start = Seconds();
+			BCDecoder::DecodeSurface(format, subresource, width, height, out.data(), width * 4, threads);
+			best[2] = std::min(best[2], Seconds() - start);
+		}
+
+		reference = megapixels / best[0];
+		oneThread = megapixels / best[1];
+		allThreads = megapixels / best[2];
+	}
+
+	//Every subresource of a DDS file, checked against DecodeBlock and timed
+	bool CheckFile(const char* filename, unsigned int threads)
+	{
+		MappedFile file;
+		DirectX::DDS_TEXTURE_INFO info;
+
+		if (!file.Open(filename, true) || !DirectX::GetDDSTextureInfo(file.getData(), file.getSize(), info))
+		{
+			printf("%s: not a DDS file\n", filename);
+			return false;
+		}
+
+		if (!BCDecoder::IsSupported(info.format))
+		{
+			printf("%s: format %d isn't one BCDecoder decodes, skipped\n", filename, (int)info.format);
+			return true;
+		}
+
+		std::unique_ptr<DirectX::DDS_SUBRESOURCE[]> subresources(new DirectX::DDS_SUBRESOURCE[info.mipCount * info.arraySize]);
+		size_t width, height, depth, skipMip;
+
+		size_t count = DirectX::FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, 0,
+												  file.getSize() - info.dataOffset, file.getData() + info.dataOffset, width, height, depth, skipMip,
+												  subresources.get());
+		if (!count)
+		{
+			printf("%s: too short\n", filename);
+			return false;
+		}
+
+		double texels = 0.0, referenceSeconds = 0.0, oneThreadSeconds = 0.0, allThreadsSeconds = 0.0;
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			size_t mip = i % info.mipCount;
+			size_t mipWidth = std::max<size_t>(1, info.width >> mip);
+			size_t mipHeight = std::max<size_t>(1, info.height >> mip);
+			size_t mipDepth = std::max<size_t>(1, info.depth >> mip);
+
+			//A volume's subresource holds every depth slice of the mip
+			for (size_t slice = 0; slice < mipDepth; ++slice)
+			{
+				DirectX::DDS_SUBRESOURCE surface = subresources[i];
+				surface.data += slice * surface.slicePitch;
+				surface.bytes = surface.slicePitch;
+
+				if (!MatchesReference(filename, info.format, surface, mipWidth, mipHeight, threads))
+					return false;
+
+				double reference, oneThread, allThreads;
+				Measure(info.format, surface, mipWidth, mipHeight, threads, reference, oneThread, allThreads);
+
+				double megapixels = mipWidth * mipHeight / 1e6;
+				texels += megapixels;
+				referenceSeconds += megapixels / reference;
+				oneThreadSeconds += megapixels / oneThread;
+				allThreadsSeconds += megapixels / allThreads;
+			}
+		}
+
+		printf("%-12s %8.0f %10.0f %10.0f   %s, %zu subresources\n", "file", texels / referenceSeconds, texels / oneThreadSeconds,
+			   texels / allThreadsSeconds, filename, count);
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t size = argc > 1 ? (size_t)atoi(argv[1]) : 2048;
+	unsigned int threads = argc > 2 ? (unsigned int)atoi(argv[2]) : 0;
+
+	if (size < 4)
+		size = 4;
+
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+#if defined(__AVX2__)
+	const char* simd = "SSE2 palettes, AVX2 lookups";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const char* simd = "SSE2 palettes";
+#else
+	const char* simd = "no SIMD";
+#endif
+
+	printf("BCDecoder with %s, %u threads\n\n", simd, threads);
+
+	bool ok = CheckKnownBlocks();
+
+	for (const Format& format : Formats)
+		ok = CheckFormat(format, threads) && ok;
+
+	printf("%s\n\n", ok ? "Every format matches the reference decodes" : "MISMATCH");
+
+	//Random blocks are the worst case for BC7, whose mode decides how much work a block is, so this is a floor for it
+	printf("Megapixels a second decoding %zu x %zu\n", size, size);
+	printf("%-12s %8s %10s %10s\n", "format", "reference", "1 thread", "threads");
+
+	for (const Format& format : Formats)
+	{
+		size_t blocksWide = (size + 3) / 4;
+		std::vector<uint8_t> blocks;
+		MakeBlocks(format.format, blocksWide * blocksWide, blocks);
+
+		DirectX::DDS_SUBRESOURCE subresource = { blocks.data(), blocksWide * BCDecoder::BlockBytes(format.format), blocks.size(), blocks.size() };
+
+		double reference, oneThread, allThreads;
+		Measure(format.format, subresource, size, size, threads, reference, oneThread, allThreads);
+
+		printf("%-12s %8.0f %10.0f %10.0f\n", format.name, reference, oneThread, allThreads);
+	}
+
+	for (int i = 3; i < argc; ++i)
+		ok = CheckFile(argv[i], threads) && ok;
+
+	return ok ? 0 : 1;
+}
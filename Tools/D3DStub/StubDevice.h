@@ -0,0 +1,286 @@
+#pragma once
+//A stand-in for a Direct3D 11 device, implementing the interfaces in this folder's d3d11_1.h, so the loader can be run
+//where there's no Direct3D. Buffers and 2D textures are kept in memory, a tightly packed copy of each subresource, and
+//UpdateSubresource, CopySubresourceRegion, CopyResource and Map work on them as they would on a real device, so what the
+//loader uploads can be read back and checked. Nothing is drawn, and 1D and 3D textures can't be created. Every object
+//counts itself, so a check can see that everything the loader made was released.
+#include "d3d11_1.h"
+#include "DDSFormat.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace StubD3D
+{
+	//Objects made and not yet released, the device and its context included
+	inline std::atomic<int>& LiveObjects()
+	{
+		static std::atomic<int> count(0);
+		return count;
+	}
+
+	template<typename Interface>
+	class Object : public Interface
+	{
+	private:
+		std::atomic<ULONG> _references;
+
+	protected:
+		//Whether QueryInterface can give out this object as riid
+		virtual bool Is(REFIID riid) const { return riid == IID_IUnknown; }
+
+	public:
+		Object() : _references(1) { ++LiveObjects(); }
+		virtual ~Object() { --LiveObjects(); }
+
+		HRESULT QueryInterface(REFIID riid, void** ppvObject) override
+		{
+			if (!Is(riid))
+			{
+				*ppvObject = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			AddRef();
+			*ppvObject = this;
+			return S_OK;
+		}
+
+		ULONG AddRef() override { return ++_references; }
+
+		ULONG Release() override
+		{
+			ULONG references = --_references;
+			if (references == 0)
+				delete this;
+
+			return references;
+		}
+	};
+
+	template<typename Interface>
+	class Child : public Object<Interface>
+	{
+	public:
+		HRESULT SetPrivateData(REFGUID, UINT, const void*) override { return S_OK; }
+	};
+
+	//What buffers and textures have in common, each subresource with its rows packed one after another
+	class Storage
+	{
+	public:
+		std::vector<std::vector<uint8_t>> subresources;
+		std::vector<UINT> rowBytes;
+		std::vector<UINT> rows;			//Of every depth slice together
+
+		void Add(size_t rowSize, size_t rowCount)
+		{
+			subresources.emplace_back(rowSize * rowCount);
+			rowBytes.push_back((UINT)rowSize);
+			rows.push_back((UINT)rowCount);
+		}
+
+		void Write(UINT subresource, const void* data, UINT rowPitch)
+		{
+			const uint8_t* source = (const uint8_t*)data;
+
+			//A buffer's pitch means nothing, it's all one row
+			if (rowPitch < rowBytes[subresource])
+				rowPitch = rowBytes[subresource];
+
+			for (UINT row = 0; row < rows[subresource]; ++row)
+				memcpy(&subresources[subresource][row * rowBytes[subresource]], source + (size_t)row * rowPitch, rowBytes[subresource]);
+		}
+
+		virtual ~Storage() {}
+	};
+
+	class Buffer : public Child<ID3D11Buffer>, public Storage
+	{
+	private:
+		D3D11_BUFFER_DESC _desc;
+
+	protected:
+		bool Is(REFIID riid) const override { return riid == IID_ID3D11Buffer || riid == IID_ID3D11Resource || riid == IID_IUnknown; }
+
+	public:
+		Buffer(const D3D11_BUFFER_DESC& desc) : _desc(desc) { Add(desc.ByteWidth, 1); }
+
+		void GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) override { *pResourceDimension = D3D11_RESOURCE_DIMENSION_BUFFER; }
+		void GetDesc(D3D11_BUFFER_DESC* pDesc) override { *pDesc = _desc; }
+	};
+
+	class Texture2D : public Child<ID3D11Texture2D>, public Storage
+	{
+	private:
+		D3D11_TEXTURE2D_DESC _desc;
+
+	protected:
+		bool Is(REFIID riid) const override { return riid == IID_ID3D11Texture2D || riid == IID_ID3D11Resource || riid == IID_IUnknown; }
+
+	public:
+		Texture2D(const D3D11_TEXTURE2D_DESC& desc) : _desc(desc)
+		{
+			//0 asks for every mip down to 1 x 1
+			if (_desc.MipLevels == 0)
+			{
+				for (UINT size = std::max(desc.Width, desc.Height); size > 0; size /= 2)
+					++_desc.MipLevels;
+			}
+
+			for (UINT slice = 0; slice < _desc.ArraySize; ++slice)
+			{
+				for (UINT mip = 0; mip < _desc.MipLevels; ++mip)
+				{
+					size_t rowSize, rowCount;
+					DirectX::GetSurfaceInfo(std::max(1u, _desc.Width >> mip), std::max(1u, _desc.Height >> mip), _desc.Format, nullptr,
+											&rowSize, &rowCount);
+					Add(rowSize, rowCount);
+				}
+			}
+		}
+
+		void GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) override { *pResourceDimension = D3D11_RESOURCE_DIMENSION_TEXTURE2D; }
+		void GetDesc(D3D11_TEXTURE2D_DESC* pDesc) override { *pDesc = _desc; }
+	};
+
+	class ShaderResourceView : public Child<ID3D11ShaderResourceView>
+	{
+	private:
+		ID3D11Resource* _resource;
+		D3D11_SHADER_RESOURCE_VIEW_DESC _desc;
+
+	public:
+		ShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC& desc) : _resource(resource), _desc(desc)
+		{
+			_resource->AddRef();
+		}
+
+		~ShaderResourceView() { _resource->Release(); }
+
+		void GetResource(ID3D11Resource** ppResource) override
+		{
+			_resource->AddRef();
+			*ppResource = _resource;
+		}
+
+		void GetDesc(D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc) override { *pDesc = _desc; }
+	};
+
+	class DeviceContext : public Child<ID3D11DeviceContext>
+	{
+	public:
+		void UpdateSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX*, const void* pSrcData, UINT SrcRowPitch,
+							   UINT) override
+		{
+			dynamic_cast<Storage&>(*pDstResource).Write(DstSubresource, pSrcData, SrcRowPitch);
+		}
+
+		//Whole subresources only, which have to be the same size
+		void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT DstSubresource, UINT, UINT, UINT, ID3D11Resource* pSrcResource,
+								   UINT SrcSubresource, const D3D11_BOX*) override
+		{
+			Storage& destination = dynamic_cast<Storage&>(*pDstResource);
+			const Storage& source = dynamic_cast<const Storage&>(*pSrcResource);
+
+			if (destination.subresources[DstSubresource].size() == source.subresources[SrcSubresource].size())
+				destination.subresources[DstSubresource] = source.subresources[SrcSubresource];
+		}
+
+		void CopyResource(ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource) override
+		{
+			Storage& destination = dynamic_cast<Storage&>(*pDstResource);
+			const Storage& source = dynamic_cast<const Storage&>(*pSrcResource);
+
+			if (destination.rowBytes == source.rowBytes && destination.rows == source.rows)
+				destination.subresources = source.subresources;
+		}
+
+		void GenerateMips(ID3D11ShaderResourceView*) override {}
+
+		HRESULT Map(ID3D11Resource* pResource, UINT Subresource, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE* pMappedResource) override
+		{
+			Storage& storage = dynamic_cast<Storage&>(*pResource);
+
+			pMappedResource->pData = storage.subresources[Subresource].data();
+			pMappedResource->RowPitch = storage.rowBytes[Subresource];
+			pMappedResource->DepthPitch = storage.rowBytes[Subresource] * storage.rows[Subresource];
+			return S_OK;
+		}
+
+		void Unmap(ID3D11Resource*, UINT) override {}
+	};
+
+	class Device : public Object<ID3D11Device>
+	{
+	private:
+		DeviceContext* _context;
+
+	public:
+		Device() : _context(new DeviceContext()) {}
+		~Device() { _context->Release(); }
+
+		HRESULT CreateBuffer(const D3D11_BUFFER_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Buffer** ppBuffer) override
+		{
+			Buffer* buffer = new Buffer(*pDesc);
+
+			if (pInitialData)
+				buffer->Write(0, pInitialData->pSysMem, 0);
+
+			*ppBuffer = buffer;
+			return S_OK;
+		}
+
+		HRESULT CreateTexture1D(const D3D11_TEXTURE1D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture1D** ppTexture1D) override
+		{
+			*ppTexture1D = nullptr;
+			return E_NOTIMPL;
+		}
+
+		HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture2D** ppTexture2D) override
+		{
+			Texture2D* texture = new Texture2D(*pDesc);
+
+			//One for every subresource, as Direct3D expects
+			for (size_t i = 0; pInitialData && i < texture->subresources.size(); ++i)
+				texture->Write((UINT)i, pInitialData[i].pSysMem, pInitialData[i].SysMemPitch);
+
+			*ppTexture2D = texture;
+			return S_OK;
+		}
+
+		HRESULT CreateTexture3D(const D3D11_TEXTURE3D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture3D** ppTexture3D) override
+		{
+			*ppTexture3D = nullptr;
+			return E_NOTIMPL;
+		}
+
+		HRESULT CreateShaderResourceView(ID3D11Resource* pResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+										 ID3D11ShaderResourceView** ppSRView) override
+		{
+			if (!pDesc)
+			{
+				*ppSRView = nullptr;
+				return E_INVALIDARG;
+			}
+
+			*ppSRView = new ShaderResourceView(pResource, *pDesc);
+			return S_OK;
+		}
+
+		//Nothing, so DDSTextureLoader never tries to make mips on the GPU
+		HRESULT CheckFormatSupport(DXGI_FORMAT, UINT* pFormatSupport) override
+		{
+			*pFormatSupport = 0;
+			return S_OK;
+		}
+
+		D3D_FEATURE_LEVEL GetFeatureLevel() override { return D3D_FEATURE_LEVEL_11_0; }
+
+		void GetImmediateContext(ID3D11DeviceContext** ppImmediateContext) override
+		{
+			_context->AddRef();
+			*ppImmediateContext = _context;
+		}
+	};
+}
@@ -0,0 +1,299 @@
+#pragma once
+//Just enough of Direct3D 11 for AssetLoader, OBJLoader and DDSTextureLoader to build where there's no Windows: the
+//types, constants and methods of the interfaces they use, with the same names and values as d3d11.h. Nothing here does
+//anything, StubDevice.h implements the interfaces
+#include "windows.h"
+#include <dxgiformat.h>
+
+#define D3D11_REQ_MIP_LEVELS 15
+#define D3D11_REQ_TEXTURE1D_ARRAY_AXIS_DIMENSION 2048
+#define D3D11_REQ_TEXTURE1D_U_DIMENSION 16384
+#define D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION 2048
+#define D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION 16384
+#define D3D11_REQ_TEXTURE3D_U_V_OR_W_DIMENSION 2048
+#define D3D11_REQ_TEXTURECUBE_DIMENSION 16384
+
+enum D3D_FEATURE_LEVEL
+{
+	D3D_FEATURE_LEVEL_9_1 = 0x9100,
+	D3D_FEATURE_LEVEL_9_2 = 0x9200,
+	D3D_FEATURE_LEVEL_9_3 = 0x9300,
+	D3D_FEATURE_LEVEL_10_0 = 0xa000,
+	D3D_FEATURE_LEVEL_10_1 = 0xa100,
+	D3D_FEATURE_LEVEL_11_0 = 0xb000,
+	D3D_FEATURE_LEVEL_11_1 = 0xb100
+};
+
+enum D3D11_USAGE
+{
+	D3D11_USAGE_DEFAULT = 0,
+	D3D11_USAGE_IMMUTABLE = 1,
+	D3D11_USAGE_DYNAMIC = 2,
+	D3D11_USAGE_STAGING = 3
+};
+
+enum D3D11_BIND_FLAG
+{
+	D3D11_BIND_VERTEX_BUFFER = 0x1,
+	D3D11_BIND_INDEX_BUFFER = 0x2,
+	D3D11_BIND_CONSTANT_BUFFER = 0x4,
+	D3D11_BIND_SHADER_RESOURCE = 0x8,
+	D3D11_BIND_RENDER_TARGET = 0x20
+};
+
+enum D3D11_CPU_ACCESS_FLAG
+{
+	D3D11_CPU_ACCESS_WRITE = 0x10000,
+	D3D11_CPU_ACCESS_READ = 0x20000
+};
+
+enum D3D11_RESOURCE_MISC_FLAG
+{
+	D3D11_RESOURCE_MISC_GENERATE_MIPS = 0x1,
+	D3D11_RESOURCE_MISC_TEXTURECUBE = 0x4
+};
+
+enum D3D11_FORMAT_SUPPORT
+{
+	D3D11_FORMAT_SUPPORT_MIP_AUTOGEN = 0x80000
+};
+
+enum D3D11_RESOURCE_DIMENSION
+{
+	D3D11_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D11_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D11_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D11_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D11_RESOURCE_DIMENSION_TEXTURE3D = 4
+};
+
+enum D3D_SRV_DIMENSION
+{
+	D3D_SRV_DIMENSION_UNKNOWN = 0,
+	D3D_SRV_DIMENSION_BUFFER = 1,
+	D3D_SRV_DIMENSION_TEXTURE1D = 2,
+	D3D_SRV_DIMENSION_TEXTURE1DARRAY = 3,
+	D3D_SRV_DIMENSION_TEXTURE2D = 4,
+	D3D_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+	D3D_SRV_DIMENSION_TEXTURE2DMS = 6,
+	D3D_SRV_DIMENSION_TEXTURE2DMSARRAY = 7,
+	D3D_SRV_DIMENSION_TEXTURE3D = 8,
+	D3D_SRV_DIMENSION_TEXTURECUBE = 9,
+	D3D_SRV_DIMENSION_TEXTURECUBEARRAY = 10,
+
+	D3D11_SRV_DIMENSION_UNKNOWN = D3D_SRV_DIMENSION_UNKNOWN,
+	D3D11_SRV_DIMENSION_BUFFER = D3D_SRV_DIMENSION_BUFFER,
+	D3D11_SRV_DIMENSION_TEXTURE1D = D3D_SRV_DIMENSION_TEXTURE1D,
+	D3D11_SRV_DIMENSION_TEXTURE1DARRAY = D3D_SRV_DIMENSION_TEXTURE1DARRAY,
+	D3D11_SRV_DIMENSION_TEXTURE2D = D3D_SRV_DIMENSION_TEXTURE2D,
+	D3D11_SRV_DIMENSION_TEXTURE2DARRAY = D3D_SRV_DIMENSION_TEXTURE2DARRAY,
+	D3D11_SRV_DIMENSION_TEXTURE2DMS = D3D_SRV_DIMENSION_TEXTURE2DMS,
+	D3D11_SRV_DIMENSION_TEXTURE2DMSARRAY = D3D_SRV_DIMENSION_TEXTURE2DMSARRAY,
+	D3D11_SRV_DIMENSION_TEXTURE3D = D3D_SRV_DIMENSION_TEXTURE3D,
+	D3D11_SRV_DIMENSION_TEXTURECUBE = D3D_SRV_DIMENSION_TEXTURECUBE,
+	D3D11_SRV_DIMENSION_TEXTURECUBEARRAY = D3D_SRV_DIMENSION_TEXTURECUBEARRAY
+};
+
+typedef D3D_SRV_DIMENSION D3D11_SRV_DIMENSION;
+
+enum D3D11_MAP
+{
+	D3D11_MAP_READ = 1,
+	D3D11_MAP_WRITE = 2,
+	D3D11_MAP_READ_WRITE = 3,
+	D3D11_MAP_WRITE_DISCARD = 4,
+	D3D11_MAP_WRITE_NO_OVERWRITE = 5
+};
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+struct D3D11_BOX
+{
+	UINT left;
+	UINT top;
+	UINT front;
+	UINT right;
+	UINT bottom;
+	UINT back;
+};
+
+struct D3D11_SUBRESOURCE_DATA
+{
+	const void* pSysMem;
+	UINT SysMemPitch;
+	UINT SysMemSlicePitch;
+};
+
+struct D3D11_MAPPED_SUBRESOURCE
+{
+	void* pData;
+	UINT RowPitch;
+	UINT DepthPitch;
+};
+
+struct D3D11_BUFFER_DESC
+{
+	UINT ByteWidth;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+	UINT StructureByteStride;
+};
+
+struct D3D11_TEXTURE1D_DESC
+{
+	UINT Width;
+	UINT MipLevels;
+	UINT ArraySize;
+	DXGI_FORMAT Format;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_TEXTURE2D_DESC
+{
+	UINT Width;
+	UINT Height;
+	UINT MipLevels;
+	UINT ArraySize;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_TEXTURE3D_DESC
+{
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT MipLevels;
+	DXGI_FORMAT Format;
+	D3D11_USAGE Usage;
+	UINT BindFlags;
+	UINT CPUAccessFlags;
+	UINT MiscFlags;
+};
+
+struct D3D11_TEX1D_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_TEX1D_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; };
+struct D3D11_TEX2D_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_TEX2D_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT FirstArraySlice; UINT ArraySize; };
+struct D3D11_TEX3D_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_TEXCUBE_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_TEXCUBE_ARRAY_SRV { UINT MostDetailedMip; UINT MipLevels; UINT First2DArrayFace; UINT NumCubes; };
+
+struct D3D11_SHADER_RESOURCE_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D11_SRV_DIMENSION ViewDimension;
+
+	union
+	{
+		D3D11_TEX1D_SRV Texture1D;
+		D3D11_TEX1D_ARRAY_SRV Texture1DArray;
+		D3D11_TEX2D_SRV Texture2D;
+		D3D11_TEX2D_ARRAY_SRV Texture2DArray;
+		D3D11_TEX3D_SRV Texture3D;
+		D3D11_TEXCUBE_SRV TextureCube;
+		D3D11_TEXCUBE_ARRAY_SRV TextureCubeArray;
+	};
+};
+
+inline UINT D3D11CalcSubresource(UINT mipSlice, UINT arraySlice, UINT mipLevels)
+{
+	return mipSlice + arraySlice * mipLevels;
+}
+
+struct IUnknown
+{
+	virtual HRESULT QueryInterface(REFIID riid, void** ppvObject) = 0;
+	virtual ULONG AddRef() = 0;
+	virtual ULONG Release() = 0;
+
+protected:
+	virtual ~IUnknown() {}
+};
+
+struct ID3D11DeviceChild : IUnknown
+{
+	virtual HRESULT SetPrivateData(REFGUID guid, UINT dataSize, const void* pData) = 0;
+};
+
+struct ID3D11Resource : ID3D11DeviceChild
+{
+	virtual void GetType(D3D11_RESOURCE_DIMENSION* pResourceDimension) = 0;
+};
+
+struct ID3D11Buffer : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_BUFFER_DESC* pDesc) = 0;
+};
+
+struct ID3D11Texture1D : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_TEXTURE1D_DESC* pDesc) = 0;
+};
+
+struct ID3D11Texture2D : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_TEXTURE2D_DESC* pDesc) = 0;
+};
+
+struct ID3D11Texture3D : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_TEXTURE3D_DESC* pDesc) = 0;
+};
+
+struct ID3D11View : ID3D11DeviceChild
+{
+	virtual void GetResource(ID3D11Resource** ppResource) = 0;
+};
+
+struct ID3D11ShaderResourceView : ID3D11View
+{
+	virtual void GetDesc(D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc) = 0;
+};
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+	virtual void UpdateSubresource(ID3D11Resource* pDstResource, UINT DstSubresource, const D3D11_BOX* pDstBox, const void* pSrcData,
+								   UINT SrcRowPitch, UINT SrcDepthPitch) = 0;
+	virtual void CopySubresourceRegion(ID3D11Resource* pDstResource, UINT DstSubresource, UINT DstX, UINT DstY, UINT DstZ,
+									   ID3D11Resource* pSrcResource, UINT SrcSubresource, const D3D11_BOX* pSrcBox) = 0;
+	virtual void CopyResource(ID3D11Resource* pDstResource, ID3D11Resource* pSrcResource) = 0;
+	virtual void GenerateMips(ID3D11ShaderResourceView* pShaderResourceView) = 0;
+	virtual HRESULT Map(ID3D11Resource* pResource, UINT Subresource, D3D11_MAP MapType, UINT MapFlags,
+						D3D11_MAPPED_SUBRESOURCE* pMappedResource) = 0;
+	virtual void Unmap(ID3D11Resource* pResource, UINT Subresource) = 0;
+};
+
+struct ID3D11Device : IUnknown
+{
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Buffer** ppBuffer) = 0;
+	virtual HRESULT CreateTexture1D(const D3D11_TEXTURE1D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture1D** ppTexture1D) = 0;
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture2D** ppTexture2D) = 0;
+	virtual HRESULT CreateTexture3D(const D3D11_TEXTURE3D_DESC* pDesc, const D3D11_SUBRESOURCE_DATA* pInitialData, ID3D11Texture3D** ppTexture3D) = 0;
+	virtual HRESULT CreateShaderResourceView(ID3D11Resource* pResource, const D3D11_SHADER_RESOURCE_VIEW_DESC* pDesc,
+											 ID3D11ShaderResourceView** ppSRView) = 0;
+	virtual HRESULT CheckFormatSupport(DXGI_FORMAT Format, UINT* pFormatSupport) = 0;
+	virtual D3D_FEATURE_LEVEL GetFeatureLevel() = 0;
+	virtual void GetImmediateContext(ID3D11DeviceContext** ppImmediateContext) = 0;
+};
+
+//The same values as the SDK gives them
+const IID IID_IUnknown = { 0x00000000, 0, 0, { 0xc0, 0, 0, 0, 0, 0, 0, 0x46 } };
+const IID IID_ID3D11Resource = { 0xdc8e63f3, 0xd12b, 0x4952, { 0xb4, 0x7b, 0x5e, 0x45, 0x02, 0x6a, 0x86, 0x2d } };
+const IID IID_ID3D11Buffer = { 0x48570b85, 0xd1ee, 0x4fcd, { 0xa2, 0x50, 0xeb, 0x35, 0x07, 0x22, 0xb0, 0x37 } };
+const IID IID_ID3D11Texture1D = { 0xf8fb5c27, 0xc6b3, 0x4f75, { 0xa4, 0xc8, 0x43, 0x9a, 0xf2, 0xef, 0x56, 0x4c } };
+const IID IID_ID3D11Texture2D = { 0x6f15aaf2, 0xd208, 0x4e89, { 0x9a, 0xb4, 0x48, 0x95, 0x35, 0xd3, 0x4f, 0x9c } };
+const IID IID_ID3D11Texture3D = { 0x037e866e, 0xf56d, 0x4357, { 0xa8, 0xaf, 0x9d, 0xab, 0xbe, 0x6e, 0x25, 0x0e } };
@@ -0,0 +1,124 @@
+#pragma once
+//Just enough of windows.h for AssetLoader, OBJLoader and DDSTextureLoader to build where there's no Windows, so
+//HotReloadCheck can run the real loader against the stand-in device in StubDevice.h. Never on the include path of the
+//game itself, or of anything built on Windows
+#include <chrono>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef int BOOL;
+typedef uint8_t BYTE;
+typedef uint16_t WORD;
+typedef uint32_t UINT;
+typedef int32_t INT;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef int32_t HRESULT;
+typedef void* LPVOID;
+
+union LARGE_INTEGER
+{
+	struct
+	{
+		DWORD LowPart;
+		LONG HighPart;
+	};
+	int64_t QuadPart;
+};
+
+struct GUID
+{
+	uint32_t Data1;
+	uint16_t Data2;
+	uint16_t Data3;
+	uint8_t Data4[8];
+};
+
+typedef GUID IID;
+typedef const GUID& REFGUID;
+typedef const IID& REFIID;
+
+inline bool operator==(const GUID& a, const GUID& b)
+{
+	return memcmp(&a, &b, sizeof(GUID)) == 0;
+}
+
+//Each interface's IID is declared as IID_<interface>, as the Windows SDK does, and this looks it up by name
+#define __uuidof(type) IID_##type
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_POINTER ((HRESULT)0x80004003)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFF)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define ERROR_HANDLE_EOF 38L
+#define ERROR_NOT_SUPPORTED 50L
+#define ERROR_INVALID_DATA 13L
+#define HRESULT_FROM_WIN32(x) ((HRESULT)(x) <= 0 ? ((HRESULT)(x)) : ((HRESULT)(((x) & 0x0000FFFF) | (7 << 16) | 0x80000000)))
+
+#define UNREFERENCED_PARAMETER(p) (void)(p)
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+
+//Source annotations, which only mean anything to Visual Studio's code analysis
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _In_reads_bytes_(size)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(size)
+#define _Outptr_
+#define _Outptr_opt_
+#define _Inout_
+#define _Use_decl_annotations_
+#define _Analysis_assume_(expression)
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = 1000000000;
+	return 1;
+}
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* count)
+{
+	count->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	return 1;
+}
+
+//There's no debugger to send it to, so it only goes anywhere if StubDebugOutput is turned on
+inline bool& StubDebugOutput()
+{
+	static bool enabled = false;
+	return enabled;
+}
+
+inline void OutputDebugStringA(const char* text)
+{
+	if (StubDebugOutput())
+		fputs(text, stderr);
+}
+
+template<size_t Size>
+int sprintf_s(char (&buffer)[Size], const char* format, ...)
+{
+	va_list arguments;
+	va_start(arguments, format);
+	int length = vsnprintf(buffer, Size, format, arguments);
+	va_end(arguments);
+
+	return length;
+}
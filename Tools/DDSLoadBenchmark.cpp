@@ -0,0 +1,420 @@
+//Times loading a large DDS texture array the way DDSTextureLoader used to, reading the whole file into the heap, against
+//the way it does now, mapping it with MappedFile, and reports how much memory each needed at its peak. Both check the
+//headers with GetDDSTextureInfo, lay out the subresources with FillSubresources and then copy every subresource into a
+//staging buffer one at a time, which is what the driver does with them when the texture is created. It writes its own
+//texture, so it only needs an empty directory. Nothing here needs Direct3D, so it runs on Linux too.
+//
+//A third way, stream, loads it the way AssetLoader::StreamTexture does: mapped without reading ahead, first with only
+//the mips no bigger than 64 x 64, then again with twice that each step until the last step keeps every mip, each step
+//uploading only the mip it adds, as the loader copies the ones it already has on the GPU. It's reported with how long it
+//took until the first, smallest, texture could be drawn and how many bytes of subresources all of its steps read between
+//them, against the bytes a single full load reads, which it should come to.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. DDSLoadBenchmark.cpp ..\DDSFormat.cpp ..\MappedFile.cpp
+//Build on Linux, with dxgiformat.h from https://github.com/microsoft/DirectX-Headers (include/directx):
+//	g++ -std=c++14 -O2 -I.. -I<DirectX-Headers>/include/directx DDSLoadBenchmark.cpp ../DDSFormat.cpp ../MappedFile.cpp -o DDSLoadBenchmark
+//
+//Usage: DDSLoadBenchmark <directory> [slices = 128] [size = 2048] [repeats = 3]
+//
+//The texture is a BC7 array of slices size x size slices with full mip chains, about 5.6 MB a slice at 2048, so the
+//default is about 700 MB and 800 slices takes it over 4 GB, which the old loader refused to load at all. Each run is in
+//a process of its own so its peak is its own. Peak resident memory counts the file's pages while they're mapped, but
+//those are the OS file cache's and can be dropped at any time. Private memory, which is what the heap copy costs and
+//has to be backed by the page file, is measured at the point where the whole texture has been uploaded, just before it
+//would be freed. Each way is timed with the file cold (not in the OS file cache, see README.md) and warm.
+#include "DDSFormat.h"
+#include "MappedFile.h"
+#include "ToolCommon.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	struct RunResult
+	{
+		bool loaded;
+		double milliseconds;
+		uint64_t peakResidentBytes;
+		uint64_t privateBytes;				//When the texture has been uploaded, before anything is freed
+		uint64_t checksum;					//Of what was uploaded, so copying it can't be optimized away
+
+		double firstMilliseconds;			//Until there was a texture to draw, which for a whole load is when it's done
+		uint64_t bytesRead;					//Of the subresources every step uploaded
+	};
+
+	const size_t FirstStreamMaxsize = 64;
+
+	std::string TextureFilename(const std::string& directory, unsigned int slices, unsigned int size)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "/array-bc7-%u-%u.dds", size, slices);
+		return directory + name;
+	}
+
+	uint64_t DataSize(unsigned int slices, unsigned int size, unsigned int& outMipCount)
+	{
+		uint64_t sliceBytes = 0;
+		outMipCount = 0;
+
+		for (unsigned int mip = size; mip > 0; mip /= 2, ++outMipCount)
+			sliceBytes += (uint64_t)((mip + 3) / 4) * ((mip + 3) / 4) * 16;
+
+		return sliceBytes * slices;
+	}
+
+	//A DX10 header, which BC7 and arrays both need. The contents are just a pattern, nothing decodes them
+	bool WriteTexture(const std::string& filename, unsigned int slices, unsigned int size)
+	{
+		unsigned int mipCount;
+		uint64_t dataSize = DataSize(slices, size, mipCount);
+
+		uint32_t header[37] = {};
+		header[0] = DirectX::DDS_MAGIC;
+		header[1] = sizeof(DirectX::DDS_HEADER);
+		header[2] = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000;
+		header[3] = size;
+		header[4] = size;
+		header[7] = mipCount;
+		header[19] = sizeof(DirectX::DDS_PIXELFORMAT);
+		header[20] = DDS_FOURCC;
+		header[21] = MAKEFOURCC('D', 'X', '1', '0');
+		header[27] = 0x1000 | 0x400000 | 0x8;		//Texture, mipmap, complex
+		header[32] = DXGI_FORMAT_BC7_UNORM;
+		header[33] = DirectX::DDS_DIMENSION_TEXTURE2D;
+		header[35] = slices;
+
+		FILE* file = fopen(filename.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+		std::vector<uint8_t> chunk(1 << 20);
+		for (size_t i = 0; i < chunk.size(); ++i)
+			chunk[i] = (uint8_t)(i * 31 + i / 4096);
+
+		for (uint64_t left = dataSize; written && left > 0;)
+		{
+			size_t count = (size_t)std::min<uint64_t>(left, chunk.size());
+			written = fwrite(chunk.data(), count, 1, file) == 1;
+			left -= count;
+		}
+
+		return fclose(file) == 0 && written;
+	}
+
+	uint64_t PeakResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+		struct rusage usage;
+		return getrusage(RUSAGE_SELF, &usage) == 0 ? (uint64_t)usage.ru_maxrss * 1024 : 0;
+#endif
+	}
+
+	uint64_t PrivateBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS_EX counters = {};
+		counters.cb = sizeof(counters);
+
+		return GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)) ? counters.PrivateUsage : 0;
+#else
+		//Resident anonymous memory, the heap and stacks, as opposed to pages of mapped files
+		FILE* status = fopen("/proc/self/status", "r");
+		if (!status)
+			return 0;
+
+		char line[256];
+		unsigned long long kilobytes = 0;
+
+		while (fgets(line, sizeof(line), status))
+		{
+			if (sscanf(line, "RssAnon: %llu kB", &kilobytes) == 1)
+				break;
+		}
+
+		fclose(status);
+		return kilobytes * 1024;
+#endif
+	}
+
+	//Everything after the file is in memory, the same for every way of getting it there. maxsize leaves out the mips
+	//bigger than it, as a streaming step does, and file is given to read what's kept ahead of copying it. residentMips is
+	//how many of the smallest a step already has, which aren't read again, and is set to how many it has afterwards
+	bool Upload(const uint8_t* ddsData, size_t ddsDataSize, RunResult& result, size_t maxsize = 0, const MappedFile* file = nullptr,
+				size_t* residentMips = nullptr)
+	{
+		DirectX::DDS_TEXTURE_INFO info;
+		if (!DirectX::GetDDSTextureInfo(ddsData, ddsDataSize, info))
+			return false;
+
+		std::unique_ptr<DirectX::DDS_SUBRESOURCE[]> subresources(new DirectX::DDS_SUBRESOURCE[info.mipCount * info.arraySize]);
+		size_t width, height, depth, skipMip;
+
+		size_t count = DirectX::FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, maxsize,
+												  ddsDataSize - info.dataOffset, ddsData + info.dataOffset, width, height, depth, skipMip,
+												  subresources.get());
+		if (!count)
+			return false;
+
+		//Each array slice's mips in turn, biggest first, the same as the loader works out which to read
+		size_t keptMips = info.mipCount - skipMip;
+		size_t newMips = residentMips && *residentMips < keptMips ? keptMips - *residentMips : keptMips;
+
+		if (residentMips)
+			*residentMips = keptMips;
+
+		if (file)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (i % keptMips < newMips)
+					file->Prefetch(subresources[i].data - ddsData, subresources[i].bytes);
+			}
+		}
+
+		//Only ever as big as the biggest subresource, the top mip
+		std::vector<uint8_t> staging(subresources[0].slicePitch);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (i % keptMips >= newMips)
+				continue;
+
+			result.bytesRead += subresources[i].bytes;
+			memcpy(staging.data(), subresources[i].data, subresources[i].slicePitch);
+			result.checksum += staging[subresources[i].slicePitch / 2];
+		}
+
+		result.privateBytes = PrivateBytes();
+		return true;
+	}
+
+	RunResult LoadRead(const std::string& filename)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+
+		FILE* file = fopen(filename.c_str(), "rb");
+		if (!file)
+			return result;
+
+#ifdef _WIN32
+		_fseeki64(file, 0, SEEK_END);
+		uint64_t size = (uint64_t)_ftelli64(file);
+		_fseeki64(file, 0, SEEK_SET);
+#else
+		fseeko(file, 0, SEEK_END);
+		uint64_t size = (uint64_t)ftello(file);
+		fseeko(file, 0, SEEK_SET);
+#endif
+
+		std::unique_ptr<uint8_t[]> ddsData(size <= (size_t)-1 ? new (std::nothrow) uint8_t[(size_t)size] : nullptr);
+		bool read = ddsData && fread(ddsData.get(), (size_t)size, 1, file) == 1;
+		fclose(file);
+
+		result.loaded = read && Upload(ddsData.get(), (size_t)size, result);
+		ddsData.reset();
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.firstMilliseconds = result.milliseconds;
+		result.peakResidentBytes = PeakResidentBytes();
+		return result;
+	}
+
+	RunResult LoadMapped(const std::string& filename)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+
+		MappedFile file;
+		result.loaded = file.Open(filename.c_str()) && Upload(file.getData(), file.getSize(), result);
+		file.Close();
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.firstMilliseconds = result.milliseconds;
+		result.peakResidentBytes = PeakResidentBytes();
+		return result;
+	}
+
+	//Each step maps the file again, as each is a request of its own in the loader, and only the last reads ahead
+	RunResult LoadStreamed(const std::string& filename)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+		size_t residentMips = 0;
+
+		for (size_t maxsize = FirstStreamMaxsize;; maxsize *= 2)
+		{
+			MappedFile file;
+			DirectX::DDS_TEXTURE_INFO info;
+
+			if (!file.Open(filename.c_str(), false) || !DirectX::GetDDSTextureInfo(file.getData(), file.getSize(), info))
+				return result;
+
+			//Once a step would keep every mip it's the last one, the same as PrepareTexture decides
+			bool last = info.mipCount <= 1 || maxsize >= std::max(info.width, std::max(info.height, info.depth));
+
+			if (!Upload(file.getData(), file.getSize(), result, last ? 0 : maxsize, &file, &residentMips))
+				return result;
+
+			if (result.firstMilliseconds == 0.0)
+				result.firstMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (last)
+				break;
+		}
+
+		result.loaded = true;
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		result.peakResidentBytes = PeakResidentBytes();
+		return result;
+	}
+
+	//Runs this program again to do one load, so the peak it reports is only that load's
+	bool RunChild(const char* program, const char* method, const std::string& filename, RunResult& outResult)
+	{
+		std::string command = std::string("\"") + program + "\" --run " + method + " \"" + filename + "\"";
+#ifdef _WIN32
+		//cmd.exe drops the first and last quote of the whole line
+		command = "\"" + command + "\"";
+#endif
+
+		FILE* child = popen(command.c_str(), "r");
+		if (!child)
+			return false;
+
+		int loaded = 0;
+		unsigned long long peakResidentBytes = 0, privateBytes = 0, checksum = 0, bytesRead = 0;
+		int fields = fscanf(child, "%d %lf %llu %llu %llu %lf %llu", &loaded, &outResult.milliseconds, &peakResidentBytes, &privateBytes, &checksum,
+							&outResult.firstMilliseconds, &bytesRead);
+
+		pclose(child);
+
+		outResult.loaded = fields == 7 && loaded;
+		outResult.peakResidentBytes = peakResidentBytes;
+		outResult.privateBytes = privateBytes;
+		outResult.checksum = checksum;
+		outResult.bytesRead = bytesRead;
+
+		return outResult.loaded;
+	}
+
+	void PrintResult(const char* label, const RunResult& result)
+	{
+		printf("%-14s %10.1f ms %10.1f ms %12.1f MB %12.1f MB %12.1f MB   checksum %llu\n", label, result.milliseconds, result.firstMilliseconds,
+			   result.peakResidentBytes / (1024.0 * 1024.0), result.privateBytes / (1024.0 * 1024.0), result.bytesRead / (1024.0 * 1024.0),
+			   (unsigned long long)result.checksum);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	//What RunChild runs
+	if (argc == 4 && strcmp(argv[1], "--run") == 0)
+	{
+		RunResult result = strcmp(argv[2], "map") == 0 ? LoadMapped(argv[3]) : strcmp(argv[2], "stream") == 0 ? LoadStreamed(argv[3]) : LoadRead(argv[3]);
+
+		printf("%d %f %llu %llu %llu %f %llu\n", result.loaded ? 1 : 0, result.milliseconds, (unsigned long long)result.peakResidentBytes,
+			   (unsigned long long)result.privateBytes, (unsigned long long)result.checksum, result.firstMilliseconds,
+			   (unsigned long long)result.bytesRead);
+		return result.loaded ? 0 : 1;
+	}
+
+	if (argc < 2)
+	{
+		printf("Usage: DDSLoadBenchmark <directory> [slices = 128] [size = 2048] [repeats = 3]\n");
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	unsigned int slices = argc > 2 ? (unsigned int)atoi(argv[2]) : 128;
+	unsigned int size = argc > 3 ? (unsigned int)atoi(argv[3]) : 2048;
+	int repeats = argc > 4 ? std::max(1, atoi(argv[4])) : 3;
+
+	std::string filename = TextureFilename(directory, slices, size);
+	unsigned int mipCount;
+	uint64_t fileBytes = DataSize(slices, size, mipCount) + sizeof(uint32_t) * 37;
+
+	FILE* existing = fopen(filename.c_str(), "rb");
+	if (existing)
+	{
+		fclose(existing);
+	}
+	else
+	{
+		printf("Writing %s (%.1f MB)...\n", filename.c_str(), fileBytes / (1024.0 * 1024.0));
+
+		if (!WriteTexture(filename, slices, size))
+		{
+			printf("Couldn't write %s\n", filename.c_str());
+			return 1;
+		}
+	}
+
+	printf("%u slices of %u x %u BC7 with %u mips, %.1f MB%s\n\n", slices, size, size, mipCount, fileBytes / (1024.0 * 1024.0),
+		   fileBytes > 0xFFFFFFFFull ? ", too big for the old loader" : "");
+	printf("%-14s %13s %13s %15s %15s %15s\n", "", "time", "first texture", "peak resident", "private", "bytes read");
+
+	const char* methods[3] = { "read", "map", "stream" };
+	RunResult fullLoad = {};
+	bool canEvict = EvictFromFileCache(filename);
+
+	for (int cold = canEvict ? 1 : 0; cold >= 0; --cold)
+	{
+		for (const char* method : methods)
+		{
+			RunResult best = {};
+			best.milliseconds = 1e30;
+
+			for (int i = 0; i < repeats; ++i)
+			{
+				if (cold)
+					EvictFromFileCache(filename);
+
+				RunResult result;
+				if (!RunChild(argv[0], method, filename, result))
+				{
+					printf("%s failed%s\n", method, strcmp(method, "read") == 0 ? ", probably out of memory" : "");
+					break;
+				}
+
+				if (result.milliseconds < best.milliseconds)
+					best = result;
+			}
+
+			if (best.loaded)
+				PrintResult((std::string(method) + (cold ? " cold" : " warm")).c_str(), best);
+
+			if (best.loaded && strcmp(method, "map") == 0)
+				fullLoad = best;
+		}
+	}
+
+	if (fullLoad.loaded)
+		printf("\nA full load reads %.1f MB of subresources\n", fullLoad.bytesRead / (1024.0 * 1024.0));
+
+	return 0;
+}
@@ -0,0 +1,480 @@
+//Checks hot reloading end to end, without a window: a FileWatcher watches a made up set of DDS textures and OBJ meshes
+//loaded by AssetLoader, the way Application::Initialise watches the game's assets, while one texture at a time is
+//edited. Each change FileWatcher reports is handed to AssetLoader::ReloadFile, as Application::HotReload does, and the
+//loader's own QueueReload, workers and swap in Create do the rest while this calls Update. Everything random is seeded,
+//so every run edits the same files the same way. Each edit is checked for:
+//	- being reported within a second, which is how long the game can take to notice at worst
+//	- being the only change reported, including for a while after, so no other asset is reloaded
+//	- the edited texture being swapped for a new version holding exactly what was written, read back from the device
+//	- every other asset keeping its version and the very same resources it had before the edit
+//Edits keep the texture the same size, and take turns between writing the file in place, writing it somewhere else and
+//renaming it over the old one (as many editors save), and writing it twice in quick succession, which has to come out as
+//the second write. Every other asset is watched and loaded as directory/./name rather than directory/name, so the same
+//folder is watched spelled two ways, and edits under either spelling have to be reported.
+//
+//On Windows the loader creates its resources on WARP, Direct3D's software rasterizer, so no GPU is needed. Elsewhere
+//it's built against the stand-in Windows and Direct3D headers in D3DStub, and creates them on StubDevice.h's device,
+//which keeps them in memory. There, once the loader has shut down, every resource it made, the versions a reload
+//replaced included, has to have been released. What isn't checked is anything Direct3D itself does with the resources.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. HotReloadCheck.cpp ..\AssetLoader.cpp ..\OBJLoader.cpp ..\DDSTextureLoader.cpp ..\FileWatcher.cpp
+//	   ..\AssetPack.cpp ..\MipGenerator.cpp ..\TextureResidency.cpp ..\DDSFormat.cpp ..\MappedFile.cpp ..\MeshCooker.cpp
+//	   ..\OBJParser.cpp ..\MeshOptimizer.cpp ..\MeshSimplifier.cpp ..\MeshletBuilder.cpp ..\VertexQuantizer.cpp
+//	   ..\BoundingVolumes.cpp ..\MeshCache.cpp ..\MeshCodec.cpp d3d11.lib
+//Build on Linux, with dxgiformat.h from https://github.com/microsoft/DirectX-Headers (include/directx) and the
+//DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -ID3DStub -I<DirectX-Headers>/include/directx -I<DirectXMath>/Inc HotReloadCheck.cpp
+//	    ../AssetLoader.cpp ../OBJLoader.cpp ../DDSTextureLoader.cpp ../FileWatcher.cpp ../AssetPack.cpp ../MipGenerator.cpp
+//	    ../TextureResidency.cpp ../DDSFormat.cpp ../MappedFile.cpp ../MeshCooker.cpp ../OBJParser.cpp ../MeshOptimizer.cpp
+//	    ../MeshSimplifier.cpp ../MeshletBuilder.cpp ../VertexQuantizer.cpp ../BoundingVolumes.cpp ../MeshCache.cpp
+//	    ../MeshCodec.cpp -pthread -o HotReloadCheck
+//
+//Usage: HotReloadCheck <directory> [edits = 30] [textures = 64] [meshes = 8]
+//
+//Prints how long each edit took to be reported and reloaded and a summary, and exits with 1 if any check failed.
+#include "AssetLoader.h"
+#include "FileWatcher.h"
+#include "DDSFormat.h"
+#ifndef _WIN32
+#include "StubDevice.h"
+#endif
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const uint32_t TextureSize = 256;
+	const unsigned int PollMilliseconds = 50;		//Only used if there's no inotify
+	const double TimeoutMilliseconds = 1000.0;
+
+	//Numerical Recipes' LCG, the same on every platform unlike rand()
+	struct Random
+	{
+		uint32_t state;
+
+		uint32_t Next()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		}
+
+		uint32_t Below(uint32_t n) { return Next() % n; }
+	};
+
+	struct Asset
+	{
+		std::string filename;
+		bool isTexture;
+		AssetHandle handle;
+		uint32_t seed;				//What its file was last written with
+	};
+
+	//What a check needs to tell whether an asset was touched
+	struct AssetState
+	{
+		unsigned int version;
+		const void* resource;		//The texture's view, or the mesh's vertex buffer
+	};
+
+	double Milliseconds()
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t Hash(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; ++i)
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+		return hash;
+	}
+
+	std::vector<uint8_t> MakeTexels(uint32_t seed)
+	{
+		std::vector<uint8_t> texels(TextureSize * TextureSize * 4);
+		Random random = { seed };
+
+		for (uint8_t& texel : texels)
+			texel = (uint8_t)random.Next();
+
+		return texels;
+	}
+
+	bool WriteFile(const std::string& filename, const std::vector<uint8_t>& contents)
+	{
+		FILE* file = fopen(filename.c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+		return fclose(file) == 0 && ok;
+	}
+
+	//An uncompressed RGBA texture with only its top mip, always the same size whatever the seed. The loader makes the
+	//rest with MipGenerator, and has to make them again from each edit rather than use the ones it saved before
+	bool WriteTexture(const std::string& filename, uint32_t seed)
+	{
+		DirectX::DDS_HEADER header = {};
+		header.size = sizeof(header);
+		header.flags = 0x1007;				//DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+		header.height = TextureSize;
+		header.width = TextureSize;
+		header.pitchOrLinearSize = TextureSize * 4;
+		header.mipMapCount = 1;
+		header.ddspf.size = sizeof(header.ddspf);
+		header.ddspf.flags = DDS_RGB;
+		header.ddspf.RGBBitCount = 32;
+		header.ddspf.RBitMask = 0x000000ff;
+		header.ddspf.GBitMask = 0x0000ff00;
+		header.ddspf.BBitMask = 0x00ff0000;
+		header.ddspf.ABitMask = 0xff000000;
+		header.caps = 0x1000;				//DDSCAPS_TEXTURE
+
+		std::vector<uint8_t> file(sizeof(uint32_t) + sizeof(header));
+		memcpy(file.data(), &DirectX::DDS_MAGIC, sizeof(uint32_t));
+		memcpy(file.data() + sizeof(uint32_t), &header, sizeof(header));
+
+		std::vector<uint8_t> texels = MakeTexels(seed);
+		file.insert(file.end(), texels.begin(), texels.end());
+
+		return WriteFile(filename, file);
+	}
+
+	//A small grid, different for each mesh so their contents can't be mixed up
+	bool WriteMesh(const std::string& filename, uint32_t seed)
+	{
+		std::string text;
+		char line[128];
+
+		for (unsigned int i = 0; i < 4; ++i)
+		{
+			snprintf(line, sizeof(line), "v %u %u %u\nvt %u %u\nvn 0 1 0\n", i & 1, seed, i >> 1, i & 1, i >> 1);
+			text += line;
+		}
+
+		text += "f 1/1/1 2/2/1 3/3/1\nf 2/2/1 4/4/1 3/3/1\n";
+		return WriteFile(filename, std::vector<uint8_t>(text.begin(), text.end()));
+	}
+
+	uint64_t ExpectedTexels(uint32_t seed)
+	{
+		std::vector<uint8_t> texels = MakeTexels(seed);
+		return Hash(texels.data(), texels.size());
+	}
+
+	//Hash of the top mip of the texture behind view, copied into a staging texture to read it back. 0 if it can't be read
+	uint64_t ReadTexels(ID3D11Device* device, ID3D11ShaderResourceView* view)
+	{
+		if (!view)
+			return 0;
+
+		ID3D11Resource* resource = nullptr;
+		ID3D11Texture2D* texture = nullptr;
+		ID3D11Texture2D* staging = nullptr;
+		ID3D11DeviceContext* context = nullptr;
+		uint64_t hash = 0;
+
+		view->GetResource(&resource);
+		device->GetImmediateContext(&context);
+
+		D3D11_TEXTURE2D_DESC desc;
+		if (SUCCEEDED(resource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&texture)))
+		{
+			texture->GetDesc(&desc);
+			desc.MipLevels = 1;
+			desc.ArraySize = 1;
+			desc.Usage = D3D11_USAGE_STAGING;
+			desc.BindFlags = 0;
+			desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+			desc.MiscFlags = 0;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mapped;
+		if (texture && desc.Width == TextureSize && desc.Height == TextureSize && SUCCEEDED(device->CreateTexture2D(&desc, nullptr, &staging)))
+		{
+			context->CopySubresourceRegion(staging, 0, 0, 0, 0, texture, 0, nullptr);
+
+			if (SUCCEEDED(context->Map(staging, 0, D3D11_MAP_READ, 0, &mapped)))
+			{
+				hash = 14695981039346656037ull;
+				for (UINT row = 0; row < desc.Height; ++row)
+					hash = Hash((const uint8_t*)mapped.pData + (size_t)row * mapped.RowPitch, desc.Width * 4, hash);
+
+				context->Unmap(staging, 0);
+			}
+
+			staging->Release();
+		}
+
+		if (texture) texture->Release();
+		context->Release();
+		resource->Release();
+
+		return hash;
+	}
+
+	//Written to a temporary file and renamed over the texture, the same way MeshCache::Save writes caches
+	bool ReplaceTexture(const std::string& filename, uint32_t seed)
+	{
+		std::string temporary = filename + ".tmp";
+		if (!WriteTexture(temporary, seed))
+			return false;
+
+		remove(filename.c_str());
+		return rename(temporary.c_str(), filename.c_str()) == 0;
+	}
+
+	AssetState getState(AssetLoader& loader, const Asset& asset)
+	{
+		AssetState state = { loader.getVersion(asset.handle), nullptr };
+		state.resource = asset.isTexture ? (const void*)loader.getTexture(asset.handle) : (const void*)loader.getMesh(asset.handle).VertexBuffer;
+
+		return state;
+	}
+
+	ID3D11Device* CreateDevice()
+	{
+#ifdef _WIN32
+		ID3D11Device* device = nullptr;
+		if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_WARP, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, &device, nullptr, nullptr)))
+			return nullptr;
+
+		return device;
+#else
+		return new StubD3D::Device();
+#endif
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: HotReloadCheck <directory> [edits = 30] [textures = 64] [meshes = 8]\n");
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	unsigned int edits = argc > 2 ? (unsigned int)atoi(argv[2]) : 30;
+	unsigned int textureCount = argc > 3 ? std::max(1, atoi(argv[3])) : 64;
+	unsigned int meshCount = argc > 4 ? (unsigned int)atoi(argv[4]) : 8;
+
+	ID3D11Device* device = CreateDevice();
+	if (!device)
+	{
+		printf("Couldn't create a device\n");
+		return 1;
+	}
+
+	AssetLoader loader;
+	loader.Init(device);
+
+	std::vector<Asset> assets;
+
+	for (unsigned int i = 0; i < textureCount + meshCount; ++i)
+	{
+		bool isTexture = i < textureCount;
+		char name[64];
+		snprintf(name, sizeof(name), isTexture ? "/texture%03u.dds" : "/mesh%03u.obj", isTexture ? i : i - textureCount);
+
+		Asset asset = { directory + (i % 2 ? "/." : "") + name, isTexture, InvalidAssetHandle, i + 1 };
+		if (!(isTexture ? WriteTexture(asset.filename, asset.seed) : WriteMesh(asset.filename, asset.seed)))
+		{
+			printf("Couldn't write %s\n", asset.filename.c_str());
+			return 1;
+		}
+
+		asset.handle = isTexture ? loader.LoadTexture(asset.filename.c_str()) : loader.LoadMesh(asset.filename.c_str());
+		assets.push_back(asset);
+	}
+
+	loader.WaitAll();
+
+	for (const Asset& asset : assets)
+	{
+		if (loader.getStatus(asset.handle) != AssetLoaded ||
+			(asset.isTexture && ReadTexels(device, loader.getTexture(asset.handle)) != ExpectedTexels(asset.seed)))
+		{
+			printf("Couldn't load %s\n", asset.filename.c_str());
+			return 1;
+		}
+	}
+
+	FileWatcher watcher;
+	for (const Asset& asset : assets)
+		watcher.Watch(asset.filename.c_str());
+
+	watcher.Start(PollMilliseconds);
+
+	printf("Watching %u textures and %u meshes %s\n", textureCount, meshCount,
+		   watcher.isNotified() ? "with inotify" : "by polling");
+
+	Random random = { 12345 };
+	unsigned int failures = 0;
+	double totalReportedMs = 0.0, totalReloadedMs = 0.0, slowestReloadedMs = 0.0, totalLoadMs = 0.0;
+
+	for (unsigned int edit = 0; edit < edits; ++edit)
+	{
+		Asset& target = assets[random.Below(textureCount)];
+		const char* how = edit % 3 == 0 ? "in place" : edit % 3 == 1 ? "renamed over" : "twice";
+
+		//From before the edit, which only the edited texture's should change from
+		std::vector<AssetState> before;
+		for (const Asset& asset : assets)
+			before.push_back(getState(loader, asset));
+
+		//The seeds never repeat, so an edit always changes the texels
+		target.seed = 1000 + edit * 2;
+		bool written = edit % 3 == 1 ? ReplaceTexture(target.filename, target.seed) : WriteTexture(target.filename, target.seed);
+
+		if (written && edit % 3 == 2)
+			written = WriteTexture(target.filename, ++target.seed);
+
+		double writtenTime = Milliseconds();
+
+		if (!written)
+		{
+			printf("Edit %u: couldn't write %s\n", edit, target.filename.c_str());
+			return 1;
+		}
+
+		//Hand whatever's reported to the loader, as Application::HotReload does, and let Update swap in what it's loaded
+		std::vector<std::string> reported;
+		double reportedMs = -1.0, reloadedMs = -1.0;
+		unsigned int targetVersion = before[&target - assets.data()].version;
+
+		auto reloadChanges = [&]()
+		{
+			for (const std::string& filename : watcher.TakeChanges())
+			{
+				if (filename == target.filename && reportedMs < 0.0)
+					reportedMs = Milliseconds() - writtenTime;
+
+				if (loader.ReloadFile(filename.c_str()) == 0)
+					printf("Edit %u: nothing was loaded from %s\n", edit, filename.c_str());
+
+				reported.push_back(filename);
+			}
+
+			loader.Update();
+
+			if (reloadedMs < 0.0 && loader.getVersion(target.handle) > targetVersion)
+				reloadedMs = Milliseconds() - writtenTime;
+		};
+
+		while (reloadedMs < 0.0 && Milliseconds() - writtenTime < TimeoutMilliseconds)
+		{
+			reloadChanges();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		//The second of two quick writes can be reported separately, and anything else reported late would still be a
+		//reload that shouldn't have happened
+		std::this_thread::sleep_for(std::chrono::milliseconds(PollMilliseconds * 3));
+		reloadChanges();
+		loader.WaitAll();
+
+		bool ok = true;
+		if (reportedMs < 0.0)
+		{
+			printf("Edit %u: %s wasn't reported within %.0f ms\n", edit, target.filename.c_str(), TimeoutMilliseconds);
+			ok = false;
+		}
+		else if (reloadedMs < 0.0)
+		{
+			printf("Edit %u: %s wasn't reloaded within %.0f ms\n", edit, target.filename.c_str(), TimeoutMilliseconds);
+			ok = false;
+		}
+
+		for (const std::string& filename : reported)
+		{
+			if (filename != target.filename)
+			{
+				printf("Edit %u: %s was reported, but only %s changed\n", edit, filename.c_str(), target.filename.c_str());
+				ok = false;
+			}
+		}
+
+		if (loader.getStatus(target.handle) != AssetLoaded || ReadTexels(device, loader.getTexture(target.handle)) != ExpectedTexels(target.seed))
+		{
+			printf("Edit %u: %s doesn't have what was written last\n", edit, target.filename.c_str());
+			ok = false;
+		}
+
+		//Every other asset should still have the very resources it had, and not have been reloaded
+		for (size_t i = 0; i < assets.size(); ++i)
+		{
+			const Asset& asset = assets[i];
+			AssetState after = getState(loader, asset);
+
+			if (&asset == &target)
+			{
+				if (after.version <= before[i].version || after.resource == before[i].resource)
+				{
+					printf("Edit %u: %s is still version %u\n", edit, asset.filename.c_str(), after.version);
+					ok = false;
+				}
+
+				continue;
+			}
+
+			if (after.version != before[i].version || after.resource != before[i].resource)
+			{
+				printf("Edit %u: %s went from version %u to %u, but its file wasn't edited\n", edit, asset.filename.c_str(), before[i].version,
+					   after.version);
+				ok = false;
+			}
+		}
+
+		if (!ok)
+		{
+			++failures;
+			continue;
+		}
+
+		//From ReloadFile until the swap, what the loader itself took
+		double loadMs = loader.getMetrics(target.handle).totalMs;
+
+		totalReportedMs += reportedMs;
+		totalReloadedMs += reloadedMs;
+		totalLoadMs += loadMs;
+		slowestReloadedMs = std::max(slowestReloadedMs, reloadedMs);
+
+		printf("Edit %2u: %s written %-12s reported after %6.2f ms, swapped in after %6.2f ms (loader %5.2f ms, version %u)\n", edit,
+			   target.filename.c_str() + directory.size() + 1, how, reportedMs, reloadedMs, loadMs, loader.getVersion(target.handle));
+	}
+
+	watcher.Stop();
+
+	unsigned int reloads = 0;
+	for (const Asset& asset : assets)
+		reloads += loader.getVersion(asset.handle) - 1;
+
+	loader.Shutdown();
+
+	unsigned int passed = edits - failures;
+	printf("%u of %u edits passed, %u reloads in all, reported after %.2f ms and swapped in after %.2f ms on average (the loader "
+		   "taking %.2f ms), %.2f ms at worst\n", passed, edits, reloads, passed ? totalReportedMs / passed : 0.0,
+		   passed ? totalReloadedMs / passed : 0.0, passed ? totalLoadMs / passed : 0.0, slowestReloadedMs);
+
+#ifndef _WIN32
+	//Just the device and its context, so every version a reload replaced was released
+	if (StubD3D::LiveObjects() != 2)
+	{
+		printf("%d resources were never released\n", StubD3D::LiveObjects() - 2);
+		++failures;
+	}
+#endif
+
+	device->Release();
+	return failures == 0 ? 0 : 1;
+}
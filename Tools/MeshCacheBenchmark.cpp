@@ -0,0 +1,286 @@
+//Times loading a large number of cooked meshes with MeshCache::Load (read into memory) against MeshCache::Map (zero copy),
+//with the files cold (not in the OS file cache, see README.md) and warm. It cooks its own meshes, so it only needs an
+//empty directory. Before timing anything it checks that both turn away a cache with an index, a base vertex or a meshlet
+//that points past the last vertex, and still take one whose largest index is the last vertex, and exits with 1 if not.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. MeshCacheBenchmark.cpp ..\MeshCache.cpp ..\MeshCodec.cpp ..\MappedFile.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc MeshCacheBenchmark.cpp ../MeshCache.cpp ../MeshCodec.cpp ../MappedFile.cpp -o MeshCacheBenchmark
+//
+//Usage: MeshCacheBenchmark <directory> [meshes = 1000] [vertices per mesh = 20000]
+#include "MeshCache.h"
+#include "ToolCommon.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct RunResult
+	{
+		double milliseconds;
+		uint64_t bytesCopied;
+		unsigned int failures;
+	};
+
+	std::string MeshFilename(const std::string& directory, unsigned int i, const char* extension)
+	{
+		char name[64];
+		snprintf(name, sizeof(name), "/mesh%04u%s", i, extension);
+		return directory + name;
+	}
+
+	//A wavy grid, so the vertices aren't all the same bytes
+	void MakeMesh(unsigned int vertexCount, unsigned int seed, CookedMesh& outMesh)
+	{
+		unsigned int side = 2;
+		while (side * side < vertexCount)
+			++side;
+
+		std::vector<SimpleVertex> vertices(side * side);
+		for (unsigned int y = 0; y < side; ++y)
+		{
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				SimpleVertex& v = vertices[y * side + x];
+				v.Pos = XMFLOAT3((float)x, (float)((x * 7 + y * 13 + seed) % 17) * 0.1f, (float)y);
+				v.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				v.TexC = XMFLOAT2((float)x / side, (float)y / side);
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		for (unsigned int y = 0; y + 1 < side; ++y)
+		{
+			for (unsigned int x = 0; x + 1 < side; ++x)
+			{
+				uint32_t i = y * side + x;
+				uint32_t quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		outMesh.info.vertexStride = sizeof(SimpleVertex);
+		outMesh.info.vertexCount = (uint32_t)vertices.size();
+		outMesh.info.indexSize = sizeof(uint32_t);
+		outMesh.info.indexCount = (uint32_t)indices.size();
+		outMesh.info.compactVertices = false;
+		outMesh.info.posScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
+		outMesh.info.posOffset = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+		outMesh.vertices.assign((const uint8_t*)vertices.data(), (const uint8_t*)(vertices.data() + vertices.size()));
+		outMesh.indices.assign((const uint8_t*)indices.data(), (const uint8_t*)(indices.data() + indices.size()));
+
+		MeshDrawRange range = { 0, outMesh.info.indexCount, 0 };
+		MeshLOD lod;
+		lod.DrawRanges.push_back(range);
+		lod.Error = 0.0f;
+		outMesh.lods.assign(1, lod);
+		outMesh.meshlets.clear();
+	}
+
+	RunResult LoadAll(const std::string& directory, unsigned int count, bool map)
+	{
+		RunResult result = {};
+		auto start = std::chrono::steady_clock::now();
+
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			std::string cacheFilename = MeshFilename(directory, i, ".meshcache");
+			std::string sourceFilename = MeshFilename(directory, i, ".obj");
+
+			if (map)
+			{
+				MappedFile file;
+				CookedMeshView view;
+
+				if (MeshCache::Map(cacheFilename.c_str(), sourceFilename.c_str(), 0, file, view) != MeshCacheValid)
+				{
+					++result.failures;
+					continue;
+				}
+
+				for (const MeshLOD& lod : view.lods)
+					result.bytesCopied += sizeof(MeshLOD) + lod.DrawRanges.size() * sizeof(MeshDrawRange);
+			}
+			else
+			{
+				CookedMesh mesh;
+
+				if (MeshCache::Load(cacheFilename.c_str(), sourceFilename.c_str(), 0, mesh) != MeshCacheValid)
+				{
+					++result.failures;
+					continue;
+				}
+
+				result.bytesCopied += mesh.vertices.size() + mesh.indices.size() + mesh.meshlets.size() * sizeof(Meshlet);
+
+				for (const MeshLOD& lod : mesh.lods)
+					result.bytesCopied += sizeof(MeshLOD) + lod.DrawRanges.size() * sizeof(MeshDrawRange);
+			}
+		}
+
+		result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	//Saves mesh, compressed or not, and whether Load and Map both give expected for it
+	bool LoadsAs(const std::string& directory, const CookedMesh& mesh, bool compress, MeshCacheStatus expected)
+	{
+		std::string cacheFilename = directory + "/bounds.meshcache";
+		MeshSourceInfo source = {};
+
+		if (!MeshCache::Save(cacheFilename.c_str(), mesh, source, 0, compress))
+			return false;
+
+		CookedMesh loaded;
+		MappedFile file;
+		CookedMeshView view;
+
+		bool same = MeshCache::Load(cacheFilename.c_str(), nullptr, 0, loaded) == expected &&
+					MeshCache::Map(cacheFilename.c_str(), nullptr, 0, file, view) == expected;
+
+		file.Close();
+		remove(cacheFilename.c_str());
+		return same;
+	}
+
+	bool CheckBounds(const std::string& directory)
+	{
+		CookedMesh valid;
+		MakeMesh(1000, 0, valid);
+
+		Meshlet meshlet = {};
+		meshlet.indexCount = valid.info.indexCount;
+		valid.meshlets.assign(1, meshlet);
+
+		CookedMesh pastIndex = valid;
+		uint32_t pastLast = valid.info.vertexCount;
+		memcpy(&pastIndex.indices[pastIndex.indices.size() / 2], &pastLast, sizeof(pastLast));
+		pastIndex.meshlets.clear();
+
+		CookedMesh pastBase = valid;
+		pastBase.lods[0].DrawRanges[0].BaseVertex = 1;
+		pastBase.meshlets.clear();
+
+		CookedMesh baseAtEnd = valid;
+		baseAtEnd.lods[0].DrawRanges[0].BaseVertex = (int)valid.info.vertexCount;
+		baseAtEnd.meshlets.clear();
+
+		//The draw range stops short of the bad index, so only the meshlet reads it
+		CookedMesh pastMeshlet = valid;
+		memcpy(&pastMeshlet.indices[pastMeshlet.indices.size() - sizeof(uint32_t)], &pastLast, sizeof(pastLast));
+		pastMeshlet.lods[0].DrawRanges[0].IndexCount -= 3;
+
+		bool passed = true;
+
+		for (int compress = 0; compress < 2; ++compress)
+		{
+			const char* encoding = compress ? "compressed" : "uncompressed";
+			bool results[5] = {
+				LoadsAs(directory, valid, compress != 0, MeshCacheValid),
+				LoadsAs(directory, pastIndex, compress != 0, MeshCacheCorrupt),
+				LoadsAs(directory, pastBase, compress != 0, MeshCacheCorrupt),
+				LoadsAs(directory, baseAtEnd, compress != 0, MeshCacheCorrupt),
+				LoadsAs(directory, pastMeshlet, compress != 0, MeshCacheCorrupt)
+			};
+			const char* names[5] = { "largest index the last vertex taken", "index past the last vertex refused", "base vertex pushing an index past it refused",
+									 "base vertex at the vertex count refused", "meshlet index past the last vertex refused" };
+
+			for (int i = 0; i < 5; ++i)
+			{
+				printf("%s, %s: %s\n", names[i], encoding, results[i] ? "yes" : "NO");
+				passed = passed && results[i];
+			}
+		}
+
+		return passed;
+	}
+
+	void Report(const char* name, const RunResult& result, unsigned int count, uint64_t totalBytes)
+	{
+		printf("%-12s %9.1f ms %8.1f us/mesh %8.1f MB/s %10.1f MB copied%s\n", name, result.milliseconds, result.milliseconds * 1000.0 / count,
+			   totalBytes / (1024.0 * 1024.0) / (result.milliseconds / 1000.0), result.bytesCopied / (1024.0 * 1024.0),
+			   result.failures ? " (some meshes failed to load)" : "");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: MeshCacheBenchmark <directory> [meshes = 1000] [vertices per mesh = 20000]\n");
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	unsigned int count = argc > 2 ? (unsigned int)atoi(argv[2]) : 1000;
+	unsigned int vertexCount = argc > 3 ? (unsigned int)atoi(argv[3]) : 20000;
+
+	if (!CheckBounds(directory))
+		return 1;
+
+	//Cook everything first, each with a tiny stand in for its source file
+	uint64_t totalBytes = 0;
+
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		std::string sourceFilename = MeshFilename(directory, i, ".obj");
+		FILE* source = fopen(sourceFilename.c_str(), "wb");
+
+		if (!source)
+		{
+			printf("Couldn't write %s\n", sourceFilename.c_str());
+			return 1;
+		}
+
+		fprintf(source, "# mesh %u\n", i);
+		fclose(source);
+
+		CookedMesh mesh;
+		MakeMesh(vertexCount, i, mesh);
+
+		MeshSourceInfo info;
+		std::string cacheFilename = MeshFilename(directory, i, ".meshcache");
+
+		if (!MeshCache::GetSourceInfo(sourceFilename.c_str(), info, true) || !MeshCache::Save(cacheFilename.c_str(), mesh, info, 0))
+		{
+			printf("Couldn't write %s\n", cacheFilename.c_str());
+			return 1;
+		}
+
+		MeshSourceInfo cacheInfo;
+		MeshCache::GetSourceInfo(cacheFilename.c_str(), cacheInfo, false);
+		totalBytes += cacheInfo.size;
+	}
+
+	printf("%u meshes, %.1f MB of cooked data\n", count, totalBytes / (1024.0 * 1024.0));
+
+	for (int map = 0; map < 2; ++map)
+	{
+		const char* name = map ? "Map" : "Load";
+		char label[32];
+
+		bool evicted = true;
+		for (unsigned int i = 0; i < count; ++i)
+			evicted = EvictFromFileCache(MeshFilename(directory, i, ".meshcache")) && evicted;
+
+		if (evicted)
+		{
+			snprintf(label, sizeof(label), "%s cold", name);
+			Report(label, LoadAll(directory, count, map != 0), count, totalBytes);
+		}
+
+		//The first pass warms the file cache
+		LoadAll(directory, count, map != 0);
+
+		snprintf(label, sizeof(label), "%s warm", name);
+		Report(label, LoadAll(directory, count, map != 0), count, totalBytes);
+	}
+
+	return 0;
+}
@@ -0,0 +1,291 @@
+//Checks that MeshCodec gives back exactly what it was given, and measures how small it makes vertices and indices and
+//how quickly they decode. It runs on the cooked meshes in any .meshcache files it's given (the source .obj has to be
+//next to each one) and on a large synthetic mesh, and exits with 1 if anything doesn't round trip.
+//
+//Decoding only pays for itself if reading the smaller file and decoding it beats reading the whole thing, so it also
+//writes each mesh out both ways in the current directory and times reading it back from disk, cold (see README.md) and
+//warm, against reading and decoding the encoded one.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. MeshCodecBenchmark.cpp ..\MeshCodec.cpp ..\MeshCache.cpp ..\MappedFile.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc MeshCodecBenchmark.cpp ../MeshCodec.cpp ../MeshCache.cpp ../MappedFile.cpp -o MeshCodecBenchmark
+//
+//Usage: MeshCodecBenchmark [synthetic vertices = 1000000] [file.meshcache...]
+#include "MeshCache.h"
+#include "MeshCodec.h"
+#include "ToolCommon.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const int DecodeRepeats = 10;
+
+	double Seconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//A wavy grid with 32-bit indices, laid out row by row like an optimized mesh would be
+	void MakeMesh(unsigned int vertexCount, CookedMesh& outMesh)
+	{
+		unsigned int side = 2;
+		while (side * side < vertexCount)
+			++side;
+
+		std::vector<SimpleVertex> vertices(side * side);
+		for (unsigned int y = 0; y < side; ++y)
+		{
+			for (unsigned int x = 0; x < side; ++x)
+			{
+				float height = sinf(x * 0.05f) * cosf(y * 0.07f);
+
+				SimpleVertex& v = vertices[y * side + x];
+				v.Pos = XMFLOAT3((float)x, height, (float)y);
+				v.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+				v.TexC = XMFLOAT2((float)x / side, (float)y / side);
+			}
+		}
+
+		std::vector<uint32_t> indices;
+		for (unsigned int y = 0; y + 1 < side; ++y)
+		{
+			for (unsigned int x = 0; x + 1 < side; ++x)
+			{
+				uint32_t i = y * side + x;
+				uint32_t quad[6] = { i, i + side, i + 1, i + 1, i + side, i + side + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		outMesh.info.vertexStride = sizeof(SimpleVertex);
+		outMesh.info.vertexCount = (uint32_t)vertices.size();
+		outMesh.info.indexSize = sizeof(uint32_t);
+		outMesh.info.indexCount = (uint32_t)indices.size();
+		outMesh.vertices.assign((const uint8_t*)vertices.data(), (const uint8_t*)(vertices.data() + vertices.size()));
+		outMesh.indices.assign((const uint8_t*)indices.data(), (const uint8_t*)(indices.data() + indices.size()));
+	}
+
+	bool WriteBoth(const char* filename, const std::vector<uint8_t>& first, const std::vector<uint8_t>& second)
+	{
+		FILE* file = fopen(filename, "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(first.data(), 1, first.size(), file) == first.size() && fwrite(second.data(), 1, second.size(), file) == second.size();
+		return fclose(file) == 0 && written;
+	}
+
+	bool ReadWhole(const char* filename, std::vector<uint8_t>& out)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (!file)
+			return false;
+
+		bool read = fread(out.data(), 1, out.size(), file) == out.size();
+		fclose(file);
+
+		return read;
+	}
+
+	//Reads the mesh as it is and as encoded from the files TimeLoads wrote, decoding the second, and returns both times
+	bool Load(const CookedMesh& mesh, size_t encodedVertexSize, size_t encodedIndexSize, double& outRawTime, double& outEncodedTime)
+	{
+		const CookedMeshInfo& info = mesh.info;
+		std::vector<uint8_t> raw(mesh.vertices.size() + mesh.indices.size());
+		std::vector<uint8_t> encoded(encodedVertexSize + encodedIndexSize);
+		std::vector<uint8_t> vertices(mesh.vertices.size()), indices(mesh.indices.size());
+
+		double start = Seconds();
+		bool loaded = ReadWhole("MeshCodecBenchmark.raw", raw);
+		outRawTime = Seconds() - start;
+
+		start = Seconds();
+		loaded = ReadWhole("MeshCodecBenchmark.encoded", encoded) &&
+				 MeshCodec::DecodeVertices(encoded.data(), encodedVertexSize, info.vertexCount, info.vertexStride, vertices.data()) &&
+				 MeshCodec::DecodeIndices(encoded.data() + encodedVertexSize, encodedIndexSize, info.indexCount, info.indexSize, indices.data()) && loaded;
+		outEncodedTime = Seconds() - start;
+
+		return loaded;
+	}
+
+	//Times whole loads from disk of the mesh as it is against encoded, cold where the files can be evicted and then warm
+	void TimeLoads(const CookedMesh& mesh, const std::vector<uint8_t>& encodedVertices, const std::vector<uint8_t>& encodedIndices)
+	{
+		if (!WriteBoth("MeshCodecBenchmark.raw", mesh.vertices, mesh.indices) || !WriteBoth("MeshCodecBenchmark.encoded", encodedVertices, encodedIndices))
+		{
+			printf("  couldn't write the files to time loading\n");
+			remove("MeshCodecBenchmark.raw");
+			remove("MeshCodecBenchmark.encoded");
+			return;
+		}
+
+		double rawTime, encodedTime;
+		bool loaded = true;
+
+		if (EvictFromFileCache("MeshCodecBenchmark.raw") && EvictFromFileCache("MeshCodecBenchmark.encoded"))
+		{
+			loaded = Load(mesh, encodedVertices.size(), encodedIndices.size(), rawTime, encodedTime);
+			printf("  cold load %8.2f ms as it is, %8.2f ms read and decoded (%.2fx)\n", rawTime * 1000.0, encodedTime * 1000.0, rawTime / encodedTime);
+		}
+
+		//Best of several once they're cached, as with decoding
+		double bestRawTime = 1e9, bestEncodedTime = 1e9;
+
+		for (int i = 0; i < DecodeRepeats; ++i)
+		{
+			loaded = Load(mesh, encodedVertices.size(), encodedIndices.size(), rawTime, encodedTime) && loaded;
+			bestRawTime = std::min(bestRawTime, rawTime);
+			bestEncodedTime = std::min(bestEncodedTime, encodedTime);
+		}
+
+		printf("  warm load %8.2f ms as it is, %8.2f ms read and decoded (%.2fx)%s\n", bestRawTime * 1000.0, bestEncodedTime * 1000.0,
+			   bestRawTime / bestEncodedTime, loaded ? "" : ", COULDN'T READ IT BACK");
+
+		remove("MeshCodecBenchmark.raw");
+		remove("MeshCodecBenchmark.encoded");
+	}
+
+	//Encodes, decodes and compares one mesh, returning false if it didn't come back the same
+	bool Run(const char* name, const CookedMesh& mesh)
+	{
+		const CookedMeshInfo& info = mesh.info;
+		std::vector<uint8_t> encodedVertices, encodedIndices;
+
+		double start = Seconds();
+		MeshCodec::EncodeVertices(mesh.vertices.data(), info.vertexCount, info.vertexStride, encodedVertices);
+		MeshCodec::EncodeIndices(mesh.indices.data(), info.indexCount, info.indexSize, encodedIndices);
+		double encodeTime = Seconds() - start;
+
+		std::vector<uint8_t> vertices(mesh.vertices.size()), indices(mesh.indices.size());
+		bool decoded = true;
+
+		//Best of several, as the machine being busy with something else only ever makes it slower
+		double vertexTime = 1e9, indexTime = 1e9;
+
+		for (int i = 0; i < DecodeRepeats; ++i)
+		{
+			start = Seconds();
+			decoded = MeshCodec::DecodeVertices(encodedVertices.data(), encodedVertices.size(), info.vertexCount, info.vertexStride, vertices.data()) && decoded;
+			vertexTime = std::min(vertexTime, Seconds() - start);
+
+			start = Seconds();
+			decoded = MeshCodec::DecodeIndices(encodedIndices.data(), encodedIndices.size(), info.indexCount, info.indexSize, indices.data()) && decoded;
+			indexTime = std::min(indexTime, Seconds() - start);
+		}
+
+		bool same = decoded && vertices == mesh.vertices && indices == mesh.indices;
+
+		//Anything cut short has to be turned away rather than decoded into garbage
+		bool truncatedRejected = (encodedVertices.empty() || !MeshCodec::DecodeVertices(encodedVertices.data(), encodedVertices.size() - 1, info.vertexCount, info.vertexStride, vertices.data())) &&
+								 (encodedIndices.empty() || !MeshCodec::DecodeIndices(encodedIndices.data(), encodedIndices.size() - 1, info.indexCount, info.indexSize, indices.data()));
+
+		printf("%s: %u vertices of %u bytes, %u %u-bit indices, encoded in %.1f ms%s%s\n", name, info.vertexCount, info.vertexStride,
+			   info.indexCount, info.indexSize * 8, encodeTime * 1000.0, same ? "" : ", DIDN'T ROUND TRIP", truncatedRejected ? "" : ", TRUNCATED DATA DECODED");
+		printf("  vertices %10zu -> %10zu bytes (%.2fx) decoded at %.2f GB/s\n", mesh.vertices.size(), encodedVertices.size(),
+			   (double)mesh.vertices.size() / encodedVertices.size(), mesh.vertices.size() / vertexTime / 1e9);
+		printf("  indices  %10zu -> %10zu bytes (%.2fx, %.2f bytes a triangle) decoded at %.2f GB/s\n", mesh.indices.size(), encodedIndices.size(),
+			   (double)mesh.indices.size() / encodedIndices.size(), encodedIndices.size() * 3.0 / info.indexCount, mesh.indices.size() / indexTime / 1e9);
+
+		TimeLoads(mesh, encodedVertices, encodedIndices);
+
+		return same && truncatedRejected;
+	}
+
+	//Random bytes and indices of awkward sizes, which compress badly and hit every block mode and escape
+	bool RunEdgeCases()
+	{
+		std::mt19937 random(1);
+		const size_t counts[] = { 0, 1, 15, 16, 17, 255, 256, 257, 1000 };
+		const size_t strides[] = { 1, 3, 4, 16, 32 };
+		bool passed = true;
+
+		for (size_t count : counts)
+		{
+			for (size_t stride : strides)
+			{
+				std::vector<uint8_t> vertices(count * stride);
+				for (uint8_t& byte : vertices)
+					byte = (uint8_t)random();
+
+				std::vector<uint32_t> indices(count * 3);
+				for (uint32_t& index : indices)
+					index = random() % (count + 1);
+
+				std::vector<uint8_t> encoded, decodedVertices(vertices.size());
+				MeshCodec::EncodeVertices(vertices.data(), count, stride, encoded);
+				passed = MeshCodec::DecodeVertices(encoded.data(), encoded.size(), count, stride, decodedVertices.data()) && decodedVertices == vertices && passed;
+
+				std::vector<uint32_t> decodedIndices(indices.size());
+				encoded.clear();
+				MeshCodec::EncodeIndices(indices.data(), indices.size(), sizeof(uint32_t), encoded);
+				passed = MeshCodec::DecodeIndices(encoded.data(), encoded.size(), indices.size(), sizeof(uint32_t), decodedIndices.data()) && decodedIndices == indices && passed;
+			}
+		}
+
+		printf("Edge cases %s\n", passed ? "round trip" : "DIDN'T ROUND TRIP");
+		return passed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int vertexCount = argc > 1 ? (unsigned int)atoi(argv[1]) : 1000000;
+	bool passed = RunEdgeCases();
+
+	CookedMesh synthetic;
+	MakeMesh(vertexCount, synthetic);
+	passed = Run("synthetic grid", synthetic) && passed;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		//Whatever settings the cache was cooked with are fine here, so take them from its own header
+		MeshCache::MeshCacheHeader header;
+		FILE* file = fopen(argv[i], "rb");
+		bool readHeader = file && fread(&header, sizeof(header), 1, file) == 1;
+
+		if (file)
+			fclose(file);
+
+		std::string sourceFilename = argv[i];
+		size_t extension = sourceFilename.rfind(".meshcache");
+
+		if (!readHeader || extension == std::string::npos)
+		{
+			printf("%s: not a .meshcache file\n", argv[i]);
+			passed = false;
+			continue;
+		}
+
+		sourceFilename.erase(extension);
+
+		//MeshCooker puts the settings hash in the name, before .meshcache
+		char settings[32];
+		snprintf(settings, sizeof(settings), ".%016llx", (unsigned long long)header.settingsHash);
+
+		if (sourceFilename.size() > strlen(settings) && sourceFilename.compare(sourceFilename.size() - strlen(settings), std::string::npos, settings) == 0)
+			sourceFilename.erase(sourceFilename.size() - strlen(settings));
+
+		CookedMesh mesh;
+		MeshCacheStatus status = MeshCache::Load(argv[i], sourceFilename.c_str(), header.settingsHash, mesh);
+
+		if (status != MeshCacheValid)
+		{
+			printf("%s: cache is %s\n", argv[i], MeshCache::getStatusName(status));
+			passed = false;
+			continue;
+		}
+
+		passed = Run(argv[i], mesh) && passed;
+	}
+
+	return passed ? 0 : 1;
+}
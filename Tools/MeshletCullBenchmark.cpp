@@ -0,0 +1,100 @@
+//Measures how much of a mesh MeshletCuller gets rid of and how long a cull takes, from the two cameras the game starts
+//with (Application::Initialise) looking at the mesh where the game first draws it, at the origin. The mesh is cooked
+//with buildMeshlets the way the game loads OBJ/torusKnot.obj, and exits with 1 if it can't be or has no meshlets.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. MeshletCullBenchmark.cpp ..\MeshletCuller.cpp ..\MeshCooker.cpp ..\OBJParser.cpp ..\MappedFile.cpp
+//	   ..\MeshOptimizer.cpp ..\MeshSimplifier.cpp ..\MeshletBuilder.cpp ..\VertexQuantizer.cpp ..\BoundingVolumes.cpp
+//	   ..\MeshCache.cpp ..\MeshCodec.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc MeshletCullBenchmark.cpp ../MeshletCuller.cpp ../MeshCooker.cpp
+//	    ../OBJParser.cpp ../MappedFile.cpp ../MeshOptimizer.cpp ../MeshSimplifier.cpp ../MeshletBuilder.cpp
+//	    ../VertexQuantizer.cpp ../BoundingVolumes.cpp ../MeshCache.cpp ../MeshCodec.cpp -pthread -o MeshletCullBenchmark
+//
+//Usage: MeshletCullBenchmark <file.obj, e.g. OBJ/torusKnot.obj from the game's folder> [culls = 1000]
+#include "MeshCooker.h"
+#include "MeshletCuller.h"
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+	struct CameraSetup
+	{
+		XMFLOAT3 eye;
+		XMFLOAT3 at;
+		XMFLOAT3 up;
+	};
+
+	//As in Application::Initialise, both in a 640 x 480 window
+	const CameraSetup Cameras[] =
+	{
+		{ XMFLOAT3(0.1f, 10.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
+		{ XMFLOAT3(0.0f, 0.0f, -3.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) },
+	};
+
+	const float WindowWidth = 640.0f;
+	const float WindowHeight = 480.0f;
+
+	//The matrices Camera::Update and Camera::Reshape make, without Camera.h and the Direct3D headers it brings in. The
+	//world matrix is the identity, so the camera is already in the mesh's model space
+	XMFLOAT4X4 ViewProjection(const CameraSetup& camera)
+	{
+		XMMATRIX view = XMMatrixLookAtLH(XMLoadFloat3(&camera.eye), XMLoadFloat3(&camera.at), XMLoadFloat3(&camera.up));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV2, WindowWidth / WindowHeight, 0.01f, 100.0f);
+
+		XMFLOAT4X4 viewProjection;
+		XMStoreFloat4x4(&viewProjection, view * projection);
+		return viewProjection;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: MeshletCullBenchmark <file.obj> [culls = 1000]\n");
+		return 1;
+	}
+
+	const char* filename = argv[1];
+	int culls = argc > 2 ? std::max(1, atoi(argv[2])) : 1000;
+
+	OBJLoadOptions options;
+	options.buildMeshlets = true;
+
+	CookedMesh cooked;
+	if (!MeshCooker::CookOBJ(filename, true, options, cooked) || cooked.meshlets.empty())
+	{
+		printf("%s: couldn't cook it into meshlets\n", filename);
+		return 1;
+	}
+
+	MeshletCuller culler;
+	culler.Init(cooked.meshlets);
+
+	std::vector<unsigned int> visible;
+
+	for (unsigned int i = 0; i < sizeof(Cameras) / sizeof(Cameras[0]); ++i)
+	{
+		XMFLOAT4X4 viewProjection = ViewProjection(Cameras[i]);
+		MeshletCullStats stats;
+
+		auto start = std::chrono::steady_clock::now();
+
+		//The torus knot is closed, so backfaces are culled as they are in the game
+		for (int j = 0; j < culls; ++j)
+			culler.Cull(viewProjection, Cameras[i].eye, true, visible, &stats);
+
+		double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / culls;
+
+		printf("Camera %u: %u of %u triangles rejected (%u outside the frustum, %u backfacing), %u of %u meshlets drawn, %.2f us per cull\n",
+			   i + 1, stats.triangles - stats.trianglesVisible, stats.triangles, stats.trianglesOutsideFrustum, stats.trianglesBackfacing,
+			   stats.meshletsVisible, stats.meshlets, microseconds);
+	}
+
+	return 0;
+}
@@ -0,0 +1,432 @@
+//Checks MipGenerator and measures how quickly it makes a full chain of mips for 4K and 8K textures, with each filter,
+//linear and sRGB, on one thread and on all of them. Before timing anything it checks that:
+//	- box filtered mips of a power of two texture are the average of the 2 x 2 texels above them, in linear light for
+//	  sRGB textures, to within the rounding of the last bit
+//	- a black and white checkerboard averages to mid grey, 128 in a linear texture and 188 in an sRGB one
+//	- a texture of one colour stays that colour with either filter, whatever its size, odd sizes included
+//	- the chain is exactly the same however many threads make it
+//	- GenerateDDS's file reads back with GetDDSTextureInfo and FillSubresources, every array slice with a full chain
+//Any DDS files it's given that MipGenerator::NeedsMips are made a chain too, and timed. It exits with 1 if anything fails.
+//
+//Build on Windows from a Developer Command Prompt in this folder (add /arch:AVX2 for the AVX rows):
+//	cl /O2 /EHsc /I.. MipGeneratorBenchmark.cpp ..\MipGenerator.cpp ..\MeshCache.cpp ..\MeshCodec.cpp ..\DDSFormat.cpp ..\MappedFile.cpp
+//Build on Linux, with dxgiformat.h from https://github.com/microsoft/DirectX-Headers (include/directx) and DirectXMath
+//(https://github.com/microsoft/DirectXMath, Inc) for MeshCache's headers:
+//	g++ -std=c++14 -O2 -mavx2 -pthread -I.. -I<DirectX-Headers>/include/directx -I<DirectXMath>/Inc MipGeneratorBenchmark.cpp ../MipGenerator.cpp ../MeshCache.cpp ../MeshCodec.cpp ../DDSFormat.cpp ../MappedFile.cpp -o MipGeneratorBenchmark
+//
+//Usage: MipGeneratorBenchmark [largest size = 8192, 0 to only check] [threads = one a core] [file.dds...]
+#include "MipGenerator.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const int GenerateRepeats = 3;
+
+	//The sizes timed start here and double up to the largest asked for
+	const size_t SmallestTimedSize = 4096;
+
+	double Seconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	//A full chain of mips, each tightly packed, with the top one filled in by whoever made it
+	struct Chain
+	{
+		size_t width;
+		size_t height;
+		std::vector<uint8_t> texels;
+		std::vector<uint8_t*> levels;
+
+		Chain(size_t chainWidth, size_t chainHeight) : width(chainWidth), height(chainHeight)
+		{
+			size_t count = MipGenerator::getMipCount(width, height);
+			std::vector<size_t> offsets(count);
+			size_t bytes = 0;
+
+			for (size_t mip = 0; mip < count; ++mip)
+			{
+				offsets[mip] = bytes;
+				bytes += getWidth(mip) * getHeight(mip) * 4;
+			}
+
+			texels.resize(bytes);
+
+			for (size_t mip = 0; mip < count; ++mip)
+				levels.push_back(texels.data() + offsets[mip]);
+		}
+
+		//levels point into texels, so a chain can be moved but not copied
+		Chain(const Chain&) = delete;
+		Chain(Chain&&) = default;
+
+		size_t getWidth(size_t mip) const { return std::max<size_t>(width >> mip, 1); }
+		size_t getHeight(size_t mip) const { return std::max<size_t>(height >> mip, 1); }
+		size_t getTopBytes() const { return width * height * 4; }
+
+		bool Generate(DXGI_FORMAT format, MipFilter filter, bool srgb, unsigned int threads)
+		{
+			MipOptions options;
+			options.filter = filter;
+			options.srgb = srgb;
+			options.threadCount = threads;
+
+			return MipGenerator::GenerateChain(format, width, height, levels.data(), levels.size(), options);
+		}
+	};
+
+	//Something with detail at every scale, so the filters have work to do: rings that get finer further out, a
+	//diagonal gradient and noise, with alpha ramping across
+	void MakeImage(Chain& chain)
+	{
+		uint8_t* texel = chain.levels[0];
+		double size = (double)std::max(chain.width, chain.height);
+		uint32_t state = 12345;
+
+		for (size_t y = 0; y < chain.height; ++y)
+		{
+			for (size_t x = 0; x < chain.width; ++x, texel += 4)
+			{
+				double dx = x - chain.width * 0.5;
+				double dy = y - chain.height * 0.5;
+				state = state * 1664525u + 1013904223u;
+
+				texel[0] = (uint8_t)(127.5 + 127.5 * cos((dx * dx + dy * dy) * 3.14159 / size));
+				texel[1] = (uint8_t)((x + y) * 255 / (chain.width + chain.height));
+				texel[2] = (uint8_t)(state >> 24);
+				texel[3] = (uint8_t)(x * 255 / chain.width);
+			}
+		}
+	}
+
+	double LinearFromSRGB(double value)
+	{
+		return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+	}
+
+	double SRGBFromLinear(double value)
+	{
+		return value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+	}
+
+	bool CheckBoxAverage(bool srgb)
+	{
+		Chain chain(256, 128);
+		MakeImage(chain);
+
+		if (!chain.Generate(DXGI_FORMAT_R8G8B8A8_UNORM, MipFilterBox, srgb, 1))
+			return false;
+
+		int worst = 0;
+
+		for (size_t mip = 1; mip < chain.levels.size(); ++mip)
+		{
+			const uint8_t* above = chain.levels[mip - 1];
+			size_t aboveWidth = chain.getWidth(mip - 1);
+			size_t aboveHeight = chain.getHeight(mip - 1);
+
+			for (size_t y = 0; y < chain.getHeight(mip); ++y)
+			{
+				for (size_t x = 0; x < chain.getWidth(mip); ++x)
+				{
+					for (int c = 0; c < 4; ++c)
+					{
+						bool decode = srgb && c < 3;
+						double sum = 0.0;
+						int count = 0;
+
+						for (size_t sy = y * 2; sy < std::min(y * 2 + 2, aboveHeight); ++sy)
+						{
+							for (size_t sx = x * 2; sx < std::min(x * 2 + 2, aboveWidth); ++sx, ++count)
+							{
+								double value = above[(sy * aboveWidth + sx) * 4 + c] / 255.0;
+								sum += decode ? LinearFromSRGB(value) : value;
+							}
+						}
+
+						double average = sum / count;
+						int expected = (int)floor((decode ? SRGBFromLinear(average) : average) * 255.0 + 0.5);
+						int made = chain.levels[mip][(y * chain.getWidth(mip) + x) * 4 + c];
+
+						worst = std::max(worst, abs(made - expected));
+					}
+				}
+			}
+		}
+
+		printf("Box filter %-6s  at most %d from the exact average\n", srgb ? "sRGB" : "linear", worst);
+		return worst <= 1;
+	}
+
+	bool CheckCheckerboard()
+	{
+		bool ok = true;
+
+		for (int srgb = 0; srgb < 2; ++srgb)
+		{
+			Chain chain(64, 64);
+
+			for (size_t i = 0; i < chain.getTopBytes(); ++i)
+				chain.levels[0][i] = ((i / 4 + i / 4 / chain.width) & 1) || i % 4 == 3 ? 255 : 0;
+
+			if (!chain.Generate(DXGI_FORMAT_B8G8R8A8_UNORM, MipFilterBox, srgb != 0, 1))
+				return false;
+
+			int expected = srgb ? 188 : 128;
+			bool grey = true;
+
+			for (size_t i = 0; i < chain.getWidth(1) * chain.getHeight(1) * 4; ++i)
+				grey = grey && chain.levels[1][i] == (i % 4 == 3 ? 255 : expected);
+
+			printf("Checkerboard %-6s  %3d, expected %d\n", srgb ? "sRGB" : "linear", chain.levels[1][0], expected);
+			ok = ok && grey;
+		}
+
+		return ok;
+	}
+
+	bool CheckConstant()
+	{
+		const size_t Sizes[][2] = { { 64, 64 }, { 1000, 600 }, { 333, 77 }, { 1, 9 }, { 17, 1 } };
+		const uint8_t Colour[4] = { 200, 13, 97, 255 };
+		bool ok = true;
+
+		for (const size_t* size : Sizes)
+		{
+			for (int filter = MipFilterBox; filter <= MipFilterKaiser; ++filter)
+			{
+				for (int srgb = 0; srgb < 2; ++srgb)
+				{
+					Chain chain(size[0], size[1]);
+
+					for (size_t i = 0; i < chain.getTopBytes(); ++i)
+						chain.levels[0][i] = Colour[i % 4];
+
+					bool constant = chain.Generate(DXGI_FORMAT_R8G8B8A8_UNORM, (MipFilter)filter, srgb != 0, 1);
+
+					for (size_t i = 0; constant && i < chain.texels.size(); ++i)
+						constant = chain.texels[i] == Colour[i % 4];
+
+					if (!constant)
+					{
+						printf("%zu x %zu %s %s doesn't stay one colour\n", size[0], size[1], filter == MipFilterBox ? "box" : "Kaiser",
+							   srgb ? "sRGB" : "linear");
+						ok = false;
+					}
+				}
+			}
+		}
+
+		printf("One colour stays one colour: %s\n", ok ? "yes" : "NO");
+		return ok;
+	}
+
+	bool CheckThreads(unsigned int threads)
+	{
+		//At least 3, so the bands are split up even on one core
+		threads = std::max(threads, 3u);
+		bool ok = true;
+
+		for (int filter = MipFilterBox; filter <= MipFilterKaiser; ++filter)
+		{
+			Chain one(1024, 768);
+			Chain several(1024, 768);
+			MakeImage(one);
+			MakeImage(several);
+
+			ok = one.Generate(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, (MipFilter)filter, false, 1) &&
+				 several.Generate(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, (MipFilter)filter, false, threads) &&
+				 one.texels == several.texels && ok;
+		}
+
+		printf("The same with 1 and %u threads: %s\n", threads, ok ? "yes" : "NO");
+		return ok;
+	}
+
+	//An array of two sRGB textures with a DX10 header, which GenerateDDS should give every slice its own chain
+	bool CheckDDS()
+	{
+		const size_t Width = 300;
+		const size_t Height = 200;
+		const size_t ArraySize = 2;
+
+		DirectX::DDS_HEADER header = {};
+		header.size = sizeof(header);
+		header.flags = 0x1007;				//DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+		header.height = Height;
+		header.width = Width;
+		header.pitchOrLinearSize = Width * 4;
+		header.ddspf.size = sizeof(header.ddspf);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+		header.caps = 0x1000;				//DDSCAPS_TEXTURE
+
+		DirectX::DDS_HEADER_DXT10 extension = {};
+		extension.dxgiFormat = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+		extension.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE2D;
+		extension.arraySize = ArraySize;
+
+		std::vector<uint8_t> source(sizeof(uint32_t) + sizeof(header) + sizeof(extension));
+		memcpy(source.data(), &DirectX::DDS_MAGIC, sizeof(uint32_t));
+		memcpy(source.data() + sizeof(uint32_t), &header, sizeof(header));
+		memcpy(source.data() + sizeof(uint32_t) + sizeof(header), &extension, sizeof(extension));
+
+		std::vector<Chain> slices;
+
+		for (size_t slice = 0; slice < ArraySize; ++slice)
+		{
+			slices.emplace_back(Width, Height);
+			MakeImage(slices[slice]);
+
+			//So the slices differ
+			slices[slice].levels[0][slice] ^= 0xFF;
+			source.insert(source.end(), slices[slice].levels[0], slices[slice].levels[0] + slices[slice].getTopBytes());
+			slices[slice].Generate(extension.dxgiFormat, MipFilterKaiser, false, 0);
+		}
+
+		std::vector<uint8_t> file;
+		DirectX::DDS_TEXTURE_INFO info;
+
+		if (!MipGenerator::GenerateDDS(source.data(), source.size(), file) || !DirectX::GetDDSTextureInfo(file.data(), file.size(), info))
+		{
+			printf("GenerateDDS's file doesn't read back\n");
+			return false;
+		}
+
+		size_t mipCount = MipGenerator::getMipCount(Width, Height);
+		std::vector<DirectX::DDS_SUBRESOURCE> subresources(mipCount * ArraySize);
+		size_t width, height, depth, skipMip;
+
+		bool ok = info.mipCount == mipCount && info.arraySize == ArraySize && info.dataOffset + info.dataSize == file.size() &&
+				  DirectX::FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, 0,
+											file.size() - info.dataOffset, file.data() + info.dataOffset, width, height, depth,
+											skipMip, subresources.data()) == subresources.size();
+
+		for (size_t slice = 0; ok && slice < ArraySize; ++slice)
+		{
+			for (size_t mip = 0; ok && mip < mipCount; ++mip)
+			{
+				const DirectX::DDS_SUBRESOURCE& subresource = subresources[slice * mipCount + mip];
+				size_t bytes = slices[slice].getWidth(mip) * slices[slice].getHeight(mip) * 4;
+
+				ok = subresource.bytes == bytes && memcmp(subresource.data, slices[slice].levels[mip], bytes) == 0;
+			}
+		}
+
+		printf("GenerateDDS's %zu x %zu array of %zu reads back with %zu mips each: %s\n", Width, Height, ArraySize, info.mipCount, ok ? "yes" : "NO");
+		return ok;
+	}
+
+	//Megapixels of the top mip a second, the best of GenerateRepeats
+	double Measure(Chain& chain, DXGI_FORMAT format, MipFilter filter, bool srgb, unsigned int threads)
+	{
+		double best = 1e30;
+
+		for (int i = 0; i < GenerateRepeats; ++i)
+		{
+			double start = Seconds();
+			chain.Generate(format, filter, srgb, threads);
+			best = std::min(best, Seconds() - start);
+		}
+
+		return chain.width * chain.height / best / 1e6;
+	}
+
+	bool TimeFile(const char* filename, unsigned int threads)
+	{
+		MappedFile file;
+		DirectX::DDS_TEXTURE_INFO info;
+
+		if (!file.Open(filename, true) || !DirectX::GetDDSTextureInfo(file.getData(), file.getSize(), info))
+		{
+			printf("%s: can't be read\n", filename);
+			return false;
+		}
+
+		if (!MipGenerator::NeedsMips(info))
+		{
+			printf("%s: has its mips already, or isn't a format MipGenerator supports\n", filename);
+			return true;
+		}
+
+		MipOptions options;
+		options.threadCount = threads;
+
+		std::vector<uint8_t> chain;
+		double start = Seconds();
+
+		if (!MipGenerator::GenerateDDS(file.getData(), file.getSize(), chain, options))
+		{
+			printf("%s: GenerateDDS failed\n", filename);
+			return false;
+		}
+
+		printf("%s: %zu x %zu, %zu mips in %.1f ms\n", filename, info.width, info.height, MipGenerator::getMipCount(info.width, info.height),
+			   (Seconds() - start) * 1000.0);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t largest = argc > 1 ? (size_t)atoi(argv[1]) : 8192;
+	unsigned int threads = argc > 2 ? (unsigned int)atoi(argv[2]) : 0;
+
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+#if defined(__AVX__)
+	const char* simd = "SSE2 and AVX";
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	const char* simd = "SSE2";
+#else
+	const char* simd = "no SIMD";
+#endif
+
+	printf("MipGenerator with %s, %u threads\n\n", simd, threads);
+
+	bool ok = CheckBoxAverage(false);
+	ok = CheckBoxAverage(true) && ok;
+	ok = CheckCheckerboard() && ok;
+	ok = CheckConstant() && ok;
+	ok = CheckThreads(threads) && ok;
+	ok = CheckDDS() && ok;
+
+	printf("%s\n", ok ? "Every check passed" : "FAILED");
+
+	for (size_t size = std::min(SmallestTimedSize, largest); size > 0 && size <= largest; size *= 2)
+	{
+		Chain chain(size, size);
+		MakeImage(chain);
+
+		printf("\nMegapixels a second making every mip of %zu x %zu (ms for the chain)\n", size, size);
+		printf("%-14s %16s %16s\n", "filter", "1 thread", "threads");
+
+		for (int filter = MipFilterBox; filter <= MipFilterKaiser; ++filter)
+		{
+			for (int srgb = 0; srgb < 2; ++srgb)
+			{
+				DXGI_FORMAT format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+				double oneThread = Measure(chain, format, (MipFilter)filter, false, 1);
+				double allThreads = Measure(chain, format, (MipFilter)filter, false, threads);
+				double megapixels = size * size / 1e6;
+
+				printf("%-6s %-7s %7.0f (%6.0f) %7.0f (%6.0f)\n", filter == MipFilterBox ? "box" : "Kaiser", srgb ? "sRGB" : "linear",
+					   oneThread, megapixels / oneThread * 1000.0, allThreads, megapixels / allThreads * 1000.0);
+			}
+		}
+	}
+
+	for (int i = 3; i < argc; ++i)
+		ok = TimeFile(argv[i], threads) && ok;
+
+	return ok ? 0 : 1;
+}
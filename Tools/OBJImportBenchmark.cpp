@@ -0,0 +1,888 @@
+//Measures how fast OBJ files are imported, end to end and one stage at a time, on synthetic meshes of a chosen size and
+//shape, and writes the results as JSON. Given the JSON from an earlier run as a baseline it exits with 1 if anything got
+//slower or started allocating more, so it can be run on every change to catch regressions.
+//
+//The meshes are flat grids like OBJ/flat plane.obj and tubes wound into a torus knot like OBJ/torusKnot.obj, written with
+//their positions, normals and texture coordinates shared between faces the way most exporters do, and unshared with
+//every corner given its own so welding has as much work as it can get. Sparse files share them too, but their faces take
+//turns leaving out the texture coordinate, the normal or both (f 1, f 1/2, f 1//3 and f 1/2/3), which the cooker fills
+//with zeros; their cook is checked against cooking them with streamingAssembly, which parses corners its own way. They're
+//generated into the directory the first time, and reused after that.
+//
+//The stages are the ones MeshCooker::CookOBJ goes through, done the same way: parse (OBJParser::ParseMappedParallel),
+//expand (one copy of the attributes per face corner), indices (MeshCooker::CreateIndices), then all of CookOBJ with the
+//default OBJLoadOptions, which is what OBJLoader does for a mesh without a cache. Last are writing the cache
+//(MeshCooker::Save) and loading the mesh from it (MeshCache::Map, reading every page), what OBJLoader does once there is
+//one. Each is run several times and the median kept, along with how far the runs strayed from it (the median of their
+//distances from it, which one slow run doesn't move). Files are warm in the OS file cache throughout.
+//
+//Every allocation goes through this file's operator new, which counts them and how many bytes were live at the peak of
+//each stage. The process's peak working set is reported too.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. OBJImportBenchmark.cpp ..\MeshCooker.cpp ..\OBJParser.cpp ..\MappedFile.cpp ..\MeshOptimizer.cpp
+//	   ..\MeshSimplifier.cpp ..\MeshletBuilder.cpp ..\VertexQuantizer.cpp ..\BoundingVolumes.cpp ..\MeshCache.cpp ..\MeshCodec.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc OBJImportBenchmark.cpp ../MeshCooker.cpp ../OBJParser.cpp ../MappedFile.cpp
+//	    ../MeshOptimizer.cpp ../MeshSimplifier.cpp ../MeshletBuilder.cpp ../VertexQuantizer.cpp ../BoundingVolumes.cpp
+//	    ../MeshCache.cpp ../MeshCodec.cpp -pthread -o OBJImportBenchmark
+//
+//Usage: OBJImportBenchmark <directory> [--triangles 1K,10K,100K,1M] [--shapes plane,knot] [--sharing shared,unshared,sparse]
+//                          [--repeats 7] [--json file] [--baseline file] [--tolerance 0.15] [--time-tolerance 0.5]
+//
+//Sizes can end in K or M. 10M triangles works, but the unshared files are several GB and cooking them needs as much
+//memory again, so it isn't in the defaults. The JSON goes to <directory>/OBJImportBenchmark.json unless --json is given.
+//A stage has regressed if it makes more allocations or has more bytes live at its peak than tolerance (as a fraction)
+//allows over the baseline, which don't change from run to run. Times do, so they get their own, looser time-tolerance,
+//and on top of that four times the spread of whichever of the two runs varied more, and half a millisecond since
+//shorter stages are mostly noise. A baseline from before spreads were recorded counts as having none. Something else
+//busy on the machine can still slow every run of a mesh down together, so a mesh with a stage that looks regressed is
+//run up to twice more, keeping each stage's quickest median, before it counts.
+#include "MeshCooker.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const double NoiseMilliseconds = 0.5;
+	const double SpreadsAllowed = 4.0;
+	const int Rechecks = 2;
+
+	//In front of every block, big enough to keep what follows it aligned for anything
+	const size_t AllocationHeader = 16;
+
+	std::atomic<uint64_t> AllocationCount(0);
+	std::atomic<uint64_t> LiveBytes(0);
+	std::atomic<uint64_t> PeakLiveBytes(0);
+
+	void* Allocate(size_t size)
+	{
+		uint8_t* block = (uint8_t*)malloc(size + AllocationHeader);
+		if (!block)
+			return nullptr;
+
+		*(size_t*)block = size;
+		++AllocationCount;
+
+		uint64_t live = LiveBytes += size;
+		uint64_t peak = PeakLiveBytes.load();
+
+		while (live > peak && !PeakLiveBytes.compare_exchange_weak(peak, live))
+		{
+		}
+
+		return block + AllocationHeader;
+	}
+
+	void Free(void* p)
+	{
+		if (!p)
+			return;
+
+		uint8_t* block = (uint8_t*)p - AllocationHeader;
+		LiveBytes -= *(size_t*)block;
+		free(block);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* p = Allocate(size);
+	if (!p)
+		throw std::bad_alloc();
+
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, size_t) noexcept { Free(p); }
+void operator delete[](void* p, size_t) noexcept { Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p); }
+
+namespace
+{
+	struct MeshCase
+	{
+		std::string name;				//e.g. knot-1000-shared, which is also its file name
+		std::string filename;
+		std::string shape;
+		std::string sharing;			//shared, unshared or sparse
+		uint64_t triangles;				//What it actually has, which is only near what was asked for
+		uint64_t fileBytes;
+	};
+
+	struct StageResult
+	{
+		std::string mesh;
+		std::string stage;
+		double milliseconds;			//The median run
+		double spreadMilliseconds;		//Median distance of the runs from that
+		uint64_t bytes;					//Of whatever the stage reads, the OBJ file or the cache
+		uint64_t triangles;
+		uint64_t allocations;
+		uint64_t peakHeapBytes;			//Live at the stage's peak, on top of what was live before it started
+
+		bool hasBaseline;
+		double baselineMilliseconds;
+		double baselineSpreadMilliseconds;
+		uint64_t baselineAllocations;
+		uint64_t baselinePeakHeapBytes;
+		bool regressed;
+	};
+
+	//A point on a surface and the normal there, for u and v from 0 to 1
+	typedef void (*Surface)(float u, float v, XMFLOAT3& outPosition, XMFLOAT3& outNormal);
+
+	void PlaneSurface(float u, float v, XMFLOAT3& outPosition, XMFLOAT3& outNormal)
+	{
+		outPosition = XMFLOAT3(u * 10.0f - 5.0f, 0.0f, v * 10.0f - 5.0f);
+		outNormal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	}
+
+	XMFLOAT3 Normalize(const XMFLOAT3& a)
+	{
+		float length = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z);
+		return XMFLOAT3(a.x / length, a.y / length, a.z / length);
+	}
+
+	XMFLOAT3 Cross(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMFLOAT3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	//A tube of radius 0.4 around the (2, 3) torus knot, u along the knot and v around the tube
+	void KnotSurface(float u, float v, XMFLOAT3& outPosition, XMFLOAT3& outNormal)
+	{
+		float t = u * 2.0f * XM_PI;
+		float r = cosf(3.0f * t) + 2.0f;
+
+		XMFLOAT3 center(r * cosf(2.0f * t), r * sinf(2.0f * t), -sinf(3.0f * t));
+		XMFLOAT3 tangent = Normalize(XMFLOAT3(-3.0f * sinf(3.0f * t) * cosf(2.0f * t) - 2.0f * r * sinf(2.0f * t),
+											  -3.0f * sinf(3.0f * t) * sinf(2.0f * t) + 2.0f * r * cosf(2.0f * t), -3.0f * cosf(3.0f * t)));
+		XMFLOAT3 binormal = Normalize(Cross(tangent, center));
+		XMFLOAT3 normal = Cross(binormal, tangent);
+
+		float a = v * 2.0f * XM_PI;
+		outNormal = XMFLOAT3(normal.x * cosf(a) + binormal.x * sinf(a), normal.y * cosf(a) + binormal.y * sinf(a), normal.z * cosf(a) + binormal.z * sinf(a));
+		outPosition = XMFLOAT3(center.x + 0.4f * outNormal.x, center.y + 0.4f * outNormal.y, center.z + 0.4f * outNormal.z);
+	}
+
+	//Writes rows x columns quads of surface as two triangles each. If wraps is set the last row and column of positions
+	//and normals are the first ones again, as on a tube, though texture coordinates never wrap. Sparse files are shared
+	//ones whose faces cycle through the four ways of writing a corner
+	bool WriteGridOBJ(const char* filename, unsigned int rows, unsigned int columns, bool wraps, const std::string& sharing, Surface surface)
+	{
+		FILE* file = fopen(filename, "wb");
+		if (!file)
+			return false;
+
+		static char buffer[1 << 20];
+		setvbuf(file, buffer, _IOFBF, sizeof(buffer));
+
+		unsigned int pointRows = wraps ? rows : rows + 1;
+		unsigned int pointColumns = wraps ? columns : columns + 1;
+
+		fprintf(file, "# %u x %u %s grid, %s attributes\n", rows, columns, wraps ? "wrapped" : "flat", sharing.c_str());
+
+		auto point = [&](unsigned int row, unsigned int column) { return (row % pointRows) * pointColumns + (column % pointColumns); };
+		auto texCoord = [&](unsigned int row, unsigned int column) { return row * (columns + 1) + column; };
+
+		//Corners of each quad's two triangles, as row and column offsets
+		const unsigned int corners[6][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 0, 1 }, { 1, 1 }, { 1, 0 } };
+
+		if (sharing != "unshared")
+		{
+			bool sparse = sharing == "sparse";
+			unsigned long long face = 0;
+
+			for (unsigned int row = 0; row < pointRows; ++row)
+			{
+				for (unsigned int column = 0; column < pointColumns; ++column)
+				{
+					XMFLOAT3 position, normal;
+					surface((float)row / rows, (float)column / columns, position, normal);
+					fprintf(file, "v %f %f %f\nvn %f %f %f\n", position.x, position.y, position.z, normal.x, normal.y, normal.z);
+				}
+			}
+
+			for (unsigned int row = 0; row <= rows; ++row)
+			{
+				for (unsigned int column = 0; column <= columns; ++column)
+					fprintf(file, "vt %f %f\n", (float)column / columns, (float)row / rows);
+			}
+
+			for (unsigned int row = 0; row < rows; ++row)
+			{
+				for (unsigned int column = 0; column < columns; ++column)
+				{
+					for (unsigned int triangle = 0; triangle < 2; ++triangle)
+					{
+						fputc('f', file);
+
+						for (unsigned int corner = 0; corner < 3; ++corner)
+						{
+							const unsigned int* offset = corners[triangle * 3 + corner];
+							unsigned int p = point(row + offset[0], column + offset[1]) + 1;
+							unsigned int t = texCoord(row + offset[0], column + offset[1]) + 1;
+
+							switch (sparse ? face % 4 : 3)
+							{
+							case 0: fprintf(file, " %u", p); break;
+							case 1: fprintf(file, " %u/%u", p, t); break;
+							case 2: fprintf(file, " %u//%u", p, p); break;
+							default: fprintf(file, " %u/%u/%u", p, t, p); break;
+							}
+						}
+
+						fputc('\n', file);
+						++face;
+					}
+				}
+			}
+		}
+		else
+		{
+			//Every triangle lists its own three corners just before it and points back at them
+			unsigned long long written = 0;
+
+			for (unsigned int row = 0; row < rows; ++row)
+			{
+				for (unsigned int column = 0; column < columns; ++column)
+				{
+					for (unsigned int triangle = 0; triangle < 2; ++triangle)
+					{
+						for (unsigned int corner = 0; corner < 3; ++corner)
+						{
+							const unsigned int* offset = corners[triangle * 3 + corner];
+							unsigned int cornerRow = row + offset[0];
+							unsigned int cornerColumn = column + offset[1];
+
+							//Wrapped corners take the first row or column's values, exactly as the shared file would
+							XMFLOAT3 position, normal;
+							surface((float)(cornerRow % pointRows) / rows, (float)(cornerColumn % pointColumns) / columns, position, normal);
+
+							fprintf(file, "v %f %f %f\nvn %f %f %f\nvt %f %f\n", position.x, position.y, position.z, normal.x, normal.y, normal.z,
+									(float)cornerColumn / columns, (float)cornerRow / rows);
+						}
+
+						fprintf(file, "f %llu/%llu/%llu %llu/%llu/%llu %llu/%llu/%llu\n", written + 1, written + 1, written + 1, written + 2, written + 2,
+								written + 2, written + 3, written + 3, written + 3);
+						written += 3;
+					}
+				}
+			}
+		}
+
+		bool ok = !ferror(file);
+		return fclose(file) == 0 && ok;
+	}
+
+	uint64_t FileSize(const std::string& filename)
+	{
+		MeshSourceInfo info;
+		return MeshCache::GetSourceInfo(filename.c_str(), info, false) ? info.size : 0;
+	}
+
+	//Generates the file unless it's already there, since big ones take a while to write
+	bool MakeMeshCase(const std::string& directory, const std::string& shape, uint64_t triangles, const std::string& sharing, MeshCase& outCase)
+	{
+		unsigned int rows, columns;
+		bool wraps = shape == "knot";
+
+		if (wraps)
+		{
+			//Long and thin like OBJ/torusKnot.obj, about eight times as many quads along the knot as around the tube
+			columns = std::max(8u, (unsigned int)(sqrt(triangles / 16.0) + 0.5));
+			rows = std::max(3u, (unsigned int)(triangles / (2.0 * columns) + 0.5));
+		}
+		else
+		{
+			rows = columns = std::max(1u, (unsigned int)(sqrt(triangles / 2.0) + 0.5));
+		}
+
+		char name[128];
+		snprintf(name, sizeof(name), "%s-%llu-%s", shape.c_str(), (unsigned long long)triangles, sharing.c_str());
+
+		outCase.name = name;
+		outCase.filename = directory + "/" + name + ".obj";
+		outCase.shape = shape;
+		outCase.sharing = sharing;
+		outCase.triangles = 2ull * rows * columns;
+		outCase.fileBytes = FileSize(outCase.filename);
+
+		if (outCase.fileBytes > 0)
+			return true;
+
+		printf("Writing %s...\n", outCase.filename.c_str());
+
+		if (!WriteGridOBJ(outCase.filename.c_str(), rows, columns, wraps, sharing, wraps ? KnotSurface : PlaneSurface))
+			return false;
+
+		outCase.fileBytes = FileSize(outCase.filename);
+		return outCase.fileBytes > 0;
+	}
+
+	double Median(std::vector<double> values)
+	{
+		std::sort(values.begin(), values.end());
+		size_t middle = values.size() / 2;
+
+		return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+	}
+
+	//Runs work repeats times, keeping the median time, the spread around it and the allocations of the last run. reset runs
+	//before each, outside what's measured, to free whatever the run before made so it isn't counted against this one
+	template<typename Reset, typename Work>
+	bool TimeStage(const MeshCase& mesh, const char* stage, uint64_t bytes, int repeats, Reset reset, Work work, std::vector<StageResult>& results)
+	{
+		StageResult result = {};
+		result.mesh = mesh.name;
+		result.stage = stage;
+		result.triangles = mesh.triangles;
+
+		std::vector<double> times;
+
+		for (int i = 0; i < repeats; ++i)
+		{
+			reset();
+
+			uint64_t allocationsBefore = AllocationCount;
+			uint64_t liveBefore = LiveBytes;
+			PeakLiveBytes = liveBefore;
+
+			auto start = std::chrono::steady_clock::now();
+			bool ok = work();
+			double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			if (!ok)
+			{
+				printf("%s: %s failed\n", mesh.name.c_str(), stage);
+				return false;
+			}
+
+			times.push_back(milliseconds);
+			result.allocations = AllocationCount - allocationsBefore;
+			result.peakHeapBytes = PeakLiveBytes - liveBefore;
+		}
+
+		result.milliseconds = Median(times);
+
+		for (double& time : times)
+			time = fabs(time - result.milliseconds);
+
+		result.spreadMilliseconds = Median(times);
+
+		//Cache sizes are only known once the stage has run. BenchmarkMesh cooks with the default options
+		result.bytes = bytes ? bytes : FileSize(MeshCooker::getCacheFilename(mesh.filename.c_str(), true, OBJLoadOptions()));
+
+		results.push_back(result);
+		return true;
+	}
+
+	bool BenchmarkMesh(const MeshCase& mesh, int repeats, std::vector<StageResult>& results)
+	{
+		const char* filename = mesh.filename.c_str();
+		const bool invertTexCoords = true;
+		OBJLoadOptions options;
+
+		OBJData data;
+		std::vector<XMFLOAT3> expandedVertices, expandedNormals;
+		std::vector<XMFLOAT2> expandedTexCoords;
+		CookedMesh cooked;
+
+		bool ok = TimeStage(mesh, "parse", mesh.fileBytes, repeats, [&]() { data = OBJData(); }, [&]()
+		{
+			return OBJParser::ParseMappedParallel(filename, data, invertTexCoords);
+		}, results);
+
+		//Grown one corner at a time without reserving, as CookOBJ does
+		ok = ok && TimeStage(mesh, "expand", mesh.fileBytes, repeats, [&]()
+		{
+			expandedVertices = std::vector<XMFLOAT3>();
+			expandedNormals = std::vector<XMFLOAT3>();
+			expandedTexCoords = std::vector<XMFLOAT2>();
+		}, [&]()
+		{
+			size_t numIndices = data.vertIndices.size();
+			for (size_t i = 0; i < numIndices; ++i)
+			{
+				unsigned int v = data.vertIndices[i];
+				unsigned int t = data.textureIndices[i];
+				unsigned int n = data.normalIndices[i];
+
+				expandedVertices.push_back(v < data.verts.size() ? data.verts[v] : XMFLOAT3(0.0f, 0.0f, 0.0f));
+				expandedTexCoords.push_back(t < data.texCoords.size() ? data.texCoords[t] : XMFLOAT2(0.0f, 0.0f));
+				expandedNormals.push_back(n < data.normals.size() ? data.normals[n] : XMFLOAT3(0.0f, 0.0f, 0.0f));
+			}
+
+			return true;
+		}, results);
+
+		ok = ok && TimeStage(mesh, "indices", mesh.fileBytes, repeats, []() {}, [&]()
+		{
+			std::vector<unsigned int> indices;
+			std::vector<XMFLOAT3> vertices, normals;
+			std::vector<XMFLOAT2> texCoords;
+
+			indices.reserve(expandedVertices.size());
+			vertices.reserve(expandedVertices.size());
+			normals.reserve(expandedNormals.size());
+			texCoords.reserve(expandedTexCoords.size());
+
+			MeshCooker::CreateIndices(expandedVertices, expandedTexCoords, expandedNormals, indices, vertices, texCoords, normals, options.weldEpsilon);
+			return indices.size() == expandedVertices.size();
+		}, results);
+
+		//The stages above are done with, and would only add to the peak of the ones below
+		data = OBJData();
+		expandedVertices = std::vector<XMFLOAT3>();
+		expandedNormals = std::vector<XMFLOAT3>();
+		expandedTexCoords = std::vector<XMFLOAT2>();
+
+		ok = ok && TimeStage(mesh, "cook", mesh.fileBytes, repeats, [&]() { cooked = CookedMesh(); }, [&]()
+		{
+			return MeshCooker::CookOBJ(filename, invertTexCoords, options, cooked);
+		}, results);
+
+		//Both ways of assembling corners have to fill in the ones a sparse file leaves out the same way
+		if (ok && mesh.sharing == "sparse")
+		{
+			OBJLoadOptions streamingOptions = options;
+			streamingOptions.streamingAssembly = true;
+
+			CookedMesh streamed;
+			if (!MeshCooker::CookOBJ(filename, invertTexCoords, streamingOptions, streamed) || streamed.vertices != cooked.vertices ||
+				streamed.indices != cooked.indices)
+			{
+				printf("%s: cooking with streamingAssembly made a different mesh\n", mesh.name.c_str());
+				return false;
+			}
+		}
+
+		ok = ok && TimeStage(mesh, "cacheWrite", 0, repeats, []() {}, [&]()
+		{
+			return MeshCooker::Save(filename, cooked, invertTexCoords, options);
+		}, results);
+
+		cooked = CookedMesh();
+		std::string cacheFilename = MeshCooker::getCacheFilename(filename, invertTexCoords, options);
+		uint64_t settingsHash = MeshCooker::SettingsHash(invertTexCoords, options);
+
+		ok = ok && TimeStage(mesh, "cacheRead", 0, repeats, []() {}, [&]()
+		{
+			MappedFile file;
+			CookedMeshView view;
+
+			if (MeshCache::Map(cacheFilename.c_str(), filename, settingsHash, file, view) != MeshCacheValid)
+				return false;
+
+			//Mapping is lazy, so read a byte of every page the way uploading the buffers would
+			volatile uint8_t sum = 0;
+			size_t vertexBytes = (size_t)view.info.vertexStride * view.info.vertexCount;
+			size_t indexBytes = (size_t)view.info.indexSize * view.info.indexCount;
+
+			for (size_t i = 0; i < vertexBytes; i += 4096)
+				sum += view.vertices[i];
+			for (size_t i = 0; i < indexBytes; i += 4096)
+				sum += view.indices[i];
+
+			return true;
+		}, results);
+
+		return ok;
+	}
+
+	uint64_t PeakWorkingSet()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+
+		return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+		struct rusage usage;
+		return getrusage(RUSAGE_SELF, &usage) == 0 ? (uint64_t)usage.ru_maxrss * 1024 : 0;
+#endif
+	}
+
+	//Splits "a,b,c" into its parts
+	std::vector<std::string> SplitList(const char* list)
+	{
+		std::vector<std::string> parts;
+		std::string part;
+
+		for (const char* c = list;; ++c)
+		{
+			if (*c == ',' || *c == 0)
+			{
+				if (!part.empty())
+					parts.push_back(part);
+
+				part.clear();
+
+				if (*c == 0)
+					return parts;
+			}
+			else
+			{
+				part += *c;
+			}
+		}
+	}
+
+	//1000, 1K or 1M
+	uint64_t ParseCount(const std::string& text)
+	{
+		char* end;
+		double count = strtod(text.c_str(), &end);
+
+		if (*end == 'k' || *end == 'K')
+			count *= 1000.0;
+		else if (*end == 'm' || *end == 'M')
+			count *= 1000000.0;
+
+		return (uint64_t)count;
+	}
+
+	//Just enough JSON to read back what WriteJSON writes, which puts each result on a line of its own
+	bool FindValue(const std::string& line, const char* key, std::string& outValue)
+	{
+		std::string quoted = std::string("\"") + key + "\":";
+		size_t at = line.find(quoted);
+
+		if (at == std::string::npos)
+			return false;
+
+		at += quoted.size();
+		while (at < line.size() && line[at] == ' ')
+			++at;
+
+		if (at < line.size() && line[at] == '"')
+		{
+			size_t end = line.find('"', at + 1);
+			outValue = line.substr(at + 1, end - at - 1);
+		}
+		else
+		{
+			size_t end = line.find_first_of(",}", at);
+			outValue = line.substr(at, end - at);
+		}
+
+		return true;
+	}
+
+	bool ReadBaseline(const char* filename, std::vector<StageResult>& results)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (!file)
+			return false;
+
+		std::map<std::string, StageResult*> byName;
+		for (StageResult& result : results)
+			byName[result.mesh + "/" + result.stage] = &result;
+
+		char buffer[4096];
+		while (fgets(buffer, sizeof(buffer), file))
+		{
+			std::string line = buffer, mesh, stage, milliseconds, spread, allocations, peakHeapBytes;
+
+			if (!FindValue(line, "mesh", mesh) || !FindValue(line, "stage", stage) || !FindValue(line, "ms", milliseconds) ||
+				!FindValue(line, "allocations", allocations) || !FindValue(line, "peakHeapBytes", peakHeapBytes))
+				continue;
+
+			auto found = byName.find(mesh + "/" + stage);
+			if (found == byName.end())
+				continue;
+
+			StageResult& result = *found->second;
+			result.hasBaseline = true;
+			result.baselineMilliseconds = atof(milliseconds.c_str());
+			result.baselineSpreadMilliseconds = FindValue(line, "spreadMs", spread) ? atof(spread.c_str()) : 0.0;
+			result.baselineAllocations = strtoull(allocations.c_str(), nullptr, 10);
+			result.baselinePeakHeapBytes = strtoull(peakHeapBytes.c_str(), nullptr, 10);
+		}
+
+		fclose(file);
+		return true;
+	}
+
+	unsigned int CheckRegressions(std::vector<StageResult>& results, double tolerance, double timeTolerance)
+	{
+		unsigned int regressions = 0;
+
+		for (StageResult& result : results)
+		{
+			if (!result.hasBaseline)
+				continue;
+
+			double spread = std::max(result.spreadMilliseconds, result.baselineSpreadMilliseconds);
+			double allowedMilliseconds = result.baselineMilliseconds * (1.0 + timeTolerance) + SpreadsAllowed * spread + NoiseMilliseconds;
+
+			result.regressed = result.milliseconds > allowedMilliseconds ||
+							   result.allocations > result.baselineAllocations * (1.0 + tolerance) ||
+							   result.peakHeapBytes > result.baselinePeakHeapBytes * (1.0 + tolerance);
+
+			if (result.regressed)
+				++regressions;
+		}
+
+		return regressions;
+	}
+
+	double PerSecond(double amount, double milliseconds)
+	{
+		return milliseconds > 0.0 ? amount / (milliseconds / 1000.0) : 0.0;
+	}
+
+	bool WriteJSON(const char* filename, const std::vector<MeshCase>& meshes, const std::vector<StageResult>& results, int repeats,
+				   double tolerance, double timeTolerance, const char* baseline, unsigned int regressions)
+	{
+		FILE* file = fopen(filename, "wb");
+		if (!file)
+			return false;
+
+		fprintf(file, "{\n  \"tool\": \"OBJImportBenchmark\",\n  \"format\": 3,\n  \"repeats\": %d,\n  \"tolerance\": %g,\n  \"timeTolerance\": %g,\n",
+				repeats, tolerance, timeTolerance);
+		fprintf(file, "  \"baseline\": %s%s%s,\n", baseline ? "\"" : "", baseline ? baseline : "null", baseline ? "\"" : "");
+		fprintf(file, "  \"peakWorkingSetBytes\": %llu,\n  \"meshes\": [\n", (unsigned long long)PeakWorkingSet());
+
+		for (size_t i = 0; i < meshes.size(); ++i)
+		{
+			const MeshCase& mesh = meshes[i];
+			fprintf(file, "    {\"mesh\": \"%s\", \"shape\": \"%s\", \"sharing\": \"%s\", \"triangles\": %llu, \"fileBytes\": %llu}%s\n", mesh.name.c_str(),
+					mesh.shape.c_str(), mesh.sharing.c_str(), (unsigned long long)mesh.triangles, (unsigned long long)mesh.fileBytes,
+					i + 1 < meshes.size() ? "," : "");
+		}
+
+		fprintf(file, "  ],\n  \"results\": [\n");
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const StageResult& result = results[i];
+
+			fprintf(file, "    {\"mesh\": \"%s\", \"stage\": \"%s\", \"ms\": %.4f, \"spreadMs\": %.4f, \"mbPerSecond\": %.2f, \"trianglesPerSecond\": %.0f, \"bytes\": %llu, "
+					"\"allocations\": %llu, \"peakHeapBytes\": %llu", result.mesh.c_str(), result.stage.c_str(), result.milliseconds,
+					result.spreadMilliseconds, PerSecond(result.bytes / (1024.0 * 1024.0), result.milliseconds), PerSecond((double)result.triangles, result.milliseconds),
+					(unsigned long long)result.bytes, (unsigned long long)result.allocations, (unsigned long long)result.peakHeapBytes);
+
+			if (result.hasBaseline)
+				fprintf(file, ", \"baselineMs\": %.4f, \"baselineSpreadMs\": %.4f, \"baselineAllocations\": %llu, \"baselinePeakHeapBytes\": %llu, \"regressed\": %s",
+						result.baselineMilliseconds, result.baselineSpreadMilliseconds, (unsigned long long)result.baselineAllocations, (unsigned long long)result.baselinePeakHeapBytes,
+						result.regressed ? "true" : "false");
+
+			fprintf(file, "}%s\n", i + 1 < results.size() ? "," : "");
+		}
+
+		fprintf(file, "  ],\n  \"regressions\": %u\n}\n", regressions);
+
+		bool ok = !ferror(file);
+		return fclose(file) == 0 && ok;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: OBJImportBenchmark <directory> [--triangles 1K,10K,100K,1M] [--shapes plane,knot] [--sharing shared,unshared,sparse]\n"
+			   "                          [--repeats 7] [--json file] [--baseline file] [--tolerance 0.15] [--time-tolerance 0.5]\n");
+		return 1;
+	}
+
+	std::string directory = argv[1];
+	std::vector<std::string> triangleCounts = SplitList("1K,10K,100K,1M");
+	std::vector<std::string> shapes = SplitList("plane,knot");
+	std::vector<std::string> sharing = SplitList("shared,unshared");
+	int repeats = 7;
+	std::string jsonFilename = directory + "/OBJImportBenchmark.json";
+	const char* baseline = nullptr;
+	double tolerance = 0.15;
+	double timeTolerance = 0.5;
+
+	for (int i = 2; i < argc; ++i)
+	{
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(argv[i], "--triangles") == 0 && hasValue)
+			triangleCounts = SplitList(argv[++i]);
+		else if (strcmp(argv[i], "--shapes") == 0 && hasValue)
+			shapes = SplitList(argv[++i]);
+		else if (strcmp(argv[i], "--sharing") == 0 && hasValue)
+			sharing = SplitList(argv[++i]);
+		else if (strcmp(argv[i], "--repeats") == 0 && hasValue)
+			repeats = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--json") == 0 && hasValue)
+			jsonFilename = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+			baseline = argv[++i];
+		else if (strcmp(argv[i], "--tolerance") == 0 && hasValue)
+			tolerance = atof(argv[++i]);
+		else if (strcmp(argv[i], "--time-tolerance") == 0 && hasValue)
+			timeTolerance = atof(argv[++i]);
+		else
+		{
+			printf("Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	for (const std::string& sharingName : sharing)
+	{
+		if (sharingName != "shared" && sharingName != "unshared" && sharingName != "sparse")
+		{
+			printf("Unknown sharing %s, there's shared, unshared and sparse\n", sharingName.c_str());
+			return 1;
+		}
+	}
+
+	std::vector<MeshCase> meshes;
+
+	for (const std::string& shape : shapes)
+	{
+		if (shape != "plane" && shape != "knot")
+		{
+			printf("Unknown shape %s, there's plane and knot\n", shape.c_str());
+			return 1;
+		}
+
+		for (const std::string& count : triangleCounts)
+		{
+			for (const std::string& sharingName : sharing)
+			{
+				MeshCase mesh;
+
+				if (!MakeMeshCase(directory, shape, ParseCount(count), sharingName, mesh))
+				{
+					printf("Couldn't write %s\n", mesh.filename.c_str());
+					return 1;
+				}
+
+				meshes.push_back(mesh);
+			}
+		}
+	}
+
+	std::vector<StageResult> results;
+
+	printf("%-24s %-10s %11s %10s %14s %12s %12s\n", "mesh", "stage", "ms", "MB/s", "triangles/s", "allocations", "peak heap MB");
+
+	for (const MeshCase& mesh : meshes)
+	{
+		size_t first = results.size();
+
+		if (!BenchmarkMesh(mesh, repeats, results))
+			return 1;
+
+		for (size_t i = first; i < results.size(); ++i)
+		{
+			const StageResult& result = results[i];
+
+			printf("%-24s %-10s %11.3f %10.1f %14.0f %12llu %12.1f\n", result.mesh.c_str(), result.stage.c_str(), result.milliseconds,
+				   PerSecond(result.bytes / (1024.0 * 1024.0), result.milliseconds), PerSecond((double)result.triangles, result.milliseconds),
+				   (unsigned long long)result.allocations, result.peakHeapBytes / (1024.0 * 1024.0));
+		}
+	}
+
+	unsigned int regressions = 0;
+
+	if (baseline)
+	{
+		if (!ReadBaseline(baseline, results))
+		{
+			printf("Couldn't read the baseline %s\n", baseline);
+			return 1;
+		}
+
+		regressions = CheckRegressions(results, tolerance, timeTolerance);
+
+		for (int recheck = 0; recheck < Rechecks && regressions; ++recheck)
+		{
+			for (const MeshCase& mesh : meshes)
+			{
+				bool regressed = false;
+				for (const StageResult& result : results)
+					regressed = regressed || (result.mesh == mesh.name && result.regressed);
+
+				if (!regressed)
+					continue;
+
+				printf("Running %s again to check it\n", mesh.name.c_str());
+
+				std::vector<StageResult> again;
+				if (!BenchmarkMesh(mesh, repeats, again))
+					return 1;
+
+				for (const StageResult& rerun : again)
+				{
+					for (StageResult& result : results)
+					{
+						if (result.mesh == rerun.mesh && result.stage == rerun.stage && rerun.milliseconds < result.milliseconds)
+						{
+							result.milliseconds = rerun.milliseconds;
+							result.spreadMilliseconds = rerun.spreadMilliseconds;
+						}
+					}
+				}
+			}
+
+			regressions = CheckRegressions(results, tolerance, timeTolerance);
+		}
+
+		for (const StageResult& result : results)
+		{
+			if (result.regressed)
+				printf("REGRESSED %s %s: %.3f ms +-%.3f (was %.3f +-%.3f), %llu allocations (was %llu), %llu bytes peak heap (was %llu)\n", result.mesh.c_str(),
+					   result.stage.c_str(), result.milliseconds, result.spreadMilliseconds, result.baselineMilliseconds,
+					   result.baselineSpreadMilliseconds, (unsigned long long)result.allocations,
+					   (unsigned long long)result.baselineAllocations, (unsigned long long)result.peakHeapBytes,
+					   (unsigned long long)result.baselinePeakHeapBytes);
+		}
+
+		printf("%u of %u stages regressed against %s\n", regressions, (unsigned int)results.size(), baseline);
+	}
+
+	printf("Peak working set %.1f MB\n", PeakWorkingSet() / (1024.0 * 1024.0));
+
+	if (!WriteJSON(jsonFilename.c_str(), meshes, results, repeats, tolerance, timeTolerance, baseline, regressions))
+	{
+		printf("Couldn't write %s\n", jsonFilename.c_str());
+		return 1;
+	}
+
+	printf("Results written to %s\n", jsonFilename.c_str());
+	return regressions ? 1 : 0;
+}
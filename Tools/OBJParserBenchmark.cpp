@@ -0,0 +1,173 @@
+//Checks that OBJParser::ParseMapped reads OBJ files exactly as the original ParseStream does, and measures how quickly
+//each of them gets through the files. Then ParseMappedParallel is run on each file with 1 thread, 2 and so on up to
+//--threads (one a core by default), checked against ParseMapped and timed, to show how well it scales. Exits with 1 if
+//any file can't be read or any two give different OBJData. Files under a megabyte a thread aren't split that many ways,
+//so the sweep needs big files.
+//
+//Any OBJ files will do. Both parsers read faces with any number of corners, and corners that leave out the texture
+//coordinate or normal or count back from the end, the same way. The files OBJImportBenchmark generates are big enough
+//to time, e.g. OBJParserBenchmark bench/*.obj.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. OBJParserBenchmark.cpp ..\OBJParser.cpp ..\MappedFile.cpp
+//Build on Linux, with the DirectXMath headers from https://github.com/microsoft/DirectXMath:
+//	g++ -std=c++14 -O2 -I.. -I<DirectXMath>/Inc OBJParserBenchmark.cpp ../OBJParser.cpp ../MappedFile.cpp -pthread -o OBJParserBenchmark
+//
+//Usage: OBJParserBenchmark [--repeats 3] [--threads N] file.obj...
+#include "OBJParser.h"
+#include <algorithm>
+#include <chrono>
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	typedef bool (*ParseFunction)(const char* filename, OBJData& data, bool invertTexCoords);
+
+	unsigned int ThreadCount = 1;
+
+	bool ParseParallel(const char* filename, OBJData& data, bool invertTexCoords)
+	{
+		return OBJParser::ParseMappedParallel(filename, data, invertTexCoords, ThreadCount);
+	}
+
+	//Compared bit for bit, so a float that parses to a different rounding counts
+	template<typename T>
+	bool SameList(const std::vector<T>& a, const std::vector<T>& b, const char* filename, const char* list, const char* against, const char* expected)
+	{
+		if (a.size() != b.size())
+		{
+			printf("%s: %s has %llu %s, %s has %llu\n", filename, against, (unsigned long long)a.size(), list, expected, (unsigned long long)b.size());
+			return false;
+		}
+
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (memcmp(&a[i], &b[i], sizeof(T)) != 0)
+			{
+				printf("%s: %s differs from %s at %s[%llu]\n", filename, against, expected, list, (unsigned long long)i);
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool SameData(const OBJData& data, const OBJData& expected, const char* filename, const char* against, const char* expectedName)
+	{
+		return SameList(data.verts, expected.verts, filename, "verts", against, expectedName) &&
+			   SameList(data.normals, expected.normals, filename, "normals", against, expectedName) &&
+			   SameList(data.texCoords, expected.texCoords, filename, "texCoords", against, expectedName) &&
+			   SameList(data.vertIndices, expected.vertIndices, filename, "vertIndices", against, expectedName) &&
+			   SameList(data.textureIndices, expected.textureIndices, filename, "textureIndices", against, expectedName) &&
+			   SameList(data.normalIndices, expected.normalIndices, filename, "normalIndices", against, expectedName);
+	}
+
+	//The quickest of repeats runs, in seconds, or a negative number if the file couldn't be read. data is from the last one
+	double TimeParse(ParseFunction parse, const char* filename, int repeats, OBJData& data)
+	{
+		double quickest = DBL_MAX;
+
+		for (int i = 0; i < repeats; ++i)
+		{
+			data = OBJData();
+
+			auto start = std::chrono::steady_clock::now();
+			if (!parse(filename, data, true))
+				return -1.0;
+
+			quickest = std::min(quickest, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		return quickest;
+	}
+
+	long long FileSize(const char* filename)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (!file)
+			return -1;
+
+		fseek(file, 0, SEEK_END);
+		long long size = ftell(file);
+		fclose(file);
+		return size;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int repeats = 3;
+	unsigned int maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	std::vector<const char*> filenames;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc)
+			repeats = std::max(1, atoi(argv[++i]));
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			maxThreads = std::max(1, atoi(argv[++i]));
+		else
+			filenames.push_back(argv[i]);
+	}
+
+	if (filenames.empty())
+	{
+		printf("Usage: OBJParserBenchmark [--repeats 3] [--threads N] file.obj...\n");
+		return 1;
+	}
+
+	bool passed = true;
+
+	printf("%-40s %10s %16s %16s %8s\n", "file", "MB", "ParseStream MB/s", "ParseMapped MB/s", "speedup");
+
+	for (const char* filename : filenames)
+	{
+		OBJData streamed, mapped;
+		double streamSeconds = TimeParse(OBJParser::ParseStream, filename, repeats, streamed);
+		double mappedSeconds = TimeParse(OBJParser::ParseMapped, filename, repeats, mapped);
+
+		if (streamSeconds < 0.0 || mappedSeconds < 0.0)
+		{
+			printf("%s: couldn't be read\n", filename);
+			passed = false;
+			continue;
+		}
+
+		if (!SameData(mapped, streamed, filename, "ParseMapped", "ParseStream"))
+		{
+			passed = false;
+			continue;
+		}
+
+		double megabytes = FileSize(filename) / (1024.0 * 1024.0);
+
+		printf("%-40s %10.1f %16.1f %16.1f %7.1fx\n", filename, megabytes, megabytes / streamSeconds, megabytes / mappedSeconds,
+			   streamSeconds / mappedSeconds);
+
+		//Against ParseMapped rather than a thread count before, so a sweep that's wrong from the start still fails
+		for (ThreadCount = 1; ThreadCount <= maxThreads; ++ThreadCount)
+		{
+			OBJData parallel;
+			double parallelSeconds = TimeParse(ParseParallel, filename, repeats, parallel);
+
+			char name[64];
+			snprintf(name, sizeof(name), "ParseMappedParallel with %u threads", ThreadCount);
+
+			if (parallelSeconds < 0.0 || !SameData(parallel, mapped, filename, name, "ParseMapped"))
+			{
+				passed = false;
+				break;
+			}
+
+			printf("    %2u threads %41.1f %7.1fx\n", ThreadCount, megabytes / parallelSeconds, mappedSeconds / parallelSeconds);
+		}
+	}
+
+	printf(passed ? "All files parsed the same every way\n" : "FAILED\n");
+	return passed ? 0 : 1;
+}
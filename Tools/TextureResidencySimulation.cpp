@@ -0,0 +1,427 @@
+//Runs TextureResidency against a made up scene of a few hundred DDS textures for a few thousand frames, with nothing
+//random that isn't seeded, so every run gives the same report. The textures are spread along a loop the camera goes
+//round, and each frame it draws the ones near enough to see, wanting fewer mips for the further ones, then stops for a
+//while so everything should settle. The scene is run twice and has to come out the same both times, and each frame is
+//checked for:
+//	- being within the budget, unless every texture is already down to its lowest mip
+//	- no texture being drawn with fewer mips than its lowest, or more than it's allowed
+//	- textures being drawn only losing mips once those that aren't have lost all they can
+//	- nothing changing size once the camera has stopped and the scene settled
+//	- the bytes it counts matching what FillSubresources lays out for the loader to upload
+//	- a streamed texture handed over part way, as AssetLoader::EndFrame does once a step fails, counting what it has and
+//	  being given the rest when there's room, and not when there isn't
+//Nothing here needs Direct3D, so it runs on Linux too.
+//
+//Build on Windows from a Developer Command Prompt in this folder:
+//	cl /O2 /EHsc /I.. TextureResidencySimulation.cpp ..\TextureResidency.cpp ..\DDSFormat.cpp
+//Build on Linux, with dxgiformat.h from https://github.com/microsoft/DirectX-Headers (include/directx):
+//	g++ -std=c++14 -O2 -I.. -I<DirectX-Headers>/include/directx TextureResidencySimulation.cpp ../TextureResidency.cpp ../DDSFormat.cpp -o TextureResidencySimulation
+//
+//Usage: TextureResidencySimulation [budgetMB = 256] [textures = 400] [frames = 3000] [--verbose]
+//
+//Prints the budget report every 100 frames (every frame with --verbose) and a summary, and exits with 1 if any check
+//failed.
+#include "TextureResidency.h"
+#include <algorithm>
+#include <math.h>
+#include <memory>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	//Numerical Recipes' LCG, the same on every platform unlike rand()
+	struct Random
+	{
+		uint32_t state;
+
+		uint32_t Next()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		}
+
+		uint32_t Below(uint32_t n) { return Next() % n; }
+	};
+
+	struct SceneTexture
+	{
+		DDS_TEXTURE_INFO info;
+		unsigned int id;
+		float position;			//Along the loop, 0 to 1
+		size_t lowestBytes;		//With as few mips as it can have
+		size_t allowedBytes;	//With every mip it's allowed
+	};
+
+	const float ViewDistance = 0.04f;
+
+	size_t MipCount(size_t size)
+	{
+		size_t count = 1;
+
+		while (size > 1)
+		{
+			size >>= 1;
+			++count;
+		}
+
+		return count;
+	}
+
+	//A mix of what a game has, mostly block compressed 2D textures with some uncompressed ones, arrays and cube maps
+	DDS_TEXTURE_INFO MakeTexture(Random& random)
+	{
+		static const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_BC5_UNORM,
+											   DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_BC7_UNORM_SRGB, DXGI_FORMAT_R8G8B8A8_UNORM };
+
+		DDS_TEXTURE_INFO info = {};
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		info.width = (size_t)256 << random.Below(5);
+		info.height = random.Below(4) == 0 ? info.width / 2 : info.width;
+		info.depth = 1;
+		info.arraySize = 1;
+		info.format = formats[random.Below(6)];
+
+		uint32_t kind = random.Below(20);
+		if (kind == 0)
+		{
+			info.isCubeMap = true;
+			info.height = info.width = std::min<size_t>(info.width, 1024);
+			info.arraySize = 6;
+		}
+		else if (kind == 1)
+		{
+			info.arraySize = 2 + random.Below(6);
+		}
+
+		//Now and then one without mips, which can only ever be whole
+		info.mipCount = random.Below(25) == 0 ? 1 : MipCount(std::max(info.width, info.height));
+
+		return info;
+	}
+
+	//How far the camera is round the loop, going round twice then stopping for the last 20% of the frames
+	float CameraPosition(unsigned int frame, unsigned int frames)
+	{
+		unsigned int moving = frames * 4 / 5;
+		return fmodf(2.0f * std::min(frame, moving) / moving, 1.0f);
+	}
+
+	float LoopDistance(float a, float b)
+	{
+		float d = fabsf(a - b);
+		return std::min(d, 1.0f - d);
+	}
+
+	struct RunResult
+	{
+		uint64_t hash;
+		unsigned int failures;
+		unsigned int mipsDropped;
+		unsigned int mipsRestored;
+		unsigned int texturesChanged;
+		unsigned int changesOnceSettled;
+		size_t peakResidentBytes;
+		double averageShortFraction;	//Of the textures drawn, that had fewer mips than they wanted
+	};
+
+	void Hash(uint64_t& hash, uint64_t value)
+	{
+		//FNV-1a a byte at a time
+		for (int i = 0; i < 8; ++i)
+		{
+			hash ^= (value >> (i * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	}
+
+	unsigned int Fail(unsigned int frame, const char* message)
+	{
+		printf("  FAILED frame %u: %s\n", frame, message);
+		return 1;
+	}
+
+	RunResult Run(size_t budget, unsigned int textureCount, unsigned int frames, bool report, bool verbose)
+	{
+		RunResult result = {};
+		result.hash = 14695981039346656037ull;
+
+		Random random = { 12345 };
+		TextureResidency residency(budget);
+		std::vector<SceneTexture> textures(textureCount);
+
+		for (SceneTexture& texture : textures)
+		{
+			texture.info = MakeTexture(random);
+			texture.position = random.Below(100000) / 100000.0f;
+			texture.id = residency.Add(texture.info);
+			texture.allowedBytes = residency.getBytes(texture.id);
+		}
+
+		//How small each can get, worked out from a residency with no room for anything
+		{
+			TextureResidency empty(1);
+			std::vector<unsigned int> ids;
+
+			for (SceneTexture& texture : textures)
+				ids.push_back(empty.Add(texture.info));
+
+			empty.EndFrame();
+
+			for (size_t i = 0; i < textures.size(); ++i)
+				textures[i].lowestBytes = empty.getBytes(ids[i]);
+		}
+
+		size_t lowestTotal = 0;
+		for (const SceneTexture& texture : textures)
+			lowestTotal += texture.lowestBytes;
+
+		unsigned int settledFrom = frames * 4 / 5 + 10;
+		double shortFractionSum = 0.0;
+		unsigned int shortFractionFrames = 0;
+
+		for (unsigned int frame = 0; frame < frames; ++frame)
+		{
+			float camera = CameraPosition(frame, frames);
+			std::vector<bool> drawn(textures.size(), false);
+			std::vector<size_t> before(textures.size());
+
+			for (size_t i = 0; i < textures.size(); ++i)
+			{
+				SceneTexture& texture = textures[i];
+				before[i] = residency.getBytes(texture.id);
+
+				float distance = LoopDistance(camera, texture.position);
+				if (distance > ViewDistance)
+					continue;
+
+				//Covers less of the screen the further away it is, 2048 pixels when it's right in front of the camera
+				size_t screenSize = (size_t)(2048.0f / (1.0f + distance * 400.0f));
+				residency.Use(texture.id, screenSize);
+				drawn[i] = true;
+			}
+
+			const TextureResidencyStats& stats = residency.EndFrame();
+
+			if (report && (verbose || frame % 100 == 0))
+			{
+				printf("frame %4u: %3u of %3u textures drawn, %7.1f MB resident of %.0f MB (%.1f MB drawn, %.1f MB wanted), %2u short, %2u mips dropped, %2u restored\n",
+					   stats.frame, stats.texturesUsed, stats.textures, stats.residentBytes / 1048576.0, stats.budgetBytes / 1048576.0,
+					   stats.usedBytes / 1048576.0, stats.wantedBytes / 1048576.0, stats.texturesShort, stats.mipsDropped, stats.mipsRestored);
+			}
+
+			Hash(result.hash, stats.residentBytes);
+			Hash(result.hash, stats.mipsDropped);
+			Hash(result.hash, stats.mipsRestored);
+
+			result.mipsDropped += stats.mipsDropped;
+			result.mipsRestored += stats.mipsRestored;
+			result.texturesChanged += stats.texturesChanged;
+			result.peakResidentBytes = std::max(result.peakResidentBytes, stats.residentBytes);
+
+			if (stats.texturesUsed > 0)
+			{
+				shortFractionSum += (double)stats.texturesShort / stats.texturesUsed;
+				++shortFractionFrames;
+			}
+
+			if (frame >= settledFrom)
+				result.changesOnceSettled += stats.texturesChanged;
+
+			size_t total = 0;
+			bool drawnLostMips = false;
+			bool undrawnCouldLose = false;
+
+			for (size_t i = 0; i < textures.size(); ++i)
+			{
+				const SceneTexture& texture = textures[i];
+				size_t bytes = residency.getBytes(texture.id);
+				total += bytes;
+
+				Hash(result.hash, residency.getMaxsize(texture.id));
+
+				if (bytes < texture.lowestBytes || bytes > texture.allowedBytes)
+					result.failures += Fail(frame, "a texture has fewer mips than its lowest, or more than it's allowed");
+
+				if (drawn[i] && bytes < before[i])
+					drawnLostMips = true;
+
+				if (!drawn[i] && bytes > texture.lowestBytes)
+					undrawnCouldLose = true;
+			}
+
+			if (total != stats.residentBytes)
+				result.failures += Fail(frame, "the resident bytes reported don't add up");
+
+			if (stats.residentBytes > budget && stats.residentBytes > lowestTotal)
+				result.failures += Fail(frame, "over budget while there were still mips to drop");
+
+			if (drawnLostMips && undrawnCouldLose)
+				result.failures += Fail(frame, "a texture being drawn lost mips while one that wasn't kept some it could have lost");
+		}
+
+		if (result.changesOnceSettled > 0)
+			result.failures += Fail(frames - 1, "textures were still changing size after the camera stopped");
+
+		result.averageShortFraction = shortFractionFrames > 0 ? shortFractionSum / shortFractionFrames : 0.0;
+
+		return result;
+	}
+
+	//What AssetLoader::EndFrame does with a streamed texture whose last step failed: it's added with the mips it has, which
+	//have to be what it counts and what getMaxsize gives until a frame decides otherwise. Drawn with room to spare it gets
+	//the rest back, and with no room it stays as it is
+	unsigned int CheckStreamHandoff()
+	{
+		const size_t streamedMaxsize = 64;
+		unsigned int failures = 0;
+
+		DDS_TEXTURE_INFO info = {};
+		info.dimension = DDS_DIMENSION_TEXTURE2D;
+		info.width = 1024;
+		info.height = 512;
+		info.depth = 1;
+		info.arraySize = 1;
+		info.mipCount = MipCount(info.width);
+		info.format = DXGI_FORMAT_BC7_UNORM;
+
+		size_t streamedBytes = TextureResidency::TextureBytes(info, streamedMaxsize);
+		size_t budgets[] = { 0, streamedBytes };
+
+		for (size_t budget : budgets)
+		{
+			TextureResidency residency(budget);
+
+			unsigned int id = residency.Add(info);
+			residency.Loaded(id, info, streamedMaxsize);
+
+			if (residency.getBytes(id) != streamedBytes || residency.getMaxsize(id) != streamedMaxsize)
+			{
+				printf("  FAILED: a texture handed over at maxsize %llu counts %llu bytes at maxsize %llu, should be %llu\n",
+					   (unsigned long long)streamedMaxsize, (unsigned long long)residency.getBytes(id),
+					   (unsigned long long)residency.getMaxsize(id), (unsigned long long)streamedBytes);
+				++failures;
+			}
+
+			//The loader's first EndFrame with it, before the game has drawn it, then a frame it's drawn in
+			if (residency.EndFrame().residentBytes != streamedBytes)
+			{
+				printf("  FAILED: a texture handed over part way isn't counted as resident\n");
+				++failures;
+			}
+
+			residency.Use(id);
+			residency.EndFrame();
+
+			size_t expected = budget == 0 ? 0 : streamedMaxsize;
+			if (residency.getMaxsize(id) != expected)
+			{
+				printf("  FAILED: a texture handed over part way was given maxsize %llu with a budget of %llu bytes, should be %llu\n",
+					   (unsigned long long)residency.getMaxsize(id), (unsigned long long)budget, (unsigned long long)expected);
+				++failures;
+			}
+		}
+
+		return failures;
+	}
+
+	//The residency's sizes against the ranges FillSubresources gives the loader, at every maxsize, for a few small textures
+	unsigned int CheckAgainstFillSubresources()
+	{
+		static const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT };
+		static const size_t sizes[][3] = { { 256, 256, 1 }, { 512, 128, 1 }, { 100, 60, 1 }, { 64, 64, 16 }, { 1, 1, 1 } };
+
+		unsigned int failures = 0;
+
+		for (DXGI_FORMAT format : formats)
+		{
+			for (const auto& size : sizes)
+			{
+				DDS_TEXTURE_INFO info = {};
+				info.dimension = size[2] > 1 ? DDS_DIMENSION_TEXTURE3D : DDS_DIMENSION_TEXTURE2D;
+				info.width = size[0];
+				info.height = size[1];
+				info.depth = size[2];
+				info.arraySize = size[2] > 1 ? 1 : 3;
+				info.mipCount = MipCount(std::max(size[0], std::max(size[1], size[2])));
+				info.format = format;
+
+				size_t dataSize = TextureResidency::TextureBytes(info, 0);
+				std::unique_ptr<uint8_t[]> data(new uint8_t[dataSize]);
+				std::vector<DDS_SUBRESOURCE> subresources(info.mipCount * info.arraySize);
+
+				for (size_t maxsize = 0; maxsize <= 512; maxsize = maxsize == 0 ? 1 : maxsize * 2)
+				{
+					size_t width, height, depth, skipMip;
+					size_t count = FillSubresources(info.width, info.height, info.depth, info.mipCount, info.arraySize, info.format, maxsize,
+													dataSize, data.get(), width, height, depth, skipMip, subresources.data());
+
+					size_t bytes = 0;
+					for (size_t i = 0; i < count; ++i)
+						bytes += subresources[i].bytes;
+
+					if (count == 0 || bytes != TextureResidency::TextureBytes(info, maxsize))
+					{
+						printf("  FAILED: %llu x %llu x %llu format %d at maxsize %llu counts %llu bytes, FillSubresources %llu\n",
+							   (unsigned long long)info.width, (unsigned long long)info.height, (unsigned long long)info.depth, (int)format,
+							   (unsigned long long)maxsize, (unsigned long long)TextureResidency::TextureBytes(info, maxsize),
+							   (unsigned long long)bytes);
+						++failures;
+					}
+				}
+			}
+		}
+
+		return failures;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool verbose = false;
+	std::vector<const char*> args;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--verbose") == 0)
+			verbose = true;
+		else
+			args.push_back(argv[i]);
+	}
+
+	size_t budget = (size_t)(args.size() > 0 ? atof(args[0]) : 256.0) * 1048576;
+	unsigned int textureCount = args.size() > 1 ? (unsigned int)atoi(args[1]) : 400;
+	unsigned int frames = args.size() > 2 ? (unsigned int)atoi(args[2]) : 3000;
+
+	if (budget == 0 || textureCount == 0 || frames < 100)
+	{
+		printf("Usage: TextureResidencySimulation [budgetMB = 256] [textures = 400] [frames = 3000] [--verbose]\n");
+		return 1;
+	}
+
+	unsigned int failures = CheckAgainstFillSubresources() + CheckStreamHandoff();
+
+	RunResult first = Run(budget, textureCount, frames, true, verbose);
+	RunResult second = Run(budget, textureCount, frames, false, false);
+
+	failures += first.failures;
+
+	if (first.hash != second.hash)
+	{
+		printf("  FAILED: a second run came out differently\n");
+		++failures;
+	}
+
+	printf("\n%u textures, %u frames, %.0f MB budget: peak %.1f MB resident, %u mips dropped and %u restored over %u changes, "
+		   "%.1f%% of the textures drawn were short of mips they wanted on average, %u changes once settled, run hash %016llx\n",
+		   textureCount, frames, budget / 1048576.0, first.peakResidentBytes / 1048576.0, first.mipsDropped, first.mipsRestored,
+		   first.texturesChanged, first.averageShortFraction * 100.0, first.changesOnceSettled, (unsigned long long)first.hash);
+
+	printf(failures == 0 ? "All checks passed\n" : "%u checks FAILED\n", failures);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,84 @@
+#pragma once
+//Helpers more than one of the tools needs. Everything is inline so none of their build lines need another file
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Every file under folder, as paths relative to it with / between folders
+inline void ListFiles(const std::string& folder, const std::string& relative, std::vector<std::string>& outFiles)
+{
+	std::string path = relative.empty() ? folder : folder + "/" + relative;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA((path + "/*").c_str(), &found);
+
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string name = found.cFileName;
+		bool isFolder = (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	DIR* directory = opendir(path.c_str());
+
+	if (!directory)
+		return;
+
+	while (dirent* found = readdir(directory))
+	{
+		std::string name = found->d_name;
+		struct stat status;
+		bool isFolder = stat((path + "/" + name).c_str(), &status) == 0 && S_ISDIR(status.st_mode);
+#endif
+		if (name == "." || name == "..")
+			continue;
+
+		std::string child = relative.empty() ? name : relative + "/" + name;
+
+		if (isFolder)
+			ListFiles(folder, child, outFiles);
+		else
+			outFiles.push_back(child);
+#ifdef _WIN32
+	} while (FindNextFileA(find, &found));
+
+	FindClose(find);
+#else
+	}
+
+	closedir(directory);
+#endif
+}
+
+//Asks the OS to forget what it has cached of a file, for the benchmarks' cold runs. Returns false where that isn't
+//possible, which is everywhere but Linux and the other systems with posix_fadvise (see README.md)
+inline bool EvictFromFileCache(const std::string& filename)
+{
+#ifdef _WIN32
+	(void)filename;
+	return false;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	fdatasync(file);
+	bool evicted = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(file);
+
+	return evicted;
+#endif
+}
@@ -0,0 +1,163 @@
+#include "VertexQuantizer.h"
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+	inline uint16_t QuantizeUnorm16(float value)
+	{
+		value = std::min(std::max(value, 0.0f), 1.0f);
+		return (uint16_t)(value * 65535.0f + 0.5f);
+	}
+
+	inline int16_t QuantizeSnorm16(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return (int16_t)floorf(value * 32767.0f + 0.5f);
+	}
+
+	inline float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	//Octahedral normal encoding (Meyer et al., "On Floating-Point Normal Vectors"): project onto the octahedron
+	//|x| + |y| + |z| = 1, then fold the lower half over the upper half so it fits in a square
+	inline void EncodeOctahedral(const XMFLOAT3& normal, int16_t* encoded)
+	{
+		float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+
+		if (length == 0.0f)
+		{
+			encoded[0] = 0;
+			encoded[1] = 0;
+			return;
+		}
+
+		float x = normal.x / length;
+		float y = normal.y / length;
+
+		if (normal.z < 0.0f)
+		{
+			float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+			float foldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+			x = foldedX;
+			y = foldedY;
+		}
+
+		encoded[0] = QuantizeSnorm16(x);
+		encoded[1] = QuantizeSnorm16(y);
+	}
+
+	//Same as DecodeOctahedral in the shader
+	inline XMFLOAT3 DecodeOctahedral(const int16_t* encoded)
+	{
+		float x = std::max(encoded[0] / 32767.0f, -1.0f);
+		float y = std::max(encoded[1] / 32767.0f, -1.0f);
+		float z = 1.0f - fabsf(x) - fabsf(y);
+
+		float t = std::max(-z, 0.0f);
+		x += x >= 0.0f ? -t : t;
+		y += y >= 0.0f ? -t : t;
+
+		float length = sqrtf(x * x + y * y + z * z);
+
+		return XMFLOAT3(x / length, y / length, z / length);
+	}
+}
+
+void VertexQuantizer::Quantize(const std::vector<SimpleVertex>& vertices, std::vector<CompactVertex>& outVertices, XMFLOAT3& posScale, XMFLOAT3& posOffset, QuantizationStats* stats)
+{
+	outVertices.resize(vertices.size());
+
+	//Bounding box of the positions
+	XMFLOAT3 minPos(0.0f, 0.0f, 0.0f);
+	XMFLOAT3 maxPos(0.0f, 0.0f, 0.0f);
+
+	if (!vertices.empty())
+	{
+		minPos = vertices[0].Pos;
+		maxPos = vertices[0].Pos;
+	}
+
+	for (const SimpleVertex& vertex : vertices)
+	{
+		minPos = XMFLOAT3(std::min(minPos.x, vertex.Pos.x), std::min(minPos.y, vertex.Pos.y), std::min(minPos.z, vertex.Pos.z));
+		maxPos = XMFLOAT3(std::max(maxPos.x, vertex.Pos.x), std::max(maxPos.y, vertex.Pos.y), std::max(maxPos.z, vertex.Pos.z));
+	}
+
+	posOffset = minPos;
+	posScale = XMFLOAT3(maxPos.x - minPos.x, maxPos.y - minPos.y, maxPos.z - minPos.z);
+
+	XMFLOAT3 invScale(posScale.x > 0.0f ? 1.0f / posScale.x : 0.0f,
+					  posScale.y > 0.0f ? 1.0f / posScale.y : 0.0f,
+					  posScale.z > 0.0f ? 1.0f / posScale.z : 0.0f);
+
+	for (size_t i = 0; i < vertices.size(); ++i)
+	{
+		const SimpleVertex& vertex = vertices[i];
+		CompactVertex& compact = outVertices[i];
+
+		compact.Pos[0] = QuantizeUnorm16((vertex.Pos.x - posOffset.x) * invScale.x);
+		compact.Pos[1] = QuantizeUnorm16((vertex.Pos.y - posOffset.y) * invScale.y);
+		compact.Pos[2] = QuantizeUnorm16((vertex.Pos.z - posOffset.z) * invScale.z);
+		compact.Pos[3] = 65535;
+
+		EncodeOctahedral(vertex.Normal, compact.Normal);
+
+		compact.TexC[0] = XMConvertFloatToHalf(vertex.TexC.x);
+		compact.TexC[1] = XMConvertFloatToHalf(vertex.TexC.y);
+	}
+
+	if (stats)
+	{
+		stats->maxPositionError = 0.0f;
+		stats->maxNormalErrorDegrees = 0.0f;
+		stats->maxTexCoordError = 0.0f;
+		stats->originalStride = sizeof(SimpleVertex);
+		stats->compactStride = sizeof(CompactVertex);
+		stats->originalBytes = sizeof(SimpleVertex) * vertices.size();
+		stats->compactBytes = sizeof(CompactVertex) * outVertices.size();
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			const SimpleVertex& original = vertices[i];
+			SimpleVertex decoded = Dequantize(outVertices[i], posScale, posOffset);
+
+			float dx = decoded.Pos.x - original.Pos.x;
+			float dy = decoded.Pos.y - original.Pos.y;
+			float dz = decoded.Pos.z - original.Pos.z;
+			stats->maxPositionError = std::max(stats->maxPositionError, sqrtf(dx * dx + dy * dy + dz * dz));
+
+			float length = sqrtf(original.Normal.x * original.Normal.x + original.Normal.y * original.Normal.y + original.Normal.z * original.Normal.z);
+			if (length > 0.0f)
+			{
+				float cosAngle = (decoded.Normal.x * original.Normal.x + decoded.Normal.y * original.Normal.y + decoded.Normal.z * original.Normal.z) / length;
+				float angle = acosf(std::min(std::max(cosAngle, -1.0f), 1.0f)) * 180.0f / XM_PI;
+				stats->maxNormalErrorDegrees = std::max(stats->maxNormalErrorDegrees, angle);
+			}
+
+			stats->maxTexCoordError = std::max(stats->maxTexCoordError, fabsf(decoded.TexC.x - original.TexC.x));
+			stats->maxTexCoordError = std::max(stats->maxTexCoordError, fabsf(decoded.TexC.y - original.TexC.y));
+		}
+	}
+}
+
+SimpleVertex VertexQuantizer::Dequantize(const CompactVertex& vertex, const XMFLOAT3& posScale, const XMFLOAT3& posOffset)
+{
+	SimpleVertex result;
+
+	result.Pos.x = vertex.Pos[0] / 65535.0f * posScale.x + posOffset.x;
+	result.Pos.y = vertex.Pos[1] / 65535.0f * posScale.y + posOffset.y;
+	result.Pos.z = vertex.Pos[2] / 65535.0f * posScale.z + posOffset.z;
+
+	result.Normal = DecodeOctahedral(vertex.Normal);
+
+	result.TexC.x = XMConvertHalfToFloat(vertex.TexC[0]);
+	result.TexC.y = XMConvertHalfToFloat(vertex.TexC[1]);
+
+	return result;
+}
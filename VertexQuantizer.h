@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include "Structures.h"
+
+//How far the compact vertices are from the originals, and what that saves
+struct QuantizationStats
+{
+	float maxPositionError;			//Largest distance between an original and dequantized position
+	float maxNormalErrorDegrees;	//Largest angle between an original and decoded normal
+	float maxTexCoordError;			//Largest difference in a texture coordinate component
+	unsigned int originalStride;
+	unsigned int compactStride;
+	unsigned int originalBytes;		//Size of the vertex buffer before and after
+	unsigned int compactBytes;
+};
+
+//Converts SimpleVertex buffers to CompactVertex
+namespace VertexQuantizer
+{
+	//Quantizes the vertices. The shader gets the position back with Pos * posScale + posOffset, which maps the
+	//16-bit positions back onto the mesh's bounding box
+	void Quantize(const std::vector<SimpleVertex>& vertices, std::vector<CompactVertex>& outVertices, XMFLOAT3& posScale, XMFLOAT3& posOffset, QuantizationStats* stats = nullptr);
+
+	//Inverse of Quantize, used to measure the error
+	SimpleVertex Dequantize(const CompactVertex& vertex, const XMFLOAT3& posScale, const XMFLOAT3& posOffset);
+};